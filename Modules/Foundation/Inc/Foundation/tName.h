@@ -6,6 +6,10 @@
 // A hash table is NOT used by this class -- with a 64 bit hash and a universe of 1000000 strings, the probability of a
 // collision is miniscule at around 2.7e-8 (assuming the hash function is good).
 //
+// Optionally a tName may be interned. Interned names share a single immutable copy of their text held in a global,
+// thread-safe pool. Copying an interned name does not allocate, and two interned names compare by pointer. This is
+// worthwhile when the same names are created over and over, like material and joint names in a large scene.
+//
 // The text in a tName is considered to be UTF-8 encoded. With UTF-8 encoding each character (code-point) may be encoded
 // by 1 or more code-units (a code-unit is 8 bits). The char8_t is used to repreresent a code-unit (as the C++ standard
 // encourages).
@@ -112,7 +116,7 @@ struct tName
 	void Set(const tStringUTF16&	src);
 	void Set(const tStringUTF32&	src);
 
-	void Clear()					/* Makes the string invalid. Frees any heap memory used. */							{ CodeUnitsSize = 0; delete[] CodeUnits; CodeUnits = nullptr; Hash = 0; }
+	void Clear()					/* Makes the string invalid. Frees any heap memory used. */							{ CodeUnitsSize = 0; if (!Interned) delete[] CodeUnits; CodeUnits = nullptr; Hash = 0; Interned = false; }
 	void Empty()					/* Makes the string a valid empty string. */										{ Clear(); CodeUnitsSize = 1; CodeUnits = new char8_t[CodeUnitsSize]; CodeUnits[0] = '\0'; Hash = ComputeHash(); }
 
 	// The length in char8_t's (code-units), not the display length (which is not that useful). Returns -1 if the tName
@@ -138,12 +142,22 @@ struct tName
 	// is treated as invalid and equality is guaranteed false. For variants taking no length, the name is considered
 	// equal if the characters match up to the first null in the tName (even if there are more of them internally). For
 	// the IsEqual that takes in another tName, the comparisons are very fast as only the hash is compared.
-	bool IsEqual(const tName&		nam) const				/* Fast. Compares hashes. */								{ if (IsInvalid() || nam.IsInvalid()) return false; return (Hash == nam.Hash); }
+	bool IsEqual(const tName&		nam) const				/* Fast. Compares hashes. */								{ if (IsInvalid() || nam.IsInvalid()) return false; return (Interned && nam.Interned) ? (CodeUnits == nam.CodeUnits) : (Hash == nam.Hash); }
 	bool IsEqual(const char*		str) const				/* A nullptr str is treated as an invalid string. */ 		{ return IsEqual(str, str ? tStd::tStrlen(str) : -1); }
 	bool IsEqual(const char8_t*		str) const																			{ return IsEqual(str, str ? tStd::tStrlen(str) : -1); }
 	bool IsEqual(const char*		str, int strLen) const	/* strLen = 0 and non-null str is the empty string. */		{ return IsEqual((const char8_t*)str, strLen); }
 	bool IsEqual(const char8_t*		str, int strLen) const;	/* Defined inline below. */
 
+	// Makes this name use the shared copy of its text in the intern pool, adding it to the pool if it isn't there yet.
+	// Invalid names are left alone. Interning is thread-safe. The text of an interned name must not be modified using
+	// Text, Txt, or operator[]. Set, Append, and Clear are fine -- they give the name its own text again. Interned text
+	// is never freed. Returns a reference to this so you can write things like: tName joint = tName("Hips").Intern();
+	tName& Intern();
+	bool IsInterned() const																								{ return Interned; }
+
+	// Returns the number of distinct names in the intern pool.
+	static int GetNumInterned();
+
 	// Appends supplied suffix name to this name. Handles the full length of suffix -- including multiple nulls if there
 	// are any.
 	tName& Append(const tName& suffix);
@@ -166,10 +180,10 @@ struct tName
 	// to be used with the char-constructor of another string if desired.
 	char& operator[](int i)																								{ return ((char*)CodeUnits)[i]; }
 
-	// These return the fast 32 bit hash of the string data (code units). They take into account the full
-	// represented string -- not just up to the first null. That is, they use StringLength as the data-set size.
-	explicit operator uint32();
-	explicit operator uint32() const;
+	// These return a 32 bit hash folded from the stored 64 bit hash, so no string data is read. They take into account
+	// the full represented string -- not just up to the first null. This is what tMap uses, so tNames make cheap keys.
+	explicit operator uint32()																							{ return uint32(Hash ^ (Hash >> 32)); }
+	explicit operator uint32() const																					{ return uint32(Hash ^ (Hash >> 32)); }
 
 	// Similar to above but return the 64 bit hash (not a fast version).
 	explicit operator uint64()																							{ return GetHash(); }
@@ -262,6 +276,9 @@ protected:
 
 	// The length of the CodeUnits array (not including the null terminator). For an invalid tName the Length is -1.
 	int32 CodeUnitsSize				= 0;
+
+	// True if CodeUnits points into the intern pool. The pool owns the memory.
+	bool Interned					= false;
 };
 
 
@@ -312,26 +329,6 @@ inline uint64 tName::ComputeHash() const
 }
 
 
-inline tName::operator uint32()
-{
-	if (IsInvalid())
-		return 0;
-
-	// This call deals with Length=0 gracefully (empty string). It does not deref the data pointer in this case.
-	return tHash::tHashDataFast32((const uint8*)CodeUnits, Length());
-}
-
-
-inline tName::operator uint32() const
-{
-	if (IsInvalid())
-		return 0;
-
-	// This function deals with a Length of zero gracefully. It does not deref the data pointer in this case.
-	return tHash::tHashDataFast32((const uint8*)CodeUnits, Length());
-}
-
-
 inline void tName::Set(const tName& src)
 {
 	if (this == &src)
@@ -342,9 +339,16 @@ inline void tName::Set(const tName& src)
 		return;
 
 	CodeUnitsSize = src.CodeUnitsSize;
+	Hash = src.Hash;
+	if (src.Interned)
+	{
+		CodeUnits = src.CodeUnits;
+		Interned = true;
+		return;
+	}
+
 	CodeUnits = new char8_t[CodeUnitsSize];
 	tStd::tMemcpy(CodeUnits, src.CodeUnits, CodeUnitsSize);
-	Hash = src.Hash;
 }
 
 
@@ -566,6 +570,7 @@ inline int tName::SetUTF32(const char32_t* src, int srcLen)
 	{
 		int len = tStd::tUTF8(nullptr, src, srcLen);
 		CodeUnitsSize = len + 1;						// +1 for the internal null termination.
+		CodeUnits = new char8_t[CodeUnitsSize];
 		tStd::tUTF8(CodeUnits, src, srcLen);
 		CodeUnits[len] = '\0';
 	}
@@ -577,17 +582,6 @@ inline int tName::SetUTF32(const char32_t* src, int srcLen)
 
 inline tNameItem& tNameItem::operator=(const tNameItem& src)
 {
-	if (this == &src)
-		return *this;
-
-	Clear();
-	if (src.IsInvalid())
-		return *this;
-
-	CodeUnitsSize = src.CodeUnitsSize;
-	CodeUnits = new char8_t[CodeUnitsSize];
-	tStd::tMemcpy(CodeUnits, src.CodeUnits, CodeUnitsSize);
-	Hash = src.Hash;
-
+	Set(src);
 	return *this;
 }
@@ -15,8 +15,10 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #pragma once
+#include <atomic>
 #include <Foundation/tAssert.h>
 #include <Foundation/tStandard.h>
+#include <Foundation/tFundamentals.h>
 
 
 // tRingBuffer allows you to append one or more items (of user-specified type) to the tail of the ring, remove one or
@@ -85,6 +87,37 @@ private:
 template<typename T> using tRing = tRingBuffer<T>;
 
 
+// tRingBufferSPSC is a lock-free ring buffer for exactly one producer (appending) thread and one consumer (removing)
+// thread. The tRingBuffer above can't be used that way since both ends update the null head/tail state. Here the head
+// and tail are free-running counters, so the producer only ever writes Tail and the consumer only ever writes Head.
+// Items are memory copied, so T must be a POD type. The capacity is rounded up to a power of 2.
+template<typename T> class tRingBufferSPSC
+{
+public:
+	tRingBufferSPSC(int capacity);
+	virtual ~tRingBufferSPSC()																							{ delete[] Buffer; }
+
+	int GetCapacity() const																								{ return Capacity; }
+
+	// These are exact when called from the producer or consumer thread. From any other thread they are a snapshot.
+	int GetNumItems() const																								{ return int(Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire)); }
+	int GetRoom() const																									{ return Capacity - GetNumItems(); }
+	bool IsEmpty() const																								{ return GetNumItems() == 0; }
+
+	// Only call from the producer thread. Appends all the items or none of them. Returns false if there wasn't room.
+	bool Append(const T* items, int numItems);
+
+	// Only call from the consumer thread. Removes up to numItems and returns how many were removed.
+	int Remove(T* items, int numItems);
+
+private:
+	int Capacity;
+	T* Buffer;
+	std::atomic<uint32> Head								= 0;
+	std::atomic<uint32> Tail								= 0;
+};
+
+
 // Implementation below this line.
 
 
@@ -115,7 +148,7 @@ template<typename T> inline void tRingBuffer<T>::Set(T* const buffer, int capaci
 template<typename T> inline void tRingBuffer<T>::Clear()
 {
 	if (OwnsBuffer)
-		delete Buffer;
+		delete[] Buffer;
 	Buffer = nullptr;
 	Head = nullptr;
 	Tail = nullptr;
@@ -317,3 +350,51 @@ template<typename T> inline int tRingBuffer<T>::Remove(T* items, int numItems, b
 
 	return numRemoved;
 }
+
+
+template<typename T> inline tRingBufferSPSC<T>::tRingBufferSPSC(int capacity)
+{
+	tAssert(capacity > 0);
+	Capacity = 1;
+	while (Capacity < capacity)
+		Capacity <<= 1;
+	Buffer = new T[Capacity];
+}
+
+
+template<typename T> inline bool tRingBufferSPSC<T>::Append(const T* items, int numItems)
+{
+	uint32 tail = Tail.load(std::memory_order_relaxed);
+	uint32 head = Head.load(std::memory_order_acquire);
+	if ((numItems <= 0) || (numItems > Capacity - int(tail - head)))
+		return numItems == 0;
+
+	// We may need two memcpys if we go past the end.
+	int start = int(tail & (Capacity-1));
+	int first = tMath::tMin(numItems, Capacity - start);
+	tStd::tMemcpy(Buffer + start, items, first*sizeof(T));
+	if (numItems > first)
+		tStd::tMemcpy(Buffer, items + first, (numItems-first)*sizeof(T));
+
+	Tail.store(tail + numItems, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T> inline int tRingBufferSPSC<T>::Remove(T* items, int numItems)
+{
+	uint32 head = Head.load(std::memory_order_relaxed);
+	uint32 tail = Tail.load(std::memory_order_acquire);
+	numItems = tMath::tMin(numItems, int(tail - head));
+	if (numItems <= 0)
+		return 0;
+
+	int start = int(head & (Capacity-1));
+	int first = tMath::tMin(numItems, Capacity - start);
+	tStd::tMemcpy(items, Buffer + start, first*sizeof(T));
+	if (numItems > first)
+		tStd::tMemcpy(items + first, Buffer, (numItems-first)*sizeof(T));
+
+	Head.store(head + numItems, std::memory_order_release);
+	return numItems;
+}
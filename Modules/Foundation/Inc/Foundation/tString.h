@@ -22,6 +22,11 @@
 // question of how much extra space to reserve. The SetGrowMethod may be used to set how much extra space is reserved
 // when a memory-size-changing operation takes place. By default a constant amount of extra memory is reserved.
 //
+// Short strings do not allocate at all. Every tString has MinCapacity code-units of inline storage and only goes to the
+// heap when it needs more than that. An empty tString never allocates. For code that makes a large number of strings
+// that all die together (directory listings for example) a tStringArena may be installed on the current thread. While
+// installed, strings that outgrow their inline storage get memory from the arena in large blocks instead of new[].
+//
 // A few of the salient functions related to the above are:
 // Length		:	Returns how many code-units are used by the string. This is NOT like a strlen call as it does not
 //					rely on nul-termination. It does not need to iterate as the length is stored explicitely.
@@ -55,7 +60,7 @@ struct tStringUTF32;
 
 struct tString
 {
-	tString()																											{ UpdateCapacity(0, false); }
+	tString()																											{ CodeUnits[0] = '\0'; }
 	tString(const tString& src)																							{ Set(src); }
 
 	// Construct a string of length null characters.
@@ -82,7 +87,7 @@ struct tString
 	// The tStringUTF constructors allow the src strings to have multiple nulls in them.
 	tString(const tStringUTF16&		src)																				{ Set(src); }
 	tString(const tStringUTF32&		src)																				{ Set(src); }
-	virtual ~tString()																									{ delete[] CodeUnits; }
+	virtual ~tString()																									{ FreeUnits(); }
 
 	// The set functions always clear the current string and set it to the supplied src.
 	void Set(const tString&			src);
@@ -403,16 +408,22 @@ protected:
 	// the current length, not the potential future length (do not modify StringLength first). It is illegal to call
 	// with preserve true and a capNeeded that is less than the StringLength.
 	//
-	// This function respects MinCapactity. If capNeeded + (possible grow amount) is under MinCapacity,
-	// MinCapacity will be used instead. Calling with capNeeded = 0 is special, it will not add any extra grow amount.
-	// This results in MinCapacity being used. When calling with 0 you still need to meet the StringLenghth requirement if
-	// preserve is true (i.e. StringLength would need to be 0).
+	// The capacity is never less than MinCapacity since the inline units are always there. The grow amount is only
+	// added when new memory is actually needed, so setting a short string never leaves the inline units. When calling
+	// with 0 you still need to meet the StringLenghth requirement if preserve is true (i.e. StringLength would need to
+	// be 0).
 	//
 	// This function never shrinks the capacity. Use Reserve, Shrink, or Grow (with negative input) for that.
 	void UpdateCapacity(int capNeeded, bool preserve);
 
-	// This could be made to be dynamic. Just didn't want to waste 4 bytes for every tString instance.
-	const int MinCapacity			= 15;
+	// Allocates capacity+1 code-units from the arena installed on the current thread, or with new[] if there isn't one.
+	// inArena is set so the units are not deleted later.
+	static char8_t* AllocUnits(int capacity, bool& inArena);
+	void FreeUnits()																									{ if ((CodeUnits != LocalUnits) && !UnitsInArena) delete[] CodeUnits; }
+
+	// This is also the number of inline code-units (not counting the terminator). A capacity of MinCapacity always
+	// means the inline units are being used.
+	static const int MinCapacity	= 15;
 
 	// If GrowParam is positive, it represents how many extra code-units to grow by when out of capacity.
 	// If GrowParam is negative, its absolute value represents how many times bigger the capacity should be
@@ -424,15 +435,58 @@ protected:
 	int StringLength				= 0;
 
 	// The capacity. The number of allocated CodeUnuts is always one more than this.
-	int CurrCapacity				= 0;
+	int CurrCapacity				= MinCapacity;
+
+	// True if CodeUnits came from a tStringArena. The arena owns the memory, not us.
+	bool UnitsInArena				= false;
 
 	// By using the char8_t we are indicating the data is stored in UTF-8 encoding. Note that unlike char, a char8_t
 	// is guaranteed to be unsigned, as well as a distinct type. In unicode spec for UTFn, these are called code-units.
-	// With tStrings the CodeUnits pointer is never nullptr after construction. There is always some capacity.
-	char8_t* CodeUnits				= nullptr;
+	// With tStrings the CodeUnits pointer is never nullptr. It points to LocalUnits until more room is needed.
+	char8_t* CodeUnits				= LocalUnits;
+	char8_t LocalUnits[MinCapacity+1];
 };
 
 
+// A tStringArena hands out tString code-units from large blocks. Install one with tSetStringArena and any tString on
+// the same thread that needs more than its inline storage gets its memory from the arena. Individual strings never
+// free arena memory, it is all released when the arena is destroyed or Reset. That makes it fast, but every tString
+// that got units from the arena must be destroyed (or copied somewhere with no arena installed) before then. Strings
+// that are set (not appended to) while an arena is installed don't get the extra grow room. An arena must only be
+// installed on one thread at a time.
+class tStringArena
+{
+public:
+	tStringArena(int blockSize = DefaultBlockSize)																		: BlockSize(blockSize) { }
+	virtual ~tStringArena()																								{ Reset(); }
+
+	// Returns numUnits code-units. Requests bigger than a quarter of the block size get a block of their own.
+	char8_t* Allocate(int numUnits);
+
+	// Frees all the blocks. Any strings using them are left dangling.
+	void Reset();
+
+	int GetNumBlocks() const																							{ return NumBlocks; }
+	int64 GetNumUnitsAllocated() const																					{ return NumUnitsAllocated; }
+
+	static const int DefaultBlockSize = 64*1024;
+
+private:
+	// Each block starts with a pointer to the previous one.
+	uint8* Blocks					= nullptr;
+	int BlockSize					= DefaultBlockSize;
+	int BlockUsed					= 0;
+	int NumBlocks					= 0;
+	int64 NumUnitsAllocated			= 0;
+};
+
+
+// Sets the arena used by tStrings on the calling thread. Set it to nullptr to go back to the heap. Returns the
+// previously installed arena so it can be restored. The arena is not owned.
+tStringArena* tSetStringArena(tStringArena*);
+tStringArena* tGetStringArena();
+
+
 // tStringUTF16 and tStringUTF32 are not intended to be full-fledged string classes, but they are handy to marshall data
 // to and from OS calls that take or return these encodings. Primarily these abstract away the memory management for the
 // different encodings, since the encoding size depends on the string contents. You may construct a tStringUTFn from a
@@ -709,11 +763,15 @@ inline int tString::Reserve(int numUnits)
 	if (numUnits == CurrCapacity)
 		return CurrCapacity;
 
+	// Shrinking to MinCapacity moves the string back into the inline units.
+	bool inArena = false;
+	char8_t* newUnits = (numUnits == MinCapacity) ? LocalUnits : AllocUnits(numUnits, inArena);
+
 	// The plus one is so we can do the null-terminator in the memcpy. It also allows it to work if the string length is 0.
-	char8_t* newUnits = new char8_t[numUnits+1];
 	tStd::tMemcpy(newUnits, CodeUnits, StringLength+1);
-	delete[] CodeUnits;
+	FreeUnits();
 	CodeUnits = newUnits;
+	UnitsInArena = inArena;
 	CurrCapacity = numUnits;
 
 	return CurrCapacity;
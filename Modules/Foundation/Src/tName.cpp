@@ -0,0 +1,116 @@
+// tName.cpp
+//
+// The intern pool for tNames. Interned text lives in a tStringArena and is found with an open-addressing table keyed
+// on the 64 bit hash the tName already has, so interning a name never rehashes it.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <mutex>
+#include "Foundation/tName.h"
+
+
+namespace tNameInternal
+{
+	// Different text with the same hash gets a different entry, so pointer equality is exact.
+	struct PoolEntry
+	{
+		uint64 Hash;
+		char8_t* Units;					// Nullptr for an empty slot.
+		int32 Size;						// Includes the terminator.
+	};
+
+	struct Pool
+	{
+		~Pool()																											{ delete[] Table; }
+		char8_t* Intern(const char8_t* units, int32 size, uint64 hash);
+		void Grow();
+
+		std::mutex Mutex;
+		tStringArena Text;
+		PoolEntry* Table			= nullptr;
+		int Capacity				= 0;			// Always a power of 2.
+		int NumEntries				= 0;
+	};
+
+	// A function static so names can be interned during static initialization.
+	Pool& GetPool()																										{ static Pool pool; return pool; }
+}
+
+
+char8_t* tNameInternal::Pool::Intern(const char8_t* units, int32 size, uint64 hash)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (2*(NumEntries+1) > Capacity)
+		Grow();
+
+	int mask = Capacity - 1;
+	for (int slot = int(hash) & mask; ; slot = (slot+1) & mask)
+	{
+		PoolEntry& entry = Table[slot];
+		if (!entry.Units)
+		{
+			entry.Hash = hash;
+			entry.Size = size;
+			entry.Units = Text.Allocate(size);
+			tStd::tMemcpy(entry.Units, units, size);
+			NumEntries++;
+			return entry.Units;
+		}
+
+		if ((entry.Hash == hash) && (entry.Size == size) && !tStd::tMemcmp(entry.Units, units, size))
+			return entry.Units;
+	}
+}
+
+
+void tNameInternal::Pool::Grow()
+{
+	int newCapacity = Capacity ? 2*Capacity : 1024;
+	PoolEntry* newTable = new PoolEntry[newCapacity];
+	tStd::tMemset(newTable, 0, newCapacity*sizeof(PoolEntry));
+
+	int mask = newCapacity - 1;
+	for (int e = 0; e < Capacity; e++)
+	{
+		if (!Table[e].Units)
+			continue;
+
+		int slot = int(Table[e].Hash) & mask;
+		while (newTable[slot].Units)
+			slot = (slot+1) & mask;
+		newTable[slot] = Table[e];
+	}
+
+	delete[] Table;
+	Table = newTable;
+	Capacity = newCapacity;
+}
+
+
+tName& tName::Intern()
+{
+	if (IsInvalid() || Interned)
+		return *this;
+
+	char8_t* units = tNameInternal::GetPool().Intern(CodeUnits, CodeUnitsSize, Hash);
+	delete[] CodeUnits;
+	CodeUnits = units;
+	Interned = true;
+	return *this;
+}
+
+
+int tName::GetNumInterned()
+{
+	tNameInternal::Pool& pool = tNameInternal::GetPool();
+	std::lock_guard<std::mutex> lock(pool.Mutex);
+	return pool.NumEntries;
+}
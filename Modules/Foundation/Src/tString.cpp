@@ -51,6 +51,12 @@
 #include "Foundation/tHash.h"
 
 
+namespace tStringInternal
+{
+	thread_local tStringArena* CurrentArena = nullptr;
+}
+
+
 tString::operator uint32()
 {
 	// This function deals with a StringLength of zero gracefully. It does not deref the data pointer in this case.
@@ -219,7 +225,7 @@ tString tString::ExtractMid(int start, int count)
 	// Memmove is needed since src and dest overlap. Capacity can stay the same.
 	int numMove = length - (start + count);
 	if (numMove > 0)
-		tStd::tMemcpy(CodeUnits + start, CodeUnits + start + count, numMove);
+		tStd::tMemmov(CodeUnits + start, CodeUnits + start + count, numMove);
 	StringLength -= count;
 	CodeUnits[StringLength] = '\0';
 
@@ -695,14 +701,6 @@ int tString::SetUTF32(const char32_t* src, int srcLen)
 
 void tString::UpdateCapacity(int capNeeded, bool preserve)
 {
-	int grow = 0;
-	if (capNeeded > 0)
-		grow = (GrowParam >= 0) ? GrowParam : capNeeded*(-GrowParam);
-
-	capNeeded += grow;
-	if (capNeeded < MinCapacity)
-		capNeeded = MinCapacity;
-
 	if (CurrCapacity >= capNeeded)
 	{
 		if (!preserve)
@@ -713,7 +711,12 @@ void tString::UpdateCapacity(int capNeeded, bool preserve)
 		return;
 	}
 
-	char8_t* newUnits = new char8_t[capNeeded+1];
+	// Arena memory can't be given back, so strings that are being set rather than appended to only get what they need.
+	if (preserve || !tStringInternal::CurrentArena)
+		capNeeded += (GrowParam >= 0) ? GrowParam : capNeeded*(-GrowParam);
+
+	bool inArena = false;
+	char8_t* newUnits = AllocUnits(capNeeded, inArena);
 	if (preserve)
 	{
 		tAssert(capNeeded >= StringLength);
@@ -726,13 +729,89 @@ void tString::UpdateCapacity(int capNeeded, bool preserve)
 	}
 	newUnits[StringLength] = '\0';
 
-	// CodeUnits mey be nullptr the first time.
-	delete[] CodeUnits;
+	FreeUnits();
 	CodeUnits = newUnits;
+	UnitsInArena = inArena;
 	CurrCapacity = capNeeded;
 }
 
 
+char8_t* tString::AllocUnits(int capacity, bool& inArena)
+{
+	tStringArena* arena = tStringInternal::CurrentArena;
+	inArena = (arena != nullptr);
+	return inArena ? arena->Allocate(capacity+1) : new char8_t[capacity+1];
+}
+
+
+char8_t* tStringArena::Allocate(int numUnits)
+{
+	tAssert(numUnits > 0);
+	NumUnitsAllocated += numUnits;
+
+	// Big requests get their own block. It goes behind the current one so the current one can keep being used.
+	const int headerSize = sizeof(uint8*);
+	if (numUnits > BlockSize/4)
+	{
+		uint8* block = new uint8[headerSize + numUnits];
+		if (Blocks)
+		{
+			*((uint8**)block) = *((uint8**)Blocks);
+			*((uint8**)Blocks) = block;
+		}
+		else
+		{
+			*((uint8**)block) = nullptr;
+			Blocks = block;
+			BlockUsed = BlockSize;
+		}
+		NumBlocks++;
+		return (char8_t*)(block + headerSize);
+	}
+
+	if (!Blocks || (BlockUsed + numUnits > BlockSize))
+	{
+		uint8* block = new uint8[headerSize + BlockSize];
+		*((uint8**)block) = Blocks;
+		Blocks = block;
+		BlockUsed = 0;
+		NumBlocks++;
+	}
+
+	char8_t* units = (char8_t*)(Blocks + headerSize + BlockUsed);
+	BlockUsed += numUnits;
+	return units;
+}
+
+
+void tStringArena::Reset()
+{
+	while (Blocks)
+	{
+		uint8* prev = *((uint8**)Blocks);
+		delete[] Blocks;
+		Blocks = prev;
+	}
+	BlockUsed = 0;
+	NumBlocks = 0;
+	NumUnitsAllocated = 0;
+}
+
+
+tStringArena* tSetStringArena(tStringArena* arena)
+{
+	tStringArena* prev = tStringInternal::CurrentArena;
+	tStringInternal::CurrentArena = arena;
+	return prev;
+}
+
+
+tStringArena* tGetStringArena()
+{
+	return tStringInternal::CurrentArena;
+}
+
+
 int tStd::tExplode(tList<tStringItem>& components, const tString& src, char divider)
 {
 	tString source = src;
@@ -74,5 +74,8 @@ struct Image
 // Returns -1 on error.
 int load_apng(const char * szIn, std::vector<Image>& img);
 
+// @tacent Exposed so frames decoded elsewhere can be composed the same way load_apng does it.
+void compose_frame(unsigned char ** rows_dst, unsigned char ** rows_src, unsigned char bop, unsigned int x, unsigned int y, unsigned int w, unsigned int h);
+
 
 }
@@ -115,6 +115,7 @@ ge_new_gif(
     if (depth < 0)
         depth = -depth;
     gif->depth = depth > 1 ? depth : 2;
+    gif->pdepth = depth;
     fwrite((uint8_t []) {0xF0 | (depth-1), (uint8_t) bgindex, 0x00}, 1, 3, gif->filep);
     if (custom_gct) {
         fwrite(palette, 1, 3 << depth, gif->filep);
@@ -201,7 +202,7 @@ end_key(ge_GIF *gif)
 }
 
 static void
-put_image(ge_GIF *gif, uint16_t w, uint16_t h, uint16_t x, uint16_t y)
+put_image(ge_GIF *gif, uint8_t *palette, uint16_t w, uint16_t h, uint16_t x, uint16_t y)
 {
     int nkeys, key_size, i, j;
     Node *node, *child, *root;
@@ -212,7 +213,14 @@ put_image(ge_GIF *gif, uint16_t w, uint16_t h, uint16_t x, uint16_t y)
     write_num(gif->filep, y);
     write_num(gif->filep, w);
     write_num(gif->filep, h);
-    fwrite((uint8_t []) {0x00, gif->depth}, 1, 2, gif->filep);
+    /* @tacent Optional local colour table. Original: fwrite((uint8_t []) {0x00, gif->depth}, 1, 2, gif->filep); */
+    if (palette) {
+        fwrite((uint8_t []) {0x80 | (gif->pdepth-1)}, 1, 1, gif->filep);
+        fwrite(palette, 1, 3 << gif->pdepth, gif->filep);
+    } else {
+        fwrite((uint8_t []) {0x00}, 1, 1, gif->filep);
+    }
+    fwrite((uint8_t []) {gif->depth}, 1, 1, gif->filep);
     root = node = new_trie(degree, &nkeys);
     key_size = gif->depth + 1;
     put_key(gif, degree, key_size); /* clear code */
@@ -306,7 +314,7 @@ ge_add_frame(ge_GIF *gif, uint16_t delay)
         w = h = 1;
         x = y = 0;
     }
-    put_image(gif, w, h, x, y);
+    put_image(gif, NULL, w, h, x, y);
     gif->nframes++;
     if (gif->bgindex < 0) {
         tmp = gif->back;
@@ -315,6 +323,19 @@ ge_add_frame(ge_GIF *gif, uint16_t delay)
     }
 }
 
+/* @tacent Added. */
+void
+ge_add_frame_rect(
+    ge_GIF *gif, uint16_t delay, uint8_t *palette,
+    uint16_t w, uint16_t h, uint16_t x, uint16_t y
+)
+{
+    if (delay || (gif->bgindex >= 0))
+        add_graphics_control_extension(gif, delay);
+    put_image(gif, palette, w, h, x, y);
+    gif->nframes++;
+}
+
 void
 ge_close_gif(ge_GIF* gif)
 {
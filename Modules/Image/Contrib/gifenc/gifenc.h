@@ -11,6 +11,7 @@ extern "C" {
 typedef struct ge_GIF {
     uint16_t w, h;
     int depth;
+    int pdepth;     /* @tacent Palette depth before the min-2 clamp. Sizes local colour tables. */
     int bgindex;
     FILE* filep;
     int offset;
@@ -25,6 +26,14 @@ ge_GIF *ge_new_gif(
     uint8_t *palette, int depth, int bgindex, int loop
 );
 void ge_add_frame(ge_GIF *gif, uint16_t delay);
+
+/* @tacent Added. Like ge_add_frame but the caller chooses the sub-rectangle of gif->frame that is stored and may pass
+ * a local colour table (same depth as the global one) or NULL to use the global one. The frame and back buffers are
+ * never swapped, so the caller is responsible for working out what changed. */
+void ge_add_frame_rect(
+    ge_GIF *gif, uint16_t delay, uint8_t *palette,
+    uint16_t w, uint16_t h, uint16_t x, uint16_t y
+);
 void ge_close_gif(ge_GIF* gif);
 
 #ifdef __cplusplus
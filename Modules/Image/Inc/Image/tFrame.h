@@ -19,6 +19,7 @@
 #include <Foundation/tStandard.h>
 #include <Foundation/tList.h>
 #include <Image/tPixelFormat.h>
+#include <Image/tPixelShare.h>
 namespace tImage
 {
 
@@ -37,6 +38,10 @@ struct tFrame : public tLink<tFrame>
 	bool Set(const tFrame& src);
 	bool Set(const tPixel4b* src, int width, int height, float duration = 0.0f);
 
+	// Uses the same pixels as src instead of copying them. Since Pixels is public, this is opt-in: once two frames
+	// share, both must call Unshare before writing to Pixels directly. GetPixels and SetPixel call it for you.
+	bool Share(const tFrame& src);
+
 	// Steals the pixels from the src frame.
 	bool StealFrom(tFrame& src);
 
@@ -45,9 +50,14 @@ struct tFrame : public tLink<tFrame>
 
 	// If steal is true the frame will be invalid after and you must delete[] the returned pixels. They are yours.
 	// If steal is false the pixels remain owned by this tFrame. You can look or modify them, but they're not yours.
-	tPixel4b* GetPixels(bool steal = false)																				{ if (steal) { tPixel4b* p = Pixels; Pixels = nullptr; return p; } else return Pixels; }
+	// Either way, if the pixels were shared with another frame you get a copy that is only yours or only this frame's.
+	tPixel4b* GetPixels(bool steal = false)																				{ if (steal) return PixelShare.Steal(Pixels, Width*Height); Unshare(); return Pixels; }
+
+	void SetPixel(int x, int y, const tPixel4b& c)																		{ Unshare(); Pixels[ GetIndex(x, y) ] = c; }
 
-	void SetPixel(int x, int y, const tPixel4b& c)																		{ Pixels[ GetIndex(x, y) ] = c; }
+	// If the pixels are shared with another frame this gives this frame its own copy.
+	void Unshare()																										{ PixelShare.Unshare(Pixels, Width*Height); }
+	bool IsShared() const																								{ return PixelShare.IsShared(); }
 
 	void Clear();
 	bool IsValid() const																								{ return (Width > 0) && (Height > 0) && Pixels; }
@@ -59,6 +69,7 @@ struct tFrame : public tLink<tFrame>
 	float Duration					/* Frame duration in seconds. */			= 0.0f;
 	tPixelFormat PixelFormatSrc		/* Use of PixelFormatSrc is optional. */	= tPixelFormat::Invalid;
 	tPixel4b* Pixels															= nullptr;
+	tPixelShare PixelShare;
 
 private:
 	int GetIndex(int x, int y) const																					{ tAssert((x >= 0) && (y >= 0) && (x < Width) && (y < Height)); return y * Width + x; }
@@ -89,6 +100,24 @@ inline bool tFrame::Set(const tFrame& frame)
 }
 
 
+inline bool tFrame::Share(const tFrame& frame)
+{
+	if (&frame == this)
+		return frame.IsValid();
+
+	Clear();
+	if (!frame.IsValid())
+		return false;
+
+	Width			= frame.Width;
+	Height			= frame.Height;
+	Duration		= frame.Duration;
+	PixelFormatSrc	= frame.PixelFormatSrc;
+	PixelShare.Share(Pixels, frame.Pixels, frame.PixelShare);
+	return true;
+}
+
+
 inline bool tFrame::Set(const tPixel4b* srcPixels, int width, int height, float duration)
 {
 	Clear();
@@ -112,12 +141,14 @@ inline bool tFrame::StealFrom(tFrame& frame)
 	if ((&frame == this) || !frame.IsValid())
 		return false;
 
+	PixelShare.Release(Pixels);
 	Width			= frame.Width;
 	Height			= frame.Height;
 	Duration		= frame.Duration;
 	PixelFormatSrc	= frame.PixelFormatSrc;
 	Pixels			= frame.Pixels;
 	frame.Pixels	= nullptr;		// Frame is left invalid.
+	PixelShare.TakeFrom(frame.PixelShare);
 	return true;
 }
 
@@ -127,6 +158,7 @@ inline bool tFrame::StealFrom(tPixel4b* src, int width, int height, float durati
 	if (!src || (width <= 0) || (height <= 0))
 		return false;
 
+	PixelShare.Release(Pixels);
 	Width			= width;
 	Height			= height;
 	Duration		= duration;
@@ -140,8 +172,7 @@ inline void tFrame::Clear()
 {
 	Width = 0;
 	Height = 0;
-	delete[] Pixels;
-	Pixels = nullptr;
+	PixelShare.Release(Pixels);
 	Duration = 0.0f;
 	PixelFormatSrc = tPixelFormat::Invalid;
 }
@@ -150,14 +181,14 @@ inline void tFrame::Clear()
 inline void tFrame::ReverseRows()
 {
 	int numPixels = Width * Height;
-	tPixel4b* origPixels = Pixels;
-	Pixels = new tPixel4b[numPixels];
+	tPixel4b* newPixels = new tPixel4b[numPixels];
 
 	int bytesPerRow = Width*sizeof(tPixel4b);
 	for (int y = Height-1; y >= 0; y--)
-		tStd::tMemcpy((uint8*)Pixels + ((Height-1)-y)*bytesPerRow, (uint8*)origPixels + y*bytesPerRow, bytesPerRow);
+		tStd::tMemcpy((uint8*)newPixels + ((Height-1)-y)*bytesPerRow, (uint8*)Pixels + y*bytesPerRow, bytesPerRow);
 
-	delete[] origPixels;
+	PixelShare.Release(Pixels);
+	Pixels = newPixels;
 }
 
 
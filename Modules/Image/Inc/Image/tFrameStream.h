@@ -0,0 +1,81 @@
+// tFrameStream.h
+//
+// Lazy access to the frames of animated gif, apng, and webp files. Opening a stream only indexes where the data for
+// each frame is. Frames are decoded when they are asked for into a small ring of reusable buffers, and the frames
+// after the one asked for are decoded ahead of time on worker threads. Use this instead of tImageGIF, tImageAPNG, or
+// tImageWEBP when you do not need every frame in memory at once, like showing the first frame of a long animation.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tString.h>
+#include <System/tFile.h>
+#include <Image/tPixelFormat.h>
+#include <Image/tFrame.h>
+namespace tFrameStreamInternal { struct Stream; }
+namespace tImage
+{
+
+
+class tFrameStream
+{
+public:
+	struct Params
+	{
+		Params()																										{ Reset(); }
+		void Reset()																									{ RingSize = 4; NumPrefetch = 4; NumThreads = 0; }
+
+		int RingSize;				// Number of finished frames kept. Asking for one of these again costs nothing. Min 1.
+		int NumPrefetch;			// Frames after the one asked for that get decoded ahead of time. 0 = none.
+		int NumThreads;				// Worker threads doing the prefetch. 0 = number of cores. Never more than NumPrefetch.
+	};
+
+	tFrameStream()																										{ }
+	tFrameStream(const tString& file, const Params& params = Params())													{ Open(file, params); }
+	virtual ~tFrameStream()																								{ Close(); }
+
+	// Supports gif, webp, and apng files. Apng files may have a png extension and a png without animation chunks is
+	// treated as a single frame. The file is read into memory (compressed) and the frames are indexed, but no frames are
+	// decoded. Returns false if the file could not be read or indexed.
+	bool Open(const tString& file, const Params& = Params());
+
+	// Same as above but from a file already in memory. The memory is copied so you can free it after.
+	bool Open(const uint8* fileInMemory, int numBytes, tSystem::tFileType, const Params& = Params());
+
+	// Stops the worker threads and frees everything. Called by the destructor.
+	void Close();
+	bool IsValid() const																								{ return Stream != nullptr; }
+
+	int GetWidth() const																								{ return Width; }
+	int GetHeight() const																								{ return Height; }
+	int GetNumFrames() const																							{ return NumFrames; }
+
+	// In seconds. Known without decoding the frame. Returns 0.0f if frameNum is out of range.
+	float GetFrameDuration(int frameNum) const;
+
+	// Returns the Width*Height pixels of a frame with the bottom row first, same as a tFrame. The pixels are not yours
+	// to delete and are only valid until the next GetPixels or GetFrame call. Each frame is drawn on top of the ones
+	// before it, so asking for frames in order is fastest. Asking for a frame before the last one (that is not still in
+	// the ring) draws from the first frame again. Returns nullptr if frameNum is out of range or the stream is invalid.
+	const tPixel4b* GetPixels(int frameNum);
+
+	// Same as GetPixels but returns a new frame with a copy of the pixels and the duration. You must delete it.
+	tFrame* GetFrame(int frameNum);
+
+private:
+	tFrameStreamInternal::Stream* Stream = nullptr;
+	int Width					= 0;
+	int Height					= 0;
+	int NumFrames				= 0;
+};
+
+
+}
@@ -87,12 +87,20 @@ public:
 	// OverrideframeDuration is in 1/100 seconds. Set to >= 0 to override all frames. Note that values of 0 or 1 get
 	// min-clamped to 2 during save since many viewers do not handle values below 2 properly. If OverrideFrameDuration
 	// is < 0, the individual frames' duration is used after being converted from seconds to 1/100th of seconds.
+	//
+	// Stream saves one frame at a time instead of quantizing a single image made of every frame. The extra memory is
+	// bounded by a small batch of frames rather than growing with the frame count, so use it for long animations. Frames
+	// are quantized on NumThreads threads (0 = one per core) and written in order. Only the part of each frame that
+	// changed is written. If LocalPalettes is false all frames share one palette made from (at most) about a million
+	// pixels sampled evenly from all the frames, and frames are mapped onto it without dithering unless the sample was
+	// every pixel. If LocalPalettes is true every frame gets its own palette from Method (dithering included). This
+	// looks better but makes a bigger file. LocalPalettes and NumThreads only apply when Stream is true.
 	struct SaveParams
 	{
 		SaveParams()																									{ Reset(); }
-		SaveParams(const SaveParams& src)																				: Format(src.Format), Method(src.Method), Loop(src.Loop), AlphaThreshold(src.AlphaThreshold), OverrideFrameDuration(src.OverrideFrameDuration), DitherLevel(src.DitherLevel), FilterSize(src.FilterSize), SampleFactor(src.SampleFactor) { }
-		void Reset()																									{ Format = tPixelFormat::PAL8BIT; Method = tQuantize::Method::Wu; Loop = 0; AlphaThreshold = -1; OverrideFrameDuration = -1; DitherLevel = 0.0; FilterSize = 3; SampleFactor = 1; }
-		SaveParams& operator=(const SaveParams& src)																	{ Format = src.Format; Method = src.Method; Loop = src.Loop; AlphaThreshold = src.AlphaThreshold; OverrideFrameDuration = src.OverrideFrameDuration; DitherLevel = src.DitherLevel; FilterSize = src.FilterSize; SampleFactor = src.SampleFactor; return *this; }
+		SaveParams(const SaveParams& src)																				: Format(src.Format), Method(src.Method), Loop(src.Loop), AlphaThreshold(src.AlphaThreshold), OverrideFrameDuration(src.OverrideFrameDuration), DitherLevel(src.DitherLevel), FilterSize(src.FilterSize), SampleFactor(src.SampleFactor), Stream(src.Stream), LocalPalettes(src.LocalPalettes), NumThreads(src.NumThreads) { }
+		void Reset()																									{ Format = tPixelFormat::PAL8BIT; Method = tQuantize::Method::Wu; Loop = 0; AlphaThreshold = -1; OverrideFrameDuration = -1; DitherLevel = 0.0; FilterSize = 3; SampleFactor = 1; Stream = false; LocalPalettes = false; NumThreads = 0; }
+		SaveParams& operator=(const SaveParams& src)																	{ Format = src.Format; Method = src.Method; Loop = src.Loop; AlphaThreshold = src.AlphaThreshold; OverrideFrameDuration = src.OverrideFrameDuration; DitherLevel = src.DitherLevel; FilterSize = src.FilterSize; SampleFactor = src.SampleFactor; Stream = src.Stream; LocalPalettes = src.LocalPalettes; NumThreads = src.NumThreads; return *this; }
 
 		tPixelFormat Format;		// See comment above. Must be one of the PALNBIT formats wher N is E [1, 8].
 		tQuantize::Method Method;	// See comment above. Choose one of the 4 available colour quantization methods.
@@ -104,6 +112,10 @@ public:
 		int FilterSize;				// For Method::Spatial only. Must be 1, 3, or 5. Default is 3.
 
 		int SampleFactor;			// For Method::Neu only. 1 = whole image learning. 10 = 1/10th image used. Max is 30.
+
+		bool Stream;				// See comment above. Save frame by frame with bounded memory. Default false.
+		bool LocalPalettes;			// For Stream only. Each frame gets its own palette. Default false (one palette).
+		int NumThreads;				// For Stream only. Frames quantized at the same time. 0 = number of cores.
 	};
 
 	bool Save(const tString& gifFile, const SaveParams& = SaveParams()) const;
@@ -132,6 +144,9 @@ private:
 	static void FrameLoadCallbackBridge(void* imgGifRaw, struct GIF_WHDR*);
 	void FrameLoadCallback(struct GIF_WHDR*);
 
+	// Does the work for Save when SaveParams::Stream is set. The params have already been validated.
+	bool SaveStream(const tString& gifFile, const SaveParams&, int loop) const;
+
 	// Variables used during load callback processing.
 	int FrmLast					= 0;
 	tPixel4b* FrmPict			= nullptr;
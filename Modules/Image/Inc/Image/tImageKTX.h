@@ -1,7 +1,8 @@
 // tImageKTX.h
 //
 // This knows how to load/save KTX and KTX2 files. It knows the details of the ktx and ktx2 file format and loads the
-// data into multiple layers.
+// data into multiple layers. There is also a KTX2 writer that streams mipmap levels to disk as they are made, and a
+// KTX2 reader that only reads the levels you ask for.
 //
 // Copyright (c) 2022-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -242,4 +243,103 @@ public:
 };
 
 
+class tTexture;
+namespace tKTX { struct Writer; struct Reader; }
+
+
+// Writes a KTX2 file one mipmap level at a time so the whole mip chain never needs to be in memory. Levels may be
+// added in any order and from any thread as they are produced. Uncompressed levels go to disk as soon as they are
+// added. With Zstandard supercompression on, each level is compressed on a pool of worker threads and written once
+// it is done. The KTX2 spec wants the smallest level first in the file, so a compressed level waits (compressed) until
+// all smaller ones have been written. Cubemaps, arrays, and 3D textures are not supported.
+class tKTX2Writer
+{
+public:
+	struct Params
+	{
+		Params()																										{ Reset(); }
+		void Reset()																									{ Profile = tColourProfile::sRGB; ReverseRowOrder = true; Supercompress = false; ZstdLevel = 3; NumThreads = 0; }
+
+		tColourProfile Profile;		// Picks the SRGB VkFormat if there is one for the pixel format. Otherwise UNORM.
+		bool ReverseRowOrder;		// Set if the data has the bottom row first like tLayers. KTX2 is top row first.
+		bool Supercompress;			// Zstandard supercompress every level.
+		int ZstdLevel;				// 1 (fastest) to 22 (smallest).
+		int NumThreads;				// Worker threads compressing levels. 0 = number of cores. Never more than the levels.
+	};
+
+	tKTX2Writer()																										{ }
+	virtual ~tKTX2Writer()																								{ Close(); }
+
+	// Creates the file and writes everything except the level data and level index. The pixel format must have a
+	// VkFormat. Most packed, float, BC, ETC, EAC, PVR, and ASTC formats do. Returns false if the file could not be
+	// created or the format or dimensions are not supported.
+	bool Open(const tString& file, tPixelFormat, int width, int height, int numLevels, const Params& = Params());
+
+	// Adds the data for a level. Level 0 is the full size image. numBytes must be the exact size of the level. You keep
+	// ownership of the data and may free it as soon as this returns. Thread-safe. Returns false if the level was
+	// already added, is the wrong size, or could not be written.
+	bool AddLevel(int level, const uint8* data, int numBytes);
+	bool AddLevel(int level, const tLayer&);
+
+	// Waits for compression to finish and writes the level index. Called by the destructor. If not every level was
+	// added, or anything failed to write, the file is deleted and false is returned.
+	bool Close();
+	bool IsOpen() const																									{ return Writer != nullptr; }
+
+	// Write a whole mip chain in one go. The first layer is level 0. Each layer is added as it is reached.
+	static bool Write(const tString& file, const tList<tLayer>&, const Params& = Params());
+	static bool Write(const tString& file, const tTexture&, const Params& = Params());
+
+private:
+	tKTX::Writer* Writer = nullptr;
+};
+
+
+// Reads KTX2 files one level at a time. Opening only reads the header and level index. The file stays open and a level
+// is only read (and decompressed if it was supercompressed) when it is asked for. Supports files with no
+// supercompression or Zstandard supercompression. Cubemaps may be read a face at a time. Arrays and 3D textures are
+// not supported.
+class tKTX2Reader
+{
+public:
+	tKTX2Reader()																										{ }
+	tKTX2Reader(const tString& file)																					{ Open(file); }
+	virtual ~tKTX2Reader()																								{ Close(); }
+
+	// Returns false if the file could not be read, is not a KTX2 file, or uses something not supported.
+	bool Open(const tString& file);
+	void Close();
+	bool IsValid() const																								{ return Reader != nullptr; }
+
+	tPixelFormat GetPixelFormat() const																					{ return PixelFormat; }
+	tColourProfile GetColourProfile() const																				{ return ColourProfile; }
+	int GetWidth() const																								{ return Width; }
+	int GetHeight() const																								{ return Height; }
+	int GetNumLevels() const																							{ return NumLevels; }
+	int GetNumFaces() const																								{ return NumFaces; }
+	bool IsSupercompressed() const																						{ return Supercompressed; }
+
+	// From the KTXorientation key. True unless the file says otherwise.
+	bool IsTopRowFirst() const																							{ return TopRowFirst; }
+
+	// Reads a new layer for the level and face. You must delete it. Thread-safe, and the decompression of different
+	// levels happens in parallel if called from more than one thread. If reverseRowOrder is true and the file is top
+	// row first, the rows are reversed so the bottom row is first like other tLayers. Some formats (BC6, BC7, ASTC)
+	// cannot be reversed without decoding, so the rows are left as they are. rowsReversed, if supplied, tells you what
+	// happened. Returns nullptr if the level or face does not exist or could not be read.
+	tLayer* GetLevel(int level, int face = 0, bool reverseRowOrder = true, bool* rowsReversed = nullptr);
+
+private:
+	tKTX::Reader* Reader			= nullptr;
+	tPixelFormat PixelFormat		= tPixelFormat::Invalid;
+	tColourProfile ColourProfile	= tColourProfile::Unspecified;
+	int Width						= 0;
+	int Height						= 0;
+	int NumLevels					= 0;
+	int NumFaces					= 0;
+	bool Supercompressed			= false;
+	bool TopRowFirst				= true;
+};
+
+
 }
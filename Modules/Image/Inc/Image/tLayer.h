@@ -26,6 +26,7 @@
 #include <Foundation/tList.h>
 #include <System/tChunk.h>
 #include <Image/tPixelFormat.h>
+#include <Image/tPixelShare.h>
 namespace tImage
 {
 
@@ -53,6 +54,14 @@ public:
 	void Set(tPixelFormat format, int width, int height, uint8* data, bool steal = false);
 	void Set(const tLayer& layer);
 
+	// Like Set but if layer owns its data the two layers use the same data instead of copying it. Since Data is public
+	// this is opt-in: once two layers share, both must call Unshare before writing to Data. StealData calls it for you.
+	void Share(const tLayer& layer);
+
+	// If the data is shared with another layer this gives this layer its own copy.
+	void Unshare()																										{ if (OwnsData) DataShare.Unshare(Data, GetDataSize()); }
+	bool IsShared() const																								{ return DataShare.IsShared(); }
+
 	// Returns the size of the data in bytes by reading the Width, Height, and PixelFormat. For block-compressed format
 	// the data size will be a multiple of the block size in bytes. BC 4x4 blocks may be different sizes, whereas ASTC
 	// block size is always 16 bytes. eg. a 1x1 BC1 format layer still needs 8 bytes. A 5x5 BC1 format layer would need
@@ -66,12 +75,13 @@ public:
 	void Load(const tChunk&, bool ownData);
 
 	// Frees internal layer data and makes the layer invalid.
-	void Clear()																										{ PixelFormat = tPixelFormat::Invalid; Width = Height = 0; if (OwnsData) delete[] Data; Data = nullptr; OwnsData = true; }
+	void Clear()																										{ if (OwnsData) DataShare.Release(Data); PixelFormat = tPixelFormat::Invalid; Width = Height = 0; Data = nullptr; OwnsData = true; }
 
 	// This just checks the pixel format to see if it supports alpha. It does NOT check the data.
 	bool IsOpaqueFormat() const																							{ return tImage::tIsOpaqueFormat(PixelFormat); }
 
-	uint8* StealData()																									{ if (!OwnsData) return nullptr; OwnsData = false; return Data; }
+	// If the data was shared with another layer the returned data is a copy that is only yours.
+	uint8* StealData()																									{ if (!OwnsData) return nullptr; Unshare(); OwnsData = false; return Data; }
 
 	// An invalid layer is never considered equal to another layer even if the other layer is also invalid. Whether the
 	// layer owns the data is considered irrelevant for equivalency purposes.
@@ -88,6 +98,7 @@ public:
 	int Height					= 0;
 	uint8* Data					= nullptr;
 	bool OwnsData				= true;
+	tPixelShare DataShare;
 
 	// 4096 x 4096 is pretty much a minimum requirement these days. 16Kx16k has good support. 32kx32k exists.
 	const static int MaxLayerDimension = 32768;
@@ -128,6 +139,7 @@ inline void tLayer::Set(const tLayer& layer)
 	if (&layer == this)
 		return;
 
+	Clear();
 	PixelFormat		= layer.PixelFormat;
 	Width			= layer.Width;
 	Height			= layer.Height;
@@ -146,6 +158,24 @@ inline void tLayer::Set(const tLayer& layer)
 }
 
 
+inline void tLayer::Share(const tLayer& layer)
+{
+	if (&layer == this)
+		return;
+
+	Clear();
+	PixelFormat		= layer.PixelFormat;
+	Width			= layer.Width;
+	Height			= layer.Height;
+	OwnsData		= layer.OwnsData;
+
+	if (OwnsData)
+		DataShare.Share(Data, layer.Data, layer.DataShare);
+	else
+		Data = layer.Data;
+}
+
+
 inline int tLayer::GetDataSize() const
 {
 	if (!Width || !Height || (PixelFormat == tPixelFormat::Invalid))
@@ -9,7 +9,7 @@
 // page, and gif/webp images may be animated and have more than one frame. A tPicture can only prepresent _one_ of 
 // these frames.
 //
-// Copyright (c) 2006, 2016, 2017, 2020-2024 Tristan Grimmer.
+// Copyright (c) 2006, 2016, 2017, 2020-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -21,12 +21,14 @@
 
 #pragma once
 #include <Foundation/tList.h>
+#include <Foundation/tArray.h>
 #include <Foundation/tConstants.h>
 #include <Math/tColour.h>
 #include <System/tFile.h>
 #include <System/tChunk.h>
 #include "Image/tBaseImage.h"
 #include "Image/tPixelFormat.h"
+#include "Image/tPixelShare.h"
 #include "Image/tResample.h"
 #include "Image/tLayer.h"
 namespace tImage
@@ -102,7 +104,7 @@ public:
 	// guaranteed that image remains unmodified, but at the cost of duplicating memory for the pixels.
 	tPicture(tBaseImage& image, bool steal = true)																		{ Set(image, steal); }
 
-	// Copy constructor.
+	// Copy constructor. The pixels are shared with src until one of the two pictures is modified.
 	tPicture(const tPicture& src)																						: tPicture() { Set(src); }
 
 	virtual ~tPicture()																									{ Clear(); }
@@ -132,6 +134,7 @@ public:
 	// guaranteed that image remains unmodified, but at the cost of duplicating memory for the pixels.
 	void Set(tBaseImage& image, bool steal = true);
 
+	// Shares the pixels with src. Neither picture copies them until one of them is modified.
 	void Set(const tPicture& src);
 
 	// Save and Load to tChunk format.
@@ -142,19 +145,27 @@ public:
 	// buffer every time it is called.
 	bool IsOpaque() const;
 
-	// These functions allow reading and writing pixels.
-	tPixel4b& Pixel(int x, int y)																						{ return Pixels[ GetIndex(x, y) ]; }
-	tPixel4b* operator[](int i)						/* Syntax: image[y][x] = colour;  No bounds checking performed. */	{ return Pixels + GetIndex(0, i); }
+	// These functions allow reading and writing pixels. The pixels may be shared with a picture this one was copied
+	// from (or that was copied from this one). The non-const accessors unshare so the returned pointers are safe to
+	// write through. Use the const versions to read without copying. StealPixels always returns an unshared buffer.
+	tPixel4b& Pixel(int x, int y)																						{ Unshare(); return Pixels[ GetIndex(x, y) ]; }
+	tPixel4b* operator[](int i)						/* Syntax: image[y][x] = colour;  No bounds checking performed. */	{ Unshare(); return Pixels + GetIndex(0, i); }
 	tPixel4b GetPixel(int x, int y) const																				{ return Pixels[ GetIndex(x, y) ]; }
-	tPixel4b* GetPixelPointer(int x = 0, int y = 0) const																{ return &Pixels[ GetIndex(x, y) ]; }
-	tPixel4b* GetPixels() const																							{ return Pixels; }
-	tPixel4b* StealPixels()																								{ tPixel4b* p = Pixels; Pixels = nullptr; return p; }
-
-	void SetPixel(int x, int y, const tColour4b& c)																		{ Pixels[ GetIndex(x, y) ] = c; }
-	void SetPixel(int x, int y, uint8 r, uint8 g, uint8 b, uint8 a = 0xFF)												{ Pixels[ GetIndex(x, y) ] = tColour4b(r, g, b, a); }
+	const tPixel4b* GetPixelPointer(int x = 0, int y = 0) const															{ return &Pixels[ GetIndex(x, y) ]; }
+	tPixel4b* GetPixelPointer(int x = 0, int y = 0)																		{ Unshare(); return &Pixels[ GetIndex(x, y) ]; }
+	const tPixel4b* GetPixels() const																					{ return Pixels; }
+	tPixel4b* GetPixels()																								{ Unshare(); return Pixels; }
+	tPixel4b* StealPixels()																								{ return PixelShare.Steal(Pixels, Width*Height); }
+
+	void SetPixel(int x, int y, const tColour4b& c)																		{ Unshare(); Pixels[ GetIndex(x, y) ] = c; }
+	void SetPixel(int x, int y, uint8 r, uint8 g, uint8 b, uint8 a = 0xFF)												{ Unshare(); Pixels[ GetIndex(x, y) ] = tColour4b(r, g, b, a); }
 	void SetPixel(int x, int y, const tColour4b& c, comp_t channels);
 	void SetAll(const tColour4b& = tColour4b(0, 0, 0), comp_t channels = tCompBit_RGBA);
 
+	// Gives this picture its own copy of the pixels if they are shared. All the modifying functions call this for you.
+	void Unshare()																										{ PixelShare.Unshare(Pixels, Width*Height); }
+	bool IsShared() const																								{ return PixelShare.IsShared(); }
+
 	// Spreads the specified single channel to all RGB channels. If channel is R, G, or B, it spreads to the remainder
 	// of RGB (e.g. R will spread to GB). If channel is alpha, spreads to RGB.
 	void Spread(tComp channel = tComp::R);
@@ -191,7 +202,8 @@ public:
 	// Rotates image about center point. The resultant image size is always big enough to hold every source pixel. Call
 	// one or more of the crop functions after if you need to change the canvas size or remove transparent sides. The
 	// rotate algorithm first upscales the image x4, rotates, then downscales. That is what upFilter and downFilter are
-	// for. If you want to rotate pixel-art (nearest neighbour, no up/dowuse upFilter = none.
+	// for. If you want to rotate pixel-art (nearest neighbour, no up/dowuse upFilter = none. See RotateCenterDirect for
+	// a smooth rotate that does not need the large intermediate image.
 	//
 	// UpFilter		DownFilter		Description
 	// None			NA				No up/down scaling. Preserves colours. Nearest Neighbour. Fast. Good for pixel art.
@@ -205,6 +217,18 @@ public:
 		tResampleFilter	downFilter	= tResampleFilter::None
 	);
 
+	// Same result size as RotateCenter with no up-filter, but each new pixel is mapped back into the original image and
+	// sampled with the filter kernel directly. There is no x4 upscale so only the new image is allocated, which matters
+	// for large images. Rows are processed on numThreads threads (0 = number of cores). Nearest gives the same pixels
+	// as RotateCenter with no up-filter. Box and Bilinear are the same here.
+	void RotateCenterDirect
+	(
+		float angle,
+		const tPixel4b& fill		= tPixel4b::transparent,
+		tResampleFilter filter		= tResampleFilter::Bilinear,
+		int numThreads				= 0
+	);
+
 	void Flip(bool horizontal);
 
 	enum class Anchor
@@ -315,6 +339,62 @@ public:
 		tResampleFilter filter = tResampleFilter::Bilinear, tResampleEdgeMode edgeMode = tResampleEdgeMode::Clamp
 	)																													{ return Resample(width, height, filter, edgeMode); }
 
+	// A list of operations that is recorded now and run later on any number of pictures with Apply. The operations
+	// give the same pixels as the tPicture functions of the same name called in the same order.
+	class OpChain
+	{
+	public:
+		OpChain()																										{ }
+		void Clear()																									{ Ops.Clear(); }
+		int GetNumOps() const																							{ return Ops.GetNumElements(); }
+
+		OpChain& Flip(bool horizontal);
+		OpChain& Rotate90(bool antiClockwise);
+		OpChain& Crop(int newWidth, int newHeight, Anchor = Anchor::MiddleMiddle, const tColour4b& fill = tColour4b::transparent);
+		OpChain& Crop(int newWidth, int newHeight, int originX, int originY, const tColour4b& fill = tColour4b::transparent);
+		OpChain& Resample
+		(
+			int width, int height,
+			tResampleFilter = tResampleFilter::Bilinear, tResampleEdgeMode = tResampleEdgeMode::Clamp
+		);
+		OpChain& Swizzle(tComp = tComp::R, tComp = tComp::G, tComp = tComp::B, tComp = tComp::A);
+		OpChain& Spread(tComp channel = tComp::R);
+		OpChain& Intensity(comp_t channels = tCompBit_RGB);
+		OpChain& AlphaBlendColour(const tColour4b& blendColour, comp_t = tCompBit_RGB, int finalAlpha = 255);
+
+	private:
+		friend class tPicture;
+		enum class OpType { Flip, Rotate90, Crop, CropAnchor, Resample, Swizzle, Spread, Intensity, AlphaBlendColour };
+		struct Op
+		{
+			OpType Type					= OpType::Flip;
+			bool Flag					= false;					// Horizontal for Flip. AntiClockwise for Rotate90.
+			int Width					= 0;						// Crop and Resample.
+			int Height					= 0;
+			int OriginX					= 0;						// Crop.
+			int OriginY					= 0;
+			Anchor CropAnchor			= Anchor::MiddleMiddle;
+			tColour4b Colour			= tColour4b::transparent;	// Crop fill or blend colour.
+			tComp Comps[4]				= { tComp::R, tComp::G, tComp::B, tComp::A };
+			comp_t Channels				= tCompBit_RGB;
+			int FinalAlpha				= 255;
+			tResampleFilter Filter		= tResampleFilter::Bilinear;
+			tResampleEdgeMode EdgeMode	= tResampleEdgeMode::Clamp;
+		};
+		Op& Add(OpType);
+		tArray<Op> Ops;
+	};
+
+	// Runs the operations in the chain. Rather than making a pass over every pixel for each operation, the flips,
+	// 90 degree rotates, and crops are combined into a single mapping from each new pixel back to the pixel it came
+	// from, and the colour operations are run on each pixel straight after it is fetched. The new image is filled in
+	// 64x64 tiles shared between numThreads threads and only the new image is allocated. If numThreads is 0 it uses up
+	// to the number of cores, fewer for small images, otherwise it uses numThreads (at most one per tile). A
+	// Resample needs the whole image before it, so it splits the chain in two and each side is fused on its own.
+	// Unlike the single functions, the filename and source pixel format are kept. Returns false and leaves the picture
+	// unmodified if it is invalid, a crop or resample size is not positive, or a resample fails.
+	bool Apply(const OpChain&, int numThreads = 0);
+
 	// A convenience. This is sort of light tTexture functionality -- generate layers that may be passed off to HW.
 	// Unlike tTexture that compresses to a BC format, this function always uses R8G8B8A8 pixel format and does not
 	// require power-of-2 dimensions. If generating mipmap layers, each layer is half (truncated) in width and height
@@ -329,6 +409,30 @@ public:
 		tResampleEdgeMode edgeMode = tResampleEdgeMode::Clamp,
 		bool chainGeneration = true
 	);
+
+	// Makes the same layers as GenerateLayers but filters in linear space, so mipmaps of sRGB images don't get darker.
+	// The RGB components are converted to linear float once and every mipmap level is filtered straight from that with
+	// the kernel widened to the level's scale. Levels are split into bands of rows that are done on numThreads threads
+	// (0 = number of cores), then converted back to sRGB with a lookup table. Alpha is filtered as is. With the Nearest
+	// filter each pixel is point sampled and with Box the covered source pixels are averaged. If filter is None only
+	// the full size layer is appended. Returns number of appended layers.
+	int GenerateLayersLinear
+	(
+		tList<tLayer>&, tResampleFilter filter = tResampleFilter::Lanczos_Narrow,
+		tResampleEdgeMode edgeMode = tResampleEdgeMode::Clamp,
+		int numThreads = 0
+	);
+
+	// Same as above for a number of pictures at once, like the six faces of a cubemap. All levels of all pictures are
+	// shared between the threads. Layers for pictures[p] are appended to layers[p]. Null or invalid pictures get no
+	// layers. Returns total number of appended layers.
+	static int GenerateLayersLinear
+	(
+		tList<tLayer>* layers, tPicture** pictures, int numPictures,
+		tResampleFilter filter = tResampleFilter::Lanczos_Narrow,
+		tResampleEdgeMode edgeMode = tResampleEdgeMode::Clamp,
+		int numThreads = 0
+	);
 	bool operator==(const tPicture&) const;
 	bool operator!=(const tPicture&) const;
 
@@ -354,6 +458,11 @@ private:
 	int GetIndex(int x, int y) const																					{ tAssert((x >= 0) && (y >= 0) && (x < Width) && (y < Height)); return y * Width + x; }
 	static int GetIndex(int x, int y, int w, int h)																		{ tAssert((x >= 0) && (y >= 0) && (x < w) && (y < h)); return y * w + x; }
 
+	// Writes lut[original] into the adjustment buffer for the components in comps. Runs on multiple threads.
+	void AdjustApplyLUT(const uint8 lut[NumGroups], comp_t comps);
+
+	// Size needed to hold every pixel of the current image after rotating it by rotMat.
+	void GetRotatedSize(const tMath::tMatrix2& rotMat, int& newW, int& newH) const;
 	void RotateCenterNearest(const tMath::tMatrix2& rotMat, const tMath::tMatrix2& invRot, const tPixel4b& fill);
 	void RotateCenterResampled
 	(
@@ -372,6 +481,7 @@ private:
 	int Height				= 0;
 	tPixel4b* Pixels			= nullptr;
 	tPixel4b* OriginalPixels	= nullptr;
+	tPixelShare PixelShare;
 };
 
 
@@ -381,8 +491,7 @@ private:
 inline void tPicture::Clear()
 {
 	Filename.Clear();
-	delete[] Pixels;
-	Pixels = nullptr;
+	PixelShare.Release(Pixels);
 	delete[] OriginalPixels;
 	OriginalPixels = nullptr;
 	Width = 0;
@@ -396,11 +505,12 @@ inline void tPicture::Set(int width, int height, const tPixel4b& colour)
 	tAssert((width > 0) && (height > 0));
 
 	// Reuse the existing buffer if possible.
-	if (width*height != Width*Height)
+	if ((width*height != Width*Height) || !Pixels || PixelShare.IsShared())
 	{
-		delete[] Pixels;
+		PixelShare.Release(Pixels);
 		Pixels = new tPixel4b[width*height];
 	}
+	PixelShare.Unshare(Pixels, width*height);
 	Width = width;
 	Height = height;
 	for (int pixel = 0; pixel < (Width*Height); pixel++)
@@ -418,15 +528,16 @@ inline void tPicture::Set(int width, int height, tPixel4b* pixelBuffer, bool cop
 	// copying and the buffer is being handed to us, we just need to free our current buffer.
 	if (copyPixels)
 	{
-		if ((width*height != Width*Height) || !Pixels)
+		if ((width*height != Width*Height) || !Pixels || PixelShare.IsShared())
 		{
-			delete[] Pixels;
+			PixelShare.Release(Pixels);
 			Pixels = new tPixel4b[width*height];
 		}
+		PixelShare.Unshare(Pixels, width*height);
 	}
 	else
 	{
-		delete[] Pixels;
+		PixelShare.Release(Pixels);
 		Pixels = pixelBuffer;
 	}
 	Width = width;
@@ -470,7 +581,9 @@ inline void tPicture::Set(const tPicture& src)
 	if (!src.IsValid())
 		return;
 
-	Set(src.Width, src.Height, src.Pixels);
+	PixelShare.Share(Pixels, src.Pixels, src.PixelShare);
+	Width = src.Width;
+	Height = src.Height;
 	Filename = src.Filename;
 	PixelFormatSrc = src.PixelFormatSrc;
 	Duration = src.Duration;
@@ -491,6 +604,7 @@ inline bool tPicture::IsOpaque() const
 
 inline void tPicture::SetPixel(int x, int y, const tColour4b& c, comp_t channels)
 {
+	Unshare();
 	tPixel4b& pixel = Pixels[ GetIndex(x, y) ];
 
 	if (channels & tCompBit_R) pixel.R = c.R;
@@ -505,6 +619,7 @@ inline void tPicture::SetAll(const tColour4b& clearColour, comp_t channels)
 	if (!Pixels)
 		return;
 
+	Unshare();
 	int numPixels = Width*Height;
 	if (channels == tCompBit_RGBA)
 	{
@@ -526,6 +641,7 @@ inline void tPicture::SetAll(const tColour4b& clearColour, comp_t channels)
 
 inline void tPicture::Spread(tComp channel)
 {
+	Unshare();
 	int numPixels = Width*Height;
 	for (int p = 0; p < numPixels; p++)
 	{
@@ -593,7 +709,7 @@ inline void tPicture::Swizzle(tComp R, tComp G, tComp B, tComp A)
 			))))));
 		dst.Set(r, g, b, a);
 	}
-	delete[] Pixels;
+	PixelShare.Release(Pixels);
 	Pixels = newPixels;
 }
 
@@ -603,6 +719,7 @@ inline void tPicture::Intensity(comp_t channels)
 	if (!channels)
 		return;
 
+	Unshare();
 	int numPixels = Width*Height;
 	for (int p = 0; p < numPixels; p++)
 	{
@@ -621,6 +738,7 @@ inline void tPicture::AlphaBlendColour(const tColour4b& blend, comp_t channels,
 	if (!Pixels)
 		return;
 
+	Unshare();
 	tMath::tiClamp(finalAlpha, -1, 255);
 	int numPixels = Width*Height;
 	for (int p = 0; p < numPixels; p++)
@@ -0,0 +1,131 @@
+// tPixelShare.h
+//
+// Lets tPictures that were copied from one another use the same pixel array until one of them writes to it. The array
+// stays an ordinary new[] array so the Steal functions keep working. Each holder keeps a tPixelShare next to its array
+// pointer. It is empty until the array is first shared, after which every holder of the array points to the same
+// count. A holder calls Unshare before writing and gets its own copy if others still use it. tFrame and tLayer copies
+// don't share because their pixel pointers are public and could be written through without unsharing. They only
+// share when asked to with their Share functions.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <atomic>
+#include <Foundation/tStandard.h>
+namespace tImage
+{
+
+
+class tPixelShare
+{
+public:
+	tPixelShare()																										{ }
+	tPixelShare(const tPixelShare&)																						= delete;
+	tPixelShare& operator=(const tPixelShare&)																			= delete;
+
+	// Makes array use srcArray, which is held with src. Whatever array held before must already have been released.
+	// Sharing from the same src on more than one thread at once is fine.
+	template<typename T> void Share(T*& array, T* srcArray, const tPixelShare& src);
+
+	// Stops using array. It is deleted if nothing else uses it. Array is null after.
+	template<typename T> void Release(T*& array);
+
+	// Call before writing to array. If anything else uses it, array is replaced by a copy of numItems that is only ours.
+	template<typename T> void Unshare(T*& array, int numItems);
+
+	// Hands array to the caller who must delete[] it. If anything else uses it the caller gets a copy of numItems
+	// instead. Array is null after.
+	template<typename T> T* Steal(T*& array, int numItems);
+
+	// For when the array itself moves to us from src, like a StealFrom. Whatever we held must already have been
+	// released. src is left empty.
+	void TakeFrom(tPixelShare& src)																						{ Count = src.Count.exchange(nullptr); }
+
+	bool IsShared() const																								{ std::atomic<int>* count = Count; return count && (*count > 1); }
+
+private:
+	// Number of holders. Null means we are the only one.
+	mutable std::atomic<std::atomic<int>*> Count = nullptr;
+};
+
+
+// Implementation below this line.
+
+
+template<typename T> inline void tPixelShare::Share(T*& array, T* srcArray, const tPixelShare& src)
+{
+	tAssert(!Count);
+	array = srcArray;
+	if (!srcArray)
+		return;
+
+	// The first share makes the count. If another thread made it first we use theirs.
+	std::atomic<int>* count = src.Count;
+	if (!count)
+	{
+		std::atomic<int>* made = new std::atomic<int>(1);
+		if (src.Count.compare_exchange_strong(count, made))
+			count = made;
+		else
+			delete made;
+	}
+	(*count)++;
+	Count = count;
+}
+
+
+template<typename T> inline void tPixelShare::Release(T*& array)
+{
+	std::atomic<int>* count = Count.exchange(nullptr);
+	if (!count || (--(*count) == 0))
+	{
+		delete count;
+		delete[] array;
+	}
+	array = nullptr;
+}
+
+
+template<typename T> inline void tPixelShare::Unshare(T*& array, int numItems)
+{
+	std::atomic<int>* count = Count;
+	if (!count)
+		return;
+
+	// Nothing can start sharing from us while we are being written, so if we are the only holder we stay that way.
+	if (*count == 1)
+	{
+		Count = nullptr;
+		delete count;
+		return;
+	}
+
+	T* copy = nullptr;
+	if (array && (numItems > 0))
+	{
+		copy = new T[numItems];
+		tStd::tMemcpy(copy, array, numItems*sizeof(T));
+	}
+	Release(array);
+	array = copy;
+}
+
+
+template<typename T> inline T* tPixelShare::Steal(T*& array, int numItems)
+{
+	Unshare(array, numItems);
+	T* stolen = array;
+	array = nullptr;
+	return stolen;
+}
+
+
+}
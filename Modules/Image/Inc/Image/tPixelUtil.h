@@ -2,7 +2,7 @@
 //
 // Helper functions for manipulating and parsing pixel-data in packed and compressed block formats.
 //
-// Copyright (c) 2022-2024 Tristan Grimmer.
+// Copyright (c) 2022-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -54,6 +54,17 @@ DecodeResult DecodePixelData_ASTC	(tPixelFormat, const uint8* data, int dataSize
 DecodeResult DecodePixelData_PVR	(tPixelFormat, const uint8* data, int dataSize, int w, int h, tColour4b*&, tColour4f*&);
 
 
+// Converts numPixels of packed pixel-data from one packed format straight to another. Nothing is decoded to tColour4b
+// or tColour4f first. Each channel is converted on its own from its type in srcFormat to its type in dstFormat, so the
+// half and small unsigned float formats convert to each other without going through a float. Channels that the source
+// does not have become 0, or 1 for alpha. Supported formats are the 8, 16, and 32 bit unsigned formats, the 16 bit
+// packed formats like G3B5R5G3, A8, L8, and all the half and float formats including R11G11B10uf and B10G11R11uf. The
+// shared-exponent formats, RGBM and RGBD, and A8L8 are not. dst must have room for numPixels in dstFormat. Work is split
+// over numThreads threads (0 = number of cores) for big conversions. Returns false if either format is not supported.
+bool CanConvertPixelData_Packed(tPixelFormat srcFormat, tPixelFormat dstFormat);
+bool ConvertPixelData_Packed(tPixelFormat srcFormat, const uint8* src, tPixelFormat dstFormat, uint8* dst, int numPixels, int numThreads = 0);
+
+
 constexpr uint32 FourCC(uint8 ch0, uint8 ch1, uint8 ch2, uint8 ch3);
 
 
@@ -55,6 +55,16 @@ namespace tQuantize
 		tPixel4b* destPixels, int width, int height,
 		const tColour3b* srcPalette, const uint8* srcIndices, bool preserveDestAlpha = false
 	);
+
+	// Goes the other way. Each pixel gets the index of the closest colour in an existing palette using the red-mean
+	// colour difference. Alpha is ignored. This is what you want when the palette was made from different pixels, for
+	// example one palette shared by all the frames of an animation. destIndices should have space for width*height
+	// indices and numColours must be in [1, 256]. Returns true on success.
+	bool ConvertToIndices
+	(
+		uint8* destIndices, int width, int height,
+		const tColour3b* srcPalette, int numColours, const tPixel4b* srcPixels
+	);
 }
 
 
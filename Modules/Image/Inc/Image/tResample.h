@@ -2,7 +2,7 @@
 //
 // Resample an image using various filers like nearest-neighbour, box, bilinear, and various bicubics.
 //
-// Copyright (c) 2020, 2024 Tristan Grimmer.
+// Copyright (c) 2020, 2024, 2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -85,4 +85,27 @@ bool Resample
 );
 
 
+// The filter kernels as functions of distance in pixels, for resamplers that need their own weights. Outside of the
+// radius the weight is always zero. Nearest and Box are both a box of width 1 and Bilinear is a tent of radius 1. To
+// downscale, widen the kernel by the scale. Both functions return 0.0f for invalid filters.
+float GetKernelRadius(tResampleFilter);
+float GetKernelWeight(tResampleFilter, float x);
+
+
+// Rotates src anticlockwise by angle (radians) about its center and writes it centered in dst. Each dst pixel is mapped
+// back into src and sampled with the filter's 2D kernel, so no intermediate images are allocated. Kernel taps that land
+// outside src use the fill colour, which antialiases the edges. Box and Bilinear give the same result since there is
+// no scaling. Rows are processed in bands on numThreads threads. 0 means the number of cores. Nearest gives the same
+// pixels as tPicture::RotateCenter with no up-filter. Returns false if a filter other than a valid one is supplied.
+bool ResampleRotate
+(
+	const tPixel4b* src, int srcW, int srcH,
+	tPixel4b* dst, int dstW, int dstH,
+	float angle,
+	const tPixel4b& fill = tPixel4b::transparent,
+	tResampleFilter = tResampleFilter::Bilinear,
+	int numThreads = 0
+);
+
+
 }
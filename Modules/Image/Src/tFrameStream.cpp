@@ -0,0 +1,1151 @@
+// tFrameStream.cpp
+//
+// Lazy access to the frames of animated gif, apng, and webp files. Opening a stream only indexes where the data for
+// each frame is. Frames are decoded when they are asked for into a small ring of reusable buffers, and the frames
+// after the one asked for are decoded ahead of time on worker threads.
+//
+// Getting a frame has two parts. Decoding turns the frame's data into pixels without looking at any other frame. This
+// is the slow part (LZW, inflate, or VP8) and it is what the workers do. Composing draws the decoded pixels on a canvas
+// that holds the result of all the frames before it. That part is cheap but must be done in order, so it is done by
+// the thread asking for the frame. Both parts give the same pixels as tImageGIF, tImageAPNG, and tImageWEBP.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Foundation/tStandard.h>
+#include <Foundation/tArray.h>
+#include <Math/tColour.h>
+#include <System/tMachine.h>
+#include <GifLoad/gif_load.h>
+#include "png.h"
+#include "WebP/include/decode.h"
+#include "WebP/include/demux.h"
+#include "apngdis.h"
+#include "Image/tFrameStream.h"
+using namespace tImage;
+
+
+namespace tFrameStreamInternal
+{
+	// What a single frame decodes to. Pixels holds a W by H rectangle that goes at X, Y on the canvas.
+	struct Decoded
+	{
+		~Decoded()																										{ delete[] Pixels; }
+		void Reserve(int w, int h);
+
+		enum class tState
+		{
+			Free,
+			Queued,							// Waiting for a worker.
+			Busy,							// Being decoded or composed.
+			Ready							// Decoded and waiting to be composed.
+		};
+		tState State					= tState::Free;
+		int FrameNum					= -1;
+		bool Valid						= false;
+		tPixel4b* Pixels				= nullptr;
+		int Capacity					= 0;
+		int X = 0, Y = 0, W = 0, H = 0;
+
+		// Gif only. The disposal mode and the colour the frame's rectangle is cleared to.
+		long Mode						= GIF_NONE;
+		tPixel4b Fill;
+	};
+
+	// There is a source for each file type. Index and Decode only read the file data and the index, so Decode may be
+	// called from any thread. Restart and Compose use the canvas and are called in frame order from one thread.
+	class Source
+	{
+	public:
+		virtual ~Source()																								{ }
+
+		// The data must stay valid for the life of the source.
+		virtual bool Index(const uint8* data, int numBytes) = 0;
+		virtual void Decode(int frameNum, Decoded&) const = 0;
+
+		// Clears the canvas so the next frame composed is frame 0.
+		virtual void Restart() = 0;
+
+		// Draws the decoded frame on the canvas and writes the result to dest bottom row first. The decoded frame may be
+		// changed.
+		virtual void Compose(int frameNum, Decoded&, tPixel4b* dest) = 0;
+
+		int Width						= 0;
+		int Height						= 0;
+		tArray<float> Durations;
+	};
+
+	class SourceGIF : public Source
+	{
+	public:
+		~SourceGIF() override																							{ delete[] Pict; delete[] Prev; }
+		bool Index(const uint8* data, int numBytes) override;
+		void Decode(int frameNum, Decoded&) const override;
+		void Restart() override;
+		void Compose(int frameNum, Decoded&, tPixel4b* dest) override;
+
+	private:
+		// The graphics control extension is optional. GCEStart is -1 if there isn't one.
+		struct Entry { int GCEStart, GCESize, ImageStart, ImageSize; };
+		static void DecodeCallback(void* decodedRaw, struct GIF_WHDR*);
+
+		const uint8* Data				= nullptr;
+		int HeaderSize					= 0;			// The screen descriptor and the global palette.
+		tArray<Entry> Entries;
+
+		// The same canvas tImageGIF keeps while loading.
+		tPixel4b* Pict					= nullptr;
+		tPixel4b* Prev					= nullptr;
+		int FrmLast						= 0;
+	};
+
+	class SourceAPNG : public Source
+	{
+	public:
+		~SourceAPNG() override;
+		bool Index(const uint8* data, int numBytes) override;
+		void Decode(int frameNum, Decoded&) const override;
+		void Restart() override;
+		void Compose(int frameNum, Decoded&, tPixel4b* dest) override;
+
+	private:
+		// Start and Size cover the whole chunk including the length, type, and crc.
+		struct Chunk { int Start, Size; bool FrameData; };
+		struct Entry { int FirstChunk, NumChunks, X, Y, W, H; uint8 Dispose, Blend; };
+		bool DecodePNG(const Entry&, Decoded&) const;
+		static void InfoCallback(png_structp, png_infop);
+		static void RowCallback(png_structp, png_bytep newRow, png_uint_32 rowNum, int pass);
+
+		const uint8* Data				= nullptr;
+		int IHDRStart					= 0;
+		tArray<Chunk> Infos;							// Chunks like PLTE and tRNS that every frame needs.
+		tArray<Chunk> Chunks;							// The IDAT and fdAT chunks of all frames.
+		tArray<Entry> Entries;
+
+		// The same canvas apngdis keeps while loading. Rows go top to bottom.
+		uint8* Canvas					= nullptr;
+		uint8* Saved					= nullptr;
+		uint8** CanvasRows				= nullptr;
+		uint8** FrameRows				= nullptr;
+	};
+
+	class SourceWEBP : public Source
+	{
+	public:
+		~SourceWEBP() override																							{ delete[] Canvas; }
+		bool Index(const uint8* data, int numBytes) override;
+		void Decode(int frameNum, Decoded&) const override;
+		void Restart() override;
+		void Compose(int frameNum, Decoded&, tPixel4b* dest) override;
+
+	private:
+		// Bytes points into the file data.
+		struct Entry { const uint8* Bytes; int Size, X, Y, W, H; bool Dispose, Blend; };
+		tArray<Entry> Entries;
+
+		// The same canvas tImageWEBP keeps while loading. Rows go bottom to top.
+		tPixel4b* Canvas				= nullptr;
+	};
+
+	// Returns the position after the terminating empty sub-block or -1 if the data ends first.
+	int SkipSubBlocks(const uint8* data, int numBytes, int pos);
+
+	// Everything behind a tFrameStream.
+	struct Stream
+	{
+		~Stream();
+		const tPixel4b* GetPixels(int frameNum);
+
+		// Run by the worker threads.
+		void Work();
+
+		// Is frameNum one of the frames needed soon if from is the one being composed? The window wraps because
+		// looping back to the first frame is the common case at the end.
+		bool IsWanted(int frameNum, int from) const																		{ return ((frameNum - from + NumFrames) % NumFrames) <= NumPrefetch; }
+
+		// These all need the mutex held.
+		Decoded* FindSlot(int frameNum);
+		Decoded* FindSpare(int from);
+		Decoded* FindJob();
+
+		// Returns the decoded frame, waiting for a worker or decoding it on this thread. The slot stays busy until
+		// Release is called.
+		Decoded& Acquire(int frameNum);
+		void Release(Decoded&);
+		void Prefetch(int from);
+
+		uint8* FileData					= nullptr;
+		Source* Src						= nullptr;
+		int NumFrames					= 0;
+
+		// The finished frames. Frame f is in slot f % RingSize if RingFrame says so.
+		int RingSize					= 0;
+		tPixel4b** Ring					= nullptr;
+		int* RingFrame					= nullptr;
+		int NextCompose					= 0;
+
+		// Decoded frames shared with the workers.
+		int NumPrefetch					= 0;
+		int NumSlots					= 0;
+		Decoded* Slots					= nullptr;
+		int Current						= 0;			// Workers start with the queued frame nearest after this one.
+		std::mutex Mutex;
+		std::condition_variable WorkReady;
+		std::condition_variable WorkDone;
+		std::thread* Workers			= nullptr;
+		int NumWorkers					= 0;
+		bool Quit						= false;
+	};
+
+	// Takes ownership of data. Returns nullptr and deletes data if it could not be indexed.
+	Stream* CreateStream(uint8* data, int numBytes, tSystem::tFileType, const tFrameStream::Params&);
+}
+
+
+void tFrameStreamInternal::Decoded::Reserve(int w, int h)
+{
+	X = Y = 0;
+	W = w;
+	H = h;
+	if (w*h <= Capacity)
+		return;
+
+	delete[] Pixels;
+	Capacity = w*h;
+	Pixels = new tPixel4b[Capacity];
+}
+
+
+int tFrameStreamInternal::SkipSubBlocks(const uint8* data, int numBytes, int pos)
+{
+	while (pos < numBytes)
+	{
+		int size = data[pos++];
+		if (!size)
+			return pos;
+		pos += size;
+	}
+	return -1;
+}
+
+
+bool tFrameStreamInternal::SourceGIF::Index(const uint8* data, int numBytes)
+{
+	if ((numBytes < 13) || tStd::tMemcmp(data, "GIF8", 4))
+		return false;
+
+	Data = data;
+	Width = data[6] | (data[7] << 8);
+	Height = data[8] | (data[9] << 8);
+	HeaderSize = 13 + ((data[10] & 0x80) ? 3 * (2 << (data[10] & 0x07)) : 0);
+	if ((Width <= 0) || (Height <= 0) || (HeaderSize > numBytes))
+		return false;
+
+	// Sub-block chains are skipped using their sizes so none of the image data is decompressed.
+	int gceStart = -1;
+	int gceSize = 0;
+	int pos = HeaderSize;
+	while (pos < numBytes)
+	{
+		int start = pos;
+		if ((data[pos] == 0x21) && (pos+2 <= numBytes))
+		{
+			uint8 label = data[pos+1];
+			pos = SkipSubBlocks(data, numBytes, pos+2);
+			if (pos < 0)
+				break;
+
+			if (label == 0xF9)
+			{
+				gceStart = start;
+				gceSize = pos - start;
+			}
+		}
+		else if ((data[pos] == 0x2C) && (pos+11 <= numBytes))
+		{
+			uint8 flags = data[pos+9];
+			pos += 10 + ((flags & 0x80) ? 3 * (2 << (flags & 0x07)) : 0) + 1;
+			pos = SkipSubBlocks(data, numBytes, pos);
+			if (pos < 0)
+				break;
+
+			Entry entry = { gceStart, gceSize, start, pos-start };
+			Entries.Append(entry);
+
+			// Same as the duration tImageGIF gets from gif_load. The user-input flag makes the delay negative.
+			int time = 0;
+			if ((gceStart >= 0) && (gceSize >= 8))
+			{
+				time = data[gceStart+4] | (data[gceStart+5] << 8);
+				if (data[gceStart+3] & 0x02)
+					time = -time - 1;
+			}
+			Durations.Append(float(time) / 100.0f);
+			gceStart = -1;
+			gceSize = 0;
+		}
+		else
+		{
+			// The trailer or something unexpected.
+			break;
+		}
+	}
+
+	if (Entries.GetNumElements() <= 0)
+		return false;
+
+	Pict = new tPixel4b[Width*Height];
+	Prev = new tPixel4b[Width*Height];
+	Restart();
+	return true;
+}
+
+
+void tFrameStreamInternal::SourceGIF::Decode(int frameNum, Decoded& decoded) const
+{
+	// Make a gif with only this frame in it so gif_load decompresses just the one frame.
+	Entry entry = Entries[frameNum];
+	int gceSize = (entry.GCEStart >= 0) ? entry.GCESize : 0;
+	int size = HeaderSize + gceSize + entry.ImageSize + 1;
+	uint8* gif = new uint8[size];
+	tStd::tMemcpy(gif, Data, HeaderSize);
+	if (gceSize)
+		tStd::tMemcpy(gif + HeaderSize, Data + entry.GCEStart, gceSize);
+	tStd::tMemcpy(gif + HeaderSize + gceSize, Data + entry.ImageStart, entry.ImageSize);
+	gif[size-1] = 0x3B;
+
+	decoded.Valid = false;
+	decoded.Mode = GIF_NONE;
+	int paletteSize = 0;
+	GIF_Load((void*)gif, size, DecodeCallback, nullptr, (void*)&decoded, 0, paletteSize);
+	delete[] gif;
+}
+
+
+void tFrameStreamInternal::SourceGIF::DecodeCallback(void* decodedRaw, struct GIF_WHDR* whdr)
+{
+	Decoded& decoded = *((Decoded*)decodedRaw);
+	int w = int(whdr->frxd);
+	int h = int(whdr->fryd);
+	decoded.Reserve(w, h);
+	decoded.X = int(whdr->frxo);
+	decoded.Y = int(whdr->fryo);
+	decoded.Mode = whdr->mode;
+
+	// Same colours as tImageGIF. Transparent pixels are all zero and all other pixels are opaque, so the alpha alone
+	// says whether a pixel gets drawn.
+	auto colour = [whdr](uint8 index) -> tPixel4b
+	{
+		if (long(index) == whdr->tran)
+			return tPixel4b(uint8(0), uint8(0), uint8(0), uint8(0));
+		return tPixel4b(whdr->cpal[index].R, whdr->cpal[index].G, whdr->cpal[index].B, uint8(0xFF));
+	};
+	decoded.Fill = colour((whdr->tran >= 0) ? uint8(whdr->tran) : uint8(whdr->bkgd));
+
+	// Interlaced rows are put where they belong here so composing does not need to know.
+	uint32 iter = whdr->intr ? 0 : 4;
+	uint32 ifin = !iter ? 4 : 5;
+	for (uint32 dsrc = (uint32)-1; iter < ifin; iter++)
+		for (int yoff = 16U >> ((iter > 1) ? iter : 1), y = (8 >> iter) & 7; y < h; y += yoff)
+			for (int x = 0; x < w; x++)
+				decoded.Pixels[y*w + x] = colour(whdr->bptr[++dsrc]);
+
+	decoded.Valid = true;
+}
+
+
+void tFrameStreamInternal::SourceGIF::Restart()
+{
+	tStd::tMemset(Pict, 0, Width*Height*sizeof(tPixel4b));
+	tStd::tMemset(Prev, 0, Width*Height*sizeof(tPixel4b));
+	FrmLast = 0;
+}
+
+
+void tFrameStreamInternal::SourceGIF::Compose(int frameNum, Decoded& decoded, tPixel4b* dest)
+{
+	// This follows tImageGIF::FrameLoadCallback.
+	long xdim = Width;
+	long ydim = Height;
+	long frxd = decoded.W;
+	long fryd = decoded.H;
+	long mode = decoded.Mode;
+	uint32 ddst = uint32(xdim * decoded.Y + decoded.X);
+
+	if (decoded.Valid)
+	{
+		for (int y = 0; y < fryd; y++)
+		{
+			tPixel4b* src = decoded.Pixels + y*frxd;
+			for (int x = 0; x < frxd; x++)
+				if (src[x].A)
+					Pict[xdim * y + x + ddst] = src[x];
+		}
+	}
+
+	// We store rows starting from the bottom (lower left is 0,0).
+	for (int row = Height-1; row >= 0; row--)
+		tStd::tMemcpy(dest + (row*Width), Pict + ((Height-row-1)*Width), Width*sizeof(tPixel4b));
+
+	if ((mode == GIF_PREV) && !FrmLast)
+	{
+		frxd = xdim;
+		fryd = ydim;
+		mode = GIF_BKGD;
+		ddst = 0;
+	}
+	else
+	{
+		FrmLast = (mode == GIF_PREV) ? FrmLast : (frameNum + 1);
+		tPixel4b* pict = (mode == GIF_PREV) ? Pict : Prev;
+		tPixel4b* prev = (mode == GIF_PREV) ? Prev : Pict;
+		for (long x = xdim * ydim; --x;
+			pict[x - 1] = prev[x - 1]);
+	}
+
+	// Cutting a hole for the next frame.
+	if (mode == GIF_BKGD)
+		for (int y = 0; y < fryd; y++)
+			for (int x = 0; x < frxd; x++)
+				Pict[xdim * y + x + ddst] = decoded.Fill;
+}
+
+
+tFrameStreamInternal::SourceAPNG::~SourceAPNG()
+{
+	delete[] Canvas;
+	delete[] Saved;
+	delete[] CanvasRows;
+	delete[] FrameRows;
+}
+
+
+bool tFrameStreamInternal::SourceAPNG::Index(const uint8* data, int numBytes)
+{
+	const uint8 signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if ((numBytes < 8+25) || tStd::tMemcmp(data, signature, 8))
+		return false;
+
+	// Reads the chunk at pos. Same limits as apngdis.
+	Data = data;
+	int pos = 8;
+	auto readChunk = [&](int& start, int& size, const uint8*& type) -> bool
+	{
+		if (pos+12 > numBytes)
+			return false;
+		uint32 length = png_get_uint_32(data + pos);
+		if (length > 8000000)
+			return false;
+		start = pos;
+		size = int(length) + 12;
+		type = data + pos + 4;
+		if (pos+size > numBytes)
+			return false;
+		pos += size;
+		return true;
+	};
+	auto isType = [](const uint8* type, const char* name) -> bool														{ return !tStd::tMemcmp(type, name, 4); };
+	auto notABC = [](uint8 c) -> bool																					{ return (c < 65) || (c > 122) || ((c > 90) && (c < 97)); };
+
+	int start = 0, size = 0;
+	const uint8* type = nullptr;
+	if (!readChunk(start, size, type) || !isType(type, "IHDR") || (size != 25))
+		return false;
+
+	IHDRStart = start;
+	Width = int(png_get_uint_32(data + start + 8));
+	Height = int(png_get_uint_32(data + start + 12));
+	if ((Width <= 0) || (Width > 16384) || (Height <= 0) || (Height > 16384))
+		return false;
+
+	// This follows the chunk handling in load_apng so the frames and their blend and dispose ops come out the same.
+	// A frame is finished by the next fcTL or by IEND.
+	Entry entry = { 0, 0, 0, 0, Width, Height, 0, 0 };
+	int delayNum = 1;
+	int delayDen = 10;
+	bool hasInfo = false;
+	bool isAnimated = false;
+	bool skipFirst = false;
+	auto finishFrame = [&]()
+	{
+		Entries.Append(entry);
+
+		// Same as tImageAPNG. A denominator of 0 means 100 and a numerator of 0 means as fast as possible.
+		int den = delayDen ? delayDen : 100;
+		Durations.Append((delayNum == 0) ? 1.0f/60.0f : float(delayNum) / float(den));
+	};
+
+	while (readChunk(start, size, type))
+	{
+		if (isType(type, "acTL") && !hasInfo && !isAnimated)
+		{
+			isAnimated = true;
+			skipFirst = true;
+		}
+		else if (isType(type, "fcTL") && (!hasInfo || isAnimated))
+		{
+			if (size < 38)
+				break;
+			if (hasInfo)
+				finishFrame();
+
+			const uint8* fctl = data + start;
+			Entry next =
+			{
+				Chunks.GetNumElements(), 0,
+				int(png_get_uint_32(fctl + 20)), int(png_get_uint_32(fctl + 24)),
+				int(png_get_uint_32(fctl + 12)), int(png_get_uint_32(fctl + 16)),
+				fctl[32], fctl[33]
+			};
+			if
+			(
+				(next.W <= 0) || (next.W > 16384) || (next.H <= 0) || (next.H > 16384) ||
+				(next.X < 0) || (next.Y < 0) || (next.X + next.W > Width) || (next.Y + next.H > Height) ||
+				(next.Dispose > 2) || (next.Blend > 1)
+			)
+			{
+				// Whatever frame was in progress is dropped, same as apngdis.
+				entry.NumChunks = -1;
+				break;
+			}
+
+			entry = next;
+			delayNum = png_get_uint_16(fctl + 28);
+			delayDen = png_get_uint_16(fctl + 30);
+			if (!hasInfo)
+				skipFirst = false;
+
+			if (Entries.GetNumElements() == (skipFirst ? 1 : 0))
+			{
+				entry.Blend = 0;
+				if (entry.Dispose == 2)
+					entry.Dispose = 1;
+			}
+		}
+		else if (isType(type, "IDAT"))
+		{
+			hasInfo = true;
+			Chunk chunk = { start, size, false };
+			Chunks.Append(chunk);
+			entry.NumChunks++;
+		}
+		else if (isType(type, "fdAT") && isAnimated)
+		{
+			if (size < 16)
+				break;
+			Chunk chunk = { start, size, true };
+			Chunks.Append(chunk);
+			entry.NumChunks++;
+		}
+		else if (isType(type, "IEND"))
+		{
+			if (hasInfo)
+				finishFrame();
+			break;
+		}
+		else if (notABC(type[0]) || notABC(type[1]) || notABC(type[2]) || notABC(type[3]))
+		{
+			break;
+		}
+		else if (!hasInfo)
+		{
+			Chunk chunk = { start, size, false };
+			Infos.Append(chunk);
+		}
+	}
+
+	if (Entries.GetNumElements() <= 0)
+		return false;
+
+	int rowBytes = Width*4;
+	Canvas = new uint8[Height*rowBytes];
+	Saved = new uint8[Height*rowBytes];
+	CanvasRows = new uint8*[Height];
+	FrameRows = new uint8*[Height];
+	for (int r = 0; r < Height; r++)
+		CanvasRows[r] = Canvas + r*rowBytes;
+
+	Restart();
+	return true;
+}
+
+
+void tFrameStreamInternal::SourceAPNG::InfoCallback(png_structp png, png_infop info)
+{
+	// Same as apngdis. Everything ends up as 8 bit RGBA.
+	png_set_expand(png);
+	png_set_strip_16(png);
+	png_set_gray_to_rgb(png);
+	png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
+	(void)png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+}
+
+
+void tFrameStreamInternal::SourceAPNG::RowCallback(png_structp png, png_bytep newRow, png_uint_32 rowNum, int pass)
+{
+	Decoded* decoded = (Decoded*)png_get_progressive_ptr(png);
+	if (int(rowNum) >= decoded->H)
+		return;
+	png_progressive_combine_row(png, (png_bytep)(decoded->Pixels + rowNum*decoded->W), newRow);
+}
+
+
+bool tFrameStreamInternal::SourceAPNG::DecodePNG(const Entry& entry, Decoded& decoded) const
+{
+	// Nothing in here may need destructing because of the longjmp.
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!png)
+		return false;
+	png_infop info = png_create_info_struct(png);
+	if (!info)
+	{
+		png_destroy_read_struct(&png, nullptr, nullptr);
+		return false;
+	}
+
+	if (setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_read_struct(&png, &info, nullptr);
+		return false;
+	}
+
+	png_set_crc_action(png, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+	png_set_progressive_read_fn(png, (void*)&decoded, InfoCallback, RowCallback, nullptr);
+
+	// The frame is decoded as a png of its own. The header gets the frame size and fdAT chunks are passed in as IDAT
+	// chunks without their sequence numbers.
+	png_byte signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	png_process_data(png, info, signature, 8);
+
+	png_byte ihdr[25];
+	tStd::tMemcpy(ihdr, Data + IHDRStart, 25);
+	png_save_uint_32(ihdr + 8, png_uint_32(entry.W));
+	png_save_uint_32(ihdr + 12, png_uint_32(entry.H));
+	png_process_data(png, info, ihdr, 25);
+
+	for (int i = 0; i < Infos.GetNumElements(); i++)
+		png_process_data(png, info, (png_bytep)Data + Infos[i].Start, Infos[i].Size);
+
+	for (int c = entry.FirstChunk; c < entry.FirstChunk + entry.NumChunks; c++)
+	{
+		Chunk chunk = Chunks[c];
+		png_bytep bytes = (png_bytep)Data + chunk.Start;
+		if (!chunk.FrameData)
+		{
+			png_process_data(png, info, bytes, chunk.Size);
+			continue;
+		}
+
+		png_byte head[8];
+		png_save_uint_32(head, png_uint_32(chunk.Size - 16));
+		tStd::tMemcpy(head + 4, "IDAT", 4);
+		png_process_data(png, info, head, 8);
+		png_process_data(png, info, bytes + 12, chunk.Size - 16);
+		png_process_data(png, info, bytes + chunk.Size - 4, 4);
+	}
+
+	png_byte footer[12] = { 0, 0, 0, 0, 73, 69, 78, 68, 174, 66, 96, 130 };
+	png_process_data(png, info, footer, 12);
+	png_destroy_read_struct(&png, &info, nullptr);
+	return true;
+}
+
+
+void tFrameStreamInternal::SourceAPNG::Decode(int frameNum, Decoded& decoded) const
+{
+	Entry entry = Entries[frameNum];
+	decoded.Reserve(entry.W, entry.H);
+	decoded.X = entry.X;
+	decoded.Y = entry.Y;
+	tStd::tMemset(decoded.Pixels, 0, entry.W*entry.H*sizeof(tPixel4b));
+	decoded.Valid = DecodePNG(entry, decoded);
+}
+
+
+void tFrameStreamInternal::SourceAPNG::Restart()
+{
+	tStd::tMemset(Canvas, 0, Width*Height*4);
+}
+
+
+void tFrameStreamInternal::SourceAPNG::Compose(int frameNum, Decoded& decoded, tPixel4b* dest)
+{
+	// This follows load_apng.
+	Entry entry = Entries[frameNum];
+	int imageSize = Width*Height*4;
+	if (entry.Dispose == 2)
+		tStd::tMemcpy(Saved, Canvas, imageSize);
+
+	if (decoded.Valid)
+	{
+		for (int r = 0; r < entry.H; r++)
+			FrameRows[r] = (uint8*)(decoded.Pixels + r*entry.W);
+		APngDis::compose_frame(CanvasRows, FrameRows, entry.Blend, entry.X, entry.Y, entry.W, entry.H);
+	}
+
+	for (int r = 0; r < Height; r++)
+		tStd::tMemcpy(dest + ((Height-1)-r)*Width, CanvasRows[r], Width*4);
+
+	if (entry.Dispose == 2)
+	{
+		tStd::tMemcpy(Canvas, Saved, imageSize);
+	}
+	else if (entry.Dispose == 1)
+	{
+		for (int r = 0; r < entry.H; r++)
+			tStd::tMemset(CanvasRows[entry.Y + r] + entry.X*4, 0, entry.W*4);
+	}
+}
+
+
+bool tFrameStreamInternal::SourceWEBP::Index(const uint8* data, int numBytes)
+{
+	WebPData webpData;
+	webpData.bytes = data;
+	webpData.size = numBytes;
+	WebPDemuxer* demux = WebPDemux(&webpData);
+	if (!demux)
+		return false;
+
+	Width = int(WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH));
+	Height = int(WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT));
+
+	// With all the data present the demuxer does not copy it, so the fragments point into the file data and stay
+	// valid after the demuxer is gone.
+	WebPIterator iter;
+	if ((Width > 0) && (Height > 0) && WebPDemuxGetFrame(demux, 1, &iter))
+	{
+		do
+		{
+			Entry entry =
+			{
+				iter.fragment.bytes, int(iter.fragment.size), iter.x_offset, iter.y_offset, iter.width, iter.height,
+				(iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND), (iter.blend_method == WEBP_MUX_BLEND)
+			};
+			Entries.Append(entry);
+			Durations.Append(float(iter.duration) / 1000.0f);
+		}
+		while (WebPDemuxNextFrame(&iter));
+		WebPDemuxReleaseIterator(&iter);
+	}
+	WebPDemuxDelete(demux);
+
+	if (Entries.GetNumElements() <= 0)
+		return false;
+
+	Canvas = new tPixel4b[Width*Height];
+	Restart();
+	return true;
+}
+
+
+void tFrameStreamInternal::SourceWEBP::Decode(int frameNum, Decoded& decoded) const
+{
+	Entry entry = Entries[frameNum];
+	decoded.Valid = false;
+	if ((entry.W <= 0) || (entry.H <= 0))
+		return;
+
+	// Decoded straight into the slot. Flipped like tImageWEBP, which also means the y offset is from the bottom.
+	decoded.Reserve(entry.W, entry.H);
+	decoded.X = entry.X;
+	decoded.Y = Height - entry.Y - entry.H;
+
+	WebPDecoderConfig config;
+	WebPInitDecoderConfig(&config);
+	config.output.colorspace = MODE_RGBA;
+	config.output.is_external_memory = 1;
+	config.output.u.RGBA.rgba = (uint8*)decoded.Pixels;
+	config.output.u.RGBA.stride = entry.W*4;
+	config.output.u.RGBA.size = size_t(entry.W*entry.H*4);
+	config.options.flip = 1;
+	int result = WebPDecode(entry.Bytes, entry.Size, &config);
+	decoded.Valid = (result == VP8_STATUS_OK) && (config.output.width == entry.W) && (config.output.height == entry.H);
+	WebPFreeDecBuffer(&config.output);
+}
+
+
+void tFrameStreamInternal::SourceWEBP::Restart()
+{
+	for (int p = 0; p < Width*Height; p++)
+		Canvas[p] = tColour4b::transparent;
+}
+
+
+void tFrameStreamInternal::SourceWEBP::Compose(int frameNum, Decoded& decoded, tPixel4b* dest)
+{
+	// This follows tImageWEBP::Load and CopyRegion.
+	Entry entry = Entries[frameNum];
+	if (entry.Dispose)
+		Restart();
+
+	bool fits =
+		(decoded.X >= 0) && (decoded.X < Width) && (decoded.Y >= 0) && (decoded.Y < Height) &&
+		(decoded.X + decoded.W <= Width) && (decoded.Y + decoded.H <= Height);
+
+	if (decoded.Valid && fits)
+	{
+		for (int sy = 0; sy < decoded.H; sy++)
+		{
+			tPixel4b* dstRow = Canvas + ((decoded.Y+sy)*Width + decoded.X);
+			tPixel4b* srcRow = decoded.Pixels + (sy*decoded.W);
+			if (!entry.Blend)
+			{
+				tStd::tMemcpy(dstRow, srcRow, decoded.W*sizeof(tPixel4b));
+				continue;
+			}
+
+			for (int sx = 0; sx < decoded.W; sx++)
+			{
+				tColour4f scol(srcRow[sx]);
+				tColour4f dcol(dstRow[sx]);
+				float alpha = scol.A;
+				float oneMinusAlpha = 1.0f - alpha;
+
+				tColour4f pixelCol = scol;
+				pixelCol.R = pixelCol.R*alpha + dcol.R*oneMinusAlpha;
+				pixelCol.G = pixelCol.G*alpha + dcol.G*oneMinusAlpha;
+				pixelCol.B = pixelCol.B*alpha + dcol.B*oneMinusAlpha;
+				pixelCol.A = alpha > 0.0f ? alpha : dcol.A;
+				dstRow[sx].Set(pixelCol);
+			}
+		}
+	}
+
+	tStd::tMemcpy(dest, Canvas, Width*Height*sizeof(tPixel4b));
+}
+
+
+tFrameStreamInternal::Stream* tFrameStreamInternal::CreateStream
+(
+	uint8* data, int numBytes, tSystem::tFileType fileType, const tFrameStream::Params& params
+)
+{
+	Source* source = nullptr;
+	switch (fileType)
+	{
+		case tSystem::tFileType::GIF:	source = new SourceGIF;		break;
+		case tSystem::tFileType::APNG:
+		case tSystem::tFileType::PNG:	source = new SourceAPNG;	break;
+		case tSystem::tFileType::WEBP:	source = new SourceWEBP;	break;
+		default:													break;
+	}
+
+	if (!source || !source->Index(data, numBytes))
+	{
+		delete source;
+		delete[] data;
+		return nullptr;
+	}
+
+	Stream* stream = new Stream;
+	stream->FileData = data;
+	stream->Src = source;
+	stream->NumFrames = source->Durations.GetNumElements();
+
+	stream->RingSize = tMath::tMax(params.RingSize, 1);
+	stream->Ring = new tPixel4b*[stream->RingSize];
+	stream->RingFrame = new int[stream->RingSize];
+	for (int r = 0; r < stream->RingSize; r++)
+	{
+		stream->Ring[r] = new tPixel4b[source->Width*source->Height];
+		stream->RingFrame[r] = -1;
+	}
+
+	// One more slot than frames prefetched so the frame being composed always has somewhere to go.
+	stream->NumPrefetch = tMath::tClamp(params.NumPrefetch, 0, stream->NumFrames-1);
+	stream->NumSlots = stream->NumPrefetch + 1;
+	stream->Slots = new Decoded[stream->NumSlots];
+
+	int numThreads = (params.NumThreads > 0) ? params.NumThreads : tMath::tMax(tSystem::tGetNumCores(), 1);
+	stream->NumWorkers = tMath::tMin(numThreads, stream->NumPrefetch);
+	if (stream->NumWorkers > 0)
+	{
+		stream->Workers = new std::thread[stream->NumWorkers];
+		for (int w = 0; w < stream->NumWorkers; w++)
+			stream->Workers[w] = std::thread(&Stream::Work, stream);
+	}
+
+	return stream;
+}
+
+
+tFrameStreamInternal::Stream::~Stream()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Quit = true;
+	}
+	WorkReady.notify_all();
+	for (int w = 0; w < NumWorkers; w++)
+		Workers[w].join();
+	delete[] Workers;
+
+	for (int r = 0; r < RingSize; r++)
+		delete[] Ring[r];
+	delete[] Ring;
+	delete[] RingFrame;
+	delete[] Slots;
+	delete Src;
+	delete[] FileData;
+}
+
+
+tFrameStreamInternal::Decoded* tFrameStreamInternal::Stream::FindSlot(int frameNum)
+{
+	for (int s = 0; s < NumSlots; s++)
+		if (Slots[s].FrameNum == frameNum)
+			return &Slots[s];
+	return nullptr;
+}
+
+
+tFrameStreamInternal::Decoded* tFrameStreamInternal::Stream::FindSpare(int from)
+{
+	for (int s = 0; s < NumSlots; s++)
+		if (Slots[s].State == Decoded::tState::Free)
+			return &Slots[s];
+
+	// Frames that are decoded or queued but no longer needed soon can be dropped. Busy ones can't.
+	for (int s = 0; s < NumSlots; s++)
+		if ((Slots[s].State != Decoded::tState::Busy) && !IsWanted(Slots[s].FrameNum, from))
+			return &Slots[s];
+
+	return nullptr;
+}
+
+
+tFrameStreamInternal::Decoded* tFrameStreamInternal::Stream::FindJob()
+{
+	Decoded* job = nullptr;
+	int nearest = NumFrames;
+	for (int s = 0; s < NumSlots; s++)
+	{
+		if (Slots[s].State != Decoded::tState::Queued)
+			continue;
+		int distance = (Slots[s].FrameNum - Current + NumFrames) % NumFrames;
+		if (distance < nearest)
+		{
+			nearest = distance;
+			job = &Slots[s];
+		}
+	}
+	return job;
+}
+
+
+void tFrameStreamInternal::Stream::Work()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		Decoded* job = nullptr;
+		WorkReady.wait(lock, [&]() { job = FindJob(); return Quit || job; });
+		if (Quit)
+			return;
+
+		job->State = Decoded::tState::Busy;
+		int frameNum = job->FrameNum;
+		lock.unlock();
+		Src->Decode(frameNum, *job);
+		lock.lock();
+		job->State = Decoded::tState::Ready;
+		WorkDone.notify_all();
+	}
+}
+
+
+tFrameStreamInternal::Decoded& tFrameStreamInternal::Stream::Acquire(int frameNum)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	Current = frameNum;
+	while (true)
+	{
+		// A queued frame no worker has started yet is quicker to just decode here.
+		Decoded* slot = FindSlot(frameNum);
+		if (slot && (slot->State == Decoded::tState::Ready))
+		{
+			slot->State = Decoded::tState::Busy;
+			return *slot;
+		}
+
+		if (!slot || (slot->State != Decoded::tState::Busy))
+			slot = slot ? slot : FindSpare(frameNum);
+
+		if (slot && (slot->State != Decoded::tState::Busy))
+		{
+			slot->FrameNum = frameNum;
+			slot->State = Decoded::tState::Busy;
+			lock.unlock();
+			Src->Decode(frameNum, *slot);
+			return *slot;
+		}
+
+		// Either a worker is decoding this frame or every slot is busy.
+		WorkDone.wait(lock);
+	}
+}
+
+
+void tFrameStreamInternal::Stream::Release(Decoded& decoded)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	decoded.State = Decoded::tState::Free;
+	decoded.FrameNum = -1;
+}
+
+
+void tFrameStreamInternal::Stream::Prefetch(int from)
+{
+	if (!NumWorkers)
+		return;
+
+	bool queued = false;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (int d = 1; d <= NumPrefetch; d++)
+		{
+			int frameNum = (from + d) % NumFrames;
+			if (FindSlot(frameNum))
+				continue;
+
+			Decoded* slot = FindSpare(from);
+			if (!slot)
+				break;
+
+			slot->FrameNum = frameNum;
+			slot->State = Decoded::tState::Queued;
+			queued = true;
+		}
+	}
+
+	if (queued)
+		WorkReady.notify_all();
+}
+
+
+const tPixel4b* tFrameStreamInternal::Stream::GetPixels(int frameNum)
+{
+	int ringSlot = frameNum % RingSize;
+	if (RingFrame[ringSlot] != frameNum)
+	{
+		// Frames are drawn on top of each other so going back means starting again.
+		if (frameNum < NextCompose)
+		{
+			Src->Restart();
+			NextCompose = 0;
+		}
+
+		while (NextCompose <= frameNum)
+		{
+			int f = NextCompose;
+			Prefetch(f);
+			Decoded& decoded = Acquire(f);
+
+			int slot = f % RingSize;
+			RingFrame[slot] = -1;
+			Src->Compose(f, decoded, Ring[slot]);
+			RingFrame[slot] = f;
+
+			Release(decoded);
+			NextCompose++;
+		}
+	}
+
+	// Frames already composed don't need decoding again.
+	Prefetch(tMath::tMax(frameNum, NextCompose-1));
+	return Ring[ringSlot];
+}
+
+
+bool tFrameStream::Open(const tString& file, const Params& params)
+{
+	Close();
+	tSystem::tFileType fileType = tSystem::tGetFileType(file);
+	if (!tSystem::tFileExists(file))
+		return false;
+
+	int numBytes = 0;
+	uint8* data = tSystem::tLoadFile(file, nullptr, &numBytes);
+	if (!data)
+		return false;
+
+	Stream = tFrameStreamInternal::CreateStream(data, numBytes, fileType, params);
+	if (!Stream)
+		return false;
+
+	Width = Stream->Src->Width;
+	Height = Stream->Src->Height;
+	NumFrames = Stream->NumFrames;
+	return true;
+}
+
+
+bool tFrameStream::Open(const uint8* fileInMemory, int numBytes, tSystem::tFileType fileType, const Params& params)
+{
+	Close();
+	if (!fileInMemory || (numBytes <= 0))
+		return false;
+
+	uint8* data = new uint8[numBytes];
+	tStd::tMemcpy(data, fileInMemory, numBytes);
+	Stream = tFrameStreamInternal::CreateStream(data, numBytes, fileType, params);
+	if (!Stream)
+		return false;
+
+	Width = Stream->Src->Width;
+	Height = Stream->Src->Height;
+	NumFrames = Stream->NumFrames;
+	return true;
+}
+
+
+void tFrameStream::Close()
+{
+	delete Stream;
+	Stream = nullptr;
+	Width = 0;
+	Height = 0;
+	NumFrames = 0;
+}
+
+
+float tFrameStream::GetFrameDuration(int frameNum) const
+{
+	if (!Stream || (frameNum < 0) || (frameNum >= NumFrames))
+		return 0.0f;
+
+	return Stream->Src->Durations[frameNum];
+}
+
+
+const tPixel4b* tFrameStream::GetPixels(int frameNum)
+{
+	if (!Stream || (frameNum < 0) || (frameNum >= NumFrames))
+		return nullptr;
+
+	return Stream->GetPixels(frameNum);
+}
+
+
+tFrame* tFrameStream::GetFrame(int frameNum)
+{
+	const tPixel4b* pixels = GetPixels(frameNum);
+	if (!pixels)
+		return nullptr;
+
+	tFrame* frame = new tFrame(pixels, Width, Height, GetFrameDuration(frameNum));
+	frame->PixelFormatSrc = tPixelFormat::R8G8B8A8;
+	return frame;
+}
@@ -957,11 +957,12 @@ bool tImageDDS::Set(tPicture& picture, bool steal)
 	// We don't know colour profile of tPicture.
 
 	// This is worth some explanation. If steal is true the picture becomes invalid and the
-	// 'set' call will steal the stolen pixels. If steal is false GetPixels is called and the
-	// 'set' call will memcpy them out... which makes sure the picture is still valid after and
-	// no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
+	// 'set' call will steal the stolen pixels. If steal is false the const GetPixels is called, so
+	// a picture sharing its pixels stays shared, and the 'set' call will memcpy them out... which
+	// makes sure the picture is still valid after and no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
 	// succeed if picture was valid.
-	tPixel4b* pixels = steal ? picture.StealPixels() : picture.GetPixels();
+	const tPicture& src = picture;
+	tPixel4b* pixels = steal ? picture.StealPixels() : const_cast<tPixel4b*>(src.GetPixels());
 	bool success = Set(pixels, picture.GetWidth(), picture.GetHeight(), steal);
 	tAssert(success);
 	return true;
@@ -13,9 +13,11 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
 #include <Foundation/tStandard.h>
 #include <Foundation/tString.h>
 #include <System/tFile.h>
+#include <System/tMachine.h>
 #include <GifLoad/gif_load.h>
 #include <gifenc/gifenc.h>
 #include "Image/tImageGIF.h"
@@ -25,6 +27,50 @@ namespace tImage
 {
 
 
+namespace tImageGIFInternal
+{
+	// Quantizes with the method in the params. These quantize functions are safe to call from more than one thread.
+	void Quantize
+	(
+		const tImageGIF::SaveParams&, int numColours, int width, int height, const tPixel4b* pixels,
+		tColour3b* destPalette, uint8* destIndices
+	);
+
+	// The most pixels a streamed save quantizes at once to make the shared palette. The sample is laid out as an image
+	// SampleWidth pixels wide.
+	const int MaxSamplePixels	= 1024*1024;
+	const int SampleWidth		= 1024;
+}
+
+
+void tImageGIFInternal::Quantize
+(
+	const tImageGIF::SaveParams& params, int numColours, int width, int height, const tPixel4b* pixels,
+	tColour3b* destPalette, uint8* destIndices
+)
+{
+	bool checkExact = true;
+	switch (params.Method)
+	{
+		case tQuantize::Method::Fixed:
+			tQuantizeFixed::QuantizeImage(numColours, width, height, pixels, destPalette, destIndices, checkExact);
+			break;
+
+		case tQuantize::Method::Neu:
+			tQuantizeNeu::QuantizeImage(numColours, width, height, pixels, destPalette, destIndices, checkExact, params.SampleFactor);
+			break;
+
+		case tQuantize::Method::Wu:
+			tQuantizeWu::QuantizeImage(numColours, width, height, pixels, destPalette, destIndices, checkExact);
+			break;
+
+		case tQuantize::Method::Spatial:
+			tQuantizeSpatial::QuantizeImage(numColours, width, height, pixels, destPalette, destIndices, checkExact, params.DitherLevel, params.FilterSize);
+			break;
+	}
+}
+
+
 // This callback is a essentially the example code from gif_load.
 void tImageGIF::FrameLoadCallback(struct GIF_WHDR* whdr)
 {
@@ -259,11 +305,12 @@ bool tImageGIF::Set(tPicture& picture, bool steal)
 	// We don't know colour profile of tPicture.
 
 	// This is worth some explanation. If steal is true the picture becomes invalid and the
-	// 'set' call will steal the stolen pixels. If steal is false GetPixels is called and the
-	// 'set' call will memcpy them out... which makes sure the picture is still valid after and
-	// no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
+	// 'set' call will steal the stolen pixels. If steal is false the const GetPixels is called, so
+	// a picture sharing its pixels stays shared, and the 'set' call will memcpy them out... which
+	// makes sure the picture is still valid after and no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
 	// succeed if picture was valid.
-	tPixel4b* pixels = steal ? picture.StealPixels() : picture.GetPixels();
+	const tPicture& src = picture;
+	tPixel4b* pixels = steal ? picture.StealPixels() : const_cast<tPixel4b*>(src.GetPixels());
 	bool success = Set(pixels, picture.GetWidth(), picture.GetHeight(), steal);
 	tAssert(success);
 	return true;
@@ -299,6 +346,9 @@ bool tImageGIF::Save(const tString& gifFile, const SaveParams& saveParams) const
 	if (params.Format == tPixelFormat::PAL1BIT)
 		params.AlphaThreshold = 255;
 
+	if (params.Stream)
+		return SaveStream(gifFile, params, loop);
+
 	// Before we create a gif with gifenc's ge_new_gif we need to have created a good palette for it to use. This is a
 	// little tricky for multiframe gifs because gifenc does not support frame-local palettes. The same palette is used
 	// for all frames so it can apply size optimization. However, quantize calls work on a single image/frame.
@@ -375,25 +425,7 @@ bool tImageGIF::Save(const tString& gifFile, const SaveParams& saveParams) const
 	tColour3b* gifPalette = new tColour3b[gifPaletteSize];
 	gifPalette[gifPaletteSize-1].Set(0, 0, 0);
 	uint8* gifIndices = new uint8[width*height];
-	bool checkExact = true;
-	switch (params.Method)
-	{
-		case tQuantize::Method::Fixed:
-			tQuantizeFixed::QuantizeImage(quantNumColours, width, height, pixels, gifPalette, gifIndices, checkExact);
-			break;
-
-		case tQuantize::Method::Neu:
-			tQuantizeNeu::QuantizeImage(quantNumColours, width, height, pixels, gifPalette, gifIndices, checkExact, params.SampleFactor);
-			break;
-
-		case tQuantize::Method::Wu:
-			tQuantizeWu::QuantizeImage(quantNumColours, width, height, pixels, gifPalette, gifIndices, checkExact);
-			break;
-
-		case tQuantize::Method::Spatial:
-			tQuantizeSpatial::QuantizeImage(quantNumColours, width, height, pixels, gifPalette, gifIndices, checkExact, params.DitherLevel, params.FilterSize);
-			break;
-	}
+	tImageGIFInternal::Quantize(params, quantNumColours, width, height, pixels, gifPalette, gifIndices);
 	int bgIndex = -1;
 
 	// Now that the indices are worked out, we need to replace any indices that are supposed to be transparent with
@@ -447,4 +479,237 @@ bool tImageGIF::Save(const tString& gifFile, const SaveParams& saveParams) const
 }
 
 
+bool tImageGIF::SaveStream(const tString& gifFile, const SaveParams& params, int loop) const
+{
+	using namespace tImageGIFInternal;
+
+	// Frames that are not the right size are skipped, same as the non-streamed save.
+	tFrame** frames = new tFrame*[GetNumFrames()];
+	int numFrames = 0;
+	for (tFrame* frame = Frames.First(); frame; frame = frame->Next())
+		if ((frame->Width == Width) && (frame->Height == Height) && frame->Pixels)
+			frames[numFrames++] = frame;
+
+	if (!numFrames)
+	{
+		delete[] frames;
+		return false;
+	}
+
+	int frameSize			= Width*Height;
+	int gifBitDepth			= tGetBitsPerPixel(params.Format);
+	int gifPaletteSize		= tMath::tPow2(gifBitDepth);
+
+	bool gifTransparency = false;
+	int alphaThreshold = params.AlphaThreshold;
+	if (params.AlphaThreshold < 0)
+	{
+		for (int f = 0; (f < numFrames) && !gifTransparency; f++)
+		{
+			for (int p = 0; p < frameSize; p++)
+			{
+				if (frames[f]->Pixels[p].A < 255)
+				{
+					gifTransparency = true;
+					alphaThreshold = 127;
+					break;
+				}
+			}
+		}
+	}
+	else if (params.AlphaThreshold < 255)
+	{
+		gifTransparency = true;
+	}
+	int quantNumColours		= gifPaletteSize - (gifTransparency ? 1 : 0);
+	int bgIndex				= gifTransparency ? gifPaletteSize-1 : -1;
+
+	// Make the shared palette. If all the pixels fit in the sample, the sample is just the frames stacked on top of each
+	// other and its indices get used directly, so nothing is lost compared to a non-streamed save. Otherwise pixels are
+	// taken evenly from all frames with a little jitter so regular patterns don't line up with the stride. Frames are
+	// then mapped onto the palette as they are written.
+	tColour3b* gifPalette = new tColour3b[gifPaletteSize];
+	tStd::tMemset(gifPalette, 0, gifPaletteSize*sizeof(tColour3b));
+	uint8* allIndices = nullptr;
+	if (!params.LocalPalettes)
+	{
+		int64 totalPixels = int64(frameSize) * int64(numFrames);
+		if (totalPixels <= MaxSamplePixels)
+		{
+			tPixel4b* allPixels = new tPixel4b[totalPixels];
+			for (int f = 0; f < numFrames; f++)
+				tStd::tMemcpy(allPixels + f*frameSize, frames[f]->Pixels, frameSize*sizeof(tPixel4b));
+
+			allIndices = new uint8[totalPixels];
+			Quantize(params, quantNumColours, Width, Height*numFrames, allPixels, gifPalette, allIndices);
+			delete[] allPixels;
+		}
+		else
+		{
+			tPixel4b* sample = new tPixel4b[MaxSamplePixels];
+			int64 stride = totalPixels / MaxSamplePixels;
+			uint32 seed = 0x9E3779B9;
+			for (int s = 0; s < MaxSamplePixels; s++)
+			{
+				seed = seed*1664525u + 1013904223u;
+				int64 pos = (int64(s)*totalPixels)/MaxSamplePixels + int64(seed >> 8) % stride;
+				sample[s] = frames[pos / frameSize]->Pixels[pos % frameSize];
+			}
+
+			uint8* sampleIndices = new uint8[MaxSamplePixels];
+			Quantize(params, quantNumColours, SampleWidth, MaxSamplePixels/SampleWidth, sample, gifPalette, sampleIndices);
+			delete[] sampleIndices;
+			delete[] sample;
+		}
+	}
+
+	// Gets the indices (and palette if local) of a single frame. Called from worker threads.
+	auto processFrame = [&](int f, uint8* indices, tColour3b* palette)
+	{
+		const tPixel4b* pixels = frames[f]->Pixels;
+		if (params.LocalPalettes)
+		{
+			tStd::tMemset(palette, 0, gifPaletteSize*sizeof(tColour3b));
+			Quantize(params, quantNumColours, Width, Height, pixels, palette, indices);
+		}
+		else if (allIndices)
+		{
+			tStd::tMemcpy(indices, allIndices + f*frameSize, frameSize);
+		}
+		else
+		{
+			tQuantize::ConvertToIndices(indices, Width, Height, gifPalette, quantNumColours, pixels);
+		}
+
+		if (gifTransparency)
+			for (int p = 0; p < frameSize; p++)
+				if (pixels[p].A <= alphaThreshold)
+					indices[p] = bgIndex;
+	};
+
+	// Only a batch of frames is ever quantized at once. The batch buffers are reused.
+	int numThreads = (params.NumThreads > 0) ? params.NumThreads : tMath::tMax(tSystem::tGetNumCores(), 1);
+	int batchSize = tMath::tMin(numThreads, numFrames);
+	uint8** batchIndices = new uint8*[batchSize];
+	tColour3b** batchPalettes = new tColour3b*[batchSize];
+	for (int b = 0; b < batchSize; b++)
+	{
+		batchIndices[b] = new uint8[frameSize];
+		batchPalettes[b] = params.LocalPalettes ? new tColour3b[gifPaletteSize] : nullptr;
+	}
+	tColour3b* prevPalette = new tColour3b[gifPaletteSize];
+
+	ge_GIF* gifHandle = nullptr;
+	bool success = true;
+	for (int first = 0; (first < numFrames) && success; first += batchSize)
+	{
+		int count = tMath::tMin(batchSize, numFrames-first);
+		if (count == 1)
+		{
+			processFrame(first, batchIndices[0], batchPalettes[0]);
+		}
+		else
+		{
+			std::thread* workers = new std::thread[count];
+			for (int b = 0; b < count; b++)
+				workers[b] = std::thread(processFrame, first+b, batchIndices[b], batchPalettes[b]);
+			for (int b = 0; b < count; b++)
+				workers[b].join();
+			delete[] workers;
+		}
+
+		for (int b = 0; b < count; b++)
+		{
+			int f = first + b;
+			const tColour3b* palette = params.LocalPalettes ? batchPalettes[b] : gifPalette;
+
+			// With local palettes the first frame's palette becomes the global one so the first frame needs no table.
+			if (!gifHandle)
+			{
+				if (params.LocalPalettes)
+					tStd::tMemcpy(gifPalette, palette, gifPaletteSize*sizeof(tColour3b));
+				gifHandle = ge_new_gif(gifFile.Chr(), Width, Height, (uint8*)gifPalette, gifBitDepth, bgIndex, loop);
+				if (!gifHandle)
+				{
+					success = false;
+					break;
+				}
+			}
+
+			// The frames need to be given to the encoder from the top row down.
+			uint8* dst = gifHandle->frame;
+			for (int y = 0; y < Height; y++)
+				tStd::tMemcpy(dst + y*Width, batchIndices[b] + (Height-y-1)*Width, Width);
+
+			// Only the rectangle that changed is written. For transparent gifs the encoder disposes each frame to the
+			// background, so the rectangle is everything not transparent. For opaque gifs it is everything that looks
+			// different from the previous frame, which is still in the back buffer.
+			int left = 0, top = 0, right = Width-1, bottom = Height-1;
+			if (f > 0)
+			{
+				const uint8* back = gifHandle->back;
+				left = Width; top = Height; right = -1; bottom = -1;
+				for (int y = 0, k = 0; y < Height; y++)
+				{
+					for (int x = 0; x < Width; x++, k++)
+					{
+						bool changed = false;
+						if (gifTransparency)
+							changed = (dst[k] != bgIndex);
+						else if (params.LocalPalettes)
+							changed = !(palette[dst[k]] == prevPalette[back[k]]);
+						else
+							changed = (dst[k] != back[k]);
+
+						if (!changed)
+							continue;
+						left = tMath::tMin(left, x);	right = tMath::tMax(right, x);
+						top = tMath::tMin(top, y);		bottom = tMath::tMax(bottom, y);
+					}
+				}
+
+				// Nothing changed. Save one pixel just to add the delay.
+				if (right < 0)
+				{
+					left = right = 0;
+					top = bottom = 0;
+				}
+			}
+
+			int delay = tMath::tClampMin((params.OverrideFrameDuration < 0) ? int(frames[f]->Duration * 100.0f) : params.OverrideFrameDuration, 2);
+			if (GetNumFrames() == 1)
+				delay = 0;
+
+			uint8* localPalette = (params.LocalPalettes && (f > 0)) ? (uint8*)palette : nullptr;
+			ge_add_frame_rect(gifHandle, delay, localPalette, right-left+1, bottom-top+1, left, top);
+
+			// Opaque gifs have a back buffer to compare the next frame against.
+			if (!gifTransparency)
+			{
+				gifHandle->frame = gifHandle->back;
+				gifHandle->back = dst;
+				if (params.LocalPalettes)
+					tStd::tMemcpy(prevPalette, palette, gifPaletteSize*sizeof(tColour3b));
+			}
+		}
+	}
+
+	if (gifHandle)
+		ge_close_gif(gifHandle);
+
+	for (int b = 0; b < batchSize; b++)
+	{
+		delete[] batchIndices[b];
+		delete[] batchPalettes[b];
+	}
+	delete[] batchIndices;
+	delete[] batchPalettes;
+	delete[] prevPalette;
+	delete[] allIndices;
+	delete[] gifPalette;
+	delete[] frames;
+	return success;
+}
+
+
 }
@@ -3,7 +3,7 @@
 // This knows how to load/save KTX files. It knows the details of the ktx and ktx2 file format and loads the data into
 // multiple tPixel arrays, one for each frame (KTKs may be animated). These arrays may be 'stolen' by tPictures.
 //
-// Copyright (c) 2022-2024 Tristan Grimmer.
+// Copyright (c) 2022-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -13,12 +13,17 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <Foundation/tString.h>
 #include <Foundation/tSmallFloat.h>
 #include <System/tMachine.h>
+#include <System/tFile.h>
 #include "Image/tImageKTX.h"
 #include "Image/tPixelUtil.h"
 #include "Image/tPicture.h"
+#include "Image/tTexture.h"
 #include "bcdec/bcdec.h"
 #include "etcdec/etcdec.h"
 #include "astcenc.h"
@@ -26,6 +31,20 @@
 #include "LibKTX/include/ktx.h"
 #include "LibKTX/include/vulkan_core.h"
 #include "LibKTX/include/gl_format.h"
+
+
+// LibKTX is built with its own copy of Zstandard for KTX2 supercompression. The zstd header does not ship with it so
+// the few functions the KTX2 writer and reader call are declared here.
+extern "C"
+{
+	size_t ZSTD_compressBound(size_t srcSize);
+	size_t ZSTD_compress(void* dst, size_t dstCapacity, const void* src, size_t srcSize, int compressionLevel);
+	size_t ZSTD_decompress(void* dst, size_t dstCapacity, const void* src, size_t compressedSize);
+	unsigned ZSTD_isError(size_t code);
+	int ZSTD_maxCLevel(void);
+}
+
+
 namespace tImage
 {
 
@@ -39,6 +58,56 @@ namespace tKTX
 	// satellite information cannot be determined, in which case they get set the their 'unspecified' enumerants.
 	void GetFormatInfo_FromGLFormat(tPixelFormat&, tColourProfile&, tAlphaMode&, tChannelType&, uint32 glType, uint32 glFormat, uint32 glInternalFormat);
 	void GetFormatInfo_FromVKFormat(tPixelFormat&, tColourProfile&, tAlphaMode&, tChannelType&, uint32 vkFormat);
+
+	// The other way, for writing. Picks the SRGB VkFormat if the profile is sRGB and there is one. Otherwise the
+	// UNORM (or float) one. Returns VK_FORMAT_UNDEFINED if the pixel format has no VkFormat.
+	uint32 GetVKFormat(tPixelFormat, tColourProfile);
+
+	// The KTX2 typeSize header field. The size of the data type the pixel format is made of for endian swapping.
+	uint32 GetVKTypeSize(tPixelFormat);
+
+	const int MaxKTX2Levels = 16;
+	const uint8 KTX2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	// Supercompression schemes we know about.
+	enum class Scheme : uint32
+	{
+		None,
+		BasisLZ,
+		Zstd,
+		Zlib
+	};
+
+	// The fixed part of a KTX2 file. Everything is little-endian.
+	struct KTX2Header
+	{
+		uint8 Identifier[12];
+		uint32 VKFormat;
+		uint32 TypeSize;
+		uint32 PixelWidth;
+		uint32 PixelHeight;
+		uint32 PixelDepth;
+		uint32 LayerCount;
+		uint32 FaceCount;
+		uint32 LevelCount;
+		uint32 SupercompressionScheme;
+		uint32 DFDByteOffset;
+		uint32 DFDByteLength;
+		uint32 KVDByteOffset;
+		uint32 KVDByteLength;
+		uint64 SGDByteOffset;
+		uint64 SGDByteLength;
+	};
+	tStaticAssert(sizeof(KTX2Header) == 80);
+
+	// One of these per level follows the header.
+	struct KTX2LevelIndex
+	{
+		uint64 ByteOffset;
+		uint64 ByteLength;
+		uint64 UncompressedByteLength;
+	};
+	tStaticAssert(sizeof(KTX2LevelIndex) == 24);
 }
 
 
@@ -518,6 +587,118 @@ void tKTX::GetFormatInfo_FromVKFormat(tPixelFormat& format, tColourProfile& prof
 }
 
 
+uint32 tKTX::GetVKFormat(tPixelFormat format, tColourProfile profile)
+{
+	bool srgb = (profile == tColourProfile::sRGB);
+
+	// V is for formats with a single VkFormat. S is for ones with a UNORM and an SRGB variant. ETC1 data is valid ETC2
+	// data so it gets the ETC2 format. There is no A8 VkFormat.
+	#define C(c) case tPixelFormat::c
+	#define V(v) return VK_FORMAT_##v;
+	#define S(u, s) return srgb ? VK_FORMAT_##s : VK_FORMAT_##u;
+	switch (format)
+	{
+		C(R8):									S(R8_UNORM,						R8_SRGB)
+		C(R8G8):								S(R8G8_UNORM,					R8G8_SRGB)
+		C(R8G8B8):								S(R8G8B8_UNORM,					R8G8B8_SRGB)
+		C(R8G8B8A8):							S(R8G8B8A8_UNORM,				R8G8B8A8_SRGB)
+		C(B8G8R8):								S(B8G8R8_UNORM,					B8G8R8_SRGB)
+		C(B8G8R8A8):							S(B8G8R8A8_UNORM,				B8G8R8A8_SRGB)
+		C(G3B5R5G3):							V(B5G6R5_UNORM_PACK16)
+		C(G4B4A4R4):							V(B4G4R4A4_UNORM_PACK16)
+		C(G3B5A1R5G2):							V(B5G5R5A1_UNORM_PACK16)
+
+		C(R16f):								V(R16_SFLOAT)
+		C(R16G16f):								V(R16G16_SFLOAT)
+		C(R16G16B16f):							V(R16G16B16_SFLOAT)
+		C(R16G16B16A16f):						V(R16G16B16A16_SFLOAT)
+		C(R32f):								V(R32_SFLOAT)
+		C(R32G32f):								V(R32G32_SFLOAT)
+		C(R32G32B32f):							V(R32G32B32_SFLOAT)
+		C(R32G32B32A32f):						V(R32G32B32A32_SFLOAT)
+		C(B10G11R11uf):							V(B10G11R11_UFLOAT_PACK32)
+		C(E5B9G9R9uf):							V(E5B9G9R9_UFLOAT_PACK32)
+
+		C(BC1DXT1):								S(BC1_RGB_UNORM_BLOCK,			BC1_RGB_SRGB_BLOCK)
+		C(BC1DXT1A):							S(BC1_RGBA_UNORM_BLOCK,			BC1_RGBA_SRGB_BLOCK)
+		C(BC2DXT2DXT3):							S(BC2_UNORM_BLOCK,				BC2_SRGB_BLOCK)
+		C(BC3DXT4DXT5):							S(BC3_UNORM_BLOCK,				BC3_SRGB_BLOCK)
+		C(BC4ATI1U):							V(BC4_UNORM_BLOCK)
+		C(BC4ATI1S):							V(BC4_SNORM_BLOCK)
+		C(BC5ATI2U):							V(BC5_UNORM_BLOCK)
+		C(BC5ATI2S):							V(BC5_SNORM_BLOCK)
+		C(BC6U):								V(BC6H_UFLOAT_BLOCK)
+		C(BC6S):								V(BC6H_SFLOAT_BLOCK)
+		C(BC7):									S(BC7_UNORM_BLOCK,				BC7_SRGB_BLOCK)
+
+		C(ETC1):								S(ETC2_R8G8B8_UNORM_BLOCK,		ETC2_R8G8B8_SRGB_BLOCK)
+		C(ETC2RGB):								S(ETC2_R8G8B8_UNORM_BLOCK,		ETC2_R8G8B8_SRGB_BLOCK)
+		C(ETC2RGBA):							S(ETC2_R8G8B8A8_UNORM_BLOCK,	ETC2_R8G8B8A8_SRGB_BLOCK)
+		C(ETC2RGBA1):							S(ETC2_R8G8B8A1_UNORM_BLOCK,	ETC2_R8G8B8A1_SRGB_BLOCK)
+		C(EACR11U):								V(EAC_R11_UNORM_BLOCK)
+		C(EACR11S):								V(EAC_R11_SNORM_BLOCK)
+		C(EACRG11U):							V(EAC_R11G11_UNORM_BLOCK)
+		C(EACRG11S):							V(EAC_R11G11_SNORM_BLOCK)
+
+		C(PVRBPP4):								S(PVRTC1_4BPP_UNORM_BLOCK_IMG,	PVRTC1_4BPP_SRGB_BLOCK_IMG)
+		C(PVRBPP2):								S(PVRTC1_2BPP_UNORM_BLOCK_IMG,	PVRTC1_2BPP_SRGB_BLOCK_IMG)
+
+		// The loader treats UNORM ASTC as possibly HDR, so HDR data is written as UNORM too.
+		C(ASTC4X4):								S(ASTC_4x4_UNORM_BLOCK,			ASTC_4x4_SRGB_BLOCK)
+		C(ASTC5X4):								S(ASTC_5x4_UNORM_BLOCK,			ASTC_5x4_SRGB_BLOCK)
+		C(ASTC5X5):								S(ASTC_5x5_UNORM_BLOCK,			ASTC_5x5_SRGB_BLOCK)
+		C(ASTC6X5):								S(ASTC_6x5_UNORM_BLOCK,			ASTC_6x5_SRGB_BLOCK)
+		C(ASTC6X6):								S(ASTC_6x6_UNORM_BLOCK,			ASTC_6x6_SRGB_BLOCK)
+		C(ASTC8X5):								S(ASTC_8x5_UNORM_BLOCK,			ASTC_8x5_SRGB_BLOCK)
+		C(ASTC8X6):								S(ASTC_8x6_UNORM_BLOCK,			ASTC_8x6_SRGB_BLOCK)
+		C(ASTC8X8):								S(ASTC_8x8_UNORM_BLOCK,			ASTC_8x8_SRGB_BLOCK)
+		C(ASTC10X5):							S(ASTC_10x5_UNORM_BLOCK,		ASTC_10x5_SRGB_BLOCK)
+		C(ASTC10X6):							S(ASTC_10x6_UNORM_BLOCK,		ASTC_10x6_SRGB_BLOCK)
+		C(ASTC10X8):							S(ASTC_10x8_UNORM_BLOCK,		ASTC_10x8_SRGB_BLOCK)
+		C(ASTC10X10):							S(ASTC_10x10_UNORM_BLOCK,		ASTC_10x10_SRGB_BLOCK)
+		C(ASTC12X10):							S(ASTC_12x10_UNORM_BLOCK,		ASTC_12x10_SRGB_BLOCK)
+		C(ASTC12X12):							S(ASTC_12x12_UNORM_BLOCK,		ASTC_12x12_SRGB_BLOCK)
+
+		default:								break;
+	}
+
+	#undef C
+	#undef V
+	#undef S
+	return VK_FORMAT_UNDEFINED;
+}
+
+
+uint32 tKTX::GetVKTypeSize(tPixelFormat format)
+{
+	switch (format)
+	{
+		case tPixelFormat::G3B5R5G3:
+		case tPixelFormat::G4B4A4R4:
+		case tPixelFormat::G3B5A1R5G2:
+		case tPixelFormat::R16f:
+		case tPixelFormat::R16G16f:
+		case tPixelFormat::R16G16B16f:
+		case tPixelFormat::R16G16B16A16f:
+			return 2;
+
+		case tPixelFormat::R32f:
+		case tPixelFormat::R32G32f:
+		case tPixelFormat::R32G32B32f:
+		case tPixelFormat::R32G32B32A32f:
+		case tPixelFormat::B10G11R11uf:
+		case tPixelFormat::E5B9G9R9uf:
+			return 4;
+
+		default:
+			break;
+	}
+
+	// Block-compressed and 8-bit formats.
+	return 1;
+}
+
+
 tImageKTX::tImageKTX()
 {
 	tStd::tMemset(Layers, 0, sizeof(Layers));
@@ -616,11 +797,12 @@ bool tImageKTX::Set(tPicture& picture, bool steal)
 	// We don't know colour profile of tPicture.
 
 	// This is worth some explanation. If steal is true the picture becomes invalid and the
-	// 'set' call will steal the stolen pixels. If steal is false GetPixels is called and the
-	// 'set' call will memcpy them out... which makes sure the picture is still valid after and
-	// no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
+	// 'set' call will steal the stolen pixels. If steal is false the const GetPixels is called, so
+	// a picture sharing its pixels stays shared, and the 'set' call will memcpy them out... which
+	// makes sure the picture is still valid after and no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
 	// succeed if picture was valid.
-	tPixel4b* pixels = steal ? picture.StealPixels() : picture.GetPixels();
+	const tPicture& src = picture;
+	tPixel4b* pixels = steal ? picture.StealPixels() : const_cast<tPixel4b*>(src.GetPixels());
 	bool success = Set(pixels, picture.GetWidth(), picture.GetHeight(), steal);
 	tAssert(success);
 	return true;
@@ -1166,4 +1348,658 @@ tStaticAssert(tNumElements(tImageKTX::StateDescriptions) == int(tImageKTX::State
 tStaticAssert(int(tImageKTX::StateBit::NumStateBits) <= int(tImageKTX::StateBit::MaxStateBits));
 
 
+namespace tKTX
+{
+	// The tKTX2Writer internals. Levels are compressed by the workers and written smallest first.
+	struct Writer
+	{
+		struct Level
+		{
+			int Width					= 0;
+			int Height					= 0;
+			int NumBytes				= 0;		// Size before supercompression.
+			int64 Offset				= 0;
+			int64 Length				= 0;
+			bool Added					= false;
+			bool Written				= false;
+			uint8* Source				= nullptr;	// Waiting to be compressed.
+			uint8* Compressed			= nullptr;	// Waiting for the smaller levels to be written.
+		};
+
+		void Work();
+		void WriteReadyLevels();					// Mutex must be held.
+
+		tString Filename;
+		tFileHandle File				= nullptr;
+		tPixelFormat PixelFormat		= tPixelFormat::Invalid;
+		bool Supercompress				= false;
+		int ZstdLevel					= 3;
+		bool ReverseRows				= false;
+		int NumLevels					= 0;
+		Level Levels[MaxKTX2Levels];
+
+		// Compressed levels are packed one after the other from WriteOffset. NextToWrite counts down to -1.
+		int64 WriteOffset				= 0;
+		int NextToWrite					= 0;
+
+		std::mutex Mutex;
+		std::condition_variable WorkReady;
+		int Queue[MaxKTX2Levels];
+		int QueueHead					= 0;
+		int QueueTail					= 0;
+		bool Stopping					= false;
+		bool Failed						= false;
+		std::thread* Workers			= nullptr;
+		int NumWorkers					= 0;
+	};
+
+	// The tKTX2Reader internals.
+	struct Reader
+	{
+		tFileHandle File				= nullptr;
+		std::mutex Mutex;							// Guards File.
+		Scheme Supercompression			= Scheme::None;
+		KTX2LevelIndex Levels[MaxKTX2Levels];
+	};
+
+	// Writes a key/value entry including its padding to dest and returns the number of bytes written. The caller makes
+	// sure dest is big enough. Keys must be added in sorted order.
+	int WriteKeyValue(uint8* dest, const char* key, const char* value);
+
+	// Returns the value for key in the key/value data, or nullptr if not there. valueLength includes any terminator.
+	const char* FindKeyValue(const uint8* kvd, int kvdLength, const char* key, int& valueLength);
+
+	bool WriteLayers(const tString& file, const tLayer* first, int numLayers, const tKTX2Writer::Params&);
+}
+
+
+int tKTX::WriteKeyValue(uint8* dest, const char* key, const char* value)
+{
+	int keyLength = tStd::tStrlen(key) + 1;
+	int valueLength = tStd::tStrlen(value) + 1;
+	uint32 length = keyLength + valueLength;
+	tStd::tMemcpy(dest, &length, 4);
+	tStd::tMemcpy(dest + 4, key, keyLength);
+	tStd::tMemcpy(dest + 4 + keyLength, value, valueLength);
+
+	int total = 4 + length;
+	int padded = (total + 3) & ~3;
+	tStd::tMemset(dest + total, 0, padded - total);
+	return padded;
+}
+
+
+const char* tKTX::FindKeyValue(const uint8* kvd, int kvdLength, const char* key, int& valueLength)
+{
+	int pos = 0;
+	while (pos + 4 <= kvdLength)
+	{
+		uint32 length;
+		tStd::tMemcpy(&length, kvd + pos, 4);
+		pos += 4;
+		if (length > uint32(kvdLength - pos))
+			break;
+
+		// The key is null-terminated. Anything without a terminator is skipped.
+		const char* entryKey = (const char*)(kvd + pos);
+		int keyLength = 0;
+		while ((keyLength < int(length)) && entryKey[keyLength])
+			keyLength++;
+
+		if ((keyLength < int(length)) && !tStd::tStrcmp(entryKey, key))
+		{
+			valueLength = int(length) - keyLength - 1;
+			return entryKey + keyLength + 1;
+		}
+		pos += (length + 3) & ~3;
+	}
+
+	valueLength = 0;
+	return nullptr;
+}
+
+
+bool tKTX::WriteLayers(const tString& file, const tLayer* first, int numLayers, const tKTX2Writer::Params& params)
+{
+	if (!first)
+		return false;
+
+	tKTX2Writer writer;
+	if (!writer.Open(file, first->PixelFormat, first->Width, first->Height, numLayers, params))
+		return false;
+
+	int level = 0;
+	for (const tLayer* layer = first; layer; layer = layer->Next(), level++)
+	{
+		if (!writer.AddLevel(level, *layer))
+			break;
+	}
+
+	// Close fails and removes the file if any level is missing.
+	return writer.Close();
+}
+
+
+void tKTX::Writer::Work()
+{
+	while (true)
+	{
+		int level = 0;
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			WorkReady.wait(lock, [&]() { return Stopping || (QueueHead < QueueTail); });
+			if (QueueHead == QueueTail)
+				return;
+			level = Queue[QueueHead++];
+		}
+
+		// The source is only touched by this worker once queued.
+		Level& lev = Levels[level];
+		size_t capacity = ZSTD_compressBound(size_t(lev.NumBytes));
+		uint8* compressed = new uint8[capacity];
+		size_t result = ZSTD_compress(compressed, capacity, lev.Source, size_t(lev.NumBytes), ZstdLevel);
+
+		const std::lock_guard<std::mutex> lock(Mutex);
+		delete[] lev.Source;
+		lev.Source = nullptr;
+		if (ZSTD_isError(result))
+		{
+			delete[] compressed;
+			Failed = true;
+			continue;
+		}
+
+		lev.Compressed = compressed;
+		lev.Length = int64(result);
+		WriteReadyLevels();
+	}
+}
+
+
+void tKTX::Writer::WriteReadyLevels()
+{
+	while (!Failed && (NextToWrite >= 0) && Levels[NextToWrite].Compressed)
+	{
+		Level& lev = Levels[NextToWrite];
+		lev.Offset = WriteOffset;
+		bool ok =
+			(tSystem::tFileSeek64(File, lev.Offset) == 0) &&
+			(tSystem::tWriteFile64(File, lev.Compressed, lev.Length) == lev.Length);
+
+		delete[] lev.Compressed;
+		lev.Compressed = nullptr;
+		if (!ok)
+		{
+			Failed = true;
+			return;
+		}
+
+		lev.Written = true;
+		WriteOffset += lev.Length;
+		NextToWrite--;
+	}
+}
+
+
+bool tKTX2Writer::Open(const tString& file, tPixelFormat format, int width, int height, int numLevels, const Params& params)
+{
+	Close();
+	uint32 vkFormat = tKTX::GetVKFormat(format, params.Profile);
+	int bytesPerBlock = tGetBytesPerBlock(format);
+	if ((vkFormat == VK_FORMAT_UNDEFINED) || (bytesPerBlock <= 0) || (width <= 0) || (height <= 0))
+		return false;
+
+	if ((numLevels < 1) || (numLevels > tKTX::MaxKTX2Levels) || (numLevels > tGetNumMipmapLevels(width, height)))
+		return false;
+
+	// Building a DFD by hand is a lot of work. LibKTX makes one from the VkFormat if we create a texture without any
+	// storage, so we borrow it.
+	ktxTextureCreateInfo createInfo;
+	tStd::tMemset(&createInfo, 0, sizeof(createInfo));
+	createInfo.vkFormat			= vkFormat;
+	createInfo.baseWidth		= width;
+	createInfo.baseHeight		= height;
+	createInfo.baseDepth		= 1;
+	createInfo.numDimensions	= 2;
+	createInfo.numLevels		= numLevels;
+	createInfo.numLayers		= 1;
+	createInfo.numFaces			= 1;
+	ktxTexture2* texture = nullptr;
+	KTX_error_code result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_NO_STORAGE, &texture);
+	if ((result != KTX_SUCCESS) || !texture || !texture->pDfd)
+	{
+		if (texture)
+			ktxTexture2_Destroy(texture);
+		return false;
+	}
+
+	// The first word of the DFD is its total size.
+	uint32 dfdLength = texture->pDfd[0];
+	uint32* dfd = new uint32[dfdLength/4];
+	tStd::tMemcpy(dfd, texture->pDfd, dfdLength);
+	ktxTexture2_Destroy(texture);
+
+	// Supercompressed levels do not have a fixed number of bytes per plane so the spec wants it zeroed.
+	if (params.Supercompress)
+		KHR_DFDSETVAL(dfd + 1, BYTESPLANE0, 0);
+
+	// If any level can't be reversed none of them are so the orientation is the same for all.
+	bool reverseRows = params.ReverseRowOrder;
+	for (int level = 0; reverseRows && (level < numLevels); level++)
+		reverseRows = CanReverseRowData(format, tGetMipmapDim(height, level));
+	bool topRowFirst = !params.ReverseRowOrder || reverseRows;
+
+	uint8 kvd[64];
+	int kvdLength = 0;
+	kvdLength += tKTX::WriteKeyValue(kvd + kvdLength, "KTXorientation", topRowFirst ? "rd" : "ru");
+	kvdLength += tKTX::WriteKeyValue(kvd + kvdLength, "KTXwriter", "Tacent tKTX2Writer");
+
+	uint32 dfdOffset = sizeof(tKTX::KTX2Header) + numLevels*sizeof(tKTX::KTX2LevelIndex);
+	uint32 kvdOffset = dfdOffset + dfdLength;
+	int64 dataOffset = kvdOffset + kvdLength;
+
+	tKTX::KTX2Header header;
+	tStd::tMemset(&header, 0, sizeof(header));
+	tStd::tMemcpy(header.Identifier, tKTX::KTX2Identifier, sizeof(header.Identifier));
+	header.VKFormat					= vkFormat;
+	header.TypeSize					= tKTX::GetVKTypeSize(format);
+	header.PixelWidth				= width;
+	header.PixelHeight				= height;
+	header.FaceCount				= 1;
+	header.LevelCount				= numLevels;
+	header.SupercompressionScheme	= uint32(params.Supercompress ? tKTX::Scheme::Zstd : tKTX::Scheme::None);
+	header.DFDByteOffset			= dfdOffset;
+	header.DFDByteLength			= dfdLength;
+	header.KVDByteOffset			= kvdOffset;
+	header.KVDByteLength			= kvdLength;
+
+	// The level index is written by Close once the offsets and lengths are all known.
+	tKTX::KTX2LevelIndex index[tKTX::MaxKTX2Levels];
+	tStd::tMemset(index, 0, sizeof(index));
+	int64 indexLength = numLevels*sizeof(tKTX::KTX2LevelIndex);
+
+	tFileHandle handle = tSystem::tOpenFile(file.Chr(), "wb");
+	bool ok = handle &&
+		(tSystem::tWriteFile64(handle, &header, sizeof(header)) == sizeof(header)) &&
+		(tSystem::tWriteFile64(handle, index, indexLength) == indexLength) &&
+		(tSystem::tWriteFile64(handle, dfd, dfdLength) == dfdLength) &&
+		(tSystem::tWriteFile64(handle, kvd, kvdLength) == kvdLength);
+	delete[] dfd;
+	if (!ok)
+	{
+		if (handle)
+		{
+			tSystem::tCloseFile(handle);
+			tSystem::tDeleteFile(file);
+		}
+		return false;
+	}
+
+	Writer = new tKTX::Writer;
+	Writer->Filename		= file;
+	Writer->File			= handle;
+	Writer->PixelFormat		= format;
+	Writer->Supercompress	= params.Supercompress;
+	Writer->ZstdLevel		= tMath::tClamp(params.ZstdLevel, 1, ZSTD_maxCLevel());
+	Writer->ReverseRows		= reverseRows;
+	Writer->NumLevels		= numLevels;
+	Writer->WriteOffset		= dataOffset;
+	Writer->NextToWrite		= numLevels - 1;
+
+	// Without supercompression every level has a known place. They start on a multiple of both the texel block size
+	// and 4, and the smallest level goes first.
+	int blockW = tGetBlockWidth(format);
+	int blockH = tGetBlockHeight(format);
+	int alignment = bytesPerBlock;
+	while (alignment % 4)
+		alignment += bytesPerBlock;
+
+	int64 offset = dataOffset;
+	for (int level = numLevels-1; level >= 0; level--)
+	{
+		tKTX::Writer::Level& lev = Writer->Levels[level];
+		lev.Width		= tGetMipmapDim(width, level);
+		lev.Height		= tGetMipmapDim(height, level);
+		lev.NumBytes	= tGetNumBlocks(blockW, lev.Width) * tGetNumBlocks(blockH, lev.Height) * bytesPerBlock;
+		if (!params.Supercompress)
+		{
+			offset			= ((offset + alignment - 1) / alignment) * alignment;
+			lev.Offset		= offset;
+			lev.Length		= lev.NumBytes;
+			offset			+= lev.NumBytes;
+		}
+	}
+
+	if (params.Supercompress)
+	{
+		int numThreads = (params.NumThreads > 0) ? params.NumThreads : tMath::tMax(tSystem::tGetNumCores(), 1);
+		Writer->NumWorkers = tMath::tMin(numThreads, numLevels);
+		Writer->Workers = new std::thread[Writer->NumWorkers];
+		for (int t = 0; t < Writer->NumWorkers; t++)
+			Writer->Workers[t] = std::thread(&tKTX::Writer::Work, Writer);
+	}
+
+	return true;
+}
+
+
+bool tKTX2Writer::AddLevel(int level, const uint8* data, int numBytes)
+{
+	if (!Writer || !data || (level < 0) || (level >= Writer->NumLevels))
+		return false;
+
+	tKTX::Writer::Level& lev = Writer->Levels[level];
+	if (numBytes != lev.NumBytes)
+		return false;
+
+	{
+		const std::lock_guard<std::mutex> lock(Writer->Mutex);
+		if (lev.Added || Writer->Stopping)
+			return false;
+		lev.Added = true;
+	}
+
+	// Reversal happens outside the lock so levels added from different threads are prepared at the same time.
+	uint8* owned = nullptr;
+	if (Writer->ReverseRows)
+	{
+		tPixelFormat format = Writer->PixelFormat;
+		int numBlocksW = tGetNumBlocks(tGetBlockWidth(format), lev.Width);
+		int numBlocksH = tGetNumBlocks(tGetBlockHeight(format), lev.Height);
+		owned = CreateReversedRowData(data, format, numBlocksW, numBlocksH);
+		if (!owned)
+		{
+			const std::lock_guard<std::mutex> lock(Writer->Mutex);
+			Writer->Failed = true;
+			return false;
+		}
+	}
+
+	if (!Writer->Supercompress)
+	{
+		const uint8* source = owned ? owned : data;
+		bool ok = false;
+		{
+			const std::lock_guard<std::mutex> lock(Writer->Mutex);
+			ok =
+				(tSystem::tFileSeek64(Writer->File, lev.Offset) == 0) &&
+				(tSystem::tWriteFile64(Writer->File, source, numBytes) == numBytes);
+			lev.Written = ok;
+			if (!ok)
+				Writer->Failed = true;
+		}
+		delete[] owned;
+		return ok;
+	}
+
+	// The caller may free data as soon as we return, so the workers get a copy.
+	if (!owned)
+	{
+		owned = new uint8[numBytes];
+		tStd::tMemcpy(owned, data, numBytes);
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(Writer->Mutex);
+		lev.Source = owned;
+		Writer->Queue[Writer->QueueTail++] = level;
+	}
+	Writer->WorkReady.notify_one();
+	return true;
+}
+
+
+bool tKTX2Writer::AddLevel(int level, const tLayer& layer)
+{
+	if (!Writer || (level < 0) || (level >= Writer->NumLevels))
+		return false;
+
+	const tKTX::Writer::Level& lev = Writer->Levels[level];
+	if ((layer.PixelFormat != Writer->PixelFormat) || (layer.Width != lev.Width) || (layer.Height != lev.Height))
+		return false;
+
+	return AddLevel(level, layer.Data, layer.GetDataSize());
+}
+
+
+bool tKTX2Writer::Close()
+{
+	if (!Writer)
+		return false;
+
+	// The workers finish everything queued before they stop.
+	{
+		const std::lock_guard<std::mutex> lock(Writer->Mutex);
+		Writer->Stopping = true;
+	}
+	Writer->WorkReady.notify_all();
+	for (int t = 0; t < Writer->NumWorkers; t++)
+		Writer->Workers[t].join();
+	delete[] Writer->Workers;
+	Writer->Workers = nullptr;
+
+	bool success = !Writer->Failed;
+	tKTX::KTX2LevelIndex index[tKTX::MaxKTX2Levels];
+	for (int level = 0; level < Writer->NumLevels; level++)
+	{
+		tKTX::Writer::Level& lev = Writer->Levels[level];
+		success = success && lev.Written;
+		delete[] lev.Source;
+		delete[] lev.Compressed;
+
+		index[level].ByteOffset				= lev.Offset;
+		index[level].ByteLength				= lev.Length;
+		index[level].UncompressedByteLength	= lev.NumBytes;
+	}
+
+	if (success)
+	{
+		int64 indexLength = Writer->NumLevels*sizeof(tKTX::KTX2LevelIndex);
+		success =
+			(tSystem::tFileSeek64(Writer->File, sizeof(tKTX::KTX2Header)) == 0) &&
+			(tSystem::tWriteFile64(Writer->File, index, indexLength) == indexLength);
+	}
+
+	tSystem::tCloseFile(Writer->File);
+	if (!success)
+		tSystem::tDeleteFile(Writer->Filename);
+
+	delete Writer;
+	Writer = nullptr;
+	return success;
+}
+
+
+bool tKTX2Writer::Write(const tString& file, const tList<tLayer>& layers, const Params& params)
+{
+	return tKTX::WriteLayers(file, layers.First(), layers.GetNumItems(), params);
+}
+
+
+bool tKTX2Writer::Write(const tString& file, const tTexture& texture, const Params& params)
+{
+	return tKTX::WriteLayers(file, texture.GetFirstLayer(), texture.GetNumLayers(), params);
+}
+
+
+bool tKTX2Reader::Open(const tString& file)
+{
+	Close();
+	tFileHandle handle = tSystem::tOpenFile(file.Chr(), "rb");
+	if (!handle)
+		return false;
+
+	int64 fileSize = tSystem::tGetFileSize64(handle);
+	tKTX::KTX2Header header;
+	bool ok =
+		(tSystem::tReadFile64(handle, &header, sizeof(header)) == sizeof(header)) &&
+		!tStd::tMemcmp(header.Identifier, tKTX::KTX2Identifier, sizeof(header.Identifier));
+
+	// A level count of 0 asks the loader to make mipmaps. There is still one level in the file.
+	int numLevels = tMath::tMax(int(header.LevelCount), 1);
+	tKTX::Scheme scheme = tKTX::Scheme(header.SupercompressionScheme);
+	ok = ok &&
+		(header.PixelWidth > 0) && (header.PixelHeight > 0) && (header.PixelDepth == 0) && (header.LayerCount == 0) &&
+		((header.FaceCount == 1) || (header.FaceCount == 6)) && (numLevels <= tKTX::MaxKTX2Levels) &&
+		((scheme == tKTX::Scheme::None) || (scheme == tKTX::Scheme::Zstd));
+
+	tPixelFormat format = tPixelFormat::Invalid;
+	tColourProfile profile = tColourProfile::Unspecified;
+	if (ok)
+	{
+		tAlphaMode alphaMode;
+		tChannelType chanType;
+		tKTX::GetFormatInfo_FromVKFormat(format, profile, alphaMode, chanType, header.VKFormat);
+		ok = (format != tPixelFormat::Invalid) && (tGetBytesPerBlock(format) > 0);
+	}
+
+	tKTX::Reader* reader = ok ? new tKTX::Reader : nullptr;
+	if (ok)
+	{
+		int64 indexLength = numLevels*sizeof(tKTX::KTX2LevelIndex);
+		ok = (tSystem::tReadFile64(handle, reader->Levels, indexLength) == indexLength);
+		for (int level = 0; ok && (level < numLevels); level++)
+		{
+			const tKTX::KTX2LevelIndex& lev = reader->Levels[level];
+			ok = (lev.ByteOffset <= uint64(fileSize)) && (lev.ByteLength <= uint64(fileSize) - lev.ByteOffset);
+		}
+	}
+
+	// The only key we care about is the orientation. Without it the rows go down.
+	bool topRowFirst = true;
+	if (ok && (header.KVDByteLength > 0))
+	{
+		ok = (uint64(header.KVDByteOffset) + header.KVDByteLength <= uint64(fileSize));
+		uint8* kvd = ok ? new uint8[header.KVDByteLength] : nullptr;
+		ok = ok &&
+			(tSystem::tFileSeek64(handle, header.KVDByteOffset) == 0) &&
+			(tSystem::tReadFile64(handle, kvd, header.KVDByteLength) == header.KVDByteLength);
+
+		int valueLength = 0;
+		const char* orientation = ok ? tKTX::FindKeyValue(kvd, header.KVDByteLength, "KTXorientation", valueLength) : nullptr;
+		if (orientation && (valueLength >= 2) && (orientation[1] == 'u'))
+			topRowFirst = false;
+		delete[] kvd;
+	}
+
+	if (!ok)
+	{
+		delete reader;
+		tSystem::tCloseFile(handle);
+		return false;
+	}
+
+	reader->File				= handle;
+	reader->Supercompression	= scheme;
+	Reader						= reader;
+	PixelFormat					= format;
+	ColourProfile				= profile;
+	Width						= header.PixelWidth;
+	Height						= header.PixelHeight;
+	NumLevels					= numLevels;
+	NumFaces					= header.FaceCount;
+	Supercompressed				= (scheme != tKTX::Scheme::None);
+	TopRowFirst					= topRowFirst;
+	return true;
+}
+
+
+void tKTX2Reader::Close()
+{
+	if (Reader)
+		tSystem::tCloseFile(Reader->File);
+
+	delete Reader;
+	Reader				= nullptr;
+	PixelFormat			= tPixelFormat::Invalid;
+	ColourProfile		= tColourProfile::Unspecified;
+	Width				= 0;
+	Height				= 0;
+	NumLevels			= 0;
+	NumFaces			= 0;
+	Supercompressed		= false;
+	TopRowFirst			= true;
+}
+
+
+tLayer* tKTX2Reader::GetLevel(int level, int face, bool reverseRowOrder, bool* rowsReversed)
+{
+	if (rowsReversed)
+		*rowsReversed = false;
+
+	if (!Reader || (level < 0) || (level >= NumLevels) || (face < 0) || (face >= NumFaces))
+		return nullptr;
+
+	int width = tGetMipmapDim(Width, level);
+	int height = tGetMipmapDim(Height, level);
+	int numBlocksW = tGetNumBlocks(tGetBlockWidth(PixelFormat), width);
+	int numBlocksH = tGetNumBlocks(tGetBlockHeight(PixelFormat), height);
+	int64 faceBytes = int64(numBlocksW) * numBlocksH * tGetBytesPerBlock(PixelFormat);
+	// Layers and depth are rejected on open, so a level is exactly its faces. The decompression buffer is sized from
+	// UncompressedByteLength, so a level claiming any other size is refused rather than trusted.
+	const tKTX::KTX2LevelIndex& lev = Reader->Levels[level];
+	if (lev.UncompressedByteLength != uint64(faceBytes*NumFaces))
+		return nullptr;
+
+	// Without supercompression only the face asked for is read. With it the whole level is read and decompressed.
+	// Only the file access is locked so levels asked for on different threads decompress in parallel.
+	bool compressed = (Reader->Supercompression != tKTX::Scheme::None);
+	int64 readOffset = compressed ? lev.ByteOffset : lev.ByteOffset + face*faceBytes;
+	int64 readLength = compressed ? lev.ByteLength : faceBytes;
+	if (!compressed && (lev.ByteLength < uint64(faceBytes*NumFaces)))
+		return nullptr;
+
+	uint8* read = new uint8[readLength];
+	bool ok = false;
+	{
+		const std::lock_guard<std::mutex> lock(Reader->Mutex);
+		ok =
+			(tSystem::tFileSeek64(Reader->File, readOffset) == 0) &&
+			(tSystem::tReadFile64(Reader->File, read, readLength) == readLength);
+	}
+	if (!ok)
+	{
+		delete[] read;
+		return nullptr;
+	}
+
+	uint8* levelData = read;
+	int64 faceOffset = 0;
+	if (compressed)
+	{
+		levelData = new uint8[lev.UncompressedByteLength];
+		size_t result = ZSTD_decompress(levelData, size_t(lev.UncompressedByteLength), read, size_t(readLength));
+		delete[] read;
+		if (ZSTD_isError(result) || (result != size_t(lev.UncompressedByteLength)))
+		{
+			delete[] levelData;
+			return nullptr;
+		}
+		faceOffset = face*faceBytes;
+	}
+
+	uint8* data = nullptr;
+	if (reverseRowOrder && TopRowFirst && CanReverseRowData(PixelFormat, height))
+	{
+		data = CreateReversedRowData(levelData + faceOffset, PixelFormat, numBlocksW, numBlocksH);
+		if (rowsReversed)
+			*rowsReversed = (data != nullptr);
+	}
+
+	if (!data && (faceOffset == 0))
+	{
+		data = levelData;
+		levelData = nullptr;
+	}
+	else if (!data)
+	{
+		data = new uint8[faceBytes];
+		tStd::tMemcpy(data, levelData + faceOffset, int(faceBytes));
+	}
+	delete[] levelData;
+
+	return new tLayer(PixelFormat, width, height, data, true);
+}
+
+
 }
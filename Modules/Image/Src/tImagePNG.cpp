@@ -4,7 +4,7 @@
 // png file format and loads the data into a tPixel array. These tPixels may be 'stolen' by the tPicture's constructor
 // if a png file is specified. After the array is stolen the tImagePNG is invalid. This is purely for performance.
 //
-// Copyright (c) 2020, 2022-2024 Tristan Grimmer.
+// Copyright (c) 2020, 2022-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -17,8 +17,12 @@
 // The loading and saving code in here is roughly based on the example code from the LibPNG and SPNG libraries. The
 // licences may be found in Licence_LibPNG.txt and Licence_LibSPNG.txt.
 
+#include <thread>
+#include <atomic>
+#include <zlib.h>
 #include <Foundation/tArray.h>
 #include <System/tFile.h>
+#include <System/tMachine.h>
 
 // This define chooses between using LibPNG (the original png library) or the slightly cleaner/newer LibSPNG. While the
 // interface for SPNG isn't that much different, I did notice SPNG loads 16-bpc PNG files without multiplying the alpha
@@ -36,6 +40,293 @@
 #include "Image/tImageJPG.h"		// Because some jpg/jfif files have a png extension in the wild. Scary but true.
 #include "Image/tPicture.h"
 using namespace tSystem;
+
+
+namespace tImagePNGInternal
+{
+	// The row filter types from the png spec. Each filtered row starts with one of these.
+	enum Filter { Filter_None, Filter_Sub, Filter_Up, Filter_Average, Filter_Paeth, NumFilters };
+
+	// Filtered rows are deflated in bands of about this many bytes. Small enough to keep every core busy on ordinary
+	// images and big enough that the byte-aligned end of each band costs almost nothing.
+	const int BandSize = 256*1024;
+
+	// Deflate can look back this far so each band is primed with this much of the band before it.
+	const int WindowSize = 32*1024;
+
+	struct Band
+	{
+		int Start;						// Offset into the filtered rows.
+		int NumBytes;
+		uLong Adler;					// Adler-32 of just this band.
+		uint8* Deflated = nullptr;
+		int NumDeflated = 0;
+	};
+
+	// Writes a png chunk a piece at a time so the deflated bands never need to be joined into one buffer.
+	struct ChunkWriter
+	{
+		ChunkWriter(tFileHandle, const char type[4], int length);
+		void Write(const uint8* data, int numBytes);
+		bool End();
+
+		tFileHandle File;
+		uLong CRC;
+		bool Ok;
+	};
+
+	int SignedAbs(uint8 v)																								{ return (v < 128) ? v : 256 - v; }
+	int Paeth(int a, int b, int c);
+	void PutBigEndian32(uint8* dst, uint32 v)																			{ dst[0] = uint8(v >> 24); dst[1] = uint8(v >> 16); dst[2] = uint8(v >> 8); dst[3] = uint8(v); }
+
+	// Filters one row of rowBytes into dst, which gets the filter type byte followed by the filtered row. prev is the
+	// row above, all zeros for the top row. The first numFilters filters are tried and the one whose bytes, read as
+	// signed, have the smallest sum of absolute values is kept. Scratch must hold (NumFilters-1)*rowBytes bytes.
+	void FilterRow(uint8* dst, const uint8* row, const uint8* prev, int rowBytes, int bytesPerPixel, int numFilters, uint8* scratch);
+
+	// Does the work for tImagePNG::Save when SaveParams::Parallel is set. The pixel data is top row first and 16 bit
+	// components are in native order. The pixel data is modified.
+	bool SaveParallel(const tString& pngFile, uint8* pixelData, int width, int height, int bytesPerPixel, bool fast, int numThreads);
+}
+
+
+tImagePNGInternal::ChunkWriter::ChunkWriter(tFileHandle file, const char type[4], int length) :
+	File(file)
+{
+	uint8 lengthBytes[4];
+	PutBigEndian32(lengthBytes, uint32(length));
+	Ok = (tWriteFile(File, lengthBytes, 4) == 4) && (tWriteFile(File, type, 4) == 4);
+	CRC = crc32(crc32(0, Z_NULL, 0), (const uint8*)type, 4);
+}
+
+
+void tImagePNGInternal::ChunkWriter::Write(const uint8* data, int numBytes)
+{
+	if (numBytes <= 0)
+		return;
+
+	Ok = Ok && (tWriteFile(File, data, numBytes) == numBytes);
+	CRC = crc32(CRC, data, numBytes);
+}
+
+
+bool tImagePNGInternal::ChunkWriter::End()
+{
+	uint8 crcBytes[4];
+	PutBigEndian32(crcBytes, uint32(CRC));
+	return Ok && (tWriteFile(File, crcBytes, 4) == 4);
+}
+
+
+int tImagePNGInternal::Paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = tMath::tAbs(p - a);
+	int pb = tMath::tAbs(p - b);
+	int pc = tMath::tAbs(p - c);
+	if ((pa <= pb) && (pa <= pc))
+		return a;
+	return (pb <= pc) ? b : c;
+}
+
+
+void tImagePNGInternal::FilterRow(uint8* dst, const uint8* row, const uint8* prev, int rowBytes, int bytesPerPixel, int numFilters, uint8* scratch)
+{
+	uint8* sub		= scratch;
+	uint8* up		= scratch + rowBytes;
+	uint8* average	= scratch + 2*rowBytes;
+	uint8* paeth	= scratch + 3*rowBytes;
+	int sums[NumFilters] = { 0, 0, 0, 0, 0 };
+	bool allFilters = (numFilters >= NumFilters);
+
+	// All the candidate filters are worked out in one pass over the row.
+	for (int i = 0; i < rowBytes; i++)
+	{
+		int x = row[i];
+		int a = (i >= bytesPerPixel) ? row[i - bytesPerPixel] : 0;
+		int b = prev[i];
+		sums[Filter_None] += SignedAbs(x);
+
+		sub[i] = uint8(x - a);
+		sums[Filter_Sub] += SignedAbs(sub[i]);
+
+		up[i] = uint8(x - b);
+		sums[Filter_Up] += SignedAbs(up[i]);
+
+		if (allFilters)
+		{
+			int c = (i >= bytesPerPixel) ? prev[i - bytesPerPixel] : 0;
+			average[i] = uint8(x - ((a + b) >> 1));
+			sums[Filter_Average] += SignedAbs(average[i]);
+
+			paeth[i] = uint8(x - Paeth(a, b, c));
+			sums[Filter_Paeth] += SignedAbs(paeth[i]);
+		}
+	}
+
+	int best = Filter_None;
+	for (int f = Filter_Sub; f < numFilters; f++)
+		if (sums[f] < sums[best])
+			best = f;
+
+	dst[0] = uint8(best);
+	tStd::tMemcpy(dst + 1, (best == Filter_None) ? row : scratch + (best-1)*rowBytes, rowBytes);
+}
+
+
+bool tImagePNGInternal::SaveParallel(const tString& pngFile, uint8* pixelData, int width, int height, int bytesPerPixel, bool fast, int numThreads)
+{
+	// Png wants 16 bit components big-endian.
+	#ifdef ENDIAN_LITTLE
+	if (bytesPerPixel >= 6)
+		tSwapEndian((uint16*)pixelData, width*height*bytesPerPixel/2);
+	#endif
+
+	int rowBytes = width*bytesPerPixel;
+	int filteredRowBytes = rowBytes + 1;
+	int bandRows = tMath::tMax(BandSize / filteredRowBytes, 1);
+	int numBands = (height + bandRows - 1) / bandRows;
+	Band* bands = new Band[numBands];
+	for (int b = 0; b < numBands; b++)
+	{
+		int startRow = b*bandRows;
+		bands[b].Start = startRow*filteredRowBytes;
+		bands[b].NumBytes = tMath::tMin(bandRows, height - startRow)*filteredRowBytes;
+	}
+
+	if (numThreads <= 0)
+		numThreads = tMath::tMax(tGetNumCores(), 1);
+	numThreads = tMath::tMin(numThreads, numBands);
+	int numFilters = fast ? Filter_Average : NumFilters;
+	int level = fast ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION;
+
+	uint8* filtered = new uint8[height*filteredRowBytes];
+	uint8* zeroRow = new uint8[rowBytes];
+	tStd::tMemset(zeroRow, 0, rowBytes);
+	std::atomic<bool> failed(false);
+
+	// Calls fn(band, threadNum) for every band with the bands handed out to the threads as they finish.
+	auto runBands = [&](auto fn)
+	{
+		std::atomic<int> nextBand(0);
+		auto work = [&](int threadNum)
+		{
+			for (int b = nextBand++; b < numBands; b = nextBand++)
+				fn(bands[b], threadNum);
+		};
+
+		std::thread* workers = new std::thread[numThreads];
+		for (int t = 1; t < numThreads; t++)
+			workers[t] = std::thread(work, t);
+		work(0);
+		for (int t = 1; t < numThreads; t++)
+			workers[t].join();
+		delete[] workers;
+	};
+
+	// Filtering only reads the unfiltered rows so the bands are independent.
+	uint8* scratch = new uint8[numThreads*(NumFilters-1)*rowBytes];
+	runBands([&](Band& band, int threadNum)
+	{
+		uint8* threadScratch = scratch + threadNum*(NumFilters-1)*rowBytes;
+		for (int y = band.Start/filteredRowBytes; y < (band.Start + band.NumBytes)/filteredRowBytes; y++)
+		{
+			const uint8* row = pixelData + y*rowBytes;
+			const uint8* prev = y ? row - rowBytes : zeroRow;
+			FilterRow(filtered + y*filteredRowBytes, row, prev, rowBytes, bytesPerPixel, numFilters, threadScratch);
+		}
+		band.Adler = adler32(adler32(0, Z_NULL, 0), filtered + band.Start, band.NumBytes);
+	});
+	delete[] scratch;
+	delete[] zeroRow;
+
+	// Each band is a raw deflate stream primed with the filtered bytes before it. All but the last end with a sync
+	// flush so they stop on a byte boundary without a final block and the next band's output can follow straight on.
+	runBands([&](Band& band, int threadNum)
+	{
+		z_stream stream;
+		tStd::tMemset(&stream, 0, sizeof(stream));
+		if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			failed = true;
+			return;
+		}
+
+		int dictionarySize = tMath::tMin(band.Start, WindowSize);
+		if (dictionarySize)
+			deflateSetDictionary(&stream, filtered + band.Start - dictionarySize, dictionarySize);
+
+		// The bound is for a finished stream. The sync flush marker is at most a few bytes more.
+		int maxDeflated = int(deflateBound(&stream, band.NumBytes)) + 64;
+		band.Deflated = new uint8[maxDeflated];
+		stream.next_in = filtered + band.Start;
+		stream.avail_in = band.NumBytes;
+		stream.next_out = band.Deflated;
+		stream.avail_out = maxDeflated;
+
+		bool last = (&band == &bands[numBands-1]);
+		int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+		if ((result != (last ? Z_STREAM_END : Z_OK)) || stream.avail_in || !stream.avail_out)
+			failed = true;
+		band.NumDeflated = maxDeflated - stream.avail_out;
+		deflateEnd(&stream);
+	});
+	delete[] filtered;
+
+	tFileHandle file = failed ? nullptr : tOpenFile(pngFile.Chr(), "wb");
+	bool ok = (file != nullptr);
+	if (ok)
+	{
+		const uint8 signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+		ok = (tWriteFile(file, signature, 8) == 8);
+
+		// See https://www.w3.org/TR/2003/REC-PNG-20031110/#table111 for valid color-type/bit-depth combinations.
+		uint8 header[13];
+		PutBigEndian32(header + 0, uint32(width));
+		PutBigEndian32(header + 4, uint32(height));
+		header[8] = (bytesPerPixel >= 6) ? 16 : 8;
+		header[9] = ((bytesPerPixel == 4) || (bytesPerPixel == 8)) ? 6 : 2;
+		header[10] = 0;					// Deflate.
+		header[11] = 0;					// Adaptive filtering.
+		header[12] = 0;					// Not interlaced.
+		ChunkWriter ihdr(file, "IHDR", 13);
+		ihdr.Write(header, 13);
+		ok = ihdr.End() && ok;
+
+		// One IDAT per band. The zlib header goes in front of the first and the Adler-32 of all the filtered rows after
+		// the last. The header's level bits are only a hint but we set them to match.
+		uint8 zlibHeader[2] = { 0x78, uint8(fast ? 0x01 : 0x9C) };
+		uLong adler = bands[0].Adler;
+		for (int b = 1; b < numBands; b++)
+			adler = adler32_combine(adler, bands[b].Adler, bands[b].NumBytes);
+		uint8 zlibTrailer[4];
+		PutBigEndian32(zlibTrailer, uint32(adler));
+
+		for (int b = 0; b < numBands; b++)
+		{
+			bool first = (b == 0);
+			bool last = (b == numBands-1);
+			ChunkWriter idat(file, "IDAT", bands[b].NumDeflated + (first ? 2 : 0) + (last ? 4 : 0));
+			if (first)
+				idat.Write(zlibHeader, 2);
+			idat.Write(bands[b].Deflated, bands[b].NumDeflated);
+			if (last)
+				idat.Write(zlibTrailer, 4);
+			ok = idat.End() && ok;
+		}
+
+		ChunkWriter iend(file, "IEND", 0);
+		ok = iend.End() && ok;
+		tCloseFile(file);
+	}
+
+	for (int b = 0; b < numBands; b++)
+		delete[] bands[b].Deflated;
+	delete[] bands;
+	return ok;
+}
+
+
 namespace tImage
 {
 
@@ -501,11 +792,12 @@ bool tImagePNG::Set(tPicture& picture, bool steal)
 	// We don't know colour profile of tPicture.
 
 	// This is worth some explanation. If steal is true the picture becomes invalid and the
-	// 'set' call will steal the stolen pixels. If steal is false GetPixels is called and the
-	// 'set' call will memcpy them out... which makes sure the picture is still valid after and
-	// no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
+	// 'set' call will steal the stolen pixels. If steal is false the const GetPixels is called, so
+	// a picture sharing its pixels stays shared, and the 'set' call will memcpy them out... which
+	// makes sure the picture is still valid after and no-one is sharing the pixel buffer. We don't check the success of 'set' because it must
 	// succeed if picture was valid.
-	tPixel4b* pixels = steal ? picture.StealPixels() : picture.GetPixels();
+	const tPicture& src = picture;
+	tPixel4b* pixels = steal ? picture.StealPixels() : const_cast<tPixel4b*>(src.GetPixels());
 	bool success = Set(pixels, picture.GetWidth(), picture.GetHeight(), steal);
 	tAssert(success);
 	return true;
@@ -840,52 +1132,62 @@ tImagePNG::tFormat tImagePNG::Save(const tString& pngFile, const SaveParams& par
 		}
 	}
 
-	FILE* fp = fopen(pngFile.Chr(), "wb");
-	if (!fp)
+	if (params.Parallel)
 	{
+		bool saved = tImagePNGInternal::SaveParallel(pngFile, pixelData, Width, Height, bytesPerPixel, params.Fast, params.NumThreads);
 		delete[] pixelData;
-		return tFormat::Invalid;
+		if (!saved)
+			return tFormat::Invalid;
 	}
+	else
+	{
+		FILE* fp = fopen(pngFile.Chr(), "wb");
+		if (!fp)
+		{
+			delete[] pixelData;
+			return tFormat::Invalid;
+		}
 
-	// Creating an encoder context requires a flag.
-	spng_ctx* ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+		// Creating an encoder context requires a flag.
+		spng_ctx* ctx = spng_ctx_new(SPNG_CTX_ENCODER);
 
-	// Don't encode to internal buffer managed by the library. We'll be writing to a file.
-	spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 0);
-	spng_set_png_file(ctx, fp);
-	spng_set_option(ctx, SPNG_FILTER_CHOICE, SPNG_DISABLE_FILTERING);
+		// Don't encode to internal buffer managed by the library. We'll be writing to a file.
+		spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 0);
+		spng_set_png_file(ctx, fp);
+		spng_set_option(ctx, SPNG_FILTER_CHOICE, SPNG_DISABLE_FILTERING);
 
-	// Set image properties, this determines the destination image format. Start by zero-initing ihdr.
-	struct spng_ihdr ihdr = { 0 };
-	ihdr.width = Width;
-	ihdr.height = Height;
+		// Set image properties, this determines the destination image format. Start by zero-initing ihdr.
+		struct spng_ihdr ihdr = { 0 };
+		ihdr.width = Width;
+		ihdr.height = Height;
 
-	// See https://www.w3.org/TR/2003/REC-PNG-20031110/#table111 for valid color-type/bit-depth combinations.
-	switch (bytesPerPixel)
-	{
-		case 3: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;		ihdr.bit_depth = 8;		break;
-		case 4: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;	ihdr.bit_depth = 8;		break;
-		case 6: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;		ihdr.bit_depth = 16;	break;
-		case 8: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;	ihdr.bit_depth = 16;	break;
-	}
-	spng_set_ihdr(ctx, &ihdr);
+		// See https://www.w3.org/TR/2003/REC-PNG-20031110/#table111 for valid color-type/bit-depth combinations.
+		switch (bytesPerPixel)
+		{
+			case 3: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;		ihdr.bit_depth = 8;		break;
+			case 4: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;	ihdr.bit_depth = 8;		break;
+			case 6: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;		ihdr.bit_depth = 16;	break;
+			case 8: ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;	ihdr.bit_depth = 16;	break;
+		}
+		spng_set_ihdr(ctx, &ihdr);
+
+		// This is the source data format. SPNG_FMT_PNG is a special value that matches the format in ihdr
+		// The encode call only works if the format is SPNG_FMT_PNG (machine-endian) or SPNG_FMT_RAW (big-endian).
+		// SPNG_ENCODE_FINALIZE will finalize the PNG with the end-of-file marker.
+		int errCode = spng_encode_image(ctx, pixelData, Width*Height*bytesPerPixel, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+		if (errCode)
+		{
+			fclose(fp);
+			spng_ctx_free(ctx);
+			delete[] pixelData;
+			return tFormat::Invalid;
+		}
 
-	// This is the source data format. SPNG_FMT_PNG is a special value that matches the format in ihdr
-	// The encode call only works if the format is SPNG_FMT_PNG (machine-endian) or SPNG_FMT_RAW (big-endian).
-	// SPNG_ENCODE_FINALIZE will finalize the PNG with the end-of-file marker.
-	int errCode = spng_encode_image(ctx, pixelData, Width*Height*bytesPerPixel, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
-	if (errCode)
-	{
 		fclose(fp);
 		spng_ctx_free(ctx);
 		delete[] pixelData;
-		return tFormat::Invalid;
 	}
 
-	fclose(fp);
-	spng_ctx_free(ctx);
-	delete[] pixelData;
-
 	switch (bytesPerPixel)
 	{
 		case 3:		return tFormat::BPP24_RGB_BPC8;
@@ -9,7 +9,7 @@
 // layer, and gif/webp/apng images may be animated and have more than one frame. A tPicture can only prepresent _one_
 // of these frames.
 //
-// Copyright (c) 2006, 2016, 2017, 2020-2024 Tristan Grimmer.
+// Copyright (c) 2006, 2016, 2017, 2020-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -29,6 +29,7 @@
 const char* ASTCENCODER_VERSION_STRING		= VERSION_STRING;
 #undef VERSION_STRING
 
+#include <Foundation/tArray.h>
 #include "Image/tPicture.h"
 #include "Image/tQuantize.h"
 #include "Math/tMatrix2.h"
@@ -47,6 +48,9 @@ const char* ASTCENCODER_VERSION_STRING		= VERSION_STRING;
 #include <tinyxml2.h>
 #include <TinyEXIF.h>
 #include "Image/tResample.h"
+#include "System/tMachine.h"
+#include <thread>
+#include <atomic>
 
 
 using namespace tMath;
@@ -54,6 +58,107 @@ using namespace tImage;
 using namespace tSystem;
 
 
+namespace tPictureInternal
+{
+	// Calls fn(start, end) for ranges of pixels that together cover [0, numPixels), on as many threads as there are
+	// cores. Small images are done on the calling thread since starting threads would cost more than it saves.
+	template<typename Fn> void ForPixelRanges(int numPixels, Fn fn);
+
+	// Where to sample the source for each pixel along one axis of a mipmap level. Index holds the source pixels,
+	// already wrapped or clamped, and Weight their normalized weights. Each destination pixel has Count of them
+	// starting at Start.
+	struct MipWeights
+	{
+		void Compute(int srcSize, int dstSize, tResampleFilter, tResampleEdgeMode);
+		tArray<int> Start, Count, Index;
+		tArray<float> Weight;
+	};
+
+	struct MipLevel
+	{
+		int PictureNum;
+		int Width, Height;
+		uint8* Pixels;					// Owned by the layer.
+		MipWeights Cols, Rows;
+	};
+
+	// Where a crop of a width by height image to newW by newH puts its origin for the anchor.
+	void GetAnchorOrigin(tPicture::Anchor, int width, int height, int newW, int newH, int& originx, int& originy);
+
+	// Maps a pixel of the image being made by a fused OpChain stage back to a pixel of an earlier image in the chain.
+	// Flips, 90 degree rotates, and crops only ever move whole rows and columns, so the A and B terms are all 0, 1, or
+	// -1. Starts as the identity.
+	struct OpMap
+	{
+		int GetX(int x, int y) const																					{ return AX*x + BX*y + CX; }
+		int GetY(int x, int y) const																					{ return AY*x + BY*y + CY; }
+
+		// Returns the map that does m first and then this one.
+		OpMap After(const OpMap& m) const;
+		bool IsIdentity() const																							{ return (AX == 1) && !BX && !CX && !AY && (BY == 1) && !CY; }
+		int AX = 1, BX = 0, CX = 0;
+		int AY = 0, BY = 1, CY = 0;
+	};
+
+	// Pixels that Map takes outside of Width by Height were removed by a crop and become Fill instead.
+	struct OpCrop
+	{
+		OpMap Map;
+		int Width, Height;
+		tPixel4b Fill;					// With the colour operations after the crop already done to it.
+		int NumColourOpsBefore;
+		bool Inside(int x, int y) const																					{ int cx = Map.GetX(x, y); int cy = Map.GetY(x, y); return (cx >= 0) && (cy >= 0) && (cx < Width) && (cy < Height); }
+	};
+
+	struct OpColour
+	{
+		enum class Kind { Swizzle, Spread, Intensity, AlphaBlendColour };
+		Kind Type;
+		tComp Comps[4];				// Swizzle. Spread uses the first.
+		comp_t Channels;
+		tColour4b Colour;
+		int FinalAlpha;
+		void Run(tPixel4b* pixels, int numPixels) const;
+	};
+
+	// The flips, rotates, crops, and colour operations between two resamples.
+	struct OpStage
+	{
+		void Reset(int width, int height)																				{ SrcW = DstW = width; SrcH = DstH = height; ToSrc = OpMap(); Crops.Clear(); Colours.Clear(); }
+		bool IsIdentity() const																							{ return ToSrc.IsIdentity() && !Crops.GetNumElements() && !Colours.GetNumElements(); }
+		void Then(const OpMap& m, int newW, int newH);
+		void Run(const tPixel4b* src, tPixel4b* dst, int numThreads);
+		void RunTile(const tPixel4b* src, tPixel4b* dst, int x0, int y0, int x1, int y1) const;
+
+		static const int TileSize = 64;
+		int SrcW, SrcH;
+		int DstW, DstH;
+		OpMap ToSrc;
+		tArray<OpCrop> Crops;
+		tArray<OpColour> Colours;
+	};
+}
+
+
+template<typename Fn> void tPictureInternal::ForPixelRanges(int numPixels, Fn fn)
+{
+	const int minPixelsPerThread = 64*1024;
+	int numThreads = tClamp(numPixels / minPixelsPerThread, 1, tMax(tGetNumCores(), 1));
+	if (numThreads == 1)
+	{
+		fn(0, numPixels);
+		return;
+	}
+
+	std::thread* workers = new std::thread[numThreads];
+	for (int t = 0; t < numThreads; t++)
+		workers[t] = std::thread(fn, int(int64(numPixels) * t / numThreads), int(int64(numPixels) * (t+1) / numThreads));
+	for (int t = 0; t < numThreads; t++)
+		workers[t].join();
+	delete[] workers;
+}
+
+
 const char* tImage::Version_LibJpegTurbo	= LIBJPEG_TURBO_VERSION;
 const char* tImage::Version_ASTCEncoder		= ASTCENCODER_VERSION_STRING;
 const char* tImage::Version_OpenEXR			= OPENEXR_VERSION_STRING;
@@ -172,16 +277,32 @@ void tPicture::RotateCenter(float angle, const tPixel4b& fill, tResampleFilter u
 }
 
 
-void tPicture::RotateCenterNearest(const tMatrix2& rotMat, const tMatrix2& invRot, const tPixel4b& fill)
+void tPicture::RotateCenterDirect(float angle, const tPixel4b& fill, tResampleFilter filter, int numThreads)
 {
-	int srcW = Width;
-	int srcH = Height;
+	if (!IsValid() || (filter == tResampleFilter::None))
+		return;
+
+	tMatrix2 rotMat;
+	rotMat.MakeRotateZ(angle);
+	int newW = 0, newH = 0;
+	GetRotatedSize(rotMat, newW, newH);
+
+	tPixel4b* newPixels = new tPixel4b[newW*newH];
+	bool success = tImage::ResampleRotate(Pixels, Width, Height, newPixels, newW, newH, angle, fill, filter, numThreads);
+	tAssert(success);
+
+	PixelShare.Release(Pixels);
+	Width = newW;
+	Height = newH;
+	Pixels = newPixels;
+}
+
 
-	// Rotate all corners to get new size. Memfill it with fill colour. Map from old to new.
+void tPicture::GetRotatedSize(const tMatrix2& rotMat, int& newW, int& newH) const
+{
+	// Rotate all corners to get new size.
 	float srcHalfW = float(Width)/2.0f;
 	float srcHalfH = float(Height)/2.0f;
-	tPixel4b* srcPixels = Pixels;
-
 	tVector2 tl(-srcHalfW,  srcHalfH);
 	tVector2 tr( srcHalfW,  srcHalfH);
 	tVector2 bl(-srcHalfW, -srcHalfH);
@@ -192,8 +313,21 @@ void tPicture::RotateCenterNearest(const tMatrix2& rotMat, const tMatrix2& invRo
 	int miny = int(tFloor(tRound(tMin(tl.y, tr.y, bl.y, br.y), epsilon)));
 	int maxx = int(tCeiling(tRound(tMax(tl.x, tr.x, bl.x, br.x), epsilon)));
 	int maxy = int(tCeiling(tRound(tMax(tl.y, tr.y, bl.y, br.y), epsilon)));
-	Width = maxx - minx;
-	Height = maxy - miny;
+	newW = maxx - minx;
+	newH = maxy - miny;
+}
+
+
+void tPicture::RotateCenterNearest(const tMatrix2& rotMat, const tMatrix2& invRot, const tPixel4b& fill)
+{
+	int srcW = Width;
+	int srcH = Height;
+
+	// Get the new size. Map from old to new.
+	float srcHalfW = float(Width)/2.0f;
+	float srcHalfH = float(Height)/2.0f;
+	tPixel4b* srcPixels = Pixels;
+	GetRotatedSize(rotMat, Width, Height);
 
 	Pixels = new tPixel4b[Width*Height];
 	float halfW = float(Width)/2.0f;
@@ -224,7 +358,8 @@ void tPicture::RotateCenterNearest(const tMatrix2& rotMat, const tMatrix2& invRo
 		}
 	}
 
-	delete[] srcPixels;
+	// The share went with the source pixels.
+	PixelShare.Release(srcPixels);
 }
 
 
@@ -290,23 +425,31 @@ bool tPicture::Crop(int newW, int newH, Anchor anchor, const tColour4b& fill)
 {
 	int originx = 0;
 	int originy = 0;
+	tPictureInternal::GetAnchorOrigin(anchor, Width, Height, newW, newH, originx, originy);
+	return Crop(newW, newH, originx, originy, fill);
+}
+
+
+void tPictureInternal::GetAnchorOrigin(tPicture::Anchor anchor, int width, int height, int newW, int newH, int& originx, int& originy)
+{
+	using Anchor = tPicture::Anchor;
+	originx = 0;
+	originy = 0;
 
 	switch (anchor)
 	{
-		case Anchor::LeftTop:		originx = 0;				originy = Height-newH;		break;
-		case Anchor::MiddleTop:		originx = Width/2 - newW/2;	originy = Height-newH;		break;
-		case Anchor::RightTop:		originx = Width - newW;		originy = Height-newH;		break;
+		case Anchor::LeftTop:		originx = 0;				originy = height-newH;		break;
+		case Anchor::MiddleTop:		originx = width/2 - newW/2;	originy = height-newH;		break;
+		case Anchor::RightTop:		originx = width - newW;		originy = height-newH;		break;
 
-		case Anchor::LeftMiddle:	originx = 0;				originy = Height/2-newH/2;	break;
-		case Anchor::MiddleMiddle:	originx = Width/2 - newW/2;	originy = Height/2-newH/2;	break;
-		case Anchor::RightMiddle:	originx = Width - newW;		originy = Height/2-newH/2;	break;
+		case Anchor::LeftMiddle:	originx = 0;				originy = height/2-newH/2;	break;
+		case Anchor::MiddleMiddle:	originx = width/2 - newW/2;	originy = height/2-newH/2;	break;
+		case Anchor::RightMiddle:	originx = width - newW;		originy = height/2-newH/2;	break;
 
 		case Anchor::LeftBottom:	originx = 0;				originy = 0;				break;
-		case Anchor::MiddleBottom:	originx = Width/2 - newW/2;	originy = 0;				break;
-		case Anchor::RightBottom:	originx = Width - newW;		originy = 0;				break;
+		case Anchor::MiddleBottom:	originx = width/2 - newW/2;	originy = 0;				break;
+		case Anchor::RightBottom:	originx = width - newW;		originy = 0;				break;
 	}
-
-	return Crop(newW, newH, originx, originy, fill);
 }
 
 
@@ -542,6 +685,7 @@ bool tPicture::QuantizeFixed(int numColours, bool checkExact)
 	}
 
 	// Now that we have the palette we can convert back into the pixel array.
+	Unshare();
 	ok = tQuantize::ConvertToPixels(Pixels, Width, Height, destPalette, destIndices, true);
 	delete[] destIndices;
 	delete[] destPalette;
@@ -566,6 +710,7 @@ bool tPicture::QuantizeSpatial(int numColours, bool checkExact, double ditherLev
 	}
 
 	// Now that we have the palette we can convert back into the pixel array (preserving alpha).
+	Unshare();
 	ok = tQuantize::ConvertToPixels(Pixels, Width, Height, destPalette, destIndices, checkExact);
 	delete[] destIndices;
 	delete[] destPalette;
@@ -590,6 +735,7 @@ bool tPicture::QuantizeNeu(int numColours, bool checkExact, int sampleFactor)
 	}
 
 	// Now that we have the palette we can convert back into the pixel array (preserving alpha).
+	Unshare();
 	ok = tQuantize::ConvertToPixels(Pixels, Width, Height, destPalette, destIndices, true);
 	delete[] destIndices;
 	delete[] destPalette;
@@ -614,6 +760,7 @@ bool tPicture::QuantizeWu(int numColours, bool checkExact)
 	}
 
 	// Now that we have the palette we can convert back into the pixel array (preserving alpha).
+	Unshare();
 	ok = tQuantize::ConvertToPixels(Pixels, Width, Height, destPalette, destIndices, true);
 	delete[] destIndices;
 	delete[] destPalette;
@@ -630,42 +777,75 @@ bool tPicture::AdjustmentBegin()
 
 	// We need to compute min and max component values so the extents of the brigtness parameter
 	// exactly match all black at 0 and full white at 1. We do this as we copy the pixel values.
+	// Each thread counts into its own integer histograms. Alpha weights are summed as integers so
+	// the totals do not depend on how the pixels were split up.
+	struct Counts
+	{
+		uint64 R[NumGroups], G[NumGroups], B[NumGroups], A[NumGroups], I[NumGroups];
+		int RGBMin, RGBMax;
+	};
+	int maxThreads = tMax(tGetNumCores(), 1);
+	Counts* counts = new Counts[maxThreads];
+	tStd::tMemset(counts, 0, maxThreads*sizeof(Counts));
+	std::atomic<int> nextCounts(0);
+
+	tPictureInternal::ForPixelRanges(Width*Height, [this, counts, &nextCounts](int start, int end)
+	{
+		Counts& count = counts[nextCounts++];
+		count.RGBMin = 256;
+		count.RGBMax = -1;
+		for (int p = start; p < end; p++)
+		{
+			tColour4b& colour = Pixels[p];
+
+			// Min/max. All RGB components considered.
+			int minRGB = tMath::tMin(colour.R, colour.G, colour.B);
+			int maxRGB = tMath::tMax(colour.R, colour.G, colour.B);
+			if (minRGB < count.RGBMin)
+				count.RGBMin = minRGB;
+			if (maxRGB > count.RGBMax)
+				count.RGBMax = maxRGB;
+
+			// Histograms.
+			count.R[colour.R] += colour.A;
+			count.G[colour.G] += colour.A;
+			count.B[colour.B] += colour.A;
+			count.A[colour.A] += 1;
+			count.I[colour.Intensity()] += colour.A;
+
+			OriginalPixels[p] = colour;
+		}
+	});
+
 	BrightnessRGBMin = 256;
 	BrightnessRGBMax = -1;
-
-	tStd::tMemset(HistogramR, 0, sizeof(HistogramR));	MaxRCount = 0.0f;
-	tStd::tMemset(HistogramG, 0, sizeof(HistogramG));	MaxGCount = 0.0f;
-	tStd::tMemset(HistogramB, 0, sizeof(HistogramB));	MaxBCount = 0.0f;
-	tStd::tMemset(HistogramA, 0, sizeof(HistogramA));	MaxACount = 0.0f;
-	tStd::tMemset(HistogramI, 0, sizeof(HistogramI));	MaxICount = 0.0f;
-	for (int p = 0; p < Width*Height; p++)
-	{
-		tColour4b& colour = Pixels[p];
-
-		// Min/max. All RGB components considered.
-		int minRGB = tMath::tMin(colour.R, colour.G, colour.B);
-		int maxRGB = tMath::tMax(colour.R, colour.G, colour.B);
-		if (minRGB < BrightnessRGBMin)
-			BrightnessRGBMin = minRGB;
-		if (maxRGB > BrightnessRGBMax)
-			BrightnessRGBMax = maxRGB;
-
-		// Histograms.
-		float alpha = colour.GetA();
-		HistogramR[colour.R] += alpha;
-		HistogramG[colour.G] += alpha;
-		HistogramB[colour.B] += alpha;
-		HistogramA[colour.A] += 1.0f;
-		HistogramI[colour.Intensity()] += alpha;
-
-		OriginalPixels[p] = colour;
+	uint64 totalR[NumGroups] = { }, totalG[NumGroups] = { }, totalB[NumGroups] = { }, totalA[NumGroups] = { }, totalI[NumGroups] = { };
+	int numCounts = nextCounts;
+	for (int c = 0; c < numCounts; c++)
+	{
+		Counts& count = counts[c];
+		BrightnessRGBMin = tMin(BrightnessRGBMin, count.RGBMin);
+		BrightnessRGBMax = tMax(BrightnessRGBMax, count.RGBMax);
+		for (int g = 0; g < NumGroups; g++)
+		{
+			totalR[g] += count.R[g];	totalG[g] += count.G[g];	totalB[g] += count.B[g];
+			totalA[g] += count.A[g];	totalI[g] += count.I[g];
+		}
 	}
+	delete[] counts;
 	tiClamp(BrightnessRGBMin, 0, 255);
 	tiClamp(BrightnessRGBMax, 0, 255);
 
-	// Find max counts for the histograms so we can normalize if needed.
+	// Find max counts for the histograms so we can normalize if needed. Alpha is in [0,1] for the weights.
+	MaxRCount = 0.0f;	MaxGCount = 0.0f;	MaxBCount = 0.0f;	MaxACount = 0.0f;	MaxICount = 0.0f;
 	for (int g = 0; g < NumGroups; g++)
 	{
+		HistogramR[g] = float(totalR[g]) / 255.0f;
+		HistogramG[g] = float(totalG[g]) / 255.0f;
+		HistogramB[g] = float(totalB[g]) / 255.0f;
+		HistogramA[g] = float(totalA[g]);
+		HistogramI[g] = float(totalI[g]) / 255.0f;
+
 		if (HistogramR[g] > MaxRCount)		MaxRCount = HistogramR[g];
 		if (HistogramG[g] > MaxGCount)		MaxGCount = HistogramG[g];
 		if (HistogramB[g] > MaxBCount)		MaxBCount = HistogramB[g];
@@ -677,6 +857,32 @@ bool tPicture::AdjustmentBegin()
 }
 
 
+void tPicture::AdjustApplyLUT(const uint8 lut[NumGroups], comp_t comps)
+{
+	// Components not being adjusted keep whatever value they have now, so the looked-up pixel is merged in with a
+	// byte mask.
+	tPixel4b maskPixel
+	(
+		uint8((comps & tCompBit_R) ? 0xFF : 0x00), uint8((comps & tCompBit_G) ? 0xFF : 0x00),
+		uint8((comps & tCompBit_B) ? 0xFF : 0x00), uint8((comps & tCompBit_A) ? 0xFF : 0x00)
+	);
+	uint32 mask = maskPixel.BP;
+	if (!mask)
+		return;
+
+	Unshare();
+	tPictureInternal::ForPixelRanges(Width*Height, [this, lut, mask](int start, int end)
+	{
+		for (int p = start; p < end; p++)
+		{
+			const tPixel4b& srcColour = OriginalPixels[p];
+			tPixel4b adjColour(lut[srcColour.R], lut[srcColour.G], lut[srcColour.B], lut[srcColour.A]);
+			Pixels[p].BP = (adjColour.BP & mask) | (Pixels[p].BP & ~mask);
+		}
+	});
+}
+
+
 bool tPicture::AdjustBrightness(float brightness, comp_t comps)
 {
 	if (!IsValid() || !OriginalPixels)
@@ -690,16 +896,14 @@ bool tPicture::AdjustBrightness(float brightness, comp_t comps)
 	int fullOffset = 255 - BrightnessRGBMin;
 	float offsetFlt = tMath::tLinearInterp(brightness, 0.0f, 1.0f, float(zeroOffset), float(fullOffset));
 	int offset = int(offsetFlt);
-	for (int p = 0; p < Width*Height; p++)
-	{
-		tColour4b& srcColour = OriginalPixels[p];
-		tColour4b& adjColour = Pixels[p];
-		if (comps & tCompBit_R)	adjColour.R = tClamp(int(srcColour.R) + offset, 0, 255);
-		if (comps & tCompBit_G)	adjColour.G = tClamp(int(srcColour.G) + offset, 0, 255);
-		if (comps & tCompBit_B)	adjColour.B = tClamp(int(srcColour.B) + offset, 0, 255);
-		if (comps & tCompBit_A)	adjColour.A = tClamp(int(srcColour.A) + offset, 0, 255);
-	}
 
+	// Every component value maps to the same adjusted value, so the mapping is computed once for each of the 256
+	// possible values and then looked up for every pixel.
+	uint8 lut[NumGroups];
+	for (int v = 0; v < NumGroups; v++)
+		lut[v] = tClamp(v + offset, 0, 255);
+
+	AdjustApplyLUT(lut, comps);
 	return true;
 }
 
@@ -725,16 +929,11 @@ bool tPicture::AdjustContrast(float contrastNorm, comp_t comps)
 
 	// The 259 is correct. Not a typo.
 	float factor = (259.0f * (contrast + 255.0f)) / (255.0f * (259.0f - contrast));
-	for (int p = 0; p < Width*Height; p++)
-	{
-		tColour4b& srcColour = OriginalPixels[p];
-		tColour4b& adjColour = Pixels[p];
-		if (comps & tCompBit_R)	adjColour.R = tClamp(int(factor * (float(srcColour.R) - 128.0f) + 128.0f), 0, 255);
-		if (comps & tCompBit_G)	adjColour.G = tClamp(int(factor * (float(srcColour.G) - 128.0f) + 128.0f), 0, 255);
-		if (comps & tCompBit_B)	adjColour.B = tClamp(int(factor * (float(srcColour.B) - 128.0f) + 128.0f), 0, 255);
-		if (comps & tCompBit_A)	adjColour.A = tClamp(int(factor * (float(srcColour.A) - 128.0f) + 128.0f), 0, 255);
-	}
+	uint8 lut[NumGroups];
+	for (int v = 0; v < NumGroups; v++)
+		lut[v] = tClamp(int(factor * (float(v) - 128.0f) + 128.0f), 0, 255);
 
+	AdjustApplyLUT(lut, comps);
 	return true;
 }
 
@@ -792,30 +991,24 @@ bool tPicture::AdjustLevels(float blackPoint, float midPoint, float whitePoint,
 		gamma = 1.0f/gamma;
 	}
 
-	// Apply for every pixel.
-	for (int p = 0; p < Width*Height; p++)
+	// Compute the curve for every possible component value.
+	uint8 lut[NumGroups];
+	for (int v = 0; v < NumGroups; v++)
 	{
-		tColour4b& srcColour = OriginalPixels[p];
-		tColour4b& dstColour = Pixels[p];
+		float src = float(v)/255.0f;
 
-		for (int e = 0; e < 4; e++)
-		{
-			if ((1 << e) & comps)
-			{
-				float src = float(srcColour.E[e])/255.0f;
+		// Black/white levels.
+		float adj = (src - blackPoint) / (whitePoint - blackPoint);
 
-				// Black/white levels.
-				float adj = (src - blackPoint) / (whitePoint - blackPoint);
+		// Midtones.
+		adj = tPow(adj, gamma);
 
-				// Midtones.
-				adj = tPow(adj, gamma);
-
-				// Output black/white levels.
-				adj = blackOut + adj*(whiteOut - blackOut);
-				dstColour.E[e] = tClamp(int(adj*255.0f), 0, 255);
-			}
-		}
+		// Output black/white levels.
+		adj = blackOut + adj*(whiteOut - blackOut);
+		lut[v] = tClamp(int(adj*255.0f), 0, 255);
 	}
+
+	AdjustApplyLUT(lut, comps);
 	return true;
 }
 
@@ -839,6 +1032,7 @@ bool tPicture::AdjustRestoreOriginal()
 	if (!IsValid() || !OriginalPixels)
 		return false;
 
+	Unshare();
 	tStd::tMemcpy(Pixels, OriginalPixels, Width*Height*sizeof(tPixel4b));
 	return true;
 }
@@ -966,7 +1160,7 @@ bool tPicture::Resample(int width, int height, tResampleFilter filter, tResample
 		return false;
 	}
 
-	delete[] Pixels;
+	PixelShare.Release(Pixels);
 	Pixels = newPixels;
 	Width = width;
 	Height = height;
@@ -975,6 +1169,473 @@ bool tPicture::Resample(int width, int height, tResampleFilter filter, tResample
 }
 
 
+tPicture::OpChain::Op& tPicture::OpChain::Add(OpType type)
+{
+	Op op;
+	op.Type = type;
+	Ops.Append(op);
+	return Ops[Ops.GetNumElements()-1];
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Flip(bool horizontal)
+{
+	Add(OpType::Flip).Flag = horizontal;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Rotate90(bool antiClockwise)
+{
+	Add(OpType::Rotate90).Flag = antiClockwise;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Crop(int newW, int newH, Anchor anchor, const tColour4b& fill)
+{
+	Op& op = Add(OpType::CropAnchor);
+	op.Width = newW;
+	op.Height = newH;
+	op.CropAnchor = anchor;
+	op.Colour = fill;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Crop(int newW, int newH, int originX, int originY, const tColour4b& fill)
+{
+	Op& op = Add(OpType::Crop);
+	op.Width = newW;
+	op.Height = newH;
+	op.OriginX = originX;
+	op.OriginY = originY;
+	op.Colour = fill;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Resample(int width, int height, tResampleFilter filter, tResampleEdgeMode edgeMode)
+{
+	Op& op = Add(OpType::Resample);
+	op.Width = width;
+	op.Height = height;
+	op.Filter = filter;
+	op.EdgeMode = edgeMode;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Swizzle(tComp R, tComp G, tComp B, tComp A)
+{
+	Op& op = Add(OpType::Swizzle);
+	op.Comps[0] = R;	op.Comps[1] = G;	op.Comps[2] = B;	op.Comps[3] = A;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Spread(tComp channel)
+{
+	Add(OpType::Spread).Comps[0] = channel;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::Intensity(comp_t channels)
+{
+	Add(OpType::Intensity).Channels = channels;
+	return *this;
+}
+
+
+tPicture::OpChain& tPicture::OpChain::AlphaBlendColour(const tColour4b& blendColour, comp_t channels, int finalAlpha)
+{
+	Op& op = Add(OpType::AlphaBlendColour);
+	op.Colour = blendColour;
+	op.Channels = channels;
+	op.FinalAlpha = finalAlpha;
+	return *this;
+}
+
+
+bool tPicture::Apply(const OpChain& chain, int numThreads)
+{
+	if (!IsValid())
+		return false;
+
+	// Sizes are checked first so a bad chain never leaves the picture half done.
+	const OpChain::Op* ops = chain.Ops.GetElements();
+	int numOps = chain.Ops.GetNumElements();
+	for (int o = 0; o < numOps; o++)
+	{
+		const OpChain::Op& op = ops[o];
+		bool sized = (op.Type == OpChain::OpType::Crop) || (op.Type == OpChain::OpType::CropAnchor) || (op.Type == OpChain::OpType::Resample);
+		if (sized && ((op.Width <= 0) || (op.Height <= 0)))
+			return false;
+	}
+
+	using namespace tPictureInternal;
+	OpStage stage;
+	stage.Reset(Width, Height);
+
+	// The pixels the current stage reads from. Either ours or the result of a resample.
+	tPixel4b* pixels = Pixels;
+	for (int o = 0; o < numOps; o++)
+	{
+		const OpChain::Op& op = ops[o];
+		switch (op.Type)
+		{
+			case OpChain::OpType::Flip:
+			{
+				OpMap flip;
+				if (op.Flag)	{ flip.AX = -1;	flip.CX = stage.DstW-1; }
+				else			{ flip.BY = -1;	flip.CY = stage.DstH-1; }
+				stage.Then(flip, stage.DstW, stage.DstH);
+				break;
+			}
+
+			case OpChain::OpType::Rotate90:
+			{
+				// Same mapping as Rotate90. The new image is DstH wide and DstW high.
+				OpMap rot;
+				rot.AX = 0;		rot.BY = 0;
+				if (op.Flag)	{ rot.BX =  1;	rot.AY = -1;	rot.CY = stage.DstH-1; }
+				else			{ rot.BX = -1;	rot.AY =  1;	rot.CX = stage.DstW-1; }
+				stage.Then(rot, stage.DstH, stage.DstW);
+				break;
+			}
+
+			case OpChain::OpType::Crop:
+			case OpChain::OpType::CropAnchor:
+			{
+				int originX = op.OriginX;
+				int originY = op.OriginY;
+				if (op.Type == OpChain::OpType::CropAnchor)
+					GetAnchorOrigin(op.CropAnchor, stage.DstW, stage.DstH, op.Width, op.Height, originX, originY);
+				if ((op.Width == stage.DstW) && (op.Height == stage.DstH) && !originX && !originY)
+					break;
+
+				// The crop keeps the pixels that land inside the image as it is now. Then() moves the map along with
+				// the rest as more operations are added.
+				OpCrop crop;
+				crop.Width = stage.DstW;
+				crop.Height = stage.DstH;
+				crop.Fill = op.Colour;
+				crop.NumColourOpsBefore = stage.Colours.GetNumElements();
+				stage.Crops.Append(crop);
+
+				OpMap offset;
+				offset.CX = originX;
+				offset.CY = originY;
+				stage.Then(offset, op.Width, op.Height);
+				break;
+			}
+
+			case OpChain::OpType::Swizzle:
+			{
+				OpColour colour;
+				colour.Type = OpColour::Kind::Swizzle;
+				const tComp defaults[4] = { tComp::R, tComp::G, tComp::B, tComp::A };
+				bool identity = true;
+				for (int c = 0; c < 4; c++)
+				{
+					colour.Comps[c] = (op.Comps[c] == tComp::Auto) ? defaults[c] : op.Comps[c];
+					identity = identity && (colour.Comps[c] == defaults[c]);
+				}
+				if (!identity)
+					stage.Colours.Append(colour);
+				break;
+			}
+
+			case OpChain::OpType::Spread:
+			{
+				OpColour colour;
+				colour.Type = OpColour::Kind::Spread;
+				colour.Comps[0] = op.Comps[0];
+				stage.Colours.Append(colour);
+				break;
+			}
+
+			case OpChain::OpType::Intensity:
+			{
+				if (!op.Channels)
+					break;
+				OpColour colour;
+				colour.Type = OpColour::Kind::Intensity;
+				colour.Channels = op.Channels;
+				stage.Colours.Append(colour);
+				break;
+			}
+
+			case OpChain::OpType::AlphaBlendColour:
+			{
+				OpColour colour;
+				colour.Type = OpColour::Kind::AlphaBlendColour;
+				colour.Colour = op.Colour;
+				colour.Channels = op.Channels;
+				colour.FinalAlpha = tClamp(op.FinalAlpha, -1, 255);
+				stage.Colours.Append(colour);
+				break;
+			}
+
+			case OpChain::OpType::Resample:
+			{
+				if ((op.Width == stage.DstW) && (op.Height == stage.DstH))
+					break;
+
+				// The resample needs every pixel of the stage before it.
+				if (!stage.IsIdentity())
+				{
+					tPixel4b* staged = new tPixel4b[stage.DstW*stage.DstH];
+					stage.Run(pixels, staged, numThreads);
+					if (pixels != Pixels)
+						delete[] pixels;
+					pixels = staged;
+				}
+
+				tPixel4b* resampled = new tPixel4b[op.Width*op.Height];
+				bool success = tImage::Resample(pixels, stage.DstW, stage.DstH, resampled, op.Width, op.Height, op.Filter, op.EdgeMode);
+				if (pixels != Pixels)
+					delete[] pixels;
+				if (!success)
+				{
+					delete[] resampled;
+					return false;
+				}
+				pixels = resampled;
+				stage.Reset(op.Width, op.Height);
+				break;
+			}
+		}
+	}
+
+	if (!stage.IsIdentity())
+	{
+		tPixel4b* staged = new tPixel4b[stage.DstW*stage.DstH];
+		stage.Run(pixels, staged, numThreads);
+		if (pixels != Pixels)
+			delete[] pixels;
+		pixels = staged;
+	}
+
+	// Nothing in the chain changed anything.
+	if (pixels == Pixels)
+		return true;
+
+	PixelShare.Release(Pixels);
+	Pixels = pixels;
+	Width = stage.DstW;
+	Height = stage.DstH;
+
+	// Any adjustment session is over since the original pixels no longer line up.
+	delete[] OriginalPixels;
+	OriginalPixels = nullptr;
+	return true;
+}
+
+
+tPictureInternal::OpMap tPictureInternal::OpMap::After(const OpMap& m) const
+{
+	OpMap r;
+	r.AX = AX*m.AX + BX*m.AY;	r.BX = AX*m.BX + BX*m.BY;	r.CX = AX*m.CX + BX*m.CY + CX;
+	r.AY = AY*m.AX + BY*m.AY;	r.BY = AY*m.BX + BY*m.BY;	r.CY = AY*m.CX + BY*m.CY + CY;
+	return r;
+}
+
+
+void tPictureInternal::OpColour::Run(tPixel4b* pixels, int numPixels) const
+{
+	// Each case does exactly what the tPicture function of the same name does to a pixel.
+	switch (Type)
+	{
+		case Kind::Swizzle:
+		{
+			auto get = [](tComp comp, const tColour4b& src, uint8 other) -> uint8
+			{
+				switch (comp)
+				{
+					case tComp::Zero:	return 0;
+					case tComp::Full:	return 255;
+					case tComp::R:		return src.R;
+					case tComp::G:		return src.G;
+					case tComp::B:		return src.B;
+					case tComp::A:		return src.A;
+					default:			return other;
+				}
+			};
+			for (int p = 0; p < numPixels; p++)
+			{
+				tColour4b src = pixels[p];
+				pixels[p].Set(get(Comps[0], src, 0), get(Comps[1], src, 0), get(Comps[2], src, 0), get(Comps[3], src, 255));
+			}
+			break;
+		}
+
+		case Kind::Spread:
+			for (int p = 0; p < numPixels; p++)
+			{
+				tPixel4b& pixel = pixels[p];
+				switch (Comps[0])
+				{
+					case tComp::R:	pixel.G = pixel.B = pixel.R;			break;
+					case tComp::G:	pixel.R = pixel.B = pixel.G;			break;
+					case tComp::B:	pixel.R = pixel.G = pixel.B;			break;
+					case tComp::A:	pixel.R = pixel.G = pixel.B = pixel.A;	break;
+					default:												break;
+				}
+			}
+			break;
+
+		case Kind::Intensity:
+			for (int p = 0; p < numPixels; p++)
+			{
+				tPixel4b& pixel = pixels[p];
+				int intensity = pixel.Intensity();
+				if (Channels & tCompBit_R) pixel.R = intensity;
+				if (Channels & tCompBit_G) pixel.G = intensity;
+				if (Channels & tCompBit_B) pixel.B = intensity;
+				if (Channels & tCompBit_A) pixel.A = intensity;
+			}
+			break;
+
+		case Kind::AlphaBlendColour:
+		{
+			tColour4f blendCol(Colour);
+			for (int p = 0; p < numPixels; p++)
+			{
+				tColour4f pixelCol(pixels[p]);
+				tColour4f pixel = pixelCol;
+				float alpha = pixelCol.A;
+				float oneMinusAlpha = 1.0f - alpha;
+
+				if (Channels & tCompBit_R) pixel.R = pixelCol.R*alpha + blendCol.R*oneMinusAlpha;
+				if (Channels & tCompBit_G) pixel.G = pixelCol.G*alpha + blendCol.G*oneMinusAlpha;
+				if (Channels & tCompBit_B) pixel.B = pixelCol.B*alpha + blendCol.B*oneMinusAlpha;
+				if (FinalAlpha >= 0)
+					pixel.SetA(FinalAlpha);
+
+				pixels[p].Set(pixel);
+			}
+			break;
+		}
+	}
+}
+
+
+void tPictureInternal::OpStage::Then(const OpMap& m, int newW, int newH)
+{
+	ToSrc = ToSrc.After(m);
+	for (int c = 0; c < Crops.GetNumElements(); c++)
+		Crops[c].Map = Crops[c].Map.After(m);
+	DstW = newW;
+	DstH = newH;
+}
+
+
+void tPictureInternal::OpStage::Run(const tPixel4b* src, tPixel4b* dst, int numThreads)
+{
+	// The fill of each crop only gets the colour operations that came after it. They are the same for every filled
+	// pixel so they are done once here.
+	for (int c = 0; c < Crops.GetNumElements(); c++)
+	{
+		OpCrop& crop = Crops[c];
+		for (int k = crop.NumColourOpsBefore; k < Colours.GetNumElements(); k++)
+			Colours[k].Run(&crop.Fill, 1);
+	}
+
+	int tilesX = (DstW + TileSize - 1) / TileSize;
+	int tilesY = (DstH + TileSize - 1) / TileSize;
+	int numTiles = tilesX*tilesY;
+
+	// When left to choose, small images aren't worth starting threads for. An explicit thread count is used as given
+	// (up to one per tile) so the tiled path can be run on any image.
+	const int minPixelsPerThread = 64*1024;
+	if (numThreads <= 0)
+		numThreads = tMin(tGetNumCores(), (DstW*DstH) / minPixelsPerThread);
+	numThreads = tClamp(numThreads, 1, numTiles);
+
+	std::atomic<int> nextTile(0);
+	auto work = [this, src, dst, tilesX, numTiles, &nextTile]()
+	{
+		for (int t = nextTile++; t < numTiles; t = nextTile++)
+		{
+			int x0 = (t % tilesX) * TileSize;
+			int y0 = (t / tilesX) * TileSize;
+			RunTile(src, dst, x0, y0, tMin(x0 + TileSize, DstW), tMin(y0 + TileSize, DstH));
+		}
+	};
+
+	if (numThreads == 1)
+	{
+		work();
+		return;
+	}
+
+	std::thread* workers = new std::thread[numThreads];
+	for (int t = 0; t < numThreads; t++)
+		workers[t] = std::thread(work);
+	for (int t = 0; t < numThreads; t++)
+		workers[t].join();
+	delete[] workers;
+}
+
+
+void tPictureInternal::OpStage::RunTile(const tPixel4b* src, tPixel4b* dst, int x0, int y0, int x1, int y1) const
+{
+	const OpCrop* crops = Crops.GetElements();
+	int numCrops = Crops.GetNumElements();
+	const OpColour* colours = Colours.GetElements();
+	int numColours = Colours.GetNumElements();
+
+	// A crop keeps or removes whole rows and columns, so if it keeps the corners of the tile it keeps all of it.
+	bool allKept = true;
+	for (int c = 0; (c < numCrops) && allKept; c++)
+	{
+		const OpCrop& crop = crops[c];
+		allKept = crop.Inside(x0, y0) && crop.Inside(x1-1, y0) && crop.Inside(x0, y1-1) && crop.Inside(x1-1, y1-1);
+	}
+
+	int count = x1 - x0;
+	int step = ToSrc.AY*SrcW + ToSrc.AX;
+	int fills[TileSize];
+	for (int y = y0; y < y1; y++)
+	{
+		tPixel4b* row = dst + y*DstW + x0;
+		if (allKept)
+		{
+			int index = ToSrc.GetY(x0, y)*SrcW + ToSrc.GetX(x0, y);
+			for (int i = 0; i < count; i++, index += step)
+				row[i] = src[index];
+		}
+		else
+		{
+			for (int i = 0; i < count; i++)
+			{
+				// The last crop to remove the pixel decides the fill.
+				int x = x0 + i;
+				int fill = -1;
+				for (int c = numCrops-1; (c >= 0) && (fill < 0); c--)
+					if (!crops[c].Inside(x, y))
+						fill = c;
+
+				fills[i] = fill;
+				row[i] = (fill < 0) ? src[ ToSrc.GetY(x, y)*SrcW + ToSrc.GetX(x, y) ] : crops[fill].Fill;
+			}
+		}
+
+		for (int k = 0; k < numColours; k++)
+			colours[k].Run(row, count);
+
+		if (!allKept)
+		{
+			for (int i = 0; i < count; i++)
+				if (fills[i] >= 0)
+					row[i] = crops[fills[i]].Fill;
+		}
+	}
+}
+
+
 int tPicture::GenerateLayers(tList<tLayer>& layers, tResampleFilter filter, tResampleEdgeMode edgeMode, bool chain)
 {
 	if (!IsValid())
@@ -982,8 +1643,9 @@ int tPicture::GenerateLayers(tList<tLayer>& layers, tResampleFilter filter, tRes
 
 	int numAppended = 0;
 
-	// We always append a fullsize layer.
-	layers.Append(new tLayer(tPixelFormat::R8G8B8A8, Width, Height, (uint8*)GetPixelPointer()));
+	// We always append a fullsize layer. Pixels are only read here, so they're used directly rather than through
+	// GetPixelPointer, which would unshare them.
+	layers.Append(new tLayer(tPixelFormat::R8G8B8A8, Width, Height, (uint8*)Pixels));
 	numAppended++;
 
 	if (filter == tResampleFilter::None)
@@ -991,7 +1653,7 @@ int tPicture::GenerateLayers(tList<tLayer>& layers, tResampleFilter filter, tRes
 
 	int srcW = Width;
 	int srcH = Height;
-	uint8* srcPixels = (uint8*)GetPixelPointer();
+	uint8* srcPixels = (uint8*)Pixels;
 
 	// We base the next mip level on previous -- mostly because it's faster than resampling from the full
 	// image each time. It's unclear to me which would generate better results.
@@ -1005,7 +1667,7 @@ int tPicture::GenerateLayers(tList<tLayer>& layers, tResampleFilter filter, tRes
 		if (chain)
 			success = tImage::Resample((tPixel4b*)srcPixels, srcW, srcH, (tPixel4b*)dstPixels, dstW, dstH, filter, edgeMode);
 		else
-			success = tImage::Resample(GetPixelPointer(), Width, Height, (tPixel4b*)dstPixels, dstW, dstH, filter, edgeMode);
+			success = tImage::Resample(Pixels, Width, Height, (tPixel4b*)dstPixels, dstW, dstH, filter, edgeMode);
 		if (!success)
 			break;
 
@@ -1020,3 +1682,266 @@ int tPicture::GenerateLayers(tList<tLayer>& layers, tResampleFilter filter, tRes
 
 	return numAppended;
 }
+
+
+void tPictureInternal::MipWeights::Compute(int srcSize, int dstSize, tResampleFilter filter, tResampleEdgeMode edgeMode)
+{
+	// Pixel centers line up, so a level half the size samples centered between each pair of source pixels. The kernel
+	// is widened by the scale so every source pixel contributes.
+	float scale = float(srcSize) / float(dstSize);
+	float kernelScale = tMax(scale, 1.0f);
+	float support = GetKernelRadius(filter) * kernelScale;
+	for (int d = 0; d < dstSize; d++)
+	{
+		float center = (float(d) + 0.5f)*scale - 0.5f;
+		int start = Index.GetNumElements();
+		Start.Append(start);
+		if (filter == tResampleFilter::Nearest)
+		{
+			Index.Append(tClamp(int(center + 0.5f), 0, srcSize-1));
+			Weight.Append(1.0f);
+			Count.Append(1);
+			continue;
+		}
+
+		float total = 0.0f;
+		for (int s = int(tCeiling(center - support)); s <= int(tFloor(center + support)); s++)
+		{
+			float weight = GetKernelWeight(filter, (float(s) - center) / kernelScale);
+			if (weight == 0.0f)
+				continue;
+			int index = (edgeMode == tResampleEdgeMode::Wrap) ? tMod(s, srcSize) : tClamp(s, 0, srcSize-1);
+			Index.Append(index);
+			Weight.Append(weight);
+			total += weight;
+		}
+
+		// A kernel narrower than a source pixel may miss every center. Use the nearest one.
+		if (total == 0.0f)
+		{
+			Index.Append(tClamp(int(center + 0.5f), 0, srcSize-1));
+			Weight.Append(1.0f);
+			total = 1.0f;
+		}
+
+		Count.Append(Index.GetNumElements() - start);
+		for (int w = start; w < Weight.GetNumElements(); w++)
+			Weight[w] /= total;
+	}
+}
+
+
+int tPicture::GenerateLayersLinear(tList<tLayer>& layers, tResampleFilter filter, tResampleEdgeMode edgeMode, int numThreads)
+{
+	tPicture* picture = this;
+	return GenerateLayersLinear(&layers, &picture, 1, filter, edgeMode, numThreads);
+}
+
+
+int tPicture::GenerateLayersLinear
+(
+	tList<tLayer>* layers, tPicture** pictures, int numPictures,
+	tResampleFilter filter, tResampleEdgeMode edgeMode, int numThreads
+)
+{
+	if (!layers || !pictures || (numPictures <= 0))
+		return 0;
+
+	// Everything is appended in order so the layer lists come out the same as GenerateLayers.
+	int numAppended = 0;
+	tArray<tPictureInternal::MipLevel*> levels;
+	tColour4f** linear = new tColour4f*[numPictures];
+	int maxWidth = 0;
+	for (int p = 0; p < numPictures; p++)
+	{
+		linear[p] = nullptr;
+		tPicture* picture = pictures[p];
+		if (!picture || !picture->IsValid())
+			continue;
+
+		layers[p].Append(new tLayer(tPixelFormat::R8G8B8A8, picture->Width, picture->Height, (uint8*)picture->Pixels));
+		numAppended++;
+		if (filter == tResampleFilter::None)
+			continue;
+
+		int srcW = picture->Width;
+		int srcH = picture->Height;
+		maxWidth = tMax(maxWidth, srcW);
+		while ((srcW > 1) || (srcH > 1))
+		{
+			int dstW = srcW >> 1; tiClampMin(dstW, 1);
+			int dstH = srcH >> 1; tiClampMin(dstH, 1);
+			tPictureInternal::MipLevel* level = new tPictureInternal::MipLevel;
+			level->PictureNum = p;
+			level->Width = dstW;
+			level->Height = dstH;
+			level->Pixels = new uint8[dstW*dstH*sizeof(tPixel4b)];
+			levels.Append(level);
+
+			layers[p].Append(new tLayer(tPixelFormat::R8G8B8A8, dstW, dstH, level->Pixels, true));
+			numAppended++;
+			srcW = dstW;
+			srcH = dstH;
+		}
+	}
+
+	int numLevels = levels.GetNumElements();
+	if (numLevels == 0)
+	{
+		delete[] linear;
+		return numAppended;
+	}
+
+	// The lookup tables between sRGB and linear. Going back the table is indexed by the linear value so it needs
+	// enough entries to resolve the steep part of the curve near black.
+	const int numLinearEntries = 1 << 14;
+	float srgbToLinear[256];
+	for (int v = 0; v < 256; v++)
+		srgbToLinear[v] = tSRGBToLinear(float(v)/255.0f);
+	uint8* linearToSRGB = new uint8[numLinearEntries];
+	for (int i = 0; i < numLinearEntries; i++)
+		linearToSRGB[i] = uint8(tClamp(int(tLinearToSRGB(float(i)/float(numLinearEntries-1))*255.0f + 0.5f), 0, 255));
+
+	if (numThreads <= 0)
+		numThreads = tMax(tGetNumCores(), 1);
+
+	// Each job is a band of rows of one level, or while converting to linear, of one picture. The jobs are handed out
+	// to the threads as they finish.
+	const int bandHeight = 16;
+	auto runJobs = [numThreads](int numJobs, auto jobFn)
+	{
+		std::atomic<int> nextJob(0);
+		auto worker = [&](int threadNum)
+		{
+			for (int job = nextJob++; job < numJobs; job = nextJob++)
+				jobFn(job, threadNum);
+		};
+
+		int count = tMin(numThreads, numJobs);
+		if (count <= 1)
+		{
+			worker(0);
+			return;
+		}
+		std::thread* workers = new std::thread[count];
+		for (int t = 0; t < count; t++)
+			workers[t] = std::thread(worker, t);
+		for (int t = 0; t < count; t++)
+			workers[t].join();
+		delete[] workers;
+	};
+
+	// Convert every picture to linear once. All levels are filtered from it.
+	tArray<int> convertPicture, convertRow;
+	for (int p = 0; p < numPictures; p++)
+	{
+		if (!pictures[p] || !pictures[p]->IsValid())
+			continue;
+		linear[p] = new tColour4f[pictures[p]->Width*pictures[p]->Height];
+		for (int row = 0; row < pictures[p]->Height; row += bandHeight)
+		{
+			convertPicture.Append(p);
+			convertRow.Append(row);
+		}
+	}
+	runJobs(convertPicture.GetNumElements(), [&](int job, int threadNum)
+	{
+		tPicture* picture = pictures[convertPicture[job]];
+		int start = convertRow[job]*picture->Width;
+		int end = tMin(convertRow[job] + bandHeight, picture->Height)*picture->Width;
+		tColour4f* dst = linear[convertPicture[job]];
+		for (int i = start; i < end; i++)
+		{
+			const tPixel4b& src = picture->Pixels[i];
+			dst[i].Set(srgbToLinear[src.R], srgbToLinear[src.G], srgbToLinear[src.B], float(src.A)/255.0f);
+		}
+	});
+
+	// The weights only depend on the sizes, so they are worked out once per level.
+	runJobs(numLevels, [&](int job, int threadNum)
+	{
+		tPictureInternal::MipLevel* level = levels[job];
+		tPicture* picture = pictures[level->PictureNum];
+		level->Cols.Compute(picture->Width, level->Width, filter, edgeMode);
+		level->Rows.Compute(picture->Height, level->Height, filter, edgeMode);
+	});
+
+	tArray<int> bandLevel, bandRow;
+	for (int l = 0; l < numLevels; l++)
+	{
+		for (int row = 0; row < levels[l]->Height; row += bandHeight)
+		{
+			bandLevel.Append(l);
+			bandRow.Append(row);
+		}
+	}
+
+	// Vertical first. Each destination row is a weighted sum of full source rows, which is then filtered
+	// horizontally. That way a band needs no more than one row of scratch memory and no work is repeated.
+	tColour4f** scratch = new tColour4f*[numThreads];
+	for (int t = 0; t < numThreads; t++)
+		scratch[t] = nullptr;
+	runJobs(bandLevel.GetNumElements(), [&](int job, int threadNum)
+	{
+		tPictureInternal::MipLevel* level = levels[bandLevel[job]];
+		tPicture* picture = pictures[level->PictureNum];
+		const tColour4f* src = linear[level->PictureNum];
+		int srcW = picture->Width;
+
+		if (!scratch[threadNum])
+			scratch[threadNum] = new tColour4f[maxWidth];
+		tColour4f* rowSum = scratch[threadNum];
+
+		int rowEnd = tMin(bandRow[job] + bandHeight, level->Height);
+		for (int y = bandRow[job]; y < rowEnd; y++)
+		{
+			for (int x = 0; x < srcW; x++)
+				rowSum[x].Set(0.0f, 0.0f, 0.0f, 0.0f);
+			for (int t = level->Rows.Start[y]; t < level->Rows.Start[y] + level->Rows.Count[y]; t++)
+			{
+				const tColour4f* srcRow = src + level->Rows.Index[t]*srcW;
+				float weight = level->Rows.Weight[t];
+				for (int x = 0; x < srcW; x++)
+				{
+					rowSum[x].R += srcRow[x].R * weight;
+					rowSum[x].G += srcRow[x].G * weight;
+					rowSum[x].B += srcRow[x].B * weight;
+					rowSum[x].A += srcRow[x].A * weight;
+				}
+			}
+
+			tPixel4b* dstRow = (tPixel4b*)level->Pixels + y*level->Width;
+			for (int x = 0; x < level->Width; x++)
+			{
+				float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+				for (int t = level->Cols.Start[x]; t < level->Cols.Start[x] + level->Cols.Count[x]; t++)
+				{
+					const tColour4f& sample = rowSum[level->Cols.Index[t]];
+					float weight = level->Cols.Weight[t];
+					r += sample.R * weight;
+					g += sample.G * weight;
+					b += sample.B * weight;
+					a += sample.A * weight;
+				}
+
+				// Sharpening kernels may go a little outside of [0, 1].
+				auto toSRGB = [&](float v) -> uint8
+				{
+					return linearToSRGB[tClamp(int(v*float(numLinearEntries-1) + 0.5f), 0, numLinearEntries-1)];
+				};
+				dstRow[x].Set(toSRGB(r), toSRGB(g), toSRGB(b), uint8(tClamp(int(a*255.0f + 0.5f), 0, 255)));
+			}
+		}
+	});
+
+	for (int t = 0; t < numThreads; t++)
+		delete[] scratch[t];
+	delete[] scratch;
+	for (int l = 0; l < numLevels; l++)
+		delete levels[l];
+	for (int p = 0; p < numPictures; p++)
+		delete[] linear[p];
+	delete[] linear;
+	delete[] linearToSRGB;
+	return numAppended;
+}
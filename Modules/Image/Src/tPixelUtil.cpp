@@ -2,7 +2,7 @@
 //
 // Helper functions for manipulating and parsing pixel-data in packed and compressed block formats.
 //
-// Copyright (c) 2022-2024 Tristan Grimmer.
+// Copyright (c) 2022-2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -12,6 +12,7 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
 #include <Foundation/tAssert.h>
 #include <Foundation/tStandard.h>
 #include <Foundation/tSmallFloat.h>
@@ -59,6 +60,342 @@ namespace tImage
 }
 
 
+namespace tPixelUtilInternal
+{
+	using namespace tImage;
+
+	// How one channel is stored in a pixel. UNorm8, 16, and 32, Half, and Float are at a byte Offset. UNormBits are in a
+	// uint16 and SmallFloats (the unsigned 10 and 11 bit floats) in a uint32, both at offset 0 and found with Shift and
+	// Bits. A SmallFloat is the top Bits of a half without the sign.
+	enum class Comp : uint8 { None, UNorm8, UNorm16, UNorm32, UNormBits, Half, Float, SmallFloat };
+
+	struct Channel
+	{
+		Comp Type;
+		uint8 Offset;
+		uint8 Shift;
+		uint8 Bits;
+
+		bool IsHalfLike() const																							{ return (Type == Comp::Half) || (Type == Comp::SmallFloat); }
+		bool IsPartOfWord() const																						{ return (Type == Comp::UNormBits) || (Type == Comp::SmallFloat); }
+	};
+
+	struct Layout
+	{
+		tPixelFormat Format;
+		int BytesPerPixel;
+		Channel Channels[4];			// RGBA.
+	};
+
+	#define CN		{ Comp::None,		0, 0,  0 }
+	#define C8(o)	{ Comp::UNorm8,		o, 0,  8 }
+	#define C16(o)	{ Comp::UNorm16,	o, 0, 16 }
+	#define C32(o)	{ Comp::UNorm32,	o, 0, 32 }
+	#define CB(s,b)	{ Comp::UNormBits,	0, s,  b }
+	#define CH(o)	{ Comp::Half,		o, 0, 16 }
+	#define CF(o)	{ Comp::Float,		o, 0, 32 }
+	#define CS(s,b)	{ Comp::SmallFloat,	0, s,  b }
+	const Layout Layouts[] =
+	{
+		{ tPixelFormat::R8,				1,		{ C8(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R8G8,			2,		{ C8(0),		C8(1),		CN,			CN			} },
+		{ tPixelFormat::R8G8B8,			3,		{ C8(0),		C8(1),		C8(2),		CN			} },
+		{ tPixelFormat::R8G8B8A8,		4,		{ C8(0),		C8(1),		C8(2),		C8(3)		} },
+		{ tPixelFormat::B8G8R8,			3,		{ C8(2),		C8(1),		C8(0),		CN			} },
+		{ tPixelFormat::B8G8R8A8,		4,		{ C8(2),		C8(1),		C8(0),		C8(3)		} },
+		{ tPixelFormat::G3B5R5G3,		2,		{ CB(11,5),		CB(5,6),	CB(0,5),	CN			} },
+		{ tPixelFormat::G4B4A4R4,		2,		{ CB(8,4),		CB(4,4),	CB(0,4),	CB(12,4)	} },
+		{ tPixelFormat::B4A4R4G4,		2,		{ CB(12,4),		CB(8,4),	CB(4,4),	CB(0,4)		} },
+		{ tPixelFormat::G3B5A1R5G2,		2,		{ CB(10,5),		CB(5,5),	CB(0,5),	CB(15,1)	} },
+		{ tPixelFormat::G2B5A1R5G3,		2,		{ CB(11,5),		CB(6,5),	CB(1,5),	CB(0,1)		} },
+		{ tPixelFormat::A8,				1,		{ CN,			CN,			CN,			C8(0)		} },
+		{ tPixelFormat::L8,				1,		{ C8(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R16,			2,		{ C16(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R16G16,			4,		{ C16(0),		C16(2),		CN,			CN			} },
+		{ tPixelFormat::R16G16B16,		6,		{ C16(0),		C16(2),		C16(4),		CN			} },
+		{ tPixelFormat::R16G16B16A16,	8,		{ C16(0),		C16(2),		C16(4),		C16(6)		} },
+		{ tPixelFormat::R32,			4,		{ C32(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R32G32,			8,		{ C32(0),		C32(4),		CN,			CN			} },
+		{ tPixelFormat::R32G32B32,		12,		{ C32(0),		C32(4),		C32(8),		CN			} },
+		{ tPixelFormat::R32G32B32A32,	16,		{ C32(0),		C32(4),		C32(8),		C32(12)		} },
+		{ tPixelFormat::R16f,			2,		{ CH(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R16G16f,		4,		{ CH(0),		CH(2),		CN,			CN			} },
+		{ tPixelFormat::R16G16B16f,		6,		{ CH(0),		CH(2),		CH(4),		CN			} },
+		{ tPixelFormat::R16G16B16A16f,	8,		{ CH(0),		CH(2),		CH(4),		CH(6)		} },
+		{ tPixelFormat::R32f,			4,		{ CF(0),		CN,			CN,			CN			} },
+		{ tPixelFormat::R32G32f,		8,		{ CF(0),		CF(4),		CN,			CN			} },
+		{ tPixelFormat::R32G32B32f,		12,		{ CF(0),		CF(4),		CF(8),		CN			} },
+		{ tPixelFormat::R32G32B32A32f,	16,		{ CF(0),		CF(4),		CF(8),		CF(12)		} },
+		{ tPixelFormat::R11G11B10uf,	4,		{ CS(21,11),	CS(10,11),	CS(0,10),	CN			} },
+		{ tPixelFormat::B10G11R11uf,	4,		{ CS(0,11),		CS(11,11),	CS(22,10),	CN			} }
+	};
+	#undef CN
+	#undef C8
+	#undef C16
+	#undef C32
+	#undef CB
+	#undef CH
+	#undef CF
+	#undef CS
+
+	// Returns nullptr if the format is not in the table.
+	const Layout* FindLayout(tPixelFormat);
+
+	// Conversions go a block of pixels at a time so the one-channel staging arrays stay in cache.
+	const int BlockSize = 1024;
+	const int MinPixelsPerThread = 64*1024;
+
+	// Every half and every 8 bit unorm as a float. Made once on first use.
+	const float* GetHalfTable();
+	const float* GetUNorm8Table();
+
+	// These read or write one channel of count pixels. Stride is the bytes per pixel. Stores to a channel that is part
+	// of a word are OR-ed in so the pixels must be cleared first.
+	void LoadFloats(float* dst, const uint8* src, int stride, const Channel&, int count);
+	void StoreFloats(uint8* dst, int stride, const Channel&, const float* src, int count);
+	void LoadHalves(uint16* dst, const uint8* src, int stride, const Channel&, int count);
+	void StoreHalves(uint8* dst, int stride, const Channel&, const uint16* src, int count);
+
+	void ConvertRange(const Layout& srcLayout, const uint8* src, const Layout& dstLayout, uint8* dst, int numPixels);
+}
+
+
+const tPixelUtilInternal::Layout* tPixelUtilInternal::FindLayout(tPixelFormat format)
+{
+	for (const Layout& layout : Layouts)
+		if (layout.Format == format)
+			return &layout;
+	return nullptr;
+}
+
+
+const float* tPixelUtilInternal::GetHalfTable()
+{
+	static float* table = []()
+	{
+		float* halves = new float[0x10000];
+		for (int h = 0; h < 0x10000; h++)
+			halves[h] = HalfRawToFloat(uint16(h));
+		return halves;
+	}();
+	return table;
+}
+
+
+const float* tPixelUtilInternal::GetUNorm8Table()
+{
+	static float* table = []()
+	{
+		float* unorms = new float[256];
+		for (int u = 0; u < 256; u++)
+			unorms[u] = float(u) / 255.0f;
+		return unorms;
+	}();
+	return table;
+}
+
+
+void tPixelUtilInternal::LoadFloats(float* dst, const uint8* src, int stride, const Channel& ch, int count)
+{
+	src += ch.Offset;
+	switch (ch.Type)
+	{
+		case Comp::UNorm8:
+		{
+			const float* table = GetUNorm8Table();
+			for (int i = 0; i < count; i++)
+				dst[i] = table[src[i*stride]];
+			break;
+		}
+
+		case Comp::UNorm16:
+			for (int i = 0; i < count; i++)
+				dst[i] = float(*(const uint16*)(src + i*stride)) / 65535.0f;
+			break;
+
+		case Comp::UNorm32:
+			for (int i = 0; i < count; i++)
+				dst[i] = float(double(*(const uint32*)(src + i*stride)) / 4294967295.0);
+			break;
+
+		case Comp::UNormBits:
+		{
+			uint32 mask = (1u << ch.Bits) - 1u;
+			float scale = 1.0f / float(mask);
+			for (int i = 0; i < count; i++)
+				dst[i] = float((*(const uint16*)(src + i*stride) >> ch.Shift) & mask) * scale;
+			break;
+		}
+
+		case Comp::Float:
+			for (int i = 0; i < count; i++)
+				dst[i] = *(const float*)(src + i*stride);
+			break;
+
+		case Comp::Half:
+		case Comp::SmallFloat:
+		{
+			// Small floats become halves with a shift so both are looked up in the half table.
+			uint16 halves[BlockSize];
+			const float* table = GetHalfTable();
+			LoadHalves(halves, src - ch.Offset, stride, ch, count);
+			for (int i = 0; i < count; i++)
+				dst[i] = table[halves[i]];
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+void tPixelUtilInternal::StoreFloats(uint8* dst, int stride, const Channel& ch, const float* src, int count)
+{
+	dst += ch.Offset;
+	switch (ch.Type)
+	{
+		case Comp::UNorm8:
+			for (int i = 0; i < count; i++)
+				dst[i*stride] = uint8(tMath::tSaturate(src[i])*255.0f + 0.5f);
+			break;
+
+		case Comp::UNorm16:
+			for (int i = 0; i < count; i++)
+				*(uint16*)(dst + i*stride) = uint16(tMath::tSaturate(src[i])*65535.0f + 0.5f);
+			break;
+
+		case Comp::UNorm32:
+			for (int i = 0; i < count; i++)
+				*(uint32*)(dst + i*stride) = uint32(double(tMath::tSaturate(src[i]))*4294967295.0 + 0.5);
+			break;
+
+		case Comp::UNormBits:
+		{
+			uint32 mask = (1u << ch.Bits) - 1u;
+			float range = float(mask);
+			for (int i = 0; i < count; i++)
+				*(uint16*)(dst + i*stride) |= uint16(uint32(tMath::tSaturate(src[i])*range + 0.5f) << ch.Shift);
+			break;
+		}
+
+		case Comp::Float:
+			for (int i = 0; i < count; i++)
+				*(float*)(dst + i*stride) = src[i];
+			break;
+
+		case Comp::Half:
+		case Comp::SmallFloat:
+		{
+			uint16 halves[BlockSize];
+			for (int i = 0; i < count; i++)
+				halves[i] = FloatToHalfRaw(src[i]);
+			StoreHalves(dst - ch.Offset, stride, ch, halves, count);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+void tPixelUtilInternal::LoadHalves(uint16* dst, const uint8* src, int stride, const Channel& ch, int count)
+{
+	if (ch.Type == Comp::Half)
+	{
+		src += ch.Offset;
+		for (int i = 0; i < count; i++)
+			dst[i] = *(const uint16*)(src + i*stride);
+		return;
+	}
+
+	tAssert(ch.Type == Comp::SmallFloat);
+	uint32 mask = (1u << ch.Bits) - 1u;
+	int halfShift = 15 - ch.Bits;
+	for (int i = 0; i < count; i++)
+		dst[i] = uint16(((*(const uint32*)(src + i*stride) >> ch.Shift) & mask) << halfShift);
+}
+
+
+void tPixelUtilInternal::StoreHalves(uint8* dst, int stride, const Channel& ch, const uint16* src, int count)
+{
+	if (ch.Type == Comp::Half)
+	{
+		dst += ch.Offset;
+		for (int i = 0; i < count; i++)
+			*(uint16*)(dst + i*stride) = src[i];
+		return;
+	}
+
+	// Small floats have no sign so negatives become 0. The extra mantissa bits are truncated, same as tPackedF11F11F10.
+	tAssert(ch.Type == Comp::SmallFloat);
+	uint32 mask = (1u << ch.Bits) - 1u;
+	int halfShift = 15 - ch.Bits;
+	for (int i = 0; i < count; i++)
+	{
+		uint32 half = (src[i] & 0x8000) ? 0 : src[i];
+		*(uint32*)(dst + i*stride) |= ((half >> halfShift) & mask) << ch.Shift;
+	}
+}
+
+
+void tPixelUtilInternal::ConvertRange(const Layout& srcLayout, const uint8* src, const Layout& dstLayout, uint8* dst, int numPixels)
+{
+	int srcStride = srcLayout.BytesPerPixel;
+	int dstStride = dstLayout.BytesPerPixel;
+	bool clearFirst = false;
+	for (int c = 0; c < 4; c++)
+		clearFirst = clearFirst || dstLayout.Channels[c].IsPartOfWord();
+
+	float floats[BlockSize];
+	uint16 halves[BlockSize];
+	for (int start = 0; start < numPixels; start += BlockSize)
+	{
+		int count = tMath::tMin(BlockSize, numPixels - start);
+		const uint8* srcBlock = src + start*srcStride;
+		uint8* dstBlock = dst + start*dstStride;
+		if (clearFirst)
+			tStd::tMemset(dstBlock, 0, count*dstStride);
+
+		for (int c = 0; c < 4; c++)
+		{
+			const Channel& srcCh = srcLayout.Channels[c];
+			const Channel& dstCh = dstLayout.Channels[c];
+			if (dstCh.Type == Comp::None)
+				continue;
+
+			// Same type and size. Only the position in the pixel changes.
+			if ((srcCh.Type == dstCh.Type) && !srcCh.IsPartOfWord())
+			{
+				int numBytes = srcCh.Bits / 8;
+				for (int i = 0; i < count; i++)
+					tStd::tMemcpy(dstBlock + i*dstStride + dstCh.Offset, srcBlock + i*srcStride + srcCh.Offset, numBytes);
+			}
+			else if (srcCh.IsHalfLike() && dstCh.IsHalfLike())
+			{
+				LoadHalves(halves, srcBlock, srcStride, srcCh, count);
+				StoreHalves(dstBlock, dstStride, dstCh, halves, count);
+			}
+			else
+			{
+				if (srcCh.Type == Comp::None)
+				{
+					float missing = (c == 3) ? 1.0f : 0.0f;
+					for (int i = 0; i < count; i++)
+						floats[i] = missing;
+				}
+				else
+				{
+					LoadFloats(floats, srcBlock, srcStride, srcCh, count);
+				}
+				StoreFloats(dstBlock, dstStride, dstCh, floats, count);
+			}
+		}
+	}
+}
+
+
 tImage::DecodeResult tImage::DecodePixelData(tPixelFormat fmt, const uint8* src, int srcSize, int w, int h, tColour4b*& decoded4b, tColour4f*& decoded4f, tColourProfile profile, float RGBM_RGBD_MaxRange)
 {
 	if (decoded4b || decoded4f)
@@ -409,158 +746,20 @@ tImage::DecodeResult tImage::DecodePixelData_Packed(tPixelFormat fmt, const uint
 		}
 
 		case tPixelFormat::R16f:
-		{
-			// This HDR format has 1 red half-float channel.
-			decoded4f = new tColour4f[w*h];
-			tHalf* hdata = (tHalf*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = hdata[ij*1 + 0];
-				tColour4f col(r, 0.0f, 0.0f, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R16G16f:
-		{
-			// This HDR format has 2 half-float channels. Red and green.
-			decoded4f = new tColour4f[w*h];
-			tHalf* hdata = (tHalf*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = hdata[ij*2 + 0];
-				float g = hdata[ij*2 + 1];
-				tColour4f col(r, g, 0.0f, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R16G16B16f:
-		{
-			// This HDR format has 3 half-float channels. RGB.
-			decoded4f = new tColour4f[w*h];
-			tHalf* hdata = (tHalf*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = hdata[ij*3 + 0];
-				float g = hdata[ij*3 + 1];
-				float b = hdata[ij*3 + 2];
-				tColour4f col(r, g, b, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R16G16B16A16f:
-		{
-			// This HDR format has 4 half-float channels. RGBA.
-			decoded4f = new tColour4f[w*h];
-			tHalf* hdata = (tHalf*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = hdata[ij*4 + 0];
-				float g = hdata[ij*4 + 1];
-				float b = hdata[ij*4 + 2];
-				float a = hdata[ij*4 + 3];
-				tColour4f col(r, g, b, a);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R32f:
-		{
-			// This HDR format has 1 red float channel.
-			decoded4f = new tColour4f[w*h];
-			float* fdata = (float*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = fdata[ij*1 + 0];
-				tColour4f col(r, 0.0f, 0.0f, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R32G32f:
-		{
-			// This HDR format has 2 float channels. Red and green.
-			decoded4f = new tColour4f[w*h];
-			float* fdata = (float*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = fdata[ij*2 + 0];
-				float g = fdata[ij*2 + 1];
-				tColour4f col(r, g, 0.0f, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R32G32B32f:
-		{
-			// This HDR format has 3 float channels. RGB.
-			decoded4f = new tColour4f[w*h];
-			float* fdata = (float*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = fdata[ij*3 + 0];
-				float g = fdata[ij*3 + 1];
-				float b = fdata[ij*3 + 2];
-				tColour4f col(r, g, b, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R32G32B32A32f:
-		{
-			// This HDR format has 4 RGBA floats.
-			decoded4f = new tColour4f[w*h];
-			float* fdata = (float*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				float r = fdata[ij*4 + 0];
-				float g = fdata[ij*4 + 1];
-				float b = fdata[ij*4 + 2];
-				float a = fdata[ij*4 + 3];
-				tColour4f col(r, g, b, a);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::R11G11B10uf:
-		{
-			// This HDR format has 3 RGB floats packed into 32-bits.
-			decoded4f = new tColour4f[w*h];
-			uint32* fdata = (uint32*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				tPackedF11F11F10 packed(fdata[ij]);
-				float r, g, b;
-				packed.Get(r, g, b);
-				tColour4f col(r, g, b, 1.0f);
-				decoded4f[ij].Set(col);
-			}
-			break;
-		}
-
 		case tPixelFormat::B10G11R11uf:
 		{
-			// This HDR format has 3 RGB floats packed into 32-bits.
+			// These HDR formats have half, float, or small float channels. The conversion is straight to RGBA floats
+			// with 0 for missing colour channels and 1 for missing alpha.
 			decoded4f = new tColour4f[w*h];
-			uint32* fdata = (uint32*)src;
-			for (int ij = 0; ij < w*h; ij++)
-			{
-				tPackedF10F11F11 packed(fdata[ij]);
-				float r, g, b;
-				packed.Get(b, g, r);
-				tColour4f col(r, g, b, 1.0f);
-				decoded4f[ij].Set(col);
-			}
+			ConvertPixelData_Packed(fmt, src, tPixelFormat::R32G32B32A32f, (uint8*)decoded4f, w*h);
 			break;
 		}
 
@@ -651,6 +850,47 @@ tImage::DecodeResult tImage::DecodePixelData_Packed(tPixelFormat fmt, const uint
 }
 
 
+bool tImage::CanConvertPixelData_Packed(tPixelFormat srcFormat, tPixelFormat dstFormat)
+{
+	return tPixelUtilInternal::FindLayout(srcFormat) && tPixelUtilInternal::FindLayout(dstFormat);
+}
+
+
+bool tImage::ConvertPixelData_Packed(tPixelFormat srcFormat, const uint8* src, tPixelFormat dstFormat, uint8* dst, int numPixels, int numThreads)
+{
+	using namespace tPixelUtilInternal;
+	const Layout* srcLayout = FindLayout(srcFormat);
+	const Layout* dstLayout = FindLayout(dstFormat);
+	if (!srcLayout || !dstLayout || !src || !dst || (numPixels < 0))
+		return false;
+
+	if (numThreads <= 0)
+		numThreads = tMath::tMax(tSystem::tGetNumCores(), 1);
+	numThreads = tMath::tClamp(numPixels / MinPixelsPerThread, 1, numThreads);
+	if (numThreads == 1)
+	{
+		ConvertRange(*srcLayout, src, *dstLayout, dst, numPixels);
+		return true;
+	}
+
+	std::thread* workers = new std::thread[numThreads];
+	for (int t = 0; t < numThreads; t++)
+	{
+		int start = int(int64(numPixels) * t / numThreads);
+		int end = int(int64(numPixels) * (t+1) / numThreads);
+		workers[t] = std::thread
+		(
+			ConvertRange, std::cref(*srcLayout), src + start*srcLayout->BytesPerPixel,
+			std::cref(*dstLayout), dst + start*dstLayout->BytesPerPixel, end - start
+		);
+	}
+	for (int t = 0; t < numThreads; t++)
+		workers[t].join();
+	delete[] workers;
+	return true;
+}
+
+
 tImage::DecodeResult tImage::DecodePixelData_Block(tPixelFormat fmt, const uint8* src, int srcSize, int w, int h, tColour4b*& decoded4b, tColour4f*& decoded4f)
 {
 	if (decoded4b || decoded4f)
@@ -152,4 +152,50 @@ bool tQuantize::ConvertToPixels
 }
 
 
+bool tQuantize::ConvertToIndices
+(
+	uint8* destIndices, int width, int height,
+	const tColour3b* srcPalette, int numColours, const tPixel4b* srcPixels
+)
+{
+	if (!destIndices || (width <= 0) || (height <= 0) || !srcPalette || (numColours < 1) || (numColours > 256) || !srcPixels)
+		return false;
+
+	// Neighbouring pixels tend to be the same colour, so a small direct-mapped cache of recent lookups avoids most of
+	// the searches through the palette. The key is the whole RGB value so a hit is always exact.
+	const int cacheSize = 4096;
+	uint32* cacheKeys = new uint32[cacheSize];
+	uint8* cacheIndices = new uint8[cacheSize];
+	tStd::tMemset(cacheKeys, 0xFF, cacheSize*sizeof(uint32));
+
+	for (int p = 0; p < width*height; p++)
+	{
+		tColour3b colour(srcPixels[p].R, srcPixels[p].G, srcPixels[p].B);
+		uint32 key = (uint32(colour.R) << 16) | (uint32(colour.G) << 8) | uint32(colour.B);
+		int slot = int((key ^ (key >> 12)) & (cacheSize-1));
+		if (cacheKeys[slot] != key)
+		{
+			float closest = 1000.0f;
+			int closestIndex = 0;
+			for (int c = 0; c < numColours; c++)
+			{
+				float diff = tMath::tColourDiffRedmean(colour, srcPalette[c]);
+				if (diff < closest)
+				{
+					closest = diff;
+					closestIndex = c;
+				}
+			}
+			cacheKeys[slot] = key;
+			cacheIndices[slot] = uint8(closestIndex);
+		}
+		destIndices[p] = cacheIndices[slot];
+	}
+
+	delete[] cacheKeys;
+	delete[] cacheIndices;
+	return true;
+}
+
+
 }
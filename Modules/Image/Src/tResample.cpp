@@ -2,7 +2,7 @@
 //
 // Resample an image using various filers like nearest-neighbour, box, bilinear, and various bicubics.
 //
-// Copyright (c) 2020, 2024 Tristan Grimmer.
+// Copyright (c) 2020, 2024, 2025 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -12,6 +12,10 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
+#include <atomic>
+#include "Math/tMatrix2.h"
+#include "System/tMachine.h"
 #include "Image/tResample.h"
 #include "System/tPrint.h"
 using namespace tMath;
@@ -461,3 +465,222 @@ tPixel4b tImage::KernelFilterLanczos
 		tClamp(int(tRound(sampleTotal.w)), 0, 255)
 	);
 }
+
+
+float tImage::GetKernelRadius(tResampleFilter filter)
+{
+	switch (filter)
+	{
+		case tResampleFilter::Nearest:
+		case tResampleFilter::Box:					return 0.5f;
+		case tResampleFilter::Bilinear:				return 1.0f;
+		case tResampleFilter::Bicubic_Standard:
+		case tResampleFilter::Bicubic_CatmullRom:
+		case tResampleFilter::Bicubic_Mitchell:
+		case tResampleFilter::Bicubic_Cardinal:
+		case tResampleFilter::Bicubic_BSpline:		return 2.0f;
+		case tResampleFilter::Lanczos_Narrow:		return 2.0f;
+		case tResampleFilter::Lanczos_Normal:		return 3.0f;
+		case tResampleFilter::Lanczos_Wide:			return 4.0f;
+		default:									break;
+	}
+	return 0.0f;
+}
+
+
+float tImage::GetKernelWeight(tResampleFilter filter, float x)
+{
+	switch (filter)
+	{
+		case tResampleFilter::Nearest:
+		case tResampleFilter::Box:					return (tAbs(x) <= 0.5f) ? 1.0f : 0.0f;
+		case tResampleFilter::Bilinear:				return tMax(1.0f - tAbs(x), 0.0f);
+		case tResampleFilter::Bicubic_Standard:		return ComputeCubicWeight(x, 0.0f, 3.0f/4.0f);
+		case tResampleFilter::Bicubic_CatmullRom:	return ComputeCubicWeight(x, 0.0f, 1.0f/2.0f);
+		case tResampleFilter::Bicubic_Mitchell:		return ComputeCubicWeight(x, 1.0f/3.0f, 1.0f/3.0f);
+		case tResampleFilter::Bicubic_Cardinal:		return ComputeCubicWeight(x, 0.0f, 1.0f);
+		case tResampleFilter::Bicubic_BSpline:		return ComputeCubicWeight(x, 1.0f, 0.0f);
+		case tResampleFilter::Lanczos_Narrow:		return ComputeLanczosWeight(tAbs(x), 2.0f);
+		case tResampleFilter::Lanczos_Normal:		return ComputeLanczosWeight(tAbs(x), 3.0f);
+		case tResampleFilter::Lanczos_Wide:			return ComputeLanczosWeight(tAbs(x), 4.0f);
+		default:									break;
+	}
+	return 0.0f;
+}
+
+
+bool tImage::ResampleRotate
+(
+	const tPixel4b* src, int srcW, int srcH,
+	tPixel4b* dst, int dstW, int dstH,
+	float angle, const tPixel4b& fill,
+	tResampleFilter resampleFilter, int numThreads
+)
+{
+	if (!src || !dst || srcW<=0 || srcH<=0 || dstW<=0 || dstH<=0)
+		return false;
+
+	// The kernel is separable so the weight of a tap is weightFn(dx) * weightFn(dy). Radius is how far from the sample
+	// point taps can have a non-zero weight.
+	int radius = 1;
+	float coeffB = 0.0f;
+	float coeffC = 0.0f;
+	float lanczosA = 0.0f;
+	switch (resampleFilter)
+	{
+		case tResampleFilter::Nearest:
+			radius = 0;
+			break;
+
+		case tResampleFilter::Box:
+		case tResampleFilter::Bilinear:
+			radius = 1;
+			break;
+
+		case tResampleFilter::Bicubic_Standard:		coeffB = 0.0f;		coeffC = 3.0f/4.0f;		radius = 2;		break;
+		case tResampleFilter::Bicubic_CatmullRom:	coeffB = 0.0f;		coeffC = 1.0f/2.0f;		radius = 2;		break;
+		case tResampleFilter::Bicubic_Mitchell:		coeffB = 1.0f/3.0f;	coeffC = 1.0f/3.0f;		radius = 2;		break;
+		case tResampleFilter::Bicubic_Cardinal:		coeffB = 0.0f;		coeffC = 1.0f;			radius = 2;		break;
+		case tResampleFilter::Bicubic_BSpline:		coeffB = 1.0f;		coeffC = 0.0f;			radius = 2;		break;
+		case tResampleFilter::Lanczos_Narrow:		lanczosA = 2.0f;							radius = 2;		break;
+		case tResampleFilter::Lanczos_Normal:		lanczosA = 3.0f;							radius = 3;		break;
+		case tResampleFilter::Lanczos_Wide:			lanczosA = 4.0f;							radius = 4;		break;
+
+		case tResampleFilter::Invalid:
+		default:
+			return false;
+	}
+
+	auto weightFn = [&](float d) -> float
+	{
+		if (lanczosA > 0.0f)
+			return ComputeLanczosWeight(tAbs(d), lanczosA);
+		if (radius == 2)
+			return ComputeCubicWeight(d, coeffB, coeffC);
+		return tMax(1.0f - tAbs(d), 0.0f);
+	};
+
+	// Matrix is orthonormal so inverse is transpose.
+	tMatrix2 invRot;
+	invRot.MakeRotateZ(angle);
+	invRot.Transpose();
+
+	float srcHalfW = float(srcW)/2.0f;
+	float srcHalfH = float(srcH)/2.0f;
+	float halfW = float(dstW)/2.0f;
+	float halfH = float(dstH)/2.0f;
+	tVector4 fillv;
+	fill.GetDenorm(fillv);
+
+	auto processRows = [&](int rowStart, int rowEnd)
+	{
+		const int maxTaps = 8;
+		float weightsX[maxTaps];
+		float weightsY[maxTaps];
+		for (int y = rowStart; y < rowEnd; y++)
+		{
+			for (int x = 0; x < dstW; x++)
+			{
+				// dstPos is the middle of the pixel we are writing to. srcPos is where it comes from in src with pixel
+				// centers at whole numbers. Same mapping as tPicture::RotateCenter.
+				tVector2 dstPos(float(x)+0.5f - halfW, float(y)+0.5f - halfH);
+				tVector2 srcPos = invRot*dstPos;
+				srcPos += tVector2(srcHalfW, srcHalfH);
+				srcPos -= tVector2(0.5f, 0.5f);
+				tPixel4b& dstPixel = dst[dstW*y + x];
+
+				if (radius == 0)
+				{
+					int srcX = int(tRound(srcPos.x));
+					int srcY = int(tRound(srcPos.y));
+					bool useFill = (srcX < 0) || (srcX >= srcW) || (srcY < 0) || (srcY >= srcH);
+					dstPixel = useFill ? fill : src[srcW*srcY + srcX];
+					continue;
+				}
+
+				// Taps from the floor minus radius plus one to the floor plus radius cover everything within radius.
+				int baseX = int(tFloor(srcPos.x)) - radius + 1;
+				int baseY = int(tFloor(srcPos.y)) - radius + 1;
+				int numTaps = 2*radius;
+				if ((baseX + numTaps <= 0) || (baseX >= srcW) || (baseY + numTaps <= 0) || (baseY >= srcH))
+				{
+					dstPixel = fill;
+					continue;
+				}
+
+				float totalX = 0.0f;
+				float totalY = 0.0f;
+				for (int t = 0; t < numTaps; t++)
+				{
+					weightsX[t] = weightFn(srcPos.x - float(baseX + t));	totalX += weightsX[t];
+					weightsY[t] = weightFn(srcPos.y - float(baseY + t));	totalY += weightsY[t];
+				}
+
+				tVector4 sampleTotal = tVector4::zero;
+				for (int ty = 0; ty < numTaps; ty++)
+				{
+					int iy = baseY + ty;
+					bool rowInside = (iy >= 0) && (iy < srcH);
+					tVector4 rowTotal = tVector4::zero;
+					for (int tx = 0; tx < numTaps; tx++)
+					{
+						int ix = baseX + tx;
+						if (rowInside && (ix >= 0) && (ix < srcW))
+						{
+							const tPixel4b& srcPixel = src[srcW*iy + ix];
+							rowTotal.x += srcPixel.R * weightsX[tx];
+							rowTotal.y += srcPixel.G * weightsX[tx];
+							rowTotal.z += srcPixel.B * weightsX[tx];
+							rowTotal.w += srcPixel.A * weightsX[tx];
+						}
+						else
+						{
+							rowTotal += fillv * weightsX[tx];
+						}
+					}
+					sampleTotal += rowTotal * weightsY[ty];
+				}
+
+				// Renormalize sampleTotal back to [0, 256).
+				float weightTotal = totalX * totalY;
+				if (weightTotal != 0.0f)
+					sampleTotal /= weightTotal;
+				dstPixel.Set
+				(
+					tClamp(int(tRound(sampleTotal.x)), 0, 255),
+					tClamp(int(tRound(sampleTotal.y)), 0, 255),
+					tClamp(int(tRound(sampleTotal.z)), 0, 255),
+					tClamp(int(tRound(sampleTotal.w)), 0, 255)
+				);
+			}
+		}
+	};
+
+	// Bands of rows are handed out to the threads as they finish, so a thread that gets mostly fill is not left idle.
+	const int bandHeight = 32;
+	int numBands = (dstH + bandHeight - 1) / bandHeight;
+	if (numThreads <= 0)
+		numThreads = tMax(tSystem::tGetNumCores(), 1);
+	numThreads = tMin(numThreads, numBands);
+
+	std::atomic<int> nextBand(0);
+	auto processBands = [&]()
+	{
+		for (int band = nextBand++; band < numBands; band = nextBand++)
+			processRows(band*bandHeight, tMin((band+1)*bandHeight, dstH));
+	};
+
+	if (numThreads <= 1)
+	{
+		processBands();
+		return true;
+	}
+
+	std::thread* workers = new std::thread[numThreads];
+	for (int t = 0; t < numThreads; t++)
+		workers[t] = std::thread(processBands);
+	for (int t = 0; t < numThreads; t++)
+		workers[t].join();
+	delete[] workers;
+	return true;
+}
@@ -290,8 +290,10 @@ struct tABox
 	tABox(float minx, float miny, float minz, float maxx, float maxy, float maxz)										: Min(minx, miny, minz), Max(maxx, maxy, maxz) { }
 
 	void AddPoint(const tVector3&);
+	void AddBox(const tABox&);
 	void Expand(float e)																								{ Min.x -= e; Min.y -= e; Min.z -= e; Max.x += e; Max.y += e; Max.z += e; }
 	void Empty()																										{ Min = tVector3(fPosInfinity, fPosInfinity, fPosInfinity); Max = tVector3(fNegInfinity, fNegInfinity, fNegInfinity); }
+	bool IsEmpty() const																								{ return (Min.x > Max.x) || (Min.y > Max.y) || (Min.z > Max.z); }
 	void Transform(const tMatrix4& xform);					// Affine and projection transforms supported.
 
 	// Boundary included.
@@ -313,7 +315,12 @@ struct tABox
 
 	tVector3 ComputeCenter() const																						{ return (Min + Max)/2.0f; }
 	tVector3 ComputeExtents() const																						{ return (Max - Min)/2.0f; }
-	bool Overlaps(const tABox&) const																					{ tAssert(!"Not implemented yet."); return false; }
+
+	// Returns zero for empty boxes. This is the quantity the surface area heuristic (SAH) is based on.
+	float ComputeSurfaceArea() const;
+
+	// Boundary included. Empty boxes never overlap anything.
+	bool Overlaps(const tABox&) const;
 
 	tVector3 Min;
 	tVector3 Max;
@@ -499,6 +506,18 @@ bool tIntersectTestRayTriangle(const tRay&, const tTriangle&);
 // Returns true if the sphere is partly or completely inside the volume of the view frustum.
 bool tIntersectTestFrustumSphere(const tFrustum&, const tSphere&);
 
+// Returns true if the box is partly or completely inside the volume of the view frustum. This is the conservative
+// plane/box test so boxes near the frustum corners may report true even though they are outside.
+bool tIntersectTestFrustumBox(const tFrustum&, const tABox&);
+
+// Returns true if the sphere and box overlap (boundary included).
+bool tIntersectTestSphereBox(const tSphere&, const tABox&);
+
+// Slab test. The tRay.Dir need not be normalized. On success t is set to the entry distance along the ray (in units
+// of Dir) and is clamped to 0 if the ray starts inside the box. Returns false if the box is behind the ray or the entry
+// distance is greater than maxT.
+bool tIntersectFindRayBox(float& t, const tRay&, const tABox&, float maxT = fInfinity);
+
 // @todo Not implemented.
 bool tIntersectTestTriangleTriangle(const tTriangle&, const tTriangle&);
 
@@ -570,6 +589,37 @@ inline void tMath::tABox::AddPoint(const tVector3& p)
 }
 
 
+inline void tMath::tABox::AddBox(const tABox& b)
+{
+	Max.x = tMax(b.Max.x, Max.x);
+	Max.y = tMax(b.Max.y, Max.y);
+	Max.z = tMax(b.Max.z, Max.z);
+
+	Min.x = tMin(b.Min.x, Min.x);
+	Min.y = tMin(b.Min.y, Min.y);
+	Min.z = tMin(b.Min.z, Min.z);
+}
+
+
+inline float tMath::tABox::ComputeSurfaceArea() const
+{
+	if (IsEmpty())
+		return 0.0f;
+
+	tVector3 d = Max - Min;
+	return 2.0f * (d.x*d.y + d.y*d.z + d.z*d.x);
+}
+
+
+inline bool tMath::tABox::Overlaps(const tABox& b) const
+{
+	return
+		(Min.x <= b.Max.x) && (Max.x >= b.Min.x) &&
+		(Min.y <= b.Max.y) && (Max.y >= b.Min.y) &&
+		(Min.z <= b.Max.z) && (Max.z >= b.Min.z);
+}
+
+
 inline bool tMath::tABox::IsPointInsideBias(const tVector3& point, tBias biasX, tBias biasY, tBias biasZ) const
 {
 	std::function<bool(float,float)> lessX = tBiasLess(biasX);
@@ -512,3 +512,74 @@ bool tMath::tIntersectTestFrustumSphere(const tFrustum& f, const tSphere& s)
 
 	return true;
 }
+
+
+bool tMath::tIntersectTestFrustumBox(const tFrustum& f, const tABox& b)
+{
+	for (int p = 0; p < int(tFrustum::Plane_NumPlanes); p++)
+	{
+		// Test the box corner furthest along the (interior-facing) plane normal. If even that corner is outside, the
+		// whole box is.
+		const tPlane& plane = f.Planes[p];
+		tVector3 pos
+		(
+			(plane.Normal.x >= 0.0f) ? b.Max.x : b.Min.x,
+			(plane.Normal.y >= 0.0f) ? b.Max.y : b.Min.y,
+			(plane.Normal.z >= 0.0f) ? b.Max.z : b.Min.z
+		);
+		if (plane.GetDistance(pos) < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+
+bool tMath::tIntersectTestSphereBox(const tSphere& s, const tABox& b)
+{
+	// Distance squared from the sphere center to the closest point on the box.
+	float distSq = 0.0f;
+	for (int a = 0; a < 3; a++)
+	{
+		float c = s.Center.E[a];
+		if (c < b.Min.E[a])
+			distSq += (b.Min.E[a] - c) * (b.Min.E[a] - c);
+		else if (c > b.Max.E[a])
+			distSq += (c - b.Max.E[a]) * (c - b.Max.E[a]);
+	}
+
+	return distSq <= s.Radius*s.Radius;
+}
+
+
+bool tMath::tIntersectFindRayBox(float& t, const tRay& ray, const tABox& b, float maxT)
+{
+	float tmin = 0.0f;
+	float tmax = maxT;
+	for (int a = 0; a < 3; a++)
+	{
+		float d = ray.Dir.E[a];
+		float o = ray.Start.E[a];
+		if (tAbs(d) < fEpsilon)
+		{
+			// Parallel to the slab. No hit if the origin is outside it.
+			if ((o < b.Min.E[a]) || (o > b.Max.E[a]))
+				return false;
+			continue;
+		}
+
+		float invD = 1.0f / d;
+		float t0 = (b.Min.E[a] - o) * invD;
+		float t1 = (b.Max.E[a] - o) * invD;
+		if (t0 > t1)
+			tStd::tSwap(t0, t1);
+
+		tmin = tMax(tmin, t0);
+		tmax = tMin(tmax, t1);
+		if (tmin > tmax)
+			return false;
+	}
+
+	t = tmin;
+	return true;
+}
@@ -1,7 +1,7 @@
 // tProcess.h
 //
 // This module contains a class for spawning other processes and receiving their exit-codes as well as some simple
-// commands for spawning one or many processes at once. Windows platform only.
+// commands for spawning one or many processes at once. Windows and Linux.
 //
 // Copyright (c) 2005, 2017, 2020, 2023 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -20,13 +20,20 @@
 #ifdef PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>					// Requires windows because the build methods can send windows messages.
+#elif defined(PLATFORM_LINUX)
+#include <sys/types.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
 #endif
 namespace tPipeline
 {
 
 
-// @todo Currently the process stuff, due to the output stream messaging, is windows only. I'm sure with modern C++
-// this can be abstracted to be multiplatform.
+// The Windows version can also send output and exit messages to a window and set up the child's environment. The
+// Linux version has no window-message, wait-handle, or environment constructors. It has four: non-blocking with exit
+// and print callbacks (and an optional separate stderr callback), detached, blocking with output appended to a string,
+// and blocking with output printed or sent to a print callback.
 #ifdef PLATFORM_WINDOWS
 
 
@@ -184,6 +191,79 @@ private:
 // int tRun(const tString& cmdLine, const tString& workingDir);
 // void tGo(const tString& cmdLine, const tString& workingDir);
 
+#elif defined(PLATFORM_LINUX)
+
+
+// Processes are started with posix_spawn and the command line is run by /bin/sh, so quoting, redirection, and pipes
+// work the way they do in a terminal. Output from the child's stdout and stderr is streamed to the callbacks as it
+// arrives (in chunks, not necessarily whole lines) from a monitor thread.
+class tProcess
+{
+public:
+	typedef void (*tExitCallback)(void* userPointer, int exitCode);
+	typedef void (*tPrintCallback)(void* userPointer, const char* text);
+
+	// Non-blocking. Supports print and exit callbacks. You simply destroy the object sometime after the exit callback.
+	// If no error print callback is supplied, stderr goes to the print callback along with stdout. The callbacks are
+	// called from the monitor thread.
+	tProcess
+	(
+		const tString& cmdLine, const tString& workingDir, tExitCallback, void* exitCallbackUserPointer = nullptr,
+		tPrintCallback = nullptr, void* printCallbackUserPointer = nullptr,
+		tPrintCallback errorCallback = nullptr, void* errorCallbackUserPointer = nullptr
+	);
+
+	// Non-blocking. Creates a completely detached process. You get no exit code OR process output.
+	tProcess(const tString& cmdLine, const tString& workingDir);
+
+	// Blocking. Fills in the exitCode if you supply it. Output from both streams is appended to the output arg.
+	tProcess(const tString& cmdLine, const tString& workingDir, tString& output, ulong* exitCode = 0);
+
+	// Blocking. Fills in the exitCode you supply. Output is sent as it occurs to stdout or, if supplied, to the print
+	// function.
+	tProcess
+	(
+		const tString& cmdLine, const tString& workingDir, ulong* exitCode,
+		tPrintCallback = nullptr, void* printCallbackUserPointer = nullptr
+	);
+
+	// For the non-blocking callback constructor the destructor blocks until the process is complete.
+	virtual ~tProcess();
+
+	bool IsRunning() const																								{ return Running; }
+
+	// Sends SIGTERM. It has no effect if the process has already completed. The exit callback is still called.
+	void Terminate();
+
+	// Sends SIGKILL and blocks until the process is gone. The exit callback is not called.
+	void TerminateHard();
+
+private:
+	// Returns false and leaves the process not running if it could not be spawned. In that case the exit code is 127,
+	// the same as the shell reports for a command it can't find.
+	bool CreateChildProcess(const tString& cmdLine, const tString& workingDir, bool detached = false);
+	void Monitor();
+	void Emit(const char* text, bool isError);
+
+	tString* OutputString				= nullptr;
+	tPrintCallback PrintCallback		= nullptr;
+	void* PrintCallbackUserPointer		= nullptr;
+	tPrintCallback ErrorCallback		= nullptr;
+	void* ErrorCallbackUserPointer		= nullptr;
+	tExitCallback ExitCallback			= nullptr;
+	void* ExitCallbackUserPointer		= nullptr;
+	ulong* ExitCode						= nullptr;
+
+	pid_t ChildProcess					= 0;
+	int StdOutRead						= -1;	// The read end of the child's stdout pipe.
+	int StdErrRead						= -1;	// The read end of the child's stderr pipe.
+	std::thread MonitorThread;
+	std::mutex ChildMutex;						// Held while signalling so an already reaped pid is never signalled.
+	std::atomic<bool> Running			= false;
+	std::atomic<bool> SuppressExit		= false;
+};
+
+
 #endif
 
 }
@@ -16,11 +16,61 @@
 #pragma once
 #include <Foundation/tString.h>
 #include <Foundation/tList.h>
+#include <Foundation/tMap.h>
 #include <System/tThrow.h>
+#include <System/tHashCache.h>
 namespace tPipeline
 {
 
 
+// Remembers file stamps so files shared by many rules are only stat'ed once during a build. Lookups are thread-safe.
+// The cache does not notice files changing, so call Invalidate for a target after building it (tRuleGraph does this
+// for you) or Clear if you don't know what changed.
+class tStampCache
+{
+public:
+	// Batches of files bigger than a few hundred are stat'ed on numThreads threads. If numThreads is 0 or less the
+	// number of cores is used.
+	tStampCache(int numThreads = 0);
+
+	// Returns false if the file doesn't exist or is a directory.
+	bool GetStamp(tSystem::tFileStamp&, const tString& file);
+
+	enum class tNewer
+	{
+		None,								// All files exist and none are newer.
+		Found,								// At least one file is newer.
+		Missing								// A file doesn't exist. missingFile is set.
+	};
+
+	// Checks if any of the files was modified after modTime. Stops at the first newer or missing file it sees, so with
+	// more than one thread which of several newer or missing files gets reported is not deterministic.
+	tNewer FindNewer(const tList<tStringItem>& files, int64 modTime, tString* missingFile = nullptr);
+
+	void Invalidate(const tString& file);
+	void Clear();
+
+private:
+	struct Entry
+	{
+		tSystem::tFileStamp Stamp;
+		bool Exists = false;
+	};
+
+	// The map is split into shards with their own locks so parallel lookups rarely wait for each other.
+	static const int NumShards = 16;
+	struct Shard
+	{
+		std::mutex Mutex;
+		tMap<tString, Entry> Entries;
+	};
+
+	Shard& GetShard(const tString& file);
+	int NumThreads;
+	Shard Shards[NumShards];
+};
+
+
 class tRule : public tLink<tRule>
 {
 public:
@@ -57,6 +107,11 @@ public:
 	// nothing.
 	void AddDependency(tStringItem* fullDepName);
 
+	// Adds a dependency that is allowed to not exist yet, normally because it is the target of another rule. When the
+	// rules are built by a tRuleGraph the producing rule is always built first. If the dependency was already added,
+	// this function does nothing.
+	void AddGeneratedDependency(const tString& fullDepName);
+
 	// Adds multiple dependencies. The list is left empty and the strings are managed by the tRule. If any dependency
 	// doesn't exist a tRuleError object is thrown and that dependency is not added. All dependencies that do exist
 	// will be added if they aren't already added.
@@ -74,15 +129,27 @@ public:
 
 	// Returns true if target has been specified and target doesn't exist or is older than any dependency or if a clean
 	// build is requested (the latter only if checkCleanFlag == true). Returns false if there is no need to build.
-	// Throws a tRuleError if any dependency doesn't exist.
+	// Throws a tRuleError if any dependency doesn't exist. If a tHashCache is installed (see tSetHashCache) the content
+	// of the dependencies is tracked too. Once a target has been seen up to date, it is only out of date again if the
+	// target changes or the content of a dependency changes. Unchanged dependencies are not re-read.
 	bool OutOfDate(bool checkCleanFlag = true);
 
+	// Stat-once version of OutOfDate. The target is stat'ed once and the dependencies are stat'ed in parallel batches
+	// through the supplied cache, which can be shared by many rules. It returns as soon as a newer dependency is seen,
+	// so unlike the above a missing dependency is only reported (by throwing a tRuleError) if no newer one was found
+	// first, and a missing target returns true without looking at the dependencies at all.
+	bool OutOfDate(tStampCache&, bool checkCleanFlag = true);
+
 	// Here are some aliases so you don't have to type as much.
 	void AddDep(const tString& fullDepName)																				{ AddDependency(fullDepName); }
 	void AddDep(tStringItem* fullDepName)																				{ AddDependency(fullDepName); }
 	void AddDeps(tList<tStringItem>& deps)																				{ AddDependencies(deps); }
 	void AddDepDir(const tString& dir, const tString& filter = "*.*")													{ AddDependencyDir(dir, filter); }
 	void AddDepDirRec(const tString& dir, const tString& filter = "*.*")												{ AddDependencyDirRec(dir, filter); }
+	void AddGenDep(const tString& fullDepName)																			{ AddGeneratedDependency(fullDepName); }
+
+	const tString& GetTarget() const																					{ return Target; }
+	const tList<tStringItem>& GetDependencies() const																	{ return Dependencies; }
 
 protected:
 	tString Target;
@@ -92,6 +159,7 @@ protected:
 
 private:
 	bool MaybeAddToDependenciesCaseInsensitive(const tString&);
+	bool OutOfDateCached(tSystem::tHashCache&, const tSystem::tFileStamp& targetStamp);
 };
 
 
@@ -0,0 +1,86 @@
+// tRuleGraph.h
+//
+// Builds a set of rules in dependency order, running independent rules concurrently. A rule depends on another rule
+// if one of its dependencies is the other rule's target. Nothing else needs to be specified to get the edges.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tArray.h>
+#include <Foundation/tList.h>
+#include <Foundation/tString.h>
+#include "Pipeline/tRule.h"
+namespace tPipeline
+{
+
+
+class tRuleGraph
+{
+public:
+	tRuleGraph()																										{ }
+	virtual ~tRuleGraph()																								{ Clear(); }
+
+	// The rule is not owned and must stay alive until the graph is cleared. Adding the same rule twice does nothing.
+	void AddRule(tRule*);
+	int GetNumRules() const																								{ return Rules.GetNumElements(); }
+
+	// Removes all rules and results.
+	void Clear();
+
+	enum class tState
+	{
+		Pending,							// Not looked at yet.
+		UpToDate,							// Did not need building.
+		Built,								// Build was called and did not throw.
+		Failed,								// OutOfDate or Build threw.
+		Skipped								// A rule it depends on failed or was skipped, or the build was stopped.
+	};
+
+	// Builds every rule that needs it. Up to maxJobs rules are built at the same time. If maxJobs is 0 or less the
+	// number of cores is used. A rule is built if it is out of date (checked with the stat-once OutOfDate and a stamp
+	// cache shared by all the rules) or if a rule it depends on was built. Build and OutOfDate are called from worker
+	// threads, so rules must not share unprotected state. If a rule throws a tError (or anything else) it is marked
+	// failed and everything depending on it is skipped. Independent rules continue unless keepGoing is false, in which
+	// case no new rules are started. Returns true if no rule failed. Throws a tRuleError without building anything if
+	// two rules have the same target or if the rules depend on each other in a cycle.
+	bool Build(int maxJobs = 0, bool keepGoing = true);
+
+	// These report on the last Build call. The errors are in the order the rules failed.
+	tState GetState(const tRule*) const;
+	int GetNumBuilt() const																								{ return NumBuilt; }
+	int GetNumFailed() const																							{ return NumFailed; }
+	const tList<tStringItem>& GetErrors() const																			{ return Errors; }
+
+private:
+	struct Node
+	{
+		tRule* Rule;
+		tState State;
+		int NumWaiting;						// Number of producer rules that still need to finish.
+		int FirstDependent;					// Index into the dependents array.
+		int NumDependents;
+		bool ProducerBuilt;
+		bool ProducerFailed;
+	};
+
+	// Fills in the nodes and the dependents array. Throws on duplicate targets or cycles.
+	void Link();
+
+	tArray<tRule*> Rules;
+	Node* Nodes						= nullptr;
+	int* Dependents					= nullptr;
+	int NumBuilt					= 0;
+	int NumFailed					= 0;
+	tList<tStringItem> Errors;
+};
+
+
+}
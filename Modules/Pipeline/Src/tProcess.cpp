@@ -1,7 +1,7 @@
 // tProcess.cpp
 //
 // This module contains a class for spawning other processes and receiving their exit-codes as well as some simple
-// commands for spawning one or many processes at once. Windows platform only.
+// commands for spawning one or many processes at once. Windows and Linux.
 //
 // Copyright (c) 2005, 2017, 2019, 2020, 2022, 2023 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -18,11 +18,18 @@
 #include <System/tTime.h>
 #include <Foundation/tFundamentals.h>
 #include "Pipeline/tProcess.h"
+#ifdef PLATFORM_LINUX
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
 using namespace tPipeline;
 
 
-// @todo Currently the process stuff, due to the output stream messaging, is windows only. I'm sure with modern C++
-// this can be abstracted to be multiplatform.
 #ifdef PLATFORM_WINDOWS
 
 
@@ -781,4 +788,249 @@ char* tProcess::BuildNewEnvironmentData_Ascii(bool appendToExisting, int numPair
 }
 
 
+#elif defined(PLATFORM_LINUX)
+
+
+tProcess::tProcess(const tString& cmd, const tString& wd, tExitCallback ec, void* ecud, tPrintCallback pc, void* pcud, tPrintCallback erc, void* ercud) :
+	PrintCallback(pc),
+	PrintCallbackUserPointer(pcud),
+	ErrorCallback(erc),
+	ErrorCallbackUserPointer(ercud),
+	ExitCallback(ec),
+	ExitCallbackUserPointer(ecud)
+{
+	if (CreateChildProcess(cmd, wd))
+		MonitorThread = std::thread(&tProcess::Monitor, this);
+}
+
+
+tProcess::tProcess(const tString& cmd, const tString& wd)
+{
+	CreateChildProcess(cmd, wd, true);
+}
+
+
+tProcess::tProcess(const tString& cmd, const tString& wd, tString& output, ulong* exitCode) :
+	OutputString(&output),
+	ExitCode(exitCode)
+{
+	if (CreateChildProcess(cmd, wd))
+		Monitor();
+}
+
+
+tProcess::tProcess(const tString& cmd, const tString& wd, ulong* exitCode, tPrintCallback pc, void* pcud) :
+	PrintCallback(pc),
+	PrintCallbackUserPointer(pcud),
+	ExitCode(exitCode)
+{
+	if (CreateChildProcess(cmd, wd))
+		Monitor();
+}
+
+
+tProcess::~tProcess()
+{
+	if (MonitorThread.joinable())
+		MonitorThread.join();
+}
+
+
+bool tProcess::CreateChildProcess(const tString& cmdLine, const tString& workingDir, bool detached)
+{
+	// A detached command is backgrounded by the shell, which exits straight away and is reaped here. The command
+	// itself is then owned by init and there is nothing left to wait on.
+	tString command = detached ? tString("( ") + cmdLine + " ) &" : cmdLine;
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+
+	#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 29)))
+	if (workingDir.IsValid())
+		posix_spawn_file_actions_addchdir_np(&actions, workingDir.Chr());
+	#else
+	if (workingDir.IsValid())
+	{
+		tString quoted(workingDir);
+		quoted.Replace("'", "'\\''");
+		command = tString("cd '") + quoted + "' && " + command;
+	}
+	#endif
+
+	int outPipe[2] = { -1, -1 };
+	int errPipe[2] = { -1, -1 };
+	bool pipesOk = true;
+	if (detached)
+	{
+		posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+		posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+	}
+	else
+	{
+		// The read ends are close-on-exec so the child never holds them open.
+		pipesOk = (pipe2(outPipe, O_CLOEXEC) == 0) && (pipe2(errPipe, O_CLOEXEC) == 0);
+		if (pipesOk)
+		{
+			posix_spawn_file_actions_adddup2(&actions, outPipe[1], 1);
+			posix_spawn_file_actions_adddup2(&actions, errPipe[1], 2);
+		}
+	}
+
+	char* argv[] = { (char*)"sh", (char*)"-c", (char*)command.Text(), nullptr };
+	pid_t pid = 0;
+	bool spawned = pipesOk && (posix_spawn(&pid, "/bin/sh", &actions, nullptr, argv, environ) == 0);
+	posix_spawn_file_actions_destroy(&actions);
+
+	// Our copies of the write ends must be closed or the reads would never see the end of the output.
+	if (outPipe[1] >= 0)
+		close(outPipe[1]);
+	if (errPipe[1] >= 0)
+		close(errPipe[1]);
+
+	if (!spawned)
+	{
+		if (outPipe[0] >= 0)
+			close(outPipe[0]);
+		if (errPipe[0] >= 0)
+			close(errPipe[0]);
+
+		if (ExitCode)
+			*ExitCode = 127;
+		if (ExitCallback)
+			ExitCallback(ExitCallbackUserPointer, 127);
+		return false;
+	}
+
+	if (detached)
+	{
+		int status = 0;
+		waitpid(pid, &status, 0);
+		return true;
+	}
+
+	ChildProcess = pid;
+	StdOutRead = outPipe[0];
+	StdErrRead = errPipe[0];
+	Running = true;
+	return true;
+}
+
+
+void tProcess::Emit(const char* text, bool isError)
+{
+	if (OutputString)
+		*OutputString += text;
+
+	tPrintCallback callback = (isError && ErrorCallback) ? ErrorCallback : PrintCallback;
+	void* userPointer = (isError && ErrorCallback) ? ErrorCallbackUserPointer : PrintCallbackUserPointer;
+	if (callback)
+		callback(userPointer, text);
+
+	// We only go to stdout if all other methods failed.
+	if (!OutputString && !callback)
+		tPrintf("%s", text);
+}
+
+
+void tProcess::Monitor()
+{
+	// Both pipes are drained until the child (and anything it started that shares them) closes them.
+	pollfd fds[2] = { { StdOutRead, POLLIN, 0 }, { StdErrRead, POLLIN, 0 } };
+	int numOpen = 2;
+	const int bufSize = 4096;
+	char buf[bufSize + 1];
+	while (numOpen > 0)
+	{
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (int f = 0; f < 2; f++)
+		{
+			if ((fds[f].fd < 0) || !fds[f].revents)
+				continue;
+
+			ssize_t numRead = read(fds[f].fd, buf, bufSize);
+			if ((numRead < 0) && (errno == EINTR))
+				continue;
+
+			if (numRead <= 0)
+			{
+				close(fds[f].fd);
+				fds[f].fd = -1;
+				numOpen--;
+				continue;
+			}
+
+			buf[numRead] = '\0';
+			Emit(buf, f == 1);
+		}
+	}
+	for (int f = 0; f < 2; f++)
+		if (fds[f].fd >= 0)
+			close(fds[f].fd);
+	StdOutRead = -1;
+	StdErrRead = -1;
+
+	// Wait without reaping first so Terminate can never signal a pid that has been reused.
+	siginfo_t info;
+	while ((waitid(P_PID, ChildProcess, &info, WEXITED | WNOWAIT) < 0) && (errno == EINTR))
+	{
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(ChildMutex);
+		Running = false;
+	}
+
+	int status = 0;
+	while ((waitpid(ChildProcess, &status, 0) < 0) && (errno == EINTR))
+	{
+	}
+	ChildProcess = 0;
+
+	// Killed processes report 128 plus the signal number, as the shell does.
+	int exitCode = 42;
+	if (WIFEXITED(status))
+		exitCode = WEXITSTATUS(status);
+	else if (WIFSIGNALED(status))
+		exitCode = 128 + WTERMSIG(status);
+
+	if (ExitCode)
+		*ExitCode = ulong(exitCode);
+
+	if (!PrintCallback && !OutputString)
+		tFlush(stdout);
+
+	if (ExitCallback && !SuppressExit)
+		ExitCallback(ExitCallbackUserPointer, exitCode);
+}
+
+
+void tProcess::Terminate()
+{
+	std::lock_guard<std::mutex> lock(ChildMutex);
+	if (Running)
+		kill(ChildProcess, SIGTERM);
+}
+
+
+void tProcess::TerminateHard()
+{
+	{
+		std::lock_guard<std::mutex> lock(ChildMutex);
+		if (!Running)
+			return;
+		SuppressExit = true;
+		kill(ChildProcess, SIGKILL);
+	}
+
+	if (MonitorThread.joinable())
+		MonitorThread.join();
+}
+
+
 #endif
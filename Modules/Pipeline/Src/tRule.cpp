@@ -13,9 +13,13 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
+#include <atomic>
 #include <System/tThrow.h>
 #include <System/tPrint.h>
 #include <System/tFile.h>
+#include <System/tHashCache.h>
+#include <System/tMachine.h>
 #include "Pipeline/tRule.h"
 #ifdef PLATFORM_WINDOWS
 #include "Pipeline/tSolution.h"
@@ -87,6 +91,12 @@ void tRule::AddDependency(tStringItem* dep)
 }
 
 
+void tRule::AddGeneratedDependency(const tString& dep)
+{
+	MaybeAddToDependenciesCaseInsensitive(dep);
+}
+
+
 void tRule::AddDependencies(tList<tStringItem>& deps)
 {
 	bool success = true;
@@ -136,33 +146,222 @@ void tRule::AddDependencyDirRec(const tString& dir, const tString& ext)
 bool tRule::OutOfDate(bool checkClean)
 {
 	// Returns true if target has been specified and target doesn't exist or is older than any dependency.
-	// Also returns false if any dep doesn't exist.
+	// Throws if any dep doesn't exist. Every file is stat'ed exactly once.
 	if (Target.IsEmpty())
 		return false;
 
-	tStringItem* dep = Dependencies.First();
-	while (dep)
+	tSystem::tFileStamp targetStamp;
+	bool targetExists = tSystem::tGetFileStamp(targetStamp, Target);
+	bool newerDep = false;
+	for (tStringItem* dep = Dependencies.First(); dep; dep = dep->Next())
 	{
-		if (!tSystem::tFileExists(*dep))
+		tSystem::tFileStamp depStamp;
+		if (!tSystem::tGetFileStamp(depStamp, *dep))
 			throw tRuleError("Cannot find dependency [%s] while targetting [%s].", dep->Chr(), Target.Chr());
 
-		dep = dep->Next();
+		if (targetExists && (depStamp.ModTime > targetStamp.ModTime))
+			newerDep = true;
 	}
 
-	if (!tSystem::tFileExists(Target))
+	if (!targetExists)
+		return true;
+
+	if (checkClean && Clean)
+		return true;
+
+	if (tSystem::tHashCache* cache = tSystem::tGetHashCache())
+		return OutOfDateCached(*cache, targetStamp);
+
+	return newerDep;
+}
+
+
+bool tRule::OutOfDate(tStampCache& stamps, bool checkClean)
+{
+	if (Target.IsEmpty())
+		return false;
+
+	tSystem::tFileStamp targetStamp;
+	if (!stamps.GetStamp(targetStamp, Target))
 		return true;
 
 	if (checkClean && Clean)
 		return true;
 
-	dep = Dependencies.First();
-	while (dep)
+	// The hash cache needs every dependency hashed anyway so there is nothing to gain from stopping early.
+	if (tSystem::tHashCache* cache = tSystem::tGetHashCache())
+		return OutOfDateCached(*cache, targetStamp);
+
+	tString missing;
+	switch (stamps.FindNewer(Dependencies, targetStamp.ModTime, &missing))
 	{
-		if (tSystem::tIsFileNewer(*dep, Target))
+		case tStampCache::tNewer::Found:
 			return true;
 
-		dep = dep->Next();
+		case tStampCache::tNewer::Missing:
+			throw tRuleError("Cannot find dependency [%s] while targetting [%s].", missing.Chr(), Target.Chr());
+
+		default:
+			return false;
+	}
+}
+
+
+bool tRule::OutOfDateCached(tSystem::tHashCache& cache, const tSystem::tFileStamp& targetStamp)
+{
+	// The signature covers the names and content of all dependencies. It is remembered against the target's stamp, so
+	// it only stays valid while the target itself is untouched. Touching a dependency without changing it is not
+	// enough to cause a rebuild, and a changed dependency always causes one, even if it is older than the target.
+	uint64 signature = tHash::HashIV64;
+	bool newerDep = false;
+	for (tStringItem* dep = Dependencies.First(); dep; dep = dep->Next())
+	{
+		tSystem::tFileStamp depStamp;
+		uint64 depHash = 0;
+		if (!cache.GetHash(depHash, *dep, &depStamp))
+			throw tRuleError("Cannot find dependency [%s] while targetting [%s].", dep->Chr(), Target.Chr());
+
+		signature = tHash::tHashString64(*dep, signature);
+		signature = tHash::tHashData64((uint8*)&depHash, sizeof(depHash), signature);
+		if (depStamp.ModTime > targetStamp.ModTime)
+			newerDep = true;
 	}
 
-	return false;
+	tString key = "tRule:" + tSystem::tGetAbsolutePath(Target);
+	uint64 recorded = 0;
+	if (cache.GetValue(recorded, key, targetStamp))
+		return recorded != signature;
+
+	// Nothing is known about this target yet so timestamps decide. If it's up to date the signature is remembered
+	// for next time. If not, it will be remembered once the rebuilt target is checked.
+	if (!newerDep)
+		cache.SetValue(key, targetStamp, signature);
+	return newerDep;
+}
+
+
+tStampCache::tStampCache(int numThreads) :
+	NumThreads((numThreads > 0) ? numThreads : tMath::tMax(tSystem::tGetNumCores(), 1))
+{
+}
+
+
+tStampCache::Shard& tStampCache::GetShard(const tString& file)
+{
+	return Shards[tHash::tHashString32(file) % NumShards];
+}
+
+
+bool tStampCache::GetStamp(tSystem::tFileStamp& stamp, const tString& file)
+{
+	Shard& shard = GetShard(file);
+	{
+		std::lock_guard<std::mutex> lock(shard.Mutex);
+		if (Entry* entry = shard.Entries.GetValue(file))
+		{
+			stamp = entry->Stamp;
+			return entry->Exists;
+		}
+	}
+
+	// Stat without holding the lock. Two threads may both stat the same file, which is harmless.
+	Entry entry;
+	entry.Exists = tSystem::tGetFileStamp(entry.Stamp, file);
+	{
+		std::lock_guard<std::mutex> lock(shard.Mutex);
+		shard.Entries[file] = entry;
+	}
+	stamp = entry.Stamp;
+	return entry.Exists;
+}
+
+
+tStampCache::tNewer tStampCache::FindNewer(const tList<tStringItem>& files, int64 modTime, tString* missingFile)
+{
+	int numFiles = files.GetNumItems();
+	if (!numFiles)
+		return tNewer::None;
+
+	// Small lists aren't worth starting threads for.
+	const int batchSize = 128;
+	int numBatches = (numFiles + batchSize - 1) / batchSize;
+	int numWorkers = tMath::tMin(NumThreads, numBatches);
+	if ((numWorkers <= 1) || (numFiles < 2*batchSize))
+	{
+		for (tStringItem* file = files.First(); file; file = file->Next())
+		{
+			tSystem::tFileStamp stamp;
+			if (!GetStamp(stamp, *file))
+			{
+				if (missingFile)
+					*missingFile = *file;
+				return tNewer::Missing;
+			}
+			if (stamp.ModTime > modTime)
+				return tNewer::Found;
+		}
+		return tNewer::None;
+	}
+
+	// The workers need random access so the list is flattened first. The result is the first thing any worker finds.
+	const tStringItem** fileArray = new const tStringItem*[numFiles];
+	int f = 0;
+	for (const tStringItem* file = files.First(); file; file = file->Next())
+		fileArray[f++] = file;
+
+	std::atomic<int> nextBatch(0);
+	std::atomic<int> result(int(tNewer::None));
+	std::atomic<int> missingIndex(-1);
+	auto worker = [&]()
+	{
+		for (int batch = nextBatch++; (batch < numBatches) && (result == int(tNewer::None)); batch = nextBatch++)
+		{
+			int end = tMath::tMin((batch+1)*batchSize, numFiles);
+			for (int i = batch*batchSize; (i < end) && (result == int(tNewer::None)); i++)
+			{
+				tSystem::tFileStamp stamp;
+				if (!GetStamp(stamp, *fileArray[i]))
+				{
+					int expected = int(tNewer::None);
+					if (result.compare_exchange_strong(expected, int(tNewer::Missing)))
+						missingIndex = i;
+				}
+				else if (stamp.ModTime > modTime)
+				{
+					int expected = int(tNewer::None);
+					result.compare_exchange_strong(expected, int(tNewer::Found));
+				}
+			}
+		}
+	};
+
+	std::thread* workers = new std::thread[numWorkers];
+	for (int w = 0; w < numWorkers; w++)
+		workers[w] = std::thread(worker);
+	for (int w = 0; w < numWorkers; w++)
+		workers[w].join();
+	delete[] workers;
+
+	if ((result == int(tNewer::Missing)) && missingFile)
+		*missingFile = *fileArray[missingIndex];
+	delete[] fileArray;
+	return tNewer(int(result));
+}
+
+
+void tStampCache::Invalidate(const tString& file)
+{
+	Shard& shard = GetShard(file);
+	std::lock_guard<std::mutex> lock(shard.Mutex);
+	shard.Entries.Remove(file);
+}
+
+
+void tStampCache::Clear()
+{
+	for (int s = 0; s < NumShards; s++)
+	{
+		std::lock_guard<std::mutex> lock(Shards[s].Mutex);
+		Shards[s].Entries.Clear();
+	}
 }
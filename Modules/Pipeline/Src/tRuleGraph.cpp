@@ -0,0 +1,311 @@
+// tRuleGraph.cpp
+//
+// Builds a set of rules in dependency order, running independent rules concurrently. A rule depends on another rule
+// if one of its dependencies is the other rule's target. Nothing else needs to be specified to get the edges.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Foundation/tMap.h>
+#include <System/tFile.h>
+#include <System/tMachine.h>
+#include "Pipeline/tRuleGraph.h"
+using namespace tPipeline;
+
+
+namespace tRuleGraphInternal
+{
+	// Targets and dependencies are matched the same way tRule matches dependencies, case-insensitive with either
+	// slash, but also after making them absolute so relative and absolute names of the same file match.
+	tString MakeKey(const tString& path);
+}
+
+
+tString tRuleGraphInternal::MakeKey(const tString& path)
+{
+	tString key = tSystem::tGetSimplifiedPath(tSystem::tGetAbsolutePath(path));
+	key.Replace('\\', '/');
+	key.ToLower();
+	return key;
+}
+
+
+void tRuleGraph::AddRule(tRule* rule)
+{
+	tAssert(rule);
+	for (int r = 0; r < Rules.GetNumElements(); r++)
+		if (Rules[r] == rule)
+			return;
+
+	Rules.Append(rule);
+}
+
+
+void tRuleGraph::Clear()
+{
+	Rules.Clear();
+	delete[] Nodes;
+	Nodes = nullptr;
+	delete[] Dependents;
+	Dependents = nullptr;
+	NumBuilt = 0;
+	NumFailed = 0;
+	Errors.Empty();
+}
+
+
+tRuleGraph::tState tRuleGraph::GetState(const tRule* rule) const
+{
+	if (!Nodes)
+		return tState::Pending;
+
+	for (int r = 0; r < Rules.GetNumElements(); r++)
+		if (Rules[r] == rule)
+			return Nodes[r].State;
+
+	return tState::Pending;
+}
+
+
+void tRuleGraph::Link()
+{
+	using namespace tRuleGraphInternal;
+	int numRules = Rules.GetNumElements();
+	delete[] Nodes;
+	delete[] Dependents;
+	Nodes = new Node[numRules];
+	Dependents = nullptr;
+
+	tMap<tString, int> producers;
+	for (int r = 0; r < numRules; r++)
+	{
+		Node& node = Nodes[r];
+		node.Rule = Rules[r];
+		node.State = tState::Pending;
+		node.NumWaiting = 0;
+		node.FirstDependent = 0;
+		node.NumDependents = 0;
+		node.ProducerBuilt = false;
+		node.ProducerFailed = false;
+
+		const tString& target = node.Rule->GetTarget();
+		if (target.IsEmpty())
+			continue;
+
+		tString key = MakeKey(target);
+		if (producers.GetValue(key))
+			throw tRuleError("More than one rule has the target [%s].", target.Chr());
+		producers[key] = r;
+	}
+
+	// Find the producer of every dependency once. The counts let the dependents of each rule be stored in one
+	// contiguous array.
+	int numDeps = 0;
+	for (int r = 0; r < numRules; r++)
+		numDeps += Nodes[r].Rule->GetDependencies().GetNumItems();
+
+	int* producerOf = new int[tMath::tMax(numDeps, 1)];
+	int numEdges = 0;
+	int d = 0;
+	for (int r = 0; r < numRules; r++)
+	{
+		for (tStringItem* dep = Nodes[r].Rule->GetDependencies().First(); dep; dep = dep->Next(), d++)
+		{
+			int* found = producers.GetValue(MakeKey(*dep));
+			producerOf[d] = (found && (*found != r)) ? *found : -1;
+			if (producerOf[d] < 0)
+				continue;
+
+			Nodes[producerOf[d]].NumDependents++;
+			Nodes[r].NumWaiting++;
+			numEdges++;
+		}
+	}
+
+	int firstDependent = 0;
+	for (int r = 0; r < numRules; r++)
+	{
+		Nodes[r].FirstDependent = firstDependent;
+		firstDependent += Nodes[r].NumDependents;
+		Nodes[r].NumDependents = 0;
+	}
+
+	Dependents = new int[tMath::tMax(numEdges, 1)];
+	d = 0;
+	for (int r = 0; r < numRules; r++)
+	{
+		for (tStringItem* dep = Nodes[r].Rule->GetDependencies().First(); dep; dep = dep->Next(), d++)
+		{
+			if (producerOf[d] < 0)
+				continue;
+			Node& producer = Nodes[producerOf[d]];
+			Dependents[producer.FirstDependent + producer.NumDependents++] = r;
+		}
+	}
+	delete[] producerOf;
+
+	// Kahn's algorithm on a copy of the waiting counts. Anything not reached is part of (or behind) a cycle.
+	int* waiting = new int[tMath::tMax(numRules, 1)];
+	int* ready = new int[tMath::tMax(numRules, 1)];
+	int numReady = 0;
+	for (int r = 0; r < numRules; r++)
+	{
+		waiting[r] = Nodes[r].NumWaiting;
+		if (!waiting[r])
+			ready[numReady++] = r;
+	}
+
+	int numVisited = 0;
+	while (numReady)
+	{
+		Node& node = Nodes[ready[--numReady]];
+		numVisited++;
+		for (int e = 0; e < node.NumDependents; e++)
+		{
+			int dependent = Dependents[node.FirstDependent + e];
+			if (--waiting[dependent] == 0)
+				ready[numReady++] = dependent;
+		}
+	}
+
+	int inCycle = -1;
+	for (int r = 0; (r < numRules) && (inCycle < 0); r++)
+		if (waiting[r])
+			inCycle = r;
+	delete[] waiting;
+	delete[] ready;
+
+	if (numVisited != numRules)
+		throw tRuleError("Rules have a dependency cycle involving target [%s].", Nodes[inCycle].Rule->GetTarget().Chr());
+}
+
+
+bool tRuleGraph::Build(int maxJobs, bool keepGoing)
+{
+	NumBuilt = 0;
+	NumFailed = 0;
+	Errors.Empty();
+	Link();
+
+	int numRules = Rules.GetNumElements();
+	if (!numRules)
+		return true;
+
+	// The ready queue never holds more than every rule once, so a plain array with a head and tail is enough.
+	std::mutex mutex;
+	std::condition_variable wake;
+	int* ready = new int[numRules];
+	int readyHead = 0;
+	int readyTail = 0;
+	int numFinished = 0;
+	bool stop = false;
+	for (int r = 0; r < numRules; r++)
+		if (!Nodes[r].NumWaiting)
+			ready[readyTail++] = r;
+
+	int numWorkers = (maxJobs > 0) ? maxJobs : tMath::tMax(tSystem::tGetNumCores(), 1);
+	numWorkers = tMath::tMin(numWorkers, numRules);
+
+	// Rules share stamps so common dependencies are only stat'ed once. The rules are already being checked in
+	// parallel so the cache only batches across threads itself when there is a single worker.
+	tStampCache stamps((numWorkers > 1) ? 1 : 0);
+
+	auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			wake.wait(lock, [&]() { return (readyHead != readyTail) || (numFinished == numRules) || stop; });
+			if ((numFinished == numRules) || stop)
+				return;
+
+			int index = ready[readyHead++];
+			Node& node = Nodes[index];
+			tState state = tState::Skipped;
+			tString error;
+			if (!node.ProducerFailed)
+			{
+				bool producerBuilt = node.ProducerBuilt;
+				lock.unlock();
+				try
+				{
+					state = tState::UpToDate;
+					if (producerBuilt || node.Rule->OutOfDate(stamps))
+					{
+						node.Rule->Build();
+						stamps.Invalidate(node.Rule->GetTarget());
+						state = tState::Built;
+					}
+				}
+				catch (tError& err)
+				{
+					state = tState::Failed;
+					error = err.Message;
+				}
+				catch (...)
+				{
+					state = tState::Failed;
+					error = "Unknown exception building [" + node.Rule->GetTarget() + "].";
+				}
+				lock.lock();
+			}
+
+			node.State = state;
+			numFinished++;
+			if (state == tState::Built)
+				NumBuilt++;
+			if (state == tState::Failed)
+			{
+				NumFailed++;
+				Errors.Append(new tStringItem(error));
+				if (!keepGoing)
+					stop = true;
+			}
+
+			for (int d = 0; d < node.NumDependents; d++)
+			{
+				Node& dependent = Nodes[Dependents[node.FirstDependent + d]];
+				if ((state == tState::Failed) || (state == tState::Skipped))
+					dependent.ProducerFailed = true;
+				if (state == tState::Built)
+					dependent.ProducerBuilt = true;
+				if (--dependent.NumWaiting == 0)
+					ready[readyTail++] = Dependents[node.FirstDependent + d];
+			}
+
+			wake.notify_all();
+		}
+	};
+
+	if (numWorkers == 1)
+	{
+		worker();
+	}
+	else
+	{
+		std::thread* workers = new std::thread[numWorkers];
+		for (int w = 0; w < numWorkers; w++)
+			workers[w] = std::thread(worker);
+		for (int w = 0; w < numWorkers; w++)
+			workers[w].join();
+		delete[] workers;
+	}
+	delete[] ready;
+
+	// Only a stopped build leaves rules behind.
+	for (int r = 0; r < numRules; r++)
+		if (Nodes[r].State == tState::Pending)
+			Nodes[r].State = tState::Skipped;
+
+	return NumFailed == 0;
+}
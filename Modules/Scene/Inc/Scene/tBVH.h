@@ -0,0 +1,164 @@
+// tBVH.h
+//
+// A bounding volume hierarchy over the world-space bounds of the instances in a tWorld. The tree is built using a
+// binned surface area heuristic (SAH) and may be built on multiple threads. When instance transforms change the tree
+// may be refit, which keeps the topology and just recomputes the node bounds. Frustum, ray, sphere, and box queries
+// are supported. Queries are read-only and may be called from multiple threads at once.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <atomic>
+#include <Foundation/tArray.h>
+#include <Foundation/tMap.h>
+#include <Math/tGeometry.h>
+#include "Scene/tWorld.h"
+namespace tScene
+{
+
+
+class tBVH
+{
+public:
+	tBVH()																												{ }
+
+	// See Build for a description of numThreads.
+	tBVH(const tWorld& world, int numThreads = 0)																		{ Build(world, numThreads); }
+	virtual ~tBVH()																										{ Clear(); }
+
+	void Clear();
+	bool IsValid() const																								{ return (NumNodes > 0); }
+
+	// Builds the tree from all the instances in the world. PolyModel instances use the transformed bounding box of
+	// their model. LodGroup instances use the union of the boxes of all models in the group. Cameras, lights, and paths
+	// are inserted as points at the instance position. Instances referring to objects that are not in the world are
+	// not inserted. If numThreads <= 0 the number of cores is used. The world must outlive the tBVH (or at least until
+	// the next Build or Clear) as the query results point to the world's instances.
+	void Build(const tWorld&, int numThreads = 0);
+
+	// Call after changing many instance transforms or any model geometry. Recomputes the bounds of every item and then
+	// refits the nodes bottom-up. The tree topology is not changed so query performance slowly degrades if instances
+	// move large distances. Rebuild if that happens. The set of instances in the world must be the same as at Build.
+	void Refit(const tWorld&);
+
+	// Call after changing the transform of a single instance. Only the nodes from the instance's leaf up to the root
+	// are updated. Returns false if the instance is not in the tree.
+	bool Refit(const tInstance*);
+
+	// The Find functions append every instance whose world bounds satisfy the query to the supplied array and return
+	// the number appended. Frustum planes are expected to be normalized and interior facing like tFrustum::Set creates.
+	int FindFrustum(tArray<tInstance*>&, const tMath::tFrustum&) const;
+	int FindSphere(tArray<tInstance*>&, const tMath::tSphere&) const;
+	int FindBox(tArray<tInstance*>&, const tMath::tABox&) const;
+	int FindRay(tArray<tInstance*>&, const tMath::tRay&, float maxT = tMath::fInfinity) const;
+
+	// Returns the instance whose bounds the ray enters first (closest entry distance). Sets t to the entry distance
+	// in units of the ray Dir. Returns nullptr if nothing is hit.
+	tInstance* FindRayNearest(float& t, const tMath::tRay&, float maxT = tMath::fInfinity) const;
+
+	int GetNumItems() const																								{ return NumItems; }
+	int GetNumNodes() const																								{ return NumNodes; }
+	tMath::tABox GetBounds() const																						{ return NumNodes ? Nodes[0].Bounds : tMath::tABox(); }
+
+	// Leaves are not split further once they have this many items or fewer.
+	const static int MaxLeafItems = 4;
+
+private:
+	struct Node
+	{
+		tMath::tABox Bounds;
+		int Index			= 0;	// Left child for interior nodes (right child is Index+1). First item for leaves.
+		int Count			= 0;	// Number of items for leaf nodes. Zero for interior nodes.
+	};
+
+	struct Item
+	{
+		tInstance* Instance	= nullptr;
+		tMath::tABox LocalBounds;
+	};
+
+	struct BuildContext
+	{
+		tMath::tVector3* Centroids	= nullptr;
+		int* Indices				= nullptr;
+		std::atomic<int> NextNode;
+		std::atomic<int> ThreadsAvailable;
+	};
+
+	void ComputeLocalBounds(const tWorld&);
+	void ComputeWorldBounds(int numThreads);
+	void BuildRecursive(BuildContext&, int node, int parent, int first, int count, int depth);
+	int PartitionSAH(BuildContext&, int first, int count, const tMath::tABox& bounds) const;
+	void RefitNodes();
+
+	// The traversal used by all the Find queries. Both test functors take a tABox and return true to accept it.
+	template<typename NodeTest, typename ItemTest> int Find(tArray<tInstance*>&, NodeTest, ItemTest) const;
+
+	// Build recursion stops at this depth to bound the traversal stack size.
+	const static int MaxDepth = 60;
+	const static int ParallelThreshold = 8192;
+
+	int NumItems					= 0;
+	Item* Items						= nullptr;
+	tMath::tABox* ItemBounds		= nullptr;		// World-space. Indexed the same as Items.
+	int* ItemLeaves					= nullptr;		// The leaf node of each item.
+
+	int NumNodes					= 0;
+	Node* Nodes						= nullptr;		// Root at index 0. Children always have higher indices than parents.
+	int* Parents					= nullptr;		// Parent node index of each node. -1 for the root.
+
+	tMap<uint32, int> InstanceItems;				// Instance ID to item index.
+	int NumThreads					= 1;
+};
+
+
+// Implementation below this line.
+
+
+template<typename NodeTest, typename ItemTest> inline int tBVH::Find(tArray<tInstance*>& found, NodeTest nodeTest, ItemTest itemTest) const
+{
+	if (!NumNodes)
+		return 0;
+
+	int numFound = 0;
+	int stack[MaxDepth + 4];
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		const Node& node = Nodes[stack[--top]];
+		if (!nodeTest(node.Bounds))
+			continue;
+
+		if (node.Count)
+		{
+			for (int i = node.Index; i < node.Index + node.Count; i++)
+			{
+				if (itemTest(ItemBounds[i]))
+				{
+					found.Append(Items[i].Instance);
+					numFound++;
+				}
+			}
+		}
+		else
+		{
+			tAssert(top+2 <= MaxDepth+4);
+			stack[top++] = node.Index + 1;
+			stack[top++] = node.Index;
+		}
+	}
+
+	return numFound;
+}
+
+
+}
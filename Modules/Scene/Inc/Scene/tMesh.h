@@ -62,14 +62,20 @@ public:
 	void ReverseWinding();
 	tMesh& operator=(const tMesh&);
 
+	// The revision is incremented every time the mesh is changed through its member functions. Values derived from the
+	// mesh, like the bounds cached by tPolyModel, compare against it to know when they need recomputing. If you write
+	// to the tables directly you must call Modified afterwards.
+	uint32 GetRevision() const																							{ return Revision; }
+	void Modified()																										{ Revision++; }
+
 	// Faces. Note that some tables may be nullptr. If a particular table does exist it will have NumFaces elements.
 	// The Create table functions assume that the number of faces has been previously set. The created table is
 	// uninitialized -- you must populate it. If num faces is 0 calling create will destroy the table. Setting the
 	// number of faces does _not_ modify or delete the associated tables.
-	void SetNumFaces(int numFaces)																						{ NumFaces = numFaces; }
+	void SetNumFaces(int numFaces)																						{ NumFaces = numFaces; Revision++; }
 	int GetNumFaces() const																								{ return NumFaces; }
 	void CreateFaceTableVertPositionIndices()																			{ DestroyFaceTableVertPositionIndices(); if (NumFaces) FaceTableVertPositionIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableVertPositionIndices()																			{ delete[] FaceTableVertPositionIndices; FaceTableVertPositionIndices = nullptr; }
+	void DestroyFaceTableVertPositionIndices()																			{ delete[] FaceTableVertPositionIndices; FaceTableVertPositionIndices = nullptr; Revision++; }
 	void CreateFaceTableVertWeightSetIndices()																			{ DestroyFaceTableVertWeightSetIndices(); if (NumFaces) FaceTableVertWeightSetIndices = new tMath::tTriFace[NumFaces]; }
 	void DestroyFaceTableVertWeightSetIndices()																			{ delete[] FaceTableVertWeightSetIndices; FaceTableVertWeightSetIndices = nullptr; }
 	void CreateFaceTableVertNormalIndices()																				{ DestroyFaceTableVertNormalIndices(); if (NumFaces) FaceTableVertNormalIndices = new tMath::tTriFace[NumFaces]; }
@@ -87,7 +93,7 @@ public:
 	void CreateFaceTableTangentIndices()																				{ DestroyFaceTableTangentIndices(); if (NumFaces) FaceTableTangentIndices = new tMath::tTriFace[NumFaces]; }
 	void DestroyFaceTableTangentIndices()																				{ delete[] FaceTableTangentIndices; FaceTableTangentIndices = nullptr; }
 
-	int NumFaces;
+	int NumFaces = 0;
 	tMath::tTriFace* FaceTableVertPositionIndices = nullptr;	// Contains indices into the vert position table.
 	tMath::tTriFace* FaceTableVertWeightSetIndices = nullptr;	// Contains indices into the vert weight table.
 	tMath::tTriFace* FaceTableVertNormalIndices = nullptr;		// Contains indices into the vertex normal table.
@@ -104,16 +110,16 @@ public:
 	int FindEdgeIndex(const tMath::tEdge& edge) const																	{ for (int e = 0; e < NumEdges; e++) if (EdgeTableVertPositionIndices[e] == edge) return e; return -1; }
 	void CreateEdgeTableVertPositionIndices()																			{ DestroyEdgeTableVertPositionIndices(); if (NumEdges) EdgeTableVertPositionIndices = new tMath::tEdge[NumEdges]; }
 	void DestroyEdgeTableVertPositionIndices()																			{ delete[] EdgeTableVertPositionIndices; EdgeTableVertPositionIndices = nullptr; }
-	int NumEdges;
+	int NumEdges = 0;
 	tMath::tEdge* EdgeTableVertPositionIndices = nullptr;		// Contains indices into the vert pos table, 2 per edge.
 	
 	// Vertices.
-	void SetNumVertPositions(int numVertPositions)																		{ NumVertPositions = numVertPositions; }
+	void SetNumVertPositions(int numVertPositions)																		{ NumVertPositions = numVertPositions; Revision++; }
 	int GetNumVertPositions() const																						{ return NumVertPositions; }
 	int FindVertPositionIndex(const tMath::tVector3& pos) const															{ for (int p = 0; p < NumVertPositions; p++) if (VertTablePositions[p] == pos) return p; return -1; }
 	void CreateVertTablePositions()																						{ DestroyVertTablePositions(); if (NumVertPositions) VertTablePositions = new tMath::tVector3[NumVertPositions]; }
-	void DestroyVertTablePositions()																					{ delete[] VertTablePositions; VertTablePositions = nullptr; }
-	int NumVertPositions;
+	void DestroyVertTablePositions()																					{ delete[] VertTablePositions; VertTablePositions = nullptr; Revision++; }
+	int NumVertPositions = 0;
 	tMath::tVector3* VertTablePositions = nullptr;
 
 	void SetNumVertWeightSets(int numVertWeightSets)																	{ NumVertWeightSets = numVertWeightSets; }
@@ -121,7 +127,7 @@ public:
 	int FindWeightSetIndex(const tWeightSet& set) const																	{ for (int s = 0; s < NumVertWeightSets; s++) if (VertTableWeightSets[s] == set) return s; return -1; }
 	void CreateVertTableWeightSets()																					{ DestroyVertTableWeightSets(); if (NumVertWeightSets) VertTableWeightSets = new tWeightSet[NumVertWeightSets]; }
 	void DestroyVertTableWeightSets()																					{ delete[] VertTableWeightSets; VertTableWeightSets = nullptr; }
-	int NumVertWeightSets;
+	int NumVertWeightSets = 0;
 	tWeightSet* VertTableWeightSets = nullptr;
 
 	void SetNumVertNormals(int numVertNormals)																			{ NumVertNormals = numVertNormals; }
@@ -129,7 +135,7 @@ public:
 	int FindVertNormalIndex(const tMath::tVector3& normal) const														{ for (int n = 0; n < NumVertNormals; n++) if (VertTableNormals[n] == normal) return n; return -1; }
 	void CreateVertTableNormals()																						{ DestroyVertTableNormals(); if (NumVertNormals) VertTableNormals = new tMath::tVector3[NumVertNormals]; }
 	void DestroyVertTableNormals()																						{ delete[] VertTableNormals; VertTableNormals = nullptr; }
-	int NumVertNormals;
+	int NumVertNormals = 0;
 	tMath::tVector3* VertTableNormals = nullptr;
 
 	void SetNumVertUVs(int numVertUVs)																					{ NumVertUVs = numVertUVs; }
@@ -137,7 +143,7 @@ public:
 	int FindVertUVIndex(const tMath::tVector2& uv) const																{ for (int u = 0; u < NumVertUVs; u++) if (VertTableUVs[u] == uv) return u; return -1; }
 	void CreateVertTableUVs()																							{ DestroyVertTableUVs(); if (NumVertUVs) VertTableUVs = new tMath::tVector2[NumVertUVs]; }
 	void DestroyVertTableUVs()																							{ delete[] VertTableUVs; VertTableUVs = nullptr; }
-	int NumVertUVs;
+	int NumVertUVs = 0;
 	tMath::tVector2* VertTableUVs = nullptr;
 
 	void SetNumVertNormalMapUVs(int numVertNormalMapUVs)																{ NumVertNormalMapUVs = numVertNormalMapUVs; }
@@ -145,7 +151,7 @@ public:
 	int FindNormalMapUVIndex(const tMath::tVector2& uv) const															{ for (int u = 0; u < NumVertNormalMapUVs; u++) if (VertTableNormalMapUVs[u] == uv) return u; return -1; }
 	void CreateVertTableNormalMapUVs()																					{ DestroyVertTableNormalMapUVs(); if (NumVertNormalMapUVs) VertTableNormalMapUVs = new tMath::tVector2[NumVertNormalMapUVs]; }
 	void DestroyVertTableNormalMapUVs()																					{ delete[] VertTableNormalMapUVs; VertTableNormalMapUVs = nullptr; }
-	int NumVertNormalMapUVs;
+	int NumVertNormalMapUVs = 0;
 	tMath::tVector2* VertTableNormalMapUVs = nullptr;
 
 	void SetNumVertColours(int numVertColours)																			{ NumVertColours = numVertColours; }
@@ -153,7 +159,7 @@ public:
 	int FindVertColourIndex(const tColour4b& colour) const																{ for (int c = 0; c < NumVertColours; c++) if (VertTableColours[c] == colour) return c; return -1; }
 	void CreateVertTableColours()																						{ DestroyVertTableColours(); if (NumVertColours) VertTableColours = new tColour4b[NumVertColours]; }
 	void DestroyVertTableColours()																						{ delete[] VertTableColours; VertTableColours = nullptr; }
-	int NumVertColours;
+	int NumVertColours = 0;
 	tColour4b* VertTableColours = nullptr;
 
 	void SetNumVertTangents(int numVertTangents)																		{ NumVertTangents = numVertTangents; }
@@ -161,8 +167,11 @@ public:
 	int FindVertTangentIndex(const tMath::tVector4& tangent) const														{ for (int t = 0; t < NumVertTangents; t++) if (VertTableTangents[t] == tangent) return t; return -1; }
 	void CreateVertTableTangents()																						{ DestroyVertTableTangents(); if (NumVertTangents) VertTableTangents = new tMath::tVector4[NumVertTangents]; }
 	void DestroyVertTableTangents()																						{ delete[] VertTableTangents; VertTableTangents = nullptr; }
-	int NumVertTangents;
+	int NumVertTangents = 0;
 	tMath::tVector4* VertTableTangents = nullptr;
+
+private:
+	uint32 Revision = 0;
 };
 
 
@@ -24,15 +24,21 @@ class tPolyModel : public tObject
 public:
 	tPolyModel()																										{ }
 	tPolyModel(const tChunk& chunk)																						{ Load(chunk); }
+	tPolyModel(const tPolyModel& src)																					{ *this = src; }
 	virtual ~tPolyModel()																								{ }
 
 	void Save(tChunkWriter&) const;
 	void Load(const tChunk&);
 	void Clear()																										{ tObject::Clear(); IsLodGroupMember = false; Mesh.Clear(); }
-	void Scale(float scale)																								{ Mesh.Scale(scale); }
 
-	// The bounding radius is the same as the maxRadius, but if you need both it's more efficient to use the
-	// ComputeMinMaxRadius function.
+	// Scaling updates any cached bounds directly rather than invalidating them.
+	void Scale(float);
+
+	// The bounds are cached. They are computed the first time they are asked for after the mesh revision changes and
+	// are saved with the model so loading does not need to recompute them. The radii and box are computed together in
+	// a single pass over the vertex positions. The bounding radius is the same as the maxRadius. Since the cache is
+	// filled lazily from const functions, don't call these concurrently from different threads on the same model
+	// until the values have been computed once.
 	float ComputeBoundingRadius() const;
 	void ComputeMinMaxRadius(float& minRadius, float& maxRadius) const;
 	tMath::tBox ComputeBoundingBox() const;
@@ -41,6 +47,21 @@ public:
 
 	bool IsLodGroupMember = false;		// This will be true if this model is a member of any LOD group.
 	tMesh Mesh;
+
+private:
+	void UpdateBounds() const;
+	void UpdateArea() const;
+
+	// The mesh revision the cached values were computed at. The mesh revision starts at 0 and only ever increases so
+	// the initial value of 0xFFFFFFFF is treated as invalid.
+	const static uint32 InvalidRevision = 0xFFFFFFFF;
+	mutable uint32 BoundsRevision		= InvalidRevision;
+	mutable float MinRadius				= 0.0f;
+	mutable float MaxRadius				= 0.0f;
+	mutable tMath::tBox BoundingBox;
+
+	mutable uint32 AreaRevision			= InvalidRevision;
+	mutable float ApproxArea			= 0.0f;
 };
 
 
@@ -55,6 +76,14 @@ inline tPolyModel& tPolyModel::operator=(const tPolyModel& src)
 	tObject::operator=(src);
 	IsLodGroupMember = src.IsLodGroupMember;
 	Mesh = src.Mesh;
+
+	// The cached values are still good if they were good for the source mesh.
+	BoundsRevision = (src.BoundsRevision == src.Mesh.GetRevision()) ? Mesh.GetRevision() : InvalidRevision;
+	MinRadius = src.MinRadius;
+	MaxRadius = src.MaxRadius;
+	BoundingBox = src.BoundingBox;
+	AreaRevision = (src.AreaRevision == src.Mesh.GetRevision()) ? Mesh.GetRevision() : InvalidRevision;
+	ApproxArea = src.ApproxArea;
 	return *this;
 }
 
@@ -0,0 +1,47 @@
+// tSimplify.h
+//
+// Mesh simplification using the quadric error metric of Garland and Heckbert. Vertices are removed by half-edge
+// collapses (a vertex is merged into one of its neighbours) so no new vertex positions or attributes are ever made up.
+// Faces keep their attribute indices. UV, normal, colour, tangent, and material seams are respected and collapses are
+// never allowed between vertices with different weight sets.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tConstants.h>
+#include "Scene/tMesh.h"
+namespace tScene
+{
+
+
+struct tSimplifyParams
+{
+	// The proportion of faces to keep. 0.25 means simplify until a quarter of the faces are left.
+	float TargetRatio		= 0.5f;
+
+	// Simplification stops before TargetRatio is reached if the cheapest collapse would exceed this error. The error
+	// is a sum of squared distances to the original planes so it is in squared mesh units.
+	float MaxError			= tMath::fInfinity;
+
+	// How strongly open borders and attribute seams are held in place. Higher values keep their shape better.
+	float SeamWeight		= 100.0f;
+};
+
+
+// Writes a simplified version of src into dest. The vertex tables in dest only contain entries that are used. The
+// face normal table, if present, is recomputed. Edges whose vertices are both kept are kept. Simplification stops
+// early when no more collapses are possible without changing the topology, flipping faces, or breaking a seam, so
+// dest may have more faces than requested. Returns the number of faces in dest. Meshes without positions are just
+// copied. dest and src must be different meshes. This function is thread-safe for different dest meshes.
+int tSimplify(tMesh& dest, const tMesh& src, const tSimplifyParams& = tSimplifyParams());
+
+
+}
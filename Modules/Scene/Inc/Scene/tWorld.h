@@ -13,6 +13,7 @@
 //
 // Version History
 // 1.0 Initial release.
+// 1.1 Poly-models may contain a cached bounds chunk.
 //
 // Copyright (c) 2006, 2017, 2023 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -41,7 +42,7 @@ namespace tScene
 
 
 const uint32 SceneMajorVersion = 1;
-const uint32 SceneMinorVersion = 0;
+const uint32 SceneMinorVersion = 1;
 
 
 class tWorld
@@ -193,6 +194,15 @@ public:
 	// highest of any current LodGroups.
 	int GenerateLodGroupsFromModelNamingConvention();
 
+	// This call generates additional tLodGroups for models that don't have hand-authored LODs by simplifying them with
+	// tSimplify. Every model that is not already an LOD group member, and does not already have a group of the same
+	// name, gets a new group named after it. The triangleRatios and thresholds arrays both have numLevels entries. A
+	// ratio of 1.0 or more uses the original model for that level. Other levels get a new simplified model named
+	// "ModelName_LOD_n" following the naming convention above. The simplification runs in parallel across models and
+	// levels. If numThreads <= 0 the number of cores is used. Instances are not modified. Returns the number of
+	// tLodGroups added to the scene.
+	int GenerateLodGroupsFromSimplification(int numLevels, const float* triangleRatios, const float* thresholds, int numThreads = 0);
+
 private:
 	// These are helper functions to save and load different types of tObjects.
 	void SaveMaterials(tChunkWriter&) const;
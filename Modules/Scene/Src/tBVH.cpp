@@ -0,0 +1,529 @@
+// tBVH.cpp
+//
+// A bounding volume hierarchy over the world-space bounds of the instances in a tWorld. The tree is built using a
+// binned surface area heuristic (SAH) and may be built on multiple threads. When instance transforms change the tree
+// may be refit, which keeps the topology and just recomputes the node bounds. Frustum, ray, sphere, and box queries
+// are supported. Queries are read-only and may be called from multiple threads at once.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <thread>
+#include <System/tMachine.h>
+#include "Scene/tBVH.h"
+using namespace tMath;
+namespace tScene
+{
+
+
+void tBVH::Clear()
+{
+	delete[] Items;			Items = nullptr;
+	delete[] ItemBounds;	ItemBounds = nullptr;
+	delete[] ItemLeaves;	ItemLeaves = nullptr;
+	delete[] Nodes;			Nodes = nullptr;
+	delete[] Parents;		Parents = nullptr;
+	NumItems = 0;
+	NumNodes = 0;
+	InstanceItems.Clear();
+}
+
+
+void tBVH::Build(const tWorld& world, int numThreads)
+{
+	Clear();
+	NumThreads = (numThreads > 0) ? numThreads : tMath::tMax(tSystem::tGetNumCores(), 1);
+
+	// Gather the valid instances. Only those with a known object make it into the tree.
+	int maxItems = world.Instances.GetNumItems();
+	if (!maxItems)
+		return;
+
+	Items = new Item[maxItems];
+	for (tItList<tInstance>::Iter inst = world.Instances.First(); inst; ++inst)
+	{
+		if (!inst->IsValid())
+			continue;
+		Items[NumItems++].Instance = inst;
+	}
+
+	ComputeLocalBounds(world);
+
+	// ComputeLocalBounds may have discarded some items.
+	if (!NumItems)
+	{
+		Clear();
+		return;
+	}
+
+	ItemBounds = new tABox[NumItems];
+	ComputeWorldBounds(NumThreads);
+
+	BuildContext context;
+	context.Centroids = new tVector3[NumItems];
+	context.Indices = new int[NumItems];
+	for (int i = 0; i < NumItems; i++)
+	{
+		context.Centroids[i] = ItemBounds[i].ComputeCenter();
+		context.Indices[i] = i;
+	}
+
+	// A binary tree with single-item leaves has 2n-1 nodes. That's the most we can need.
+	int maxNodes = 2*NumItems - 1;
+	Nodes = new Node[maxNodes];
+	Parents = new int[maxNodes];
+	context.NextNode = 1;
+	context.ThreadsAvailable = NumThreads - 1;
+	BuildRecursive(context, 0, -1, 0, NumItems, 0);
+	NumNodes = context.NextNode;
+
+	// Reorder the items so each leaf references a contiguous run. This keeps the item data for a leaf together in
+	// memory during queries.
+	Item* orderedItems = new Item[NumItems];
+	tABox* orderedBounds = new tABox[NumItems];
+	for (int i = 0; i < NumItems; i++)
+	{
+		orderedItems[i] = Items[context.Indices[i]];
+		orderedBounds[i] = ItemBounds[context.Indices[i]];
+	}
+	delete[] Items;			Items = orderedItems;
+	delete[] ItemBounds;	ItemBounds = orderedBounds;
+	delete[] context.Centroids;
+	delete[] context.Indices;
+
+	ItemLeaves = new int[NumItems];
+	for (int n = 0; n < NumNodes; n++)
+	{
+		const Node& node = Nodes[n];
+		for (int i = node.Index; i < node.Index + node.Count; i++)
+			ItemLeaves[i] = n;
+	}
+
+	for (int i = 0; i < NumItems; i++)
+		InstanceItems[Items[i].Instance->ID] = i;
+}
+
+
+void tBVH::ComputeLocalBounds(const tWorld& world)
+{
+	// Compute each model's bounding box once. Many instances usually share a model.
+	tMap<uint32, tABox> modelBounds;
+	for (tItList<tPolyModel>::Iter model = world.PolyModels.First(); model; ++model)
+		modelBounds[model->ID] = model->ComputeBoundingBox();
+
+	tMap<uint32, tABox> groupBounds;
+	for (tItList<tLodGroup>::Iter group = world.LodGroups.First(); group; ++group)
+	{
+		tABox box;
+		for (tItList<tLodParam>::Iter param = group->LodParams.First(); param; ++param)
+		{
+			tABox* memberBox = modelBounds.GetValue(param->ModelID);
+			if (memberBox)
+				box.AddBox(*memberBox);
+		}
+		groupBounds[group->ID] = box;
+	}
+
+	int numKept = 0;
+	for (int i = 0; i < NumItems; i++)
+	{
+		Item& item = Items[i];
+		tABox* box = nullptr;
+		tABox point(tVector3::zero, tVector3::zero);
+		switch (item.Instance->ObjectType)
+		{
+			case tInstance::tType::PolyModel:
+				box = modelBounds.GetValue(item.Instance->ObjectID);
+				break;
+
+			case tInstance::tType::LodGroup:
+				box = groupBounds.GetValue(item.Instance->ObjectID);
+				break;
+
+			case tInstance::tType::Camera:
+			case tInstance::tType::Light:
+			case tInstance::tType::Path:
+				box = &point;
+				break;
+
+			default:
+				break;
+		}
+
+		if (!box || box->IsEmpty())
+			continue;
+
+		item.LocalBounds = *box;
+		Items[numKept++] = item;
+	}
+
+	NumItems = numKept;
+}
+
+
+void tBVH::ComputeWorldBounds(int numThreads)
+{
+	auto computeRange = [this](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			ItemBounds[i] = Items[i].LocalBounds;
+			if (!ItemBounds[i].IsEmpty())
+				ItemBounds[i].Transform(Items[i].Instance->Transform);
+		}
+	};
+
+	int numWorkers = tMath::tMin(numThreads, NumItems / ParallelThreshold);
+	if (numWorkers <= 1)
+	{
+		computeRange(0, NumItems);
+		return;
+	}
+
+	int perWorker = (NumItems + numWorkers - 1) / numWorkers;
+	std::thread* workers = new std::thread[numWorkers];
+	for (int w = 0; w < numWorkers; w++)
+	{
+		int first = w*perWorker;
+		int last = tMath::tMin(first + perWorker, NumItems);
+		workers[w] = std::thread(computeRange, first, last);
+	}
+
+	for (int w = 0; w < numWorkers; w++)
+		workers[w].join();
+	delete[] workers;
+}
+
+
+void tBVH::BuildRecursive(BuildContext& context, int nodeIndex, int parent, int first, int count, int depth)
+{
+	Node& node = Nodes[nodeIndex];
+	Parents[nodeIndex] = parent;
+
+	node.Bounds.Empty();
+	for (int i = first; i < first + count; i++)
+		node.Bounds.AddBox(ItemBounds[context.Indices[i]]);
+
+	int split = -1;
+	if ((count > MaxLeafItems) && (depth < MaxDepth))
+		split = PartitionSAH(context, first, count, node.Bounds);
+
+	if (split <= 0)
+	{
+		node.Index = first;
+		node.Count = count;
+		return;
+	}
+
+	// Siblings are allocated together so the right child is always Index+1.
+	int left = context.NextNode.fetch_add(2);
+	node.Index = left;
+	node.Count = 0;
+
+	// Large subtrees are handed off to another thread if any are available. The number of threads in flight is
+	// bounded by the ThreadsAvailable counter.
+	bool spawn = false;
+	if ((count > ParallelThreshold) && (context.ThreadsAvailable.fetch_sub(1) > 0))
+		spawn = true;
+	else if (count > ParallelThreshold)
+		context.ThreadsAvailable++;
+
+	if (spawn)
+	{
+		std::thread leftThread(&tBVH::BuildRecursive, this, std::ref(context), left, nodeIndex, first, split, depth+1);
+		BuildRecursive(context, left+1, nodeIndex, first+split, count-split, depth+1);
+		leftThread.join();
+		context.ThreadsAvailable++;
+	}
+	else
+	{
+		BuildRecursive(context, left, nodeIndex, first, split, depth+1);
+		BuildRecursive(context, left+1, nodeIndex, first+split, count-split, depth+1);
+	}
+}
+
+
+int tBVH::PartitionSAH(BuildContext& context, int first, int count, const tABox& bounds) const
+{
+	// Bin the centroids along each axis and evaluate the SAH cost at every bin boundary.
+	const int numBins = 16;
+	tABox centroidBounds;
+	for (int i = first; i < first + count; i++)
+		centroidBounds.AddPoint(context.Centroids[context.Indices[i]]);
+
+	float bestCost = float(count) * bounds.ComputeSurfaceArea();
+	int bestAxis = -1;
+	int bestBin = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float minC = centroidBounds.Min.E[axis];
+		float extent = centroidBounds.Max.E[axis] - minC;
+		if (extent <= 0.0f)
+			continue;
+
+		int binCounts[numBins] = { 0 };
+		tABox binBounds[numBins];
+		float scale = float(numBins) / extent;
+		for (int i = first; i < first + count; i++)
+		{
+			int idx = context.Indices[i];
+			int bin = tMath::tClamp(int((context.Centroids[idx].E[axis] - minC) * scale), 0, numBins-1);
+			binCounts[bin]++;
+			binBounds[bin].AddBox(ItemBounds[idx]);
+		}
+
+		// Sweep from the right to get the right-side areas, then from the left evaluating the cost.
+		float rightArea[numBins];
+		int rightCount[numBins];
+		tABox acc;
+		int accCount = 0;
+		for (int b = numBins-1; b > 0; b--)
+		{
+			acc.AddBox(binBounds[b]);
+			accCount += binCounts[b];
+			rightArea[b] = acc.ComputeSurfaceArea();
+			rightCount[b] = accCount;
+		}
+
+		acc.Empty();
+		accCount = 0;
+		for (int b = 0; b < numBins-1; b++)
+		{
+			acc.AddBox(binBounds[b]);
+			accCount += binCounts[b];
+			if (!accCount || !rightCount[b+1])
+				continue;
+
+			float cost = acc.ComputeSurfaceArea()*float(accCount) + rightArea[b+1]*float(rightCount[b+1]);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	// If no split beats a leaf we still need to split since we're above MaxLeafItems. Use the middle of the longest
+	// centroid axis, falling back to an even split by count if all centroids coincide.
+	float splitPos = 0.0f;
+	if (bestAxis == -1)
+	{
+		tVector3 ext = centroidBounds.Max - centroidBounds.Min;
+		bestAxis = (ext.x > ext.y) ? ((ext.x > ext.z) ? 0 : 2) : ((ext.y > ext.z) ? 1 : 2);
+		if (ext.E[bestAxis] <= 0.0f)
+			return count/2;
+		splitPos = centroidBounds.Min.E[bestAxis] + ext.E[bestAxis]*0.5f;
+	}
+	else
+	{
+		float extent = centroidBounds.Max.E[bestAxis] - centroidBounds.Min.E[bestAxis];
+		splitPos = centroidBounds.Min.E[bestAxis] + extent*float(bestBin+1)/float(numBins);
+	}
+
+	// Partition in-place. Items with centroids less than splitPos go left. The bin computation above rounds the same
+	// way so the counts match, but we compute the split from the actual partition to be safe.
+	int* indices = context.Indices + first;
+	int lo = 0;
+	int hi = count - 1;
+	while (lo <= hi)
+	{
+		if (context.Centroids[indices[lo]].E[bestAxis] < splitPos)
+			lo++;
+		else
+			tStd::tSwap(indices[lo], indices[hi--]);
+	}
+
+	if ((lo == 0) || (lo == count))
+		return count/2;
+
+	return lo;
+}
+
+
+void tBVH::Refit(const tWorld& world)
+{
+	if (!NumNodes)
+		return;
+
+	// Recompute the local bounds using the current models. The items and their order are preserved, so we can't call
+	// ComputeLocalBounds as it discards items. Instances whose object vanished get an empty box.
+	tMap<uint32, tABox> modelBounds;
+	for (tItList<tPolyModel>::Iter model = world.PolyModels.First(); model; ++model)
+		modelBounds[model->ID] = model->ComputeBoundingBox();
+
+	for (int i = 0; i < NumItems; i++)
+	{
+		const tInstance* inst = Items[i].Instance;
+		if (inst->ObjectType == tInstance::tType::PolyModel)
+		{
+			tABox* box = modelBounds.GetValue(inst->ObjectID);
+			Items[i].LocalBounds = box ? *box : tABox();
+		}
+		else if (inst->ObjectType == tInstance::tType::LodGroup)
+		{
+			tABox box;
+			tLodGroup* group = world.FindLodGroup(inst->ObjectID);
+			if (group)
+			{
+				for (tItList<tLodParam>::Iter param = group->LodParams.First(); param; ++param)
+				{
+					tABox* memberBox = modelBounds.GetValue(param->ModelID);
+					if (memberBox)
+						box.AddBox(*memberBox);
+				}
+			}
+			Items[i].LocalBounds = box;
+		}
+	}
+
+	ComputeWorldBounds(NumThreads);
+	RefitNodes();
+}
+
+
+bool tBVH::Refit(const tInstance* inst)
+{
+	if (!inst || !NumNodes)
+		return false;
+
+	int* itemIndex = InstanceItems.GetValue(inst->ID);
+	if (!itemIndex || (Items[*itemIndex].Instance != inst))
+		return false;
+
+	int i = *itemIndex;
+	ItemBounds[i] = Items[i].LocalBounds;
+	if (!ItemBounds[i].IsEmpty())
+		ItemBounds[i].Transform(inst->Transform);
+
+	for (int n = ItemLeaves[i]; n != -1; n = Parents[n])
+	{
+		Node& node = Nodes[n];
+		node.Bounds.Empty();
+		if (node.Count)
+		{
+			for (int c = node.Index; c < node.Index + node.Count; c++)
+				node.Bounds.AddBox(ItemBounds[c]);
+		}
+		else
+		{
+			node.Bounds.AddBox(Nodes[node.Index].Bounds);
+			node.Bounds.AddBox(Nodes[node.Index+1].Bounds);
+		}
+	}
+
+	return true;
+}
+
+
+void tBVH::RefitNodes()
+{
+	// Children always have higher indices than their parents so a reverse sweep visits children first.
+	for (int n = NumNodes-1; n >= 0; n--)
+	{
+		Node& node = Nodes[n];
+		node.Bounds.Empty();
+		if (node.Count)
+		{
+			for (int i = node.Index; i < node.Index + node.Count; i++)
+				node.Bounds.AddBox(ItemBounds[i]);
+		}
+		else
+		{
+			node.Bounds.AddBox(Nodes[node.Index].Bounds);
+			node.Bounds.AddBox(Nodes[node.Index+1].Bounds);
+		}
+	}
+}
+
+
+int tBVH::FindFrustum(tArray<tInstance*>& found, const tFrustum& frustum) const
+{
+	auto test = [&frustum](const tABox& box) { return tIntersectTestFrustumBox(frustum, box); };
+	return Find(found, test, test);
+}
+
+
+int tBVH::FindSphere(tArray<tInstance*>& found, const tSphere& sphere) const
+{
+	auto test = [&sphere](const tABox& box) { return tIntersectTestSphereBox(sphere, box); };
+	return Find(found, test, test);
+}
+
+
+int tBVH::FindBox(tArray<tInstance*>& found, const tABox& query) const
+{
+	auto test = [&query](const tABox& box) { return query.Overlaps(box); };
+	return Find(found, test, test);
+}
+
+
+int tBVH::FindRay(tArray<tInstance*>& found, const tRay& ray, float maxT) const
+{
+	auto test = [&ray, maxT](const tABox& box) { float t; return tIntersectFindRayBox(t, ray, box, maxT); };
+	return Find(found, test, test);
+}
+
+
+tInstance* tBVH::FindRayNearest(float& t, const tRay& ray, float maxT) const
+{
+	if (!NumNodes)
+		return nullptr;
+
+	// Front-to-back traversal. The nearest child is visited first and subtrees further than the best hit are culled.
+	tInstance* nearest = nullptr;
+	float bestT = maxT;
+	int stack[MaxDepth + 4];
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		const Node& node = Nodes[stack[--top]];
+		float nodeT;
+		if (!tIntersectFindRayBox(nodeT, ray, node.Bounds, bestT))
+			continue;
+
+		if (node.Count)
+		{
+			for (int i = node.Index; i < node.Index + node.Count; i++)
+			{
+				float itemT;
+				if (tIntersectFindRayBox(itemT, ray, ItemBounds[i], bestT) && (!nearest || (itemT < bestT)))
+				{
+					bestT = itemT;
+					nearest = Items[i].Instance;
+				}
+			}
+			continue;
+		}
+
+		float tl, tr;
+		bool hitL = tIntersectFindRayBox(tl, ray, Nodes[node.Index].Bounds, bestT);
+		bool hitR = tIntersectFindRayBox(tr, ray, Nodes[node.Index+1].Bounds, bestT);
+		tAssert(top+2 <= MaxDepth+4);
+		if (hitL && hitR)
+		{
+			// Push the far one first so the near one is popped next.
+			stack[top++] = (tl < tr) ? node.Index+1 : node.Index;
+			stack[top++] = (tl < tr) ? node.Index : node.Index+1;
+		}
+		else if (hitL)
+			stack[top++] = node.Index;
+		else if (hitR)
+			stack[top++] = node.Index+1;
+	}
+
+	if (nearest)
+		t = bestT;
+	return nearest;
+}
+
+
+}
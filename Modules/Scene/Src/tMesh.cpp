@@ -103,6 +103,7 @@ tMesh& tMesh::operator=(const tMesh& src)
 	if (VertTableTangents)
 		tMemcpy(VertTableTangents, src.VertTableTangents, NumVertTangents * sizeof(tVector4));
 
+	Revision++;
 	return *this;
 }
 
@@ -355,6 +356,7 @@ void tMesh::Load(const tChunk& meshChunk)
 			}
 		}
 	}
+	Revision++;
 }
 
 
@@ -504,6 +506,7 @@ void tMesh::Scale(float scale)
 {
 	for (int v = 0; v < NumVertPositions; v++)
 		VertTablePositions[v] *= scale;
+	Revision++;
 }
 
 
@@ -532,6 +535,7 @@ void tMesh::ReverseWinding()
 		if (FaceTableTangentIndices)
 			tStd::tSwap(FaceTableTangentIndices[f].Index[0], FaceTableTangentIndices[f].Index[2]);
 	}
+	Revision++;
 }
 
 
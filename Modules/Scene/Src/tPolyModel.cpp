@@ -13,6 +13,10 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <Foundation/tFundamentals.h>
+#include <Foundation/tPlatform.h>
+#if defined(ARCHITECTURE_X64)
+#include <xmmintrin.h>
+#endif
 #include "Scene/tPolyModel.h"
 using namespace tMath;
 namespace tScene
@@ -32,6 +36,19 @@ void tPolyModel::Save(tChunkWriter& chunk) const
 		chunk.End();
 
 		Mesh.Save(chunk);
+
+		// The bounds are written after the mesh so that when loading the mesh revision is known.
+		UpdateBounds();
+		UpdateArea();
+		chunk.Begin(tChunkID::Scene_PolyModelBounds);
+		{
+			chunk.Write(MinRadius);
+			chunk.Write(MaxRadius);
+			chunk.Write(BoundingBox.Min);
+			chunk.Write(BoundingBox.Max);
+			chunk.Write(ApproxArea);
+		}
+		chunk.End();
 	}
 	chunk.End();
 }
@@ -57,78 +74,227 @@ void tPolyModel::Load(const tChunk& modelChunk)
 			case tChunkID::Scene_Mesh:
 				Mesh.Load(chunk);
 				break;
+
+			// Older files do not have this chunk. In that case the bounds are computed when first needed.
+			case tChunkID::Scene_PolyModelBounds:
+				chunk.GetItem(MinRadius);
+				chunk.GetItem(MaxRadius);
+				chunk.GetItem(BoundingBox.Min);
+				chunk.GetItem(BoundingBox.Max);
+				chunk.GetItem(ApproxArea);
+				BoundsRevision = Mesh.GetRevision();
+				AreaRevision = Mesh.GetRevision();
+				break;
 		}
 	}
 }
 
 
-float tPolyModel::ComputeBoundingRadius() const
+void tPolyModel::Scale(float scale)
 {
-	float maxRadiusSq = 0.0f;
-	for (int v = 0; v < Mesh.NumVertPositions; v++)
+	bool boundsValid = (BoundsRevision == Mesh.GetRevision());
+	bool areaValid = (AreaRevision == Mesh.GetRevision());
+	Mesh.Scale(scale);
+
+	// Uniform scaling about the origin scales the radii and box by the scale and the area by its square. A negative
+	// scale swaps the box min and max.
+	if (boundsValid)
 	{
-		float distSq = Mesh.VertTablePositions[v].LengthSq();
-		if (distSq > maxRadiusSq)
-			maxRadiusSq = distSq;
+		float absScale = tAbs(scale);
+		if (MinRadius != fInfinity)
+			MinRadius *= absScale;
+		MaxRadius *= absScale;
+		if (!BoundingBox.IsEmpty())
+		{
+			BoundingBox.Min *= scale;
+			BoundingBox.Max *= scale;
+			if (scale < 0.0f)
+				tStd::tSwap(BoundingBox.Min, BoundingBox.Max);
+		}
+		BoundsRevision = Mesh.GetRevision();
 	}
 
-	return tSqrt(maxRadiusSq);
+	if (areaValid)
+	{
+		ApproxArea *= scale*scale;
+		AreaRevision = Mesh.GetRevision();
+	}
+}
+
+
+float tPolyModel::ComputeBoundingRadius() const
+{
+	UpdateBounds();
+	return MaxRadius;
 }
 
 
 void tPolyModel::ComputeMinMaxRadius(float& minRadius, float& maxRadius) const
 {
+	UpdateBounds();
+	minRadius = MinRadius;
+	maxRadius = MaxRadius;
+}
+
+
+tBox tPolyModel::ComputeBoundingBox() const
+{
+	UpdateBounds();
+	return BoundingBox;
+}
+
+
+float tPolyModel::ComputeApproxArea() const
+{
+	UpdateArea();
+	return ApproxArea;
+}
+
+
+void tPolyModel::UpdateBounds() const
+{
+	if (BoundsRevision == Mesh.GetRevision())
+		return;
+
+	const tVector3* positions = Mesh.VertTablePositions;
+	int numVerts = positions ? Mesh.NumVertPositions : 0;
+	tVector3 boxMin(fPosInfinity, fPosInfinity, fPosInfinity);
+	tVector3 boxMax(fNegInfinity, fNegInfinity, fNegInfinity);
 	float minRadiusSq = fInfinity;
 	float maxRadiusSq = 0.0f;
-	for (int v = 0; v < Mesh.NumVertPositions; v++)
+	int v = 0;
+
+	#if defined(ARCHITECTURE_X64)
+	// Four vertices at a time. The 12 packed floats are loaded as 3 registers and shuffled into x, y, and z registers.
+	if (numVerts >= 4)
 	{
-		float distSq = Mesh.VertTablePositions[v].LengthSq();
-		if (distSq > maxRadiusSq)
-			maxRadiusSq = distSq;
+		__m128 minX = _mm_set1_ps(fPosInfinity);	__m128 maxX = _mm_set1_ps(fNegInfinity);
+		__m128 minY = minX;							__m128 maxY = maxX;
+		__m128 minZ = minX;							__m128 maxZ = maxX;
+		__m128 minLenSq = _mm_set1_ps(fInfinity);	__m128 maxLenSq = _mm_setzero_ps();
 
-		if (distSq < minRadiusSq)
-			minRadiusSq = distSq;
-	}
+		const float* src = &positions[0].x;
+		for (; v+4 <= numVerts; v += 4, src += 12)
+		{
+			__m128 a = _mm_loadu_ps(src);			// x0 y0 z0 x1
+			__m128 b = _mm_loadu_ps(src + 4);		// y1 z1 x2 y2
+			__m128 c = _mm_loadu_ps(src + 8);		// z2 x3 y3 z3
 
-	minRadius = tSqrt(minRadiusSq);
-	maxRadius = tSqrt(maxRadiusSq);
-}
+			__m128 xy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,1,3,2));		// x2 y2 x3 y3
+			__m128 yz = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1,0,2,1));		// y0 z0 y1 z1
+			__m128 x = _mm_shuffle_ps(a, xy, _MM_SHUFFLE(2,0,3,0));		// x0 x1 x2 x3
+			__m128 y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3,1,2,0));	// y0 y1 y2 y3
+			__m128 z = _mm_shuffle_ps(yz, c, _MM_SHUFFLE(3,0,3,1));		// z0 z1 z2 z3
 
+			minX = _mm_min_ps(minX, x);		maxX = _mm_max_ps(maxX, x);
+			minY = _mm_min_ps(minY, y);		maxY = _mm_max_ps(maxY, y);
+			minZ = _mm_min_ps(minZ, z);		maxZ = _mm_max_ps(maxZ, z);
 
-tBox tPolyModel::ComputeBoundingBox() const
-{
-	tBox boundingBox;
+			__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			minLenSq = _mm_min_ps(minLenSq, lenSq);
+			maxLenSq = _mm_max_ps(maxLenSq, lenSq);
+		}
 
-	for (int v = 0; v < Mesh.NumVertPositions; v++)
-		boundingBox.AddPoint(Mesh.VertTablePositions[v]);
+		alignas(16) float lanes[8][4];
+		_mm_store_ps(lanes[0], minX);		_mm_store_ps(lanes[1], maxX);
+		_mm_store_ps(lanes[2], minY);		_mm_store_ps(lanes[3], maxY);
+		_mm_store_ps(lanes[4], minZ);		_mm_store_ps(lanes[5], maxZ);
+		_mm_store_ps(lanes[6], minLenSq);	_mm_store_ps(lanes[7], maxLenSq);
+		for (int l = 0; l < 4; l++)
+		{
+			boxMin.x = tMin(boxMin.x, lanes[0][l]);		boxMax.x = tMax(boxMax.x, lanes[1][l]);
+			boxMin.y = tMin(boxMin.y, lanes[2][l]);		boxMax.y = tMax(boxMax.y, lanes[3][l]);
+			boxMin.z = tMin(boxMin.z, lanes[4][l]);		boxMax.z = tMax(boxMax.z, lanes[5][l]);
+			minRadiusSq = tMin(minRadiusSq, lanes[6][l]);
+			maxRadiusSq = tMax(maxRadiusSq, lanes[7][l]);
+		}
+	}
+	#endif
 
-	return boundingBox;
+	// Remaining vertices, or all of them on platforms without the vector path.
+	for (; v < numVerts; v++)
+	{
+		const tVector3& pos = positions[v];
+		boxMin.x = tMin(boxMin.x, pos.x);	boxMax.x = tMax(boxMax.x, pos.x);
+		boxMin.y = tMin(boxMin.y, pos.y);	boxMax.y = tMax(boxMax.y, pos.y);
+		boxMin.z = tMin(boxMin.z, pos.z);	boxMax.z = tMax(boxMax.z, pos.z);
+
+		float distSq = pos.LengthSq();
+		minRadiusSq = tMin(minRadiusSq, distSq);
+		maxRadiusSq = tMax(maxRadiusSq, distSq);
+	}
+
+	MinRadius = tSqrt(minRadiusSq);
+	MaxRadius = tSqrt(maxRadiusSq);
+	BoundingBox.Min = boxMin;
+	BoundingBox.Max = boxMax;
+	BoundsRevision = Mesh.GetRevision();
 }
 
 
-float tPolyModel::ComputeApproxArea() const
+void tPolyModel::UpdateArea() const
 {
-	// See http://mathworld.wolfram.com/TriangleArea.html and http://mathworld.wolfram.com/Circumradius.html
+	if (AreaRevision == Mesh.GetRevision())
+		return;
+
+	// Each triangle area is half the length of the cross product of two of its edges. Unlike the circumradius form
+	// this is well behaved for degenerate triangles (they contribute zero).
+	const tVector3* positions = Mesh.VertTablePositions;
+	const tTriFace* faces = Mesh.FaceTableVertPositionIndices;
+	int numFaces = (positions && faces) ? Mesh.NumFaces : 0;
 	float area = 0.0f;
-	for (int f = 0; f < Mesh.NumFaces; f++)
+	int f = 0;
+
+	#if defined(ARCHITECTURE_X64)
+	// Four faces at a time. The vertex fetches are gathers so only the arithmetic is vectorized.
+	if (numFaces >= 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (; f+4 <= numFaces; f += 4)
+		{
+			const tTriFace* quad = faces + f;
+			const tVector3* p0[4]; const tVector3* p1[4]; const tVector3* p2[4];
+			for (int l = 0; l < 4; l++)
+			{
+				p0[l] = positions + quad[l].Index[0];
+				p1[l] = positions + quad[l].Index[1];
+				p2[l] = positions + quad[l].Index[2];
+			}
+
+			__m128 x0 = _mm_setr_ps(p0[0]->x, p0[1]->x, p0[2]->x, p0[3]->x);
+			__m128 y0 = _mm_setr_ps(p0[0]->y, p0[1]->y, p0[2]->y, p0[3]->y);
+			__m128 z0 = _mm_setr_ps(p0[0]->z, p0[1]->z, p0[2]->z, p0[3]->z);
+			__m128 ax = _mm_sub_ps(_mm_setr_ps(p1[0]->x, p1[1]->x, p1[2]->x, p1[3]->x), x0);
+			__m128 ay = _mm_sub_ps(_mm_setr_ps(p1[0]->y, p1[1]->y, p1[2]->y, p1[3]->y), y0);
+			__m128 az = _mm_sub_ps(_mm_setr_ps(p1[0]->z, p1[1]->z, p1[2]->z, p1[3]->z), z0);
+			__m128 bx = _mm_sub_ps(_mm_setr_ps(p2[0]->x, p2[1]->x, p2[2]->x, p2[3]->x), x0);
+			__m128 by = _mm_sub_ps(_mm_setr_ps(p2[0]->y, p2[1]->y, p2[2]->y, p2[3]->y), y0);
+			__m128 bz = _mm_sub_ps(_mm_setr_ps(p2[0]->z, p2[1]->z, p2[2]->z, p2[3]->z), z0);
+
+			__m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+			__m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+			__m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+			__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+			sum = _mm_add_ps(sum, _mm_sqrt_ps(lenSq));
+		}
+
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, sum);
+		area = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+	#endif
+
+	for (; f < numFaces; f++)
 	{
-		int start = f*3;
-		tMath::tTriFace& face = Mesh.FaceTableVertPositionIndices[f];
-
-		tVector3& v0 = Mesh.VertTablePositions[face.Index[0]];
-		tVector3& v1 = Mesh.VertTablePositions[face.Index[1]];
-		tVector3& v2 = Mesh.VertTablePositions[face.Index[2]];
-		tVector3 A = v1 - v0;	float a = A.NormalizeGetLength();
-		tVector3 B = v2 - v0;	float b = B.NormalizeGetLength();
-		tVector3 C = v1 - v2;	float c = C.NormalizeGetLength();
-
-		// The link above explains this name.
-		float circumradius = a*b*c / tMath::tSqrt((a+b+c)*(b+c+-a)*(c+a-b)*(a+b-c));
-		float triArea = a*b*c / (4.0f * circumradius);
-		area += triArea;
+		const tTriFace& face = faces[f];
+		const tVector3& v0 = positions[face.Index[0]];
+		tVector3 A = positions[face.Index[1]] - v0;
+		tVector3 B = positions[face.Index[2]] - v0;
+		area += (A % B).Length();
 	}
 
-	return area;
+	ApproxArea = 0.5f * area;
+	AreaRevision = Mesh.GetRevision();
 }
 
 
@@ -0,0 +1,781 @@
+// tSimplify.cpp
+//
+// Mesh simplification using the quadric error metric of Garland and Heckbert. Vertices are removed by half-edge
+// collapses (a vertex is merged into one of its neighbours) so no new vertex positions or attributes are ever made up.
+// Faces keep their attribute indices. UV, normal, colour, tangent, and material seams are respected and collapses are
+// never allowed between vertices with different weight sets.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <Foundation/tArray.h>
+#include <Foundation/tPriorityQueue.h>
+#include <Foundation/tFundamentals.h>
+#include "Scene/tSimplify.h"
+using namespace tMath;
+namespace tScene
+{
+
+
+namespace tSimp
+{
+	// A symmetric 4x4 matrix stored as its upper triangle. Doubles are used because the plane equations are squared.
+	struct Quadric
+	{
+		void AddPlane(const tVector3& n, float d, float weight);
+		void Add(const Quadric& q)																						{ for (int e = 0; e < 10; e++) E[e] += q.E[e]; }
+		float Evaluate(const tVector3& p) const;
+		double E[10] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	};
+
+	// Each face corner refers to a position and a wedge. The wedge is everything else about the corner. Material is a
+	// face property but is included so that material boundaries are treated as seams.
+	enum Attrib
+	{
+		Attrib_WeightSet,
+		Attrib_Normal,
+		Attrib_UV,
+		Attrib_NormalMapUV,
+		Attrib_Colour,
+		Attrib_Tangent,
+		Attrib_Material,
+		NumAttribs
+	};
+
+	struct Wedge
+	{
+		bool operator==(const Wedge& w) const																			{ return tStd::tMemcmp(Index, w.Index, sizeof(Index)) == 0; }
+		bool operator!=(const Wedge& w) const																			{ return !(*this == w); }
+		int Index[NumAttribs];
+	};
+
+	struct QueueEntry
+	{
+		bool operator==(const QueueEntry& e) const																		{ return (Vert == e.Vert) && (Target == e.Target) && (Version == e.Version); }
+		int Vert			= -1;
+		int Target			= -1;
+		uint32 Version		= 0;
+	};
+
+	enum VertFlag
+	{
+		VertFlag_Border		= 0x01,		// On an edge used by only one face.
+		VertFlag_Locked		= 0x02		// On a non-manifold edge. Never removed.
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const tMesh& src, const tSimplifyParams& params);
+		~Simplifier();
+
+		void Run();
+		int Write(tMesh& dest) const;
+
+	private:
+		// The cost is returned through cost. Returns false if the collapse of u into v is not allowed.
+		bool EvaluateCollapse(float& cost, int u, int v) const;
+		bool FindBestCollapse(float& cost, int& target, int u) const;
+		void Collapse(int u, int v);
+		void Enqueue(int u);
+		void GatherRing(tArray<int>& ring, int v) const;			// Appends the unique vertices of the faces around v.
+		void PurgeFaces(int v);
+		int FindCorner(int face, int vert) const																		{ const int* idx = Faces[face].Index; return (idx[0] == vert) ? 0 : ((idx[1] == vert) ? 1 : ((idx[2] == vert) ? 2 : -1)); }
+		bool IsSameWeightSet(int setA, int setB) const;
+
+		// Key ordering of non-negative floats is the same as the ordering of their bit patterns.
+		static int64 CostToKey(float cost)																				{ uint32 bits; tStd::tMemcpy(&bits, &cost, sizeof(bits)); return int64(bits); }
+
+		const tMesh& Src;
+		const tSimplifyParams& Params;
+
+		int NumVerts;
+		int NumFaces;
+		int NumActiveFaces;
+		int TargetFaces;
+
+		tVector3* Positions;
+		tTriFace* Faces;
+		Wedge* Wedges;							// 3 per face.
+		bool* FaceRemoved;
+
+		Quadric* Quadrics;
+		uint8* VertFlags;
+		bool* VertRemoved;
+		uint32* VertVersions;
+		tArray<int>* VertFaces;					// May contain removed faces. They get purged lazily.
+
+		// Scratch marks so neighbourhoods can be searched without building sets. A vertex is marked if its entry
+		// equals the current stamp.
+		mutable uint32* CandidateMarks;
+		mutable uint32 CandidateStamp;
+		mutable uint32* LinkMarks;
+		mutable uint32 LinkStamp;
+
+		// Stale entries are skipped rather than removed so the queue grows. It grows in large steps to keep the copying
+		// down.
+		tPriorityQueue<QueueEntry> Queue;
+	};
+}
+
+
+void tSimp::Quadric::AddPlane(const tVector3& n, float d, float weight)
+{
+	double a = n.x; double b = n.y; double c = n.z; double dd = d; double w = weight;
+	E[0] += w*a*a;	E[1] += w*a*b;	E[2] += w*a*c;	E[3] += w*a*dd;
+					E[4] += w*b*b;	E[5] += w*b*c;	E[6] += w*b*dd;
+									E[7] += w*c*c;	E[8] += w*c*dd;
+													E[9] += w*dd*dd;
+}
+
+
+float tSimp::Quadric::Evaluate(const tVector3& p) const
+{
+	double x = p.x; double y = p.y; double z = p.z;
+	double err =
+		E[0]*x*x + 2.0*E[1]*x*y + 2.0*E[2]*x*z + 2.0*E[3]*x +
+		E[4]*y*y + 2.0*E[5]*y*z + 2.0*E[6]*y +
+		E[7]*z*z + 2.0*E[8]*z +
+		E[9];
+
+	// Rounding can make this very slightly negative.
+	return (err > 0.0) ? float(err) : 0.0f;
+}
+
+
+tSimp::Simplifier::Simplifier(const tMesh& src, const tSimplifyParams& params) :
+	Src(src),
+	Params(params),
+	NumVerts(src.NumVertPositions),
+	NumFaces(src.NumFaces),
+	NumActiveFaces(src.NumFaces),
+	TargetFaces(0),
+	Queue(tMath::tMax(src.NumVertPositions*2, 64), tMath::tMax(src.NumVertPositions, 64))
+{
+	TargetFaces = int(float(NumFaces) * tClamp(Params.TargetRatio, 0.0f, 1.0f));
+	Positions = src.VertTablePositions;
+
+	Faces = new tTriFace[NumFaces];
+	Wedges = new Wedge[NumFaces*3];
+	FaceRemoved = new bool[NumFaces];
+	const tTriFace* attribTables[Attrib_Material] =
+	{
+		src.FaceTableVertWeightSetIndices, src.FaceTableVertNormalIndices, src.FaceTableUVIndices,
+		src.FaceTableNormalMapUVIndices, src.FaceTableColourIndices, src.FaceTableTangentIndices
+	};
+	for (int f = 0; f < NumFaces; f++)
+	{
+		Faces[f] = src.FaceTableVertPositionIndices[f];
+		FaceRemoved[f] = false;
+		for (int c = 0; c < 3; c++)
+		{
+			Wedge& wedge = Wedges[f*3 + c];
+			for (int a = 0; a < Attrib_Material; a++)
+				wedge.Index[a] = attribTables[a] ? attribTables[a][f].Index[c] : -1;
+			wedge.Index[Attrib_Material] = src.FaceTableMaterialIDs ? int(src.FaceTableMaterialIDs[f]) : -1;
+		}
+	}
+
+	Quadrics = new Quadric[NumVerts];
+	VertFlags = new uint8[NumVerts];
+	VertRemoved = new bool[NumVerts];
+	VertVersions = new uint32[NumVerts];
+	VertFaces = new tArray<int>[NumVerts];
+	CandidateMarks = new uint32[NumVerts];
+	CandidateStamp = 0;
+	LinkMarks = new uint32[NumVerts];
+	LinkStamp = 0;
+	for (int v = 0; v < NumVerts; v++)
+	{
+		VertFlags[v] = 0;
+		VertRemoved[v] = false;
+		VertVersions[v] = 0;
+		CandidateMarks[v] = 0;
+		LinkMarks[v] = 0;
+	}
+
+	// Size the face lists exactly. Collapses only ever add a few faces to a list before it is purged.
+	int* valences = new int[NumVerts];
+	tStd::tMemset(valences, 0, NumVerts*sizeof(int));
+	for (int f = 0; f < NumFaces; f++)
+		for (int c = 0; c < 3; c++)
+			valences[Faces[f].Index[c]]++;
+	for (int v = 0; v < NumVerts; v++)
+		VertFaces[v].Clear(valences[v], 8);
+	delete[] valences;
+
+	for (int f = 0; f < NumFaces; f++)
+		for (int c = 0; c < 3; c++)
+			VertFaces[Faces[f].Index[c]].Append(f);
+
+	// Face plane quadrics, weighted by area.
+	for (int f = 0; f < NumFaces; f++)
+	{
+		const tVector3& p0 = Positions[Faces[f].Index[0]];
+		tVector3 n = (Positions[Faces[f].Index[1]] - p0) % (Positions[Faces[f].Index[2]] - p0);
+		float len = n.Length();
+		if (len <= 0.0f)
+			continue;
+
+		n /= len;
+		for (int c = 0; c < 3; c++)
+			Quadrics[Faces[f].Index[c]].AddPlane(n, -(n*p0), len*0.5f);
+	}
+
+	// Classify edges. Borders and seams get an extra plane through the edge perpendicular to the face. This keeps the
+	// vertices along them from sliding off the line.
+	for (int f = 0; f < NumFaces; f++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			int a = Faces[f].Index[c];
+			int b = Faces[f].Index[(c+1)%3];
+			int numOther = 0;
+			bool seam = false;
+			for (int i = 0; i < VertFaces[a].GetNumElements(); i++)
+			{
+				int g = VertFaces[a][i];
+				int cb = FindCorner(g, b);
+				if ((g == f) || (cb == -1))
+					continue;
+
+				numOther++;
+				int ca = FindCorner(g, a);
+				if ((Wedges[g*3 + ca] != Wedges[f*3 + c]) || (Wedges[g*3 + cb] != Wedges[f*3 + (c+1)%3]))
+					seam = true;
+			}
+
+			if (numOther > 1)
+			{
+				VertFlags[a] |= VertFlag_Locked;
+				VertFlags[b] |= VertFlag_Locked;
+			}
+			else if (numOther == 0)
+			{
+				VertFlags[a] |= VertFlag_Border;
+				VertFlags[b] |= VertFlag_Border;
+			}
+
+			if ((numOther == 0) || seam)
+			{
+				const tVector3& pa = Positions[a];
+				tVector3 edge = Positions[b] - pa;
+				tVector3 faceNorm = (Positions[Faces[f].Index[1]] - Positions[Faces[f].Index[0]]) % (Positions[Faces[f].Index[2]] - Positions[Faces[f].Index[0]]);
+				tVector3 n = edge % faceNorm;
+				float len = n.Length();
+				if (len <= 0.0f)
+					continue;
+
+				n /= len;
+				float weight = Params.SeamWeight * edge.LengthSq();
+				Quadrics[a].AddPlane(n, -(n*pa), weight);
+				Quadrics[b].AddPlane(n, -(n*pa), weight);
+			}
+		}
+	}
+}
+
+
+tSimp::Simplifier::~Simplifier()
+{
+	delete[] Faces;
+	delete[] Wedges;
+	delete[] FaceRemoved;
+	delete[] Quadrics;
+	delete[] VertFlags;
+	delete[] VertRemoved;
+	delete[] VertVersions;
+	delete[] VertFaces;
+	delete[] CandidateMarks;
+	delete[] LinkMarks;
+}
+
+
+bool tSimp::Simplifier::IsSameWeightSet(int setA, int setB) const
+{
+	if (setA == setB)
+		return true;
+
+	if ((setA < 0) || (setB < 0) || !Src.VertTableWeightSets)
+		return false;
+
+	return Src.VertTableWeightSets[setA] == Src.VertTableWeightSets[setB];
+}
+
+
+void tSimp::Simplifier::GatherRing(tArray<int>& ring, int v) const
+{
+	for (int i = 0; i < VertFaces[v].GetNumElements(); i++)
+	{
+		int f = VertFaces[v][i];
+		if (FaceRemoved[f])
+			continue;
+
+		for (int c = 0; c < 3; c++)
+		{
+			int w = Faces[f].Index[c];
+			bool found = false;
+			for (int r = 0; (r < ring.GetNumElements()) && !found; r++)
+				found = (ring[r] == w);
+			if (!found)
+				ring.Append(w);
+		}
+	}
+}
+
+
+void tSimp::Simplifier::PurgeFaces(int v)
+{
+	tArray<int>& faces = VertFaces[v];
+	int numKept = 0;
+	for (int i = 0; i < faces.GetNumElements(); i++)
+		if (!FaceRemoved[faces[i]])
+			faces[numKept++] = faces[i];
+
+	while (faces.GetNumElements() > numKept)
+		faces.Truncate();
+}
+
+
+bool tSimp::Simplifier::EvaluateCollapse(float& cost, int u, int v) const
+{
+	if ((u == v) || VertRemoved[u] || VertRemoved[v] || (VertFlags[u] & VertFlag_Locked))
+		return false;
+
+	// Map each wedge of u to the wedge v has in the same face. The faces that contain both u and v are the ones that
+	// disappear and they tell us what the wedges of u become.
+	const int maxMap = 16;
+	Wedge mapFrom[maxMap];
+	Wedge mapTo[maxMap];
+	int numMap = 0;
+	int numEdgeFaces = 0;
+	const tArray<int>& uFaces = VertFaces[u];
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+	{
+		int f = uFaces[i];
+		int cv = FindCorner(f, v);
+		if (FaceRemoved[f] || (cv == -1))
+			continue;
+
+		numEdgeFaces++;
+		const Wedge& from = Wedges[f*3 + FindCorner(f, u)];
+		const Wedge& to = Wedges[f*3 + cv];
+		if (!IsSameWeightSet(from.Index[Attrib_WeightSet], to.Index[Attrib_WeightSet]))
+			return false;
+
+		int m = 0;
+		for (; m < numMap; m++)
+			if (mapFrom[m] == from)
+				break;
+
+		if (m < numMap)
+		{
+			if (mapTo[m] != to)
+				return false;
+		}
+		else
+		{
+			if (numMap >= maxMap)
+				return false;
+			mapFrom[numMap] = from;
+			mapTo[numMap] = to;
+			numMap++;
+		}
+	}
+
+	// Border vertices may only move along the border. An edge with one face is a border edge.
+	if ((numEdgeFaces == 0) || (numEdgeFaces > 2))
+		return false;
+	if ((VertFlags[u] & VertFlag_Border) && (numEdgeFaces != 1))
+		return false;
+	if (!(VertFlags[u] & VertFlag_Border) && (numEdgeFaces != 2))
+		return false;
+
+	// Every face that remains must have a u wedge that was mapped, and must not flip or become degenerate.
+	const tVector3& pv = Positions[v];
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+	{
+		int f = uFaces[i];
+		if (FaceRemoved[f] || (FindCorner(f, v) != -1))
+			continue;
+
+		const Wedge& from = Wedges[f*3 + FindCorner(f, u)];
+		int m = 0;
+		for (; m < numMap; m++)
+			if (mapFrom[m] == from)
+				break;
+		if (m == numMap)
+			return false;
+
+		tVector3 p[3];
+		for (int c = 0; c < 3; c++)
+			p[c] = Positions[Faces[f].Index[c]];
+		tVector3 before = (p[1] - p[0]) % (p[2] - p[0]);
+		int cu = FindCorner(f, u);
+		p[cu] = pv;
+		tVector3 after = (p[1] - p[0]) % (p[2] - p[0]);
+		float afterLenSq = after.LengthSq();
+		if ((afterLenSq <= before.LengthSq()*1.0e-6f) || ((before*after) <= 0.0f))
+			return false;
+
+		// The moved face must not end up on top of one v already has. This happens when collapsing a tetrahedron.
+		int other0 = Faces[f].Index[(cu+1)%3];
+		int other1 = Faces[f].Index[(cu+2)%3];
+		const tArray<int>& vFaces = VertFaces[v];
+		for (int j = 0; j < vFaces.GetNumElements(); j++)
+		{
+			int g = vFaces[j];
+			if (!FaceRemoved[g] && (FindCorner(g, other0) != -1) && (FindCorner(g, other1) != -1))
+				return false;
+		}
+	}
+
+	// The link condition. The only vertices that may neighbour both u and v are the ones opposite the collapsed edge.
+	// Any others would end up with a non-manifold edge. The neighbours of u are marked with one stamp and each shared
+	// neighbour found around v is re-marked with a second so it is only counted once.
+	uint32 uStamp = ++LinkStamp;
+	uint32 sharedStamp = ++LinkStamp;
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+		if (!FaceRemoved[uFaces[i]])
+			for (int c = 0; c < 3; c++)
+				LinkMarks[Faces[uFaces[i]].Index[c]] = uStamp;
+
+	int numShared = 0;
+	const tArray<int>& vFaces = VertFaces[v];
+	for (int i = 0; i < vFaces.GetNumElements(); i++)
+	{
+		if (FaceRemoved[vFaces[i]])
+			continue;
+		for (int c = 0; c < 3; c++)
+		{
+			int w = Faces[vFaces[i]].Index[c];
+			if ((w != u) && (w != v) && (LinkMarks[w] == uStamp))
+			{
+				LinkMarks[w] = sharedStamp;
+				numShared++;
+			}
+		}
+	}
+	if (numShared != numEdgeFaces)
+		return false;
+
+	Quadric q = Quadrics[u];
+	q.Add(Quadrics[v]);
+	cost = q.Evaluate(pv);
+	return true;
+}
+
+
+bool tSimp::Simplifier::FindBestCollapse(float& cost, int& target, int u) const
+{
+	// Each neighbour is only evaluated once even though it is in two faces.
+	uint32 stamp = ++CandidateStamp;
+	bool found = false;
+	const tArray<int>& uFaces = VertFaces[u];
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+	{
+		if (FaceRemoved[uFaces[i]])
+			continue;
+
+		for (int c = 0; c < 3; c++)
+		{
+			int v = Faces[uFaces[i]].Index[c];
+			if ((v == u) || (CandidateMarks[v] == stamp))
+				continue;
+
+			CandidateMarks[v] = stamp;
+			float vCost = 0.0f;
+			if (EvaluateCollapse(vCost, u, v) && (!found || (vCost < cost)))
+			{
+				cost = vCost;
+				target = v;
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+
+void tSimp::Simplifier::Enqueue(int u)
+{
+	float cost = 0.0f;
+	int target = -1;
+	if (!FindBestCollapse(cost, target, u))
+		return;
+
+	QueueEntry entry;
+	entry.Vert = u;
+	entry.Target = target;
+	entry.Version = VertVersions[u];
+	Queue.Insert(tPriorityQueue<QueueEntry>::tItem(entry, CostToKey(cost)));
+}
+
+
+void tSimp::Simplifier::Collapse(int u, int v)
+{
+	// Build the wedge map again. EvaluateCollapse has already checked it is consistent and complete.
+	const int maxMap = 16;
+	Wedge mapFrom[maxMap];
+	Wedge mapTo[maxMap];
+	int numMap = 0;
+	const tArray<int>& uFaces = VertFaces[u];
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+	{
+		int f = uFaces[i];
+		int cv = FindCorner(f, v);
+		if (FaceRemoved[f] || (cv == -1))
+			continue;
+
+		mapFrom[numMap] = Wedges[f*3 + FindCorner(f, u)];
+		mapTo[numMap] = Wedges[f*3 + cv];
+		numMap++;
+		FaceRemoved[f] = true;
+		NumActiveFaces--;
+	}
+
+	for (int i = 0; i < uFaces.GetNumElements(); i++)
+	{
+		int f = uFaces[i];
+		if (FaceRemoved[f])
+			continue;
+
+		int cu = FindCorner(f, u);
+		Wedge& wedge = Wedges[f*3 + cu];
+		for (int m = 0; m < numMap; m++)
+		{
+			if (mapFrom[m] == wedge)
+			{
+				wedge = mapTo[m];
+				break;
+			}
+		}
+		Faces[f].Index[cu] = v;
+		VertFaces[v].Append(f);
+	}
+
+	Quadrics[v].Add(Quadrics[u]);
+	VertRemoved[u] = true;
+	VertFaces[u].Clear();
+
+	// Everything around v has new neighbours or lost faces so gets a new best collapse.
+	tArray<int> ring(16, 16);
+	GatherRing(ring, v);
+	for (int i = 0; i < ring.GetNumElements(); i++)
+		PurgeFaces(ring[i]);
+
+	for (int i = 0; i < ring.GetNumElements(); i++)
+	{
+		int w = ring[i];
+		VertVersions[w]++;
+		Enqueue(w);
+	}
+}
+
+
+void tSimp::Simplifier::Run()
+{
+	for (int v = 0; v < NumVerts; v++)
+		Enqueue(v);
+
+	while ((NumActiveFaces > TargetFaces) && !Queue.IsEmpty())
+	{
+		tPriorityQueue<QueueEntry>::tItem item = Queue.GetRemoveMin();
+		int u = item.Data.Vert;
+		if (VertRemoved[u] || (item.Data.Version != VertVersions[u]))
+			continue;
+
+		// The neighbourhood may have changed in ways that did not bump the version of u, so check again. If the
+		// collapse is no longer allowed or got more expensive, u goes back in the queue with its new best.
+		float cost = 0.0f;
+		int target = item.Data.Target;
+		if (!EvaluateCollapse(cost, u, target) || (CostToKey(cost) > item.Key))
+		{
+			VertVersions[u]++;
+			Enqueue(u);
+			continue;
+		}
+
+		if (cost > Params.MaxError)
+			break;
+
+		Collapse(u, target);
+	}
+}
+
+
+namespace tSimp
+{
+	// Copies the used entries of a vertex table and remaps the face indices into it. Tables that are not present or
+	// have no face index table are left empty.
+	template<typename T> void CompactTable
+	(
+		T*& dstTable, int& dstNum, tTriFace* dstFaceTable,
+		const T* srcTable, int srcNum, int numFaces
+	)
+	{
+		dstNum = 0;
+		dstTable = nullptr;
+		if (!srcTable || !srcNum || !dstFaceTable)
+			return;
+
+		int* remap = new int[srcNum];
+		for (int i = 0; i < srcNum; i++)
+			remap[i] = -1;
+
+		for (int f = 0; f < numFaces; f++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				int& index = dstFaceTable[f].Index[c];
+				if (remap[index] == -1)
+					remap[index] = dstNum++;
+				index = remap[index];
+			}
+		}
+
+		if (dstNum)
+		{
+			dstTable = new T[dstNum];
+			for (int i = 0; i < srcNum; i++)
+				if (remap[i] != -1)
+					dstTable[remap[i]] = srcTable[i];
+		}
+		delete[] remap;
+	}
+}
+
+
+int tSimp::Simplifier::Write(tMesh& dest) const
+{
+	dest.Clear();
+	dest.SetNumFaces(NumActiveFaces);
+	if (!NumActiveFaces)
+		return 0;
+
+	dest.CreateFaceTableVertPositionIndices();
+	tTriFace** destTables[Attrib_Material] =
+	{
+		Src.FaceTableVertWeightSetIndices	? &dest.FaceTableVertWeightSetIndices	: nullptr,
+		Src.FaceTableVertNormalIndices		? &dest.FaceTableVertNormalIndices		: nullptr,
+		Src.FaceTableUVIndices				? &dest.FaceTableUVIndices				: nullptr,
+		Src.FaceTableNormalMapUVIndices		? &dest.FaceTableNormalMapUVIndices		: nullptr,
+		Src.FaceTableColourIndices			? &dest.FaceTableColourIndices			: nullptr,
+		Src.FaceTableTangentIndices			? &dest.FaceTableTangentIndices			: nullptr
+	};
+	for (int a = 0; a < Attrib_Material; a++)
+		if (destTables[a])
+			*destTables[a] = new tTriFace[NumActiveFaces];
+	if (Src.FaceTableMaterialIDs)
+		dest.CreateFaceTableMaterialIDs();
+
+	int d = 0;
+	for (int f = 0; f < NumFaces; f++)
+	{
+		if (FaceRemoved[f])
+			continue;
+
+		dest.FaceTableVertPositionIndices[d] = Faces[f];
+		for (int c = 0; c < 3; c++)
+			for (int a = 0; a < Attrib_Material; a++)
+				if (destTables[a])
+					(*destTables[a])[d].Index[c] = Wedges[f*3 + c].Index[a];
+
+		if (dest.FaceTableMaterialIDs)
+			dest.FaceTableMaterialIDs[d] = uint32(Wedges[f*3].Index[Attrib_Material]);
+		d++;
+	}
+
+	// Compacting the positions also gives the remap needed for the edges.
+	int* posRemap = new int[NumVerts];
+	for (int v = 0; v < NumVerts; v++)
+		posRemap[v] = -1;
+	for (int f = 0; f < NumActiveFaces; f++)
+		for (int c = 0; c < 3; c++)
+			posRemap[dest.FaceTableVertPositionIndices[f].Index[c]] = 0;
+
+	int numPositions = 0;
+	for (int v = 0; v < NumVerts; v++)
+		if (posRemap[v] != -1)
+			posRemap[v] = numPositions++;
+
+	dest.SetNumVertPositions(numPositions);
+	dest.CreateVertTablePositions();
+	for (int v = 0; v < NumVerts; v++)
+		if (posRemap[v] != -1)
+			dest.VertTablePositions[posRemap[v]] = Positions[v];
+	for (int f = 0; f < NumActiveFaces; f++)
+		for (int c = 0; c < 3; c++)
+			dest.FaceTableVertPositionIndices[f].Index[c] = posRemap[dest.FaceTableVertPositionIndices[f].Index[c]];
+
+	if (Src.EdgeTableVertPositionIndices && Src.NumEdges)
+	{
+		int numEdges = 0;
+		for (int e = 0; e < Src.NumEdges; e++)
+			if ((posRemap[Src.EdgeTableVertPositionIndices[e].Index[0]] != -1) && (posRemap[Src.EdgeTableVertPositionIndices[e].Index[1]] != -1))
+				numEdges++;
+
+		dest.SetNumEdges(numEdges);
+		dest.CreateEdgeTableVertPositionIndices();
+		numEdges = 0;
+		for (int e = 0; e < Src.NumEdges; e++)
+		{
+			const tEdge& edge = Src.EdgeTableVertPositionIndices[e];
+			if ((posRemap[edge.Index[0]] == -1) || (posRemap[edge.Index[1]] == -1))
+				continue;
+			dest.EdgeTableVertPositionIndices[numEdges].Index[0] = posRemap[edge.Index[0]];
+			dest.EdgeTableVertPositionIndices[numEdges].Index[1] = posRemap[edge.Index[1]];
+			numEdges++;
+		}
+	}
+	delete[] posRemap;
+
+	CompactTable(dest.VertTableWeightSets, dest.NumVertWeightSets, dest.FaceTableVertWeightSetIndices, Src.VertTableWeightSets, Src.NumVertWeightSets, NumActiveFaces);
+	CompactTable(dest.VertTableNormals, dest.NumVertNormals, dest.FaceTableVertNormalIndices, Src.VertTableNormals, Src.NumVertNormals, NumActiveFaces);
+	CompactTable(dest.VertTableUVs, dest.NumVertUVs, dest.FaceTableUVIndices, Src.VertTableUVs, Src.NumVertUVs, NumActiveFaces);
+	CompactTable(dest.VertTableNormalMapUVs, dest.NumVertNormalMapUVs, dest.FaceTableNormalMapUVIndices, Src.VertTableNormalMapUVs, Src.NumVertNormalMapUVs, NumActiveFaces);
+	CompactTable(dest.VertTableColours, dest.NumVertColours, dest.FaceTableColourIndices, Src.VertTableColours, Src.NumVertColours, NumActiveFaces);
+	CompactTable(dest.VertTableTangents, dest.NumVertTangents, dest.FaceTableTangentIndices, Src.VertTableTangents, Src.NumVertTangents, NumActiveFaces);
+
+	if (Src.FaceTableFaceNormals)
+	{
+		dest.CreateFaceTableFaceNormals();
+		for (int f = 0; f < NumActiveFaces; f++)
+		{
+			const tTriFace& face = dest.FaceTableVertPositionIndices[f];
+			const tVector3& p0 = dest.VertTablePositions[face.Index[0]];
+			tVector3 n = (dest.VertTablePositions[face.Index[1]] - p0) % (dest.VertTablePositions[face.Index[2]] - p0);
+			n.Normalize();
+			dest.FaceTableFaceNormals[f] = n;
+		}
+	}
+
+	dest.Modified();
+	return NumActiveFaces;
+}
+
+
+int tSimplify(tMesh& dest, const tMesh& src, const tSimplifyParams& params)
+{
+	tAssert(&dest != &src);
+	if (!src.VertTablePositions || !src.FaceTableVertPositionIndices || !src.NumFaces || !src.NumVertPositions)
+	{
+		dest = src;
+		return dest.NumFaces;
+	}
+
+	tSimp::Simplifier simplifier(src, params);
+	simplifier.Run();
+	return simplifier.Write(dest);
+}
+
+
+}
@@ -21,6 +21,11 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <atomic>
+#include <thread>
+#include <Foundation/tArray.h>
+#include <System/tMachine.h>
+#include "Scene/tSimplify.h"
 #include "Scene/tWorld.h"
 using namespace tMath;
 using namespace tStd;
@@ -1637,6 +1642,108 @@ int tWorld::GenerateLodGroupsFromModelNamingConvention()
 }
 
 
+int tWorld::GenerateLodGroupsFromSimplification(int numLevels, const float* triangleRatios, const float* thresholds, int numThreads)
+{
+	if ((numLevels <= 0) || !triangleRatios || !thresholds)
+		return 0;
+
+	tArray<tPolyModel*> sources(PolyModels.GetNumItems(), 64);
+	for (tItList<tPolyModel>::Iter model = PolyModels.First(); model; ++model)
+		if (!model->IsLodGroupMember && !FindLodGroup(model->Name))
+			sources.Append(model);
+
+	int numSources = sources.GetNumElements();
+	if (!numSources)
+		return 0;
+
+	// One job for every level of every model that needs simplifying. The results are indexed the same as the jobs.
+	int numJobs = numSources * numLevels;
+	tPolyModel** results = new tPolyModel*[numJobs];
+	for (int j = 0; j < numJobs; j++)
+		results[j] = nullptr;
+
+	std::atomic<int> nextJob(0);
+	auto worker = [&]()
+	{
+		for (int j = nextJob++; j < numJobs; j = nextJob++)
+		{
+			float ratio = triangleRatios[j % numLevels];
+			if (ratio >= 1.0f)
+				continue;
+
+			tSimplifyParams params;
+			params.TargetRatio = ratio;
+			results[j] = new tPolyModel();
+			tSimplify(results[j]->Mesh, sources[j / numLevels]->Mesh, params);
+		}
+	};
+
+	int numWorkers = tMin((numThreads > 0) ? numThreads : tSystem::tGetNumCores(), numJobs);
+	if (numWorkers <= 1)
+	{
+		worker();
+	}
+	else
+	{
+		std::thread* workers = new std::thread[numWorkers];
+		for (int w = 0; w < numWorkers; w++)
+			workers[w] = std::thread(worker);
+		for (int w = 0; w < numWorkers; w++)
+			workers[w].join();
+		delete[] workers;
+	}
+
+	// New objects are added serially so the IDs do not depend on the thread timing.
+	uint32 nextModelID = NextPolyModelID;
+	for (tItList<tPolyModel>::Iter model = PolyModels.First(); model; ++model)
+		if (model->ID >= nextModelID)
+			nextModelID = model->ID + 1;
+
+	uint32 nextLodGroupID = NextLodGroupID;
+	for (tItList<tLodGroup>::Iter grp = LodGroups.First(); grp; ++grp)
+		if (grp->ID >= nextLodGroupID)
+			nextLodGroupID = grp->ID + 1;
+
+	for (int s = 0; s < numSources; s++)
+	{
+		tPolyModel* source = sources[s];
+		tLodGroup* group = new tLodGroup();
+		group->ID = nextLodGroupID++;
+		group->Name = source->Name;
+
+		for (int l = 0; l < numLevels; l++)
+		{
+			tLodParam* param = new tLodParam();
+			param->Threshold = thresholds[l];
+			tPolyModel* lodModel = results[s*numLevels + l];
+			if (lodModel)
+			{
+				lodModel->ID = nextModelID++;
+				tsPrintf(lodModel->Name, "%s_LOD_%d", source->Name.Chr(), int(thresholds[l]*100.0f + 0.5f));
+				lodModel->Attributes = source->Attributes;
+				lodModel->IsLodGroupMember = true;
+				PolyModels.Append(lodModel);
+				param->ModelID = lodModel->ID;
+			}
+			else
+			{
+				source->IsLodGroupMember = true;
+				param->ModelID = source->ID;
+			}
+			group->LodParams.Append(param);
+		}
+
+		group->Sort();
+		LodGroups.Append(group);
+	}
+
+	NextPolyModelID = nextModelID;
+	NextLodGroupID = nextLodGroupID;
+	delete[] results;
+	return numSources;
+}
+
+
 int tWorld::GetNumInstances(const tString& name) const
 {
 	if (name.IsEmpty())
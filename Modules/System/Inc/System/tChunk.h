@@ -456,6 +456,7 @@ namespace tChunkID
 				Scene_PolyModel																	= 0x81003000,
 					Previous(Scene_Object)
 					Previous(Core_Bool)																					// Is model a member of an LOD group.
+					Scene_PolyModelBounds														= 0x01003100,			// Cached bounds. Min radius, max radius, bounding box (min xyz followed by max xyz), approx area.
 					Scene_Mesh																	= 0x81004000,			// The mesh is a triangle mesh.
 						Scene_MeshProperties													= 0x0100A000,			// Contains, in order, NumFaces, NumEdges, NumVerts, NumNormals, NumUVs, and NumColours
 						Scene_FaceTable_VertPositionIndices										= 0x0100B000,			// Each entry contains 3 indices into the vertex table.
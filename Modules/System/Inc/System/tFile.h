@@ -30,6 +30,7 @@
 
 #pragma once
 #include <ctime>
+#include <functional>
 #include <Foundation/tHash.h>
 #include "System/tThrow.h"
 #include "System/tPrint.h"
@@ -73,6 +74,13 @@ enum class tSeekOrigin
 };
 int tFileSeek(tFileHandle, int offsetBytes, tSeekOrigin = tSeekOrigin::Beginning);
 
+// 64-bit versions of the above for files bigger than 2GB. The int versions silently truncate for these files.
+int64 tGetFileSize64(tFileHandle);
+int64 tReadFile64(tFileHandle, void* buffer, int64 sizeBytes);
+int64 tWriteFile64(tFileHandle, const void* buffer, int64 sizeBytes);
+int64 tFileTell64(tFileHandle);
+int tFileSeek64(tFileHandle, int64 offsetBytes, tSeekOrigin = tSeekOrigin::Beginning);
+
 
 //
 // Path-based functions work on the syntax of a path but generally do not need to access the filesystem.
@@ -177,8 +185,10 @@ bool tFileExists(const tString& file);
 // all you'll get a false as well. If you want to check if a drive letter exists on windows, use tDriveExists.
 bool tDirExists(const tString& dir);
 
-// Returns 0 if the file doesn't exist. Also returns 0 if the file exists and its size is actually 0.
+// Returns 0 if the file doesn't exist. Also returns 0 if the file exists and its size is actually 0. Use the 64-bit
+// version for files that may be bigger than 2GB.
 int tGetFileSize(const tString& file);
+int64 tGetFileSize64(const tString& file);
 
 // Works for both files and directories. Returns false if read-only not set or an error occurred like the path not
 // existing. For Lixux returns true is user w permission flag not set and r permission flag is set.
@@ -207,12 +217,15 @@ bool tDriveExists(const tString& driveName);
 
 bool tIsFileNewer(const tString& fileA, const tString& fileB);
 
-// If either (or both) file doesn't exist you get false. Entire files will temporarily be read into memory so it's not
-// too efficient (only for tool use).
+// If either (or both) file doesn't exist you get false. Files of any size are supported. They are compared a chunk at
+// a time and the compare stops at the first difference, so only a small amount of memory is used. If a tHashCache is
+// installed with tSetHashCache, the cached content hashes are compared instead and unchanged files are not read.
 bool tFilesIdentical(const tString& fileA, const tString& fileB);
 
 // Overwrites dest if it exists. Returns true if success. Will return false and not copy if overWriteReadOnly is false
-// and the file already exists and is read-only.
+// and the file already exists and is read-only. On Linux the copy is done by the kernel. A reflink (shared extents)
+// is made if the filesystem supports it, otherwise copy_file_range or sendfile is used so the data never passes
+// through user space.
 bool tCopyFile(const tString& destFile, const tString& srcFile, bool overWriteReadOnly = true);
 
 // Renames the file or directory specified by oldName to the newName. This function can only be used for renaming, not
@@ -649,6 +662,52 @@ bool tFindFilesRec(tList<tFileInfo>&   files, const tString& dir, bool hidden =
 bool tFindFilesRec(tList<tFileInfo>&   files, const tString& dir, const tString& ext, bool hidden = true, Backend = Backend::Native);
 bool tFindFilesRec(tList<tFileInfo>&   files, const tString& dir, const tExtensions&, bool hidden = true, Backend = Backend::Native);
 
+// A compact container for a large number of paths. All the paths are stored back-to-back in a single buffer instead of
+// as one heap-allocated list node each. Appending is amortized constant time.
+class tPathArena
+{
+public:
+	tPathArena()																										{ }
+	tPathArena(const tPathArena&)																						= delete;
+	tPathArena& operator=(const tPathArena&)																			= delete;
+	virtual ~tPathArena()																								{ Clear(); }
+
+	void Clear();
+	void Append(const char* path, int length);
+	void Append(const tPathArena&);
+
+	int GetNumPaths() const																								{ return NumPaths; }
+	const char* GetPath(int index) const																				{ tAssert((index >= 0) && (index < NumPaths)); return Buffer + Offsets[index]; }
+	int GetPathLength(int index) const																					{ tAssert((index >= 0) && (index < NumPaths)); return int(((index+1 < NumPaths) ? Offsets[index+1] : BufferSize) - Offsets[index] - 1); }
+
+private:
+	char* Buffer					= nullptr;		// The paths are null-terminated.
+	int64 BufferSize				= 0;
+	int64 BufferCapacity			= 0;
+	int64* Offsets					= nullptr;
+	int NumPaths					= 0;
+	int OffsetsCapacity				= 0;
+};
+
+// Parallel recursive enumeration for very large trees. Sub-directories are scanned concurrently by a bounded pool of
+// worker threads. If numThreads <= 0 the number of cores is used. On Linux directories are read with getdents64 and
+// entry types come from the directory entries themselves, only falling back to fstatat when the filesystem doesn't
+// supply them. On other platforms each directory is read with the Native backend. Symbolic links are not followed.
+// If hidden is false, hidden files are skipped and hidden directories are not descended into. The order of results is
+// not defined. The paths have the same form as the tFindFilesRec and tFindDirsRec results, with directories ending in
+// a slash. The supplied dir itself is not reported.
+//
+// The callback version streams entries as they are found. The callback is called from the worker threads, possibly
+// concurrently, so it must be thread-safe. Return false from the callback to stop the walk early. If includeDirs is
+// true, directories are reported as well as files. If extensions is non-null only files with one of the extensions
+// are reported. Returns false if the dir could not be read or the walk was stopped.
+typedef std::function<bool(const char* path, bool isDir)> tFindRecCallback;
+bool tFindRecParallel(const tFindRecCallback&, const tString& dir, bool includeDirs, const tExtensions* = nullptr, bool hidden = true, int numThreads = 0);
+
+// These append to the supplied arena. Each worker collects into its own arena so no locking is done per entry.
+bool tFindFilesRecParallel(tPathArena& files, const tString& dir, const tExtensions* = nullptr, bool hidden = true, int numThreads = 0);
+bool tFindDirsRecParallel(tPathArena& dirs, const tString& dir, bool hidden = true, int numThreads = 0);
+
 // Creates a directory. The parent directory must already exist. For example, if you pass "C:/DirA/DirB/", DirB will
 // only be created if C:/DirA/ already existed.
 bool tCreateDir(const tString& dir);
@@ -665,7 +724,8 @@ bool tDeleteDir(const tString& directory, bool deleteReadOnly = true);
 // @todo Implement the tFile class. Right now we're basically just reserving the class name.
 class tFile : public tStream { tFile(const tString& file, tStream::tModes modes)																: tStream(modes) { } };
 
-// File hash functions using tHash standard hash algorithms.
+// File hash functions using tHash standard hash algorithms. If a tHashCache is installed with tSetHashCache,
+// tHashFile64 with the default iv gets its result from the cache.
 uint32 tHashFileFast32(  const tString& filename, uint32         iv = tHash::HashIV32);
 uint32 tHashFile32(      const tString& filename, uint32         iv = tHash::HashIV32);
 uint64 tHashFile64(      const tString& filename, uint64         iv = tHash::HashIV64);
@@ -774,6 +834,28 @@ inline int tSystem::tFileTell(tFileHandle handle)
 }
 
 
+inline int64 tSystem::tReadFile64(tFileHandle handle, void* buffer, int64 sizeBytes)
+{
+	return int64(fread((char*)buffer, 1, size_t(sizeBytes), handle));
+}
+
+
+inline int64 tSystem::tWriteFile64(tFileHandle handle, const void* buffer, int64 sizeBytes)
+{
+	return int64(fwrite((void*)buffer, 1, size_t(sizeBytes), handle));
+}
+
+
+inline int64 tSystem::tFileTell64(tFileHandle handle)
+{
+	#ifdef PLATFORM_WINDOWS
+	return int64(_ftelli64(handle));
+	#else
+	return int64(ftello(handle));
+	#endif
+}
+
+
 inline bool tSystem::tIsDir(const tString& path)
 {
 	if (path.IsEmpty())
@@ -0,0 +1,138 @@
+// tHashCache.h
+//
+// A persistent cache mapping file metadata to content hashes. Each entry is keyed by path and remembers the file's
+// size, modification time, and inode along with the 64-bit content hash. If the metadata of a file still matches, the
+// hash is returned without reading the file. The cache lives in a single file that is memory-mapped and updated in
+// place, so only entries that changed are ever written.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <mutex>
+#include <Foundation/tString.h>
+namespace tSystem
+{
+
+
+// The metadata used to decide if a file may have changed. ModTime is in nanoseconds since the POSIX epoch. Inode is 0
+// on platforms that don't have a cheap equivalent.
+struct tFileStamp
+{
+	uint64 Size				= 0;
+	int64 ModTime			= 0;
+	uint64 Inode			= 0;
+	bool operator==(const tFileStamp& s) const																			{ return (Size == s.Size) && (ModTime == s.ModTime) && (Inode == s.Inode); }
+	bool operator!=(const tFileStamp& s) const																			{ return !(*this == s); }
+};
+
+// Returns false if the file doesn't exist or is a directory. This is a single stat call.
+bool tGetFileStamp(tFileStamp&, const tString& file);
+
+
+class tHashCache
+{
+public:
+	tHashCache()																										{ }
+
+	// Calls Open with the supplied cache file.
+	tHashCache(const tString& cacheFile)																				{ Open(cacheFile); }
+	virtual ~tHashCache()																								{ Close(); }
+
+	// Opens the cache file, creating it if it doesn't exist. A cache file that is damaged or from a different version
+	// is silently reset, it's only a cache. Returns false if the file could not be created or mapped. Only one process
+	// should have a given cache file open at a time.
+	bool Open(const tString& cacheFile);
+	bool IsOpen() const																									{ return Data != nullptr; }
+
+	// Makes sure all changes are written to disk. On Linux the file is mapped and the OS writes changes as they happen,
+	// so this only needs to be called if you want them on disk right now. Elsewhere the table is written here.
+	bool Flush();
+
+	// Flushes and closes the cache file. Safe to call on a cache that isn't open.
+	void Close();
+
+	// Gets the 64-bit content hash of a file. This is the same value tHashFile64 returns with the default iv. The file
+	// is only read if its stamp does not match the cached one. Returns false if the file can't be read, in which case
+	// hash is not modified. Files modified in the last couple of seconds are hashed but not recorded, since a second
+	// change within the same timestamp tick would otherwise go unnoticed. Works (without caching) if not open. If stamp
+	// is supplied it receives the stamp of the file so callers don't need to stat it again.
+	bool GetHash(uint64& hash, const tString& file, tFileStamp* stamp = nullptr);
+
+	// Returns true if both files exist, are the same size, and have the same content hash. No file is read if both
+	// hashes are cached. Two different files with the same 64-bit hash would be reported as identical, so use
+	// tFilesIdentical without a cache installed if that one-in-2^64 chance matters to you.
+	bool FilesIdentical(const tString& fileA, const tString& fileB);
+
+	// General keyed values tied to a file stamp. GetValue returns false if there is no value for the key or if the
+	// stamp it was stored with differs from the supplied one. tRule uses these to remember the dependency signature
+	// of a target.
+	bool GetValue(uint64& value, const tString& key, const tFileStamp&);
+	void SetValue(const tString& key, const tFileStamp&, uint64 value);
+
+	// Forgets everything. The cache file stays open.
+	void Clear();
+
+	int GetNumEntries() const																							{ return Header() ? int(Header()->NumEntries) : 0; }
+	int GetNumHits() const																								{ return NumHits; }
+	int GetNumMisses() const																							{ return NumMisses; }
+
+private:
+	struct HeaderType
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 Capacity;						// Always a power of 2.
+		uint32 NumEntries;
+	};
+
+	// A Key of 0 means the slot is empty. Check is a hash of the other members so a torn write is seen as a miss.
+	struct EntryType
+	{
+		uint64 Key;
+		uint64 Size;
+		int64 ModTime;
+		uint64 Inode;
+		uint64 Value;
+		uint64 Check;
+	};
+
+	static uint64 ComputeKey(const tString& path);
+	static uint64 ComputeCheck(const EntryType&);
+	HeaderType* Header() const																							{ return (HeaderType*)Data; }
+	EntryType* Entries() const																							{ return (EntryType*)(Data + sizeof(HeaderType)); }
+
+	// These must be called with the mutex held.
+	bool Lookup(uint64& value, uint64 key, const tFileStamp&);
+	void Store(uint64 key, const tFileStamp&, uint64 value);
+	bool Resize(uint32 capacity);
+	void Unmap();
+
+	std::mutex Mutex;
+	tString CacheFile;
+	uint8* Data				= nullptr;
+	int64 DataSize			= 0;
+	#if defined(PLATFORM_LINUX)
+	int FileDescriptor		= -1;
+	#else
+	bool Dirty				= false;
+	#endif
+	int NumHits				= 0;
+	int NumMisses			= 0;
+};
+
+
+// A process-wide cache that tHashFile64 (with the default iv), tFilesIdentical, and tRule::OutOfDate use if set. Set
+// it to nullptr to go back to reading files every time. The cache is not owned.
+void tSetHashCache(tHashCache*);
+tHashCache* tGetHashCache();
+
+
+}
@@ -16,6 +16,10 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #pragma once
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <type_traits>
 #include <Foundation/tString.h>
 #include <Foundation/tFixInt.h>
 #include <Math/tLinearAlgebra.h>
@@ -75,6 +79,7 @@ namespace tSystem
 	// If you wish top turn on or off channels regardless of computer name, just call this with the channels you want.
 	// Any channel not specified will no longer be displayed.
 	void tSetChannels(tChannel channelsToSee);
+	tChannel tGetChannels();
 
 	// After all print formatting, a simple stream output function is called, possibly multiple times, for the Print,
 	// tPrintf, and tvPrintf functions. By default those functions output to stdout. By setting the OutputCallback
@@ -90,6 +95,28 @@ namespace tSystem
 	// still be called regardless of what you call SetSupplementaryDebuggerOutput with.
 	void tSetSupplementaryDebuggerOutput(bool enable = true);
 
+	// Asynchronous output. Once started, text that would go to stdout (or the redirect callback) is copied into a
+	// lock-free ring buffer belonging to the calling thread, and the print returns straight away. A background thread
+	// drains the ring buffers and writes the text out in batches. If logFile is supplied the text is written to it
+	// instead of stdout. Each printing thread gets a ring buffer of bufferSize bytes and memory never grows past that --
+	// a message that doesn't fit is dropped and counted, and a note saying how many were dropped is written. When a
+	// thread exits its ring buffer is reused by the next new printing thread, so the total is bufferSize times the most
+	// threads that were printing at the same time. Output from one thread stays in order, but output from different
+	// threads may interleave differently than it was printed. Starting when already started restarts with the new
+	// settings. Returns false if the log file can't be opened.
+	bool tStartAsyncOutput(const tString& logFile = tString(), int bufferSize = 64*1024);
+	bool tIsAsyncOutput();
+
+	// Blocks until everything printed before the call has been written. Does nothing if async output isn't started.
+	void tFlushAsyncOutput();
+
+	// Flushes, stops the background thread, and goes back to printing on the calling thread. This is called for you at
+	// exit if you forget.
+	void tStopAsyncOutput();
+
+	// The number of messages dropped because a ring buffer was full since the last tStartAsyncOutput.
+	int tGetNumDroppedOutput();
+
 	// This is a non-formatting print. Just prints the string you give it to the supplied FileHandle. If the supplied
 	// FileHandle is set to 0 then stdout is used. When stdout is the destination this function performs filtering on
 	// the characters that are printed. On some platforms there are unprintable stdout characters that this function
@@ -118,6 +145,40 @@ namespace tSystem
 	// These are synonyms of the above two functions.
 	inline bool tFtoa(tString& dest, float value, bool incBitRep = true)												{ return tFtostr(dest, value, incBitRep); }
 	inline bool tDtoa(tString& dest, double value, bool incBitRep = true)												{ return tDtostr(dest, value, incBitRep); }
+
+	// A single parsed format specification. The compile-time format functions (see tsPrintf<"...">) build these while
+	// compiling, so the format string is never looked at when they run.
+	enum tPrintFlag : uint32
+	{
+		tPrintFlag_ForcePosOrNegSign			= 1 << 0,
+		tPrintFlag_SpaceForPosSign				= 1 << 1,
+		tPrintFlag_LeadingZeros					= 1 << 2,
+		tPrintFlag_LeftJustify					= 1 << 3,
+		tPrintFlag_DecorativeFormatting			= 1 << 4,
+		tPrintFlag_DecorativeFormattingAlt		= 1 << 5,
+		tPrintFlag_BasePrefix					= 1 << 6
+	};
+
+	struct tPrintSpec
+	{
+		char Type						= '\0';		// The type character. eg. 'd' or 'v'.
+		uint32 Flags					= 0;		// Any combination of tPrintFlags.
+		int Width						= 0;
+		int Precision					= -1;		// -1 means not specified.
+		int TypeSizeBytes				= 0;		// Already defaulted from the type. Chars and shorts are promoted to 4.
+	};
+
+	// Formats a single value. The data points to the value as it would be read from a vararg list, so integers are at
+	// least 32 bits and floats are doubles. At most destSize characters are written and no terminator is added. Returns
+	// the number of characters the value needs, which may be more than destSize. Dest may be nullptr to just count.
+	int tPrintValue(char* dest, int destSize, const tPrintSpec&, const void* data);
+
+	// Holds a format string passed as a template argument.
+	template<int N> struct tFormatString
+	{
+		constexpr tFormatString(const char (&text)[N])																	{ for (int c = 0; c < N; c++) Text[c] = text[c]; }
+		char Text[N];
+	};
 };
 
 
@@ -201,9 +262,8 @@ namespace tSystem
 //									when _ used and Y or N when ' used.
 //		Percent:	%				Displays percent sign.
 //
-// The functions return the number of characters printed. They do NOT care about channels in that they always report
-// what would have been printed if the channel was visible. Channels are an output filter only, not something that
-// changes behaviour depending on what machine you are on.
+// The functions return the number of characters printed. If none of the supplied channels are visible nothing is
+// formatted and 0 is returned, so leaving debug prints in costs almost nothing when their channels are off.
 //
 // Examples:
 // uint32 a = 0x1234ABCD;
@@ -313,6 +373,22 @@ int tmsPrintf(tSystem::tChannel channels, char* dest, int destSize, const char*
 int tmfPrintf(tFileHandle dest, const char* format, ...);
 int tmfPrintf(tSystem::tChannel channels, tFileHandle dest, const char* format, ...);
 
+// Compile-time format strings. Give the format as a template argument, as in tsPrintf<"%d items">(str, numItems), and
+// it is parsed while compiling. The arguments are checked against it as well. The wrong number of arguments, or an
+// argument that does not match its specifier (a float for %d, an int64 for %d instead of %|64d, or a tVec3 for %:4v),
+// will not compile. The output is identical to the regular functions of the same name, but nothing is parsed at runtime
+// and the text goes straight into the destination without heap allocations, apart from growing a tString when needed.
+// tStrings may be passed to %s directly without calling Pod.
+template<tSystem::tFormatString F, typename... Args> int tsPrintf(char* dest, int destSize, const Args&...);
+template<tSystem::tFormatString F, typename... Args> tString& tsPrintf(tString& dest, const Args&...);
+template<tSystem::tFormatString F, typename... Args> tString& tsaPrintf(tString& dest, const Args&...);
+template<tSystem::tFormatString F, typename... Args> tString tsrPrintf(const Args&...);
+template<tSystem::tFormatString F, typename... Args> int tcPrintf(const Args&...);
+template<tSystem::tFormatString F, typename... Args> int tPrintf(const Args&...);
+namespace tPrintInternal { template<tSystem::tFormatString F> constexpr int GetNumArgs(); }
+template<tSystem::tFormatString F, typename... Args> requires (tPrintInternal::GetNumArgs<F>() == sizeof...(Args))
+int tPrintf(tSystem::tChannel channels, const Args&...);
+
 
 // Implementation below this line.
 
@@ -471,3 +547,488 @@ inline int tmfPrintf(tSystem::tChannel channels, tFileHandle dest, const char* f
 	tvPrintf(channels, format, marker); 
 	return tfvPrintf(dest, format, marker);
 }
+
+
+namespace tPrintInternal
+{
+	// One piece of a parsed format string. A run of literal text, then an optional specification.
+	struct FormatItem
+	{
+		int LiteralStart				= 0;		// Index into the format text.
+		int LiteralLength				= 0;
+		tSystem::tPrintSpec Spec;
+		int WidthArg					= -1;		// Index of the argument holding the width for a * width.
+		int PrecisionArg				= -1;		// Index of the argument holding the precision for a * precision.
+		int ValueArg					= -1;		// Index of the argument to print. -1 if there's no specification.
+	};
+
+	template<int MaxItems> struct FormatProgram
+	{
+		FormatItem Items[MaxItems];
+		int NumItems					= 0;
+		int NumArgs						= 0;
+		bool Valid						= true;
+	};
+
+	// Returns 0 if the character isn't a type.
+	constexpr int GetDefaultTypeSize(char type)
+	{
+		switch (type)
+		{
+			case 'b': case 'o': case 'd': case 'i': case 'u': case 'x': case 'X': case 'c': case 'B':
+				return 4;
+			case 'p': case 's':
+				return int(sizeof(void*));
+			case 'e': case 'f': case 'g':
+				return 8;
+			case 'v':	return int(sizeof(tMath::tVec3));
+			case 'q':	return int(sizeof(tMath::tQuat));
+			case 'm':	return int(sizeof(tMath::tMat4));
+		}
+		return 0;
+	}
+
+	// Type sizes the handlers can print.
+	constexpr bool IsValidTypeSize(char type, int size)
+	{
+		switch (type)
+		{
+			case 'b': case 'o': case 'd': case 'i': case 'u': case 'x': case 'X':
+				return (size == 4) || (size == 8) || (size == 16) || (size == 32) || (size == 64);
+			case 'p':		return (size == 4) || (size == 8);
+			case 'c':		return size == 4;
+			case 'B':		return size == 4;
+			case 'e': case 'f': case 'g':
+				return size == 8;
+			case 'v':		return (size == 8) || (size == 12) || (size == 16);
+			case 'q':		return size == 16;
+			case 'm':		return (size == 16) || (size == 64);
+			case 's':		return size == int(sizeof(void*));
+		}
+		return false;
+	}
+
+	// Same rules as tSystem::IsValidFormatSpecifierCharacter.
+	constexpr bool IsSpecCharacter(char c)
+	{
+		return
+			(c == '-') || (c == '+') || (c == ' ') || (c == '0') || (c == '#') || (c == '_') || (c == '\'') ||
+			((c >= '0') && (c <= '9')) || (c == '.') || (c == '*') || (c == ':') || (c == '!') || (c == '|') ||
+			GetDefaultTypeSize(c);
+	}
+
+	template<int N> constexpr int GetMaxItems(const char (&text)[N])
+	{
+		int count = 1;
+		for (int c = 0; c < N; c++)
+			if (text[c] == '%')
+				count++;
+		return count;
+	}
+
+	// This parses exactly like tSystem::Process so the output is identical. Anything Process would assert on, or read
+	// past the end of the string for, makes the program invalid.
+	template<int MaxItems, int N> constexpr FormatProgram<MaxItems> Parse(const char (&text)[N])
+	{
+		FormatProgram<MaxItems> program;
+		int pos = 0;
+		int literalStart = 0;
+		while ((pos < N-1) && text[pos])
+		{
+			if (text[pos] != '%')
+			{
+				pos++;
+				continue;
+			}
+
+			FormatItem& item = program.Items[program.NumItems++];
+			item.LiteralStart = literalStart;
+			item.LiteralLength = pos - literalStart;
+			char next = text[pos+1];
+			if (!next)
+			{
+				program.Valid = false;
+				return program;
+			}
+
+			// An invalid character after the % is printed. This is how %% works. It starts the next literal.
+			if (!IsSpecCharacter(next))
+			{
+				literalStart = pos + 1;
+				pos += 2;
+				continue;
+			}
+
+			pos++;
+			tSystem::tPrintSpec& spec = item.Spec;
+			while
+			(
+				(text[pos] == '-') || (text[pos] == '+') || (text[pos] == ' ') || (text[pos] == '0') ||
+				(text[pos] == '_') || (text[pos] == '\'') || (text[pos] == '#')
+			)
+			{
+				switch (text[pos])
+				{
+					case '-':	spec.Flags |= tSystem::tPrintFlag_LeftJustify;				break;
+					case '+':	spec.Flags |= tSystem::tPrintFlag_ForcePosOrNegSign;		break;
+					case ' ':	spec.Flags |= tSystem::tPrintFlag_SpaceForPosSign;			break;
+					case '0':	spec.Flags |= tSystem::tPrintFlag_LeadingZeros;				break;
+					case '_':	spec.Flags |= tSystem::tPrintFlag_DecorativeFormatting;		break;
+					case '\'':	spec.Flags |= tSystem::tPrintFlag_DecorativeFormattingAlt;	break;
+					case '#':	spec.Flags |= tSystem::tPrintFlag_BasePrefix;				break;
+				}
+				pos++;
+			}
+
+			if ((spec.Flags & tSystem::tPrintFlag_LeadingZeros) && (spec.Flags & tSystem::tPrintFlag_LeftJustify))
+				spec.Flags &= ~tSystem::tPrintFlag_LeadingZeros;
+
+			if (text[pos] == '*')
+			{
+				item.WidthArg = program.NumArgs++;
+				pos++;
+			}
+			else
+			{
+				while ((text[pos] >= '0') && (text[pos] <= '9'))
+					spec.Width = spec.Width*10 + (text[pos++] - '0');
+			}
+
+			if (text[pos] == '.')
+			{
+				spec.Precision = 0;
+				pos++;
+				if (text[pos] == '*')
+				{
+					item.PrecisionArg = program.NumArgs++;
+					pos++;
+				}
+				else
+				{
+					while ((text[pos] >= '0') && (text[pos] <= '9'))
+						spec.Precision = spec.Precision*10 + (text[pos++] - '0');
+				}
+			}
+
+			if ((text[pos] == ':') || (text[pos] == '!') || (text[pos] == '|'))
+			{
+				char typeUnit = text[pos++];
+				while ((text[pos] >= '0') && (text[pos] <= '9'))
+					spec.TypeSizeBytes = spec.TypeSizeBytes*10 + (text[pos++] - '0');
+				switch (typeUnit)
+				{
+					case ':':	spec.TypeSizeBytes *= 4;	break;
+					case '|':	spec.TypeSizeBytes /= 8;	break;
+				}
+			}
+
+			spec.Type = text[pos];
+			int defaultSize = GetDefaultTypeSize(spec.Type);
+			if (!spec.TypeSizeBytes)
+				spec.TypeSizeBytes = defaultSize;
+			else if ((spec.TypeSizeBytes == 1) || (spec.TypeSizeBytes == 2))
+				spec.TypeSizeBytes = 4;
+
+			if (!defaultSize || !IsValidTypeSize(spec.Type, spec.TypeSizeBytes))
+			{
+				program.Valid = false;
+				return program;
+			}
+
+			item.ValueArg = program.NumArgs++;
+			pos++;
+			literalStart = pos;
+		}
+
+		FormatItem& last = program.Items[program.NumItems++];
+		last.LiteralStart = literalStart;
+		last.LiteralLength = pos - literalStart;
+		return program;
+	}
+
+	template<tSystem::tFormatString F> inline constexpr auto Program = Parse<GetMaxItems(F.Text)>(F.Text);
+	template<tSystem::tFormatString F> constexpr int GetNumArgs()														{ return Program<F>.NumArgs; }
+
+	// What an argument is as far as matching it to a specification goes. Sizes are after vararg promotion.
+	enum class ArgKind
+	{
+		Unsupported,
+		Integral,							// Including bools, chars, and enums.
+		Floating,
+		Pointer,
+		CharString,							// Char pointers and arrays. Also usable as pointers.
+		String,								// A tString or something derived from one.
+		Other								// Trivially copyable types like tVec3, tMat4, and tuint256.
+	};
+
+	struct ArgDesc
+	{
+		ArgKind Kind					= ArgKind::Unsupported;
+		int Size						= 0;
+	};
+
+	template<typename T> constexpr ArgDesc DescribeArg()
+	{
+		using D = std::decay_t<T>;
+		if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+			return { ArgKind::Integral, (sizeof(T) < 4) ? 4 : int(sizeof(T)) };
+		else if constexpr (std::is_floating_point_v<T>)
+			return { ArgKind::Floating, (sizeof(T) < 8) ? 8 : int(sizeof(T)) };
+		else if constexpr
+		(
+			std::is_same_v<D, char*> || std::is_same_v<D, const char*> ||
+			std::is_same_v<D, char8_t*> || std::is_same_v<D, const char8_t*>
+		)
+			return { ArgKind::CharString, int(sizeof(void*)) };
+		else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+			return { ArgKind::Pointer, int(sizeof(void*)) };
+		else if constexpr (std::is_base_of_v<tString, T>)
+			return { ArgKind::String, int(sizeof(void*)) };
+		else if constexpr (std::is_trivially_copyable_v<T>)
+			return { ArgKind::Other, int(sizeof(T)) };
+		else
+			return { ArgKind::Unsupported, 0 };
+	}
+
+	constexpr bool IsMatch(const tSystem::tPrintSpec& spec, ArgDesc arg)
+	{
+		switch (spec.Type)
+		{
+			case 'b': case 'o': case 'd': case 'i': case 'u': case 'x': case 'X':
+				if (spec.TypeSizeBytes <= 8)
+					return (arg.Kind == ArgKind::Integral) && (arg.Size == spec.TypeSizeBytes);
+				return (arg.Kind == ArgKind::Other) && (arg.Size == spec.TypeSizeBytes);
+
+			case 'p':
+				return
+					((arg.Kind == ArgKind::Pointer) || (arg.Kind == ArgKind::CharString) || (arg.Kind == ArgKind::Integral)) &&
+					(arg.Size == spec.TypeSizeBytes);
+
+			case 'c': case 'B':
+				return (arg.Kind == ArgKind::Integral) && (arg.Size == 4);
+
+			case 'e': case 'f': case 'g':
+				return (arg.Kind == ArgKind::Floating) && (arg.Size == 8);
+
+			case 'v': case 'q': case 'm':
+				return (arg.Kind == ArgKind::Other) && (arg.Size == spec.TypeSizeBytes);
+
+			case 's':
+				return (arg.Kind == ArgKind::CharString) || (arg.Kind == ArgKind::String);
+		}
+		return false;
+	}
+
+	template<tSystem::tFormatString F, typename... Args> constexpr bool IsMatch()
+	{
+		const auto& program = Program<F>;
+		if (!program.Valid || (program.NumArgs != int(sizeof...(Args))))
+			return false;
+
+		const ArgDesc args[] = { DescribeArg<Args>()..., ArgDesc() };
+		const ArgDesc widthArg = { ArgKind::Integral, 4 };
+		for (int i = 0; i < program.NumItems; i++)
+		{
+			const FormatItem& item = program.Items[i];
+			if ((item.WidthArg >= 0) && ((args[item.WidthArg].Kind != widthArg.Kind) || (args[item.WidthArg].Size != widthArg.Size)))
+				return false;
+			if ((item.PrecisionArg >= 0) && ((args[item.PrecisionArg].Kind != widthArg.Kind) || (args[item.PrecisionArg].Size != widthArg.Size)))
+				return false;
+			if ((item.ValueArg >= 0) && !IsMatch(item.Spec, args[item.ValueArg]))
+				return false;
+		}
+		return true;
+	}
+
+	// Writes up to Size characters into Dest and counts everything, including what didn't fit.
+	struct Writer
+	{
+		void Append(const char* text, int numChars)
+		{
+			if (Count < Size)
+				tStd::tMemcpy(Dest+Count, text, (numChars < Size-Count) ? numChars : Size-Count);
+			Count += numChars;
+		}
+
+		void Append(const tSystem::tPrintSpec& spec, const void* data)
+		{
+			int room = Size - Count;
+			Count += tSystem::tPrintValue((room > 0) ? Dest+Count : nullptr, (room > 0) ? room : 0, spec, data);
+		}
+
+		char* Dest;
+		int Size;
+		int Count;
+	};
+
+	// Converts the argument the same way passing it through the vararg list would.
+	template<typename T> inline void AppendValue(Writer& writer, const tSystem::tPrintSpec& spec, const T& value)
+	{
+		constexpr ArgKind kind = DescribeArg<T>().Kind;
+		if constexpr (kind == ArgKind::Integral)
+		{
+			if (spec.TypeSizeBytes == 8)
+			{
+				uint64 val = uint64(value);
+				writer.Append(spec, &val);
+			}
+			else
+			{
+				uint32 val = uint32(value);
+				writer.Append(spec, &val);
+			}
+		}
+		else if constexpr (kind == ArgKind::Floating)
+		{
+			double val = double(value);
+			writer.Append(spec, &val);
+		}
+		else if constexpr ((kind == ArgKind::Pointer) || (kind == ArgKind::CharString))
+		{
+			const void* ptr = value;
+			if (spec.Type == 's')
+			{
+				const char* str = (const char*)ptr;
+				writer.Append(spec, &str);
+			}
+			else if (spec.TypeSizeBytes == 8)
+			{
+				uint64 val = uint64(std::uintptr_t(ptr));
+				writer.Append(spec, &val);
+			}
+			else
+			{
+				uint32 val = uint32(std::uintptr_t(ptr));
+				writer.Append(spec, &val);
+			}
+		}
+		else if constexpr (kind == ArgKind::String)
+		{
+			const char* str = value.Chr();
+			writer.Append(spec, &str);
+		}
+		else
+		{
+			writer.Append(spec, &value);
+		}
+	}
+
+	template<tSystem::tFormatString F, int I, typename... Args> inline void AppendItem(Writer& writer, const Args&... args)
+	{
+		constexpr FormatItem item = Program<F>.Items[I];
+		if constexpr (item.LiteralLength > 0)
+			writer.Append(F.Text + item.LiteralStart, item.LiteralLength);
+
+		if constexpr (item.ValueArg >= 0)
+		{
+			tSystem::tPrintSpec spec = item.Spec;
+			if constexpr (item.WidthArg >= 0)
+				spec.Width = int(std::get<item.WidthArg>(std::forward_as_tuple(args...)));
+			if constexpr (item.PrecisionArg >= 0)
+				spec.Precision = int(std::get<item.PrecisionArg>(std::forward_as_tuple(args...)));
+			AppendValue(writer, spec, std::get<item.ValueArg>(std::forward_as_tuple(args...)));
+		}
+	}
+
+	// Writes at most destSize characters and no terminator. Returns the number of characters needed.
+	template<tSystem::tFormatString F, typename... Args> inline int Format(char* dest, int destSize, const Args&... args)
+	{
+		static_assert(Program<F>.Valid, "Invalid format string.");
+		static_assert(Program<F>.NumArgs == int(sizeof...(Args)), "Wrong number of arguments for the format string.");
+		static_assert(IsMatch<F, Args...>(), "An argument does not match its format specification.");
+
+		Writer writer = { dest, destSize, 0 };
+		if constexpr (IsMatch<F, Args...>())
+		{
+			[&]<int... I>(std::integer_sequence<int, I...>)
+			{
+				(AppendItem<F, I>(writer, args...), ...);
+			}
+			(std::make_integer_sequence<int, Program<F>.NumItems>());
+		}
+		return writer.Count;
+	}
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline int tsPrintf(char* dest, int destSize, const Args&... args)
+{
+	if (!dest || (destSize <= 0))
+		return 0;
+
+	int count = tPrintInternal::Format<F>(dest, destSize-1, args...);
+	int len = (count < destSize-1) ? count : destSize-1;
+	dest[len] = '\0';
+	return len;
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline tString& tsPrintf(tString& dest, const Args&... args)
+{
+	// Short results are formatted once on the stack. Longer ones are formatted again straight into the string.
+	char local[256];
+	int count = tPrintInternal::Format<F>(local, int(sizeof(local)), args...);
+	dest.SetLength(count, false);
+	if (count <= int(sizeof(local)))
+		tStd::tMemcpy(dest.Txt(), local, count);
+	else
+		tPrintInternal::Format<F>(dest.Txt(), count, args...);
+	return dest;
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline tString& tsaPrintf(tString& dest, const Args&... args)
+{
+	char local[256];
+	int currLen = dest.Length();
+	int count = tPrintInternal::Format<F>(local, int(sizeof(local)), args...);
+	dest.SetLength(currLen + count, true);
+	if (count <= int(sizeof(local)))
+		tStd::tMemcpy(dest.Txt() + currLen, local, count);
+	else
+		tPrintInternal::Format<F>(dest.Txt() + currLen, count, args...);
+	return dest;
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline tString tsrPrintf(const Args&... args)
+{
+	tString dest;
+	tsPrintf<F>(dest, args...);
+	return dest;
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline int tcPrintf(const Args&... args)
+{
+	return tPrintInternal::Format<F>(nullptr, 0, args...);
+}
+
+
+template<tSystem::tFormatString F, typename... Args> inline int tPrintf(const Args&... args)
+{
+	return tPrintf<F>(tSystem::tChannel_Default, args...);
+}
+
+
+template<tSystem::tFormatString F, typename... Args> requires (tPrintInternal::GetNumArgs<F>() == sizeof...(Args))
+inline int tPrintf(tSystem::tChannel channels, const Args&... args)
+{
+	if (!(channels & tSystem::tGetChannels()))
+		return 0;
+
+	char local[512];
+	int count = tPrintInternal::Format<F>(local, int(sizeof(local))-1, args...);
+	if (count < int(sizeof(local)))
+	{
+		local[count] = '\0';
+		tSystem::tPrint(local, channels);
+	}
+	else
+	{
+		tString text;
+		tsPrintf<F>(text, args...);
+		tSystem::tPrint(text.Chr(), channels);
+	}
+	return count;
+}
@@ -84,12 +84,19 @@ namespace tSystem
 //		\P		Non-punctuation.
 //		\b		Word boundary.
 //		\B		Non-word boundary.
+//
+// Compile also builds an automaton for the pattern when it can. It is a Thompson NFA whose DFA states are only made
+// when text needs them, so IsMatch and the search for where a match starts take time linear in the text length
+// whatever the pattern. It handles everything above except word boundaries, which use the original backtracking
+// matcher. Because the automaton tries every way the pattern could match, IsMatch may find a match the backtracking
+// matcher misses (for example a*a on aaa). Searches also skip ahead to the pattern's leading literal characters (if
+// there are any) with memchr. A tRegex is not safe to use from more than one thread at a time.
 class tRegex
 {
 public:
-	tRegex()																											: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); }
-	tRegex(const tString& pattern)																						: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); Compile(pattern); }
-	tRegex(const char* pattern)																							: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); Compile(pattern); }
+	tRegex()																											: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); }
+	tRegex(const tString& pattern)																						: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); Compile(pattern); }
+	tRegex(const char* pattern)																							: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); Compile(pattern); }
 	~tRegex()																											{ Clear(); }
 
 	// Compiles a regular expression (described above). Any previously compiled expression is lost.
@@ -98,6 +105,7 @@ public:
 	void Compile(const char* pattern);
 	bool IsMatch(const char* text) const;					// Returns true is a perfect match is attained.
 	bool IsValid() const																								{ return Pattern ? true : false; }
+	bool HasAutomaton() const																							{ return Auto ? true : false; }
 	void Clear();
 
 	// Returns the number of sub-expressions for the compiled pattern. If all expressions match a test pattern, this is
@@ -119,6 +127,10 @@ public:
 	// These populate the supplied list of matches. If no matches are appended to the list that means none were found.
 	// The end pointer should be one past the last valid character to check.
 	void Search(const char* begin, const char* end, tList<Match>&) const;
+
+	// Same as above but fills in the caller's array so nothing is allocated. Up to maxMatches matches are written, in
+	// the same order the list gets them. Returns the number written, which is 0 if the pattern wasn't found.
+	int Search(const char* begin, const char* end, Match* matches, int maxMatches) const;
 	void Search(const char* text, tList<Match>& matches) const															{ Search(text, text + tStd::tStrlen(text), matches); }
 	void Search(const tString& text, tList<Match>& matches) const														{ Search(text.Chr(), matches); }
 
@@ -153,6 +165,10 @@ private:
 	bool MatchClass(const Node*, char c) const;
 	const char* MatchNode(const Node*, const char* str, const Node* next) const;
 
+	// Returns the first position at or after pos (and before end) where the literal prefix appears. Returns nullptr if
+	// there isn't one. With no prefix every position qualifies.
+	const char* FindPrefix(const char* pos, const char* end) const;
+
 	char* Pattern;											// Owned by this object.
 	mutable const char* EOL;								// End of line.
 	mutable const char* BOL;								// Beginning of line.
@@ -164,6 +180,13 @@ private:
 	int NumSubExpr;
 	MatchInternal* Matches;
 	mutable int CurrSubExpr;
+
+	// The characters every match must start with. Found from the parsed nodes.
+	tString Prefix;
+
+	// The linear-time matcher. See tRegex.cpp. nullptr if the pattern has something it doesn't support.
+	struct Automaton;
+	Automaton* Auto;
 };
 
 
@@ -5,7 +5,9 @@
 // find this notation much more elegant than stuff like the lame XML notation. This site agrees:
 // http://c2.com/cgi/wiki?XmlIsaPoorCopyOfEssExpressions
 // The tExpression reader class in this file parses 'in-place'. That is, the entire file is just read into memory once
-// and accessed as const data. This reduces memory fragmentation but may have made implementation more complex. 
+// and accessed as const data. This reduces memory fragmentation but may have made implementation more complex. For
+// big scripts the reader can optionally build a node table in one pass when loading. Navigation then no longer rescans
+// the text.
 //
 // The second format is a functional format. ex. a(b,c) See tFunExtression.
 //
@@ -36,6 +38,28 @@
 #include "System/tFile.h"
 
 
+// One entry of the node table an indexed tExprReader builds. The children of a list are stored next to each other so
+// the nth item of a list is found directly. Offsets are from the start of the reader's buffer.
+struct tExprNode
+{
+	enum class tValueType : uint8
+	{
+		None, Bool, Uint, Uint64, Int, Float, Double
+	};
+
+	int Offset;							// Of the first character of the expression.
+	int AtomLength;						// Number of characters GetAtomString returns. 0 for lists.
+	int LineNumber;
+	int FirstChild;						// -1 for atoms and empty lists.
+	int NumChildren;
+	int NextSibling;					// -1 for the last item of a list.
+
+	// The last atom value conversion is cached. Bits holds the value and ValueType says which conversion it came from.
+	uint64 ValueBits;
+	tValueType ValueType;
+};
+
+
 // An s-expression has the following syntax: [expr expr ...] OR atom. That is, an s-expression is either a list of
 // s-expressions enclosed in square brackets or it is an 'atom' (base value type, not divisible, as in an atom).
 // By convention s-expressions often take the more restricted form [command argument1 argument2 argument3] where the
@@ -49,23 +73,23 @@ class tExpression
 public:
 	// Creates an invalid expression. Useful for default arg vals in functions to possibly do something different if
 	// a valid expression isn't passed in.
-	tExpression()																										: ExprData(nullptr), LineNumber(0) { }
+	tExpression()																										: ExprData(nullptr), LineNumber(0), Nodes(nullptr), NodeIndex(-1) { }
 
 	// The copy constructor is fast. There's not much point passing tExpressions around by reference as they're only
 	// 8 to 12 bytes long (a pointer and an int). In fact, the default C++ behaviour of doing a memcopy works just fine,
 	// so there's not much point to this copy-cons other than to make it clearly understood that passing these things
 	// around by value is perfectly acceptable.
-	tExpression(const tExpression& src)																					: ExprData(src.ExprData), LineNumber(src.LineNumber) { }
+	tExpression(const tExpression& src)																					: ExprData(src.ExprData), LineNumber(src.LineNumber), Nodes(src.Nodes), NodeIndex(src.NodeIndex) { }
 
 	// Creates an expression from a string. If the first non-white character is [, it's a list expression, otherwise
 	// it's an atom.
-	tExpression(const char8_t* v)																						: ExprData(v), LineNumber(0) { }
-	tExpression(const char* v)																							: ExprData((const char8_t*)v), LineNumber(0) { }
+	tExpression(const char8_t* v)																						: ExprData(v), LineNumber(0), Nodes(nullptr), NodeIndex(-1) { }
+	tExpression(const char* v)																							: ExprData((const char8_t*)v), LineNumber(0), Nodes(nullptr), NodeIndex(-1) { }
 
 	// If you want the expression to keep track of what line number it's on then you should supply the current line
 	// number. Thrown error messages will include the line number if it's set.
-	tExpression(const char8_t* v, int lineNumber)																		: ExprData(v), LineNumber(lineNumber) { }
-	tExpression(const char* v, int lineNumber)																			: ExprData((const char8_t*)v), LineNumber(lineNumber) { }
+	tExpression(const char8_t* v, int lineNumber)																		: ExprData(v), LineNumber(lineNumber), Nodes(nullptr), NodeIndex(-1) { }
+	tExpression(const char* v, int lineNumber)																			: ExprData((const char8_t*)v), LineNumber(lineNumber), Nodes(nullptr), NodeIndex(-1) { }
 	virtual ~tExpression()																								{ }
 
 	// Like in scheme. Contents of the Address Register from the old IBM days.
@@ -79,7 +103,8 @@ public:
 	tExpression CarCdrN(int n) const;
 
 	// If there aren't enough d's in the above commands or there are a variable number of items, use this until you get
-	// an invalid expression.
+	// an invalid expression. If the expression came from an indexed tExprReader, Car, CarCdrN, and Next are constant
+	// time. Otherwise they scan the text.
 	virtual tExpression Next() const;
 
 	bool IsValid() const																								{ return ExprData ? true : false; }
@@ -94,13 +119,14 @@ public:
 	// base-16 number that is the binary representation of a float (IEEE 754). It would be twice as long for a double.
 	// If there is a # and hex value, it is used instead of the base 10 text. This essentially removes 'wobble' like
 	// you see in many engines from saving and reloading floats, and keeps it human-readable/editable. Note, I have
-	// very little confidence FB0933CE actually represents 67.3677 -- I just chose a random 32 bit hex number.
-	bool GetAtomBool() const																							{ return GetAtomString().GetAsBool(); }
-	uint GetAtomUint() const																							{ return GetAtomString().GetAsUInt(); }
-	uint64 GetAtomUint64() const																						{ return GetAtomString().GetAsUInt64(); }
-	int GetAtomInt() const																								{ return GetAtomString().GetAsInt(); }
-	float GetAtomFloat() const																							{ return GetAtomString().GetAsFloat(); }
-	double GetAtomDouble() const																						{ return GetAtomString().GetAsDouble(); }
+	// very little confidence FB0933CE actually represents 67.3677 -- I just chose a random 32 bit hex number. For an
+	// indexed reader the converted value is cached, so asking for it again does not reparse the atom.
+	bool GetAtomBool() const;
+	uint GetAtomUint() const;
+	uint64 GetAtomUint64() const;
+	int GetAtomInt() const;
+	float GetAtomFloat() const;
+	double GetAtomDouble() const;
 	uint32 GetAtomHash() const																							{ return tHash::tHashString(GetAtomString()); }
 	uint32 Hash() const																									{ return GetAtomHash(); }
 
@@ -141,7 +167,7 @@ public:
 	tExpression Arg5() const																							{ return Cadddddr(); }
 	tExpression Arg6() const																							{ return Caddddddr(); }
 	tExpression ArgN(int n) const																						{ return CarCdrN(n); }
-	int CountArgs() const									/* Not fast. */												{ if (!IsValid()) return 0; int c = 0; while (CarCdrN(c).IsValid()) c++; return c; }
+	int CountArgs() const;									// Not fast unless indexed.
 
 	tExpression Item0() const																							{ return Car(); }
 	tExpression Item1() const																							{ return Cadr(); }
@@ -151,7 +177,7 @@ public:
 	tExpression Item5() const																							{ return Cadddddr(); }
 	tExpression Item6() const																							{ return Caddddddr(); }
 	tExpression ItemN(int n) const																						{ return CarCdrN(n); }
-	int CountItems() const									/* Not fast. */												{ return CountArgs(); }
+	int CountItems() const									/* Not fast unless indexed. */								{ return CountArgs(); }
 
 	tExpression Cmd() const																								{ return Car(); }
 	tExpression Command() const																							{ return Car(); }
@@ -178,7 +204,19 @@ protected:
 	// When throwing an error this is how much of the file is supplied to give a context.
 	static const int ContextSize = 32;
 
+	// The node table of an indexed tExprReader, or nullptr. Owned by the reader. Not const because the nodes cache
+	// converted atom values.
+	tExprNode* Nodes;
+	int NodeIndex;
+
 private:
+	tExpression(const char8_t* v, int lineNumber, tExprNode* nodes, int nodeIndex)										: ExprData(v), LineNumber(lineNumber), Nodes(nodes), NodeIndex(nodeIndex) { }
+
+	// Returns the expression for another node in the same table.
+	tExpression GetNodeExpression(int nodeIndex) const;
+	bool GetCachedValue(uint64& bits, tExprNode::tValueType) const;
+	void SetCachedValue(uint64 bits, tExprNode::tValueType) const;
+
 	// Parses atom strings of the form (a, b, c, ...). There may or may not be spaces. Returns the part inside the
 	// brackets and removes all spaces. This function is a helper for getting atoms that are vectors, quaternions,
 	// matrices, or colours.
@@ -214,36 +252,55 @@ public:
 	// Constructs an initially invalid tExprReader.
 	tExprReader()																										: tExpression(), ExprBuffer(nullptr) { }
 
-	// If isFile is true then the file 'name' is loaded, otherwise treats 'name' as the actual script string.
-	tExprReader(const tString& name, bool isFile = true)																: tExpression(), ExprBuffer(nullptr) { Load(name, isFile); }
+	// If isFile is true then the file 'name' is loaded, otherwise treats 'name' as the actual script string. See Load
+	// for what buildIndex does.
+	tExprReader(const tString& name, bool isFile = true, bool buildIndex = false)										: tExpression(), ExprBuffer(nullptr) { Load(name, isFile, buildIndex); }
 
 	// Useful for command line utilities. Makes a script from standard command line argc and argv parameters. Honestly,
 	// I'm not sure how useful this is now that we have tOption for parsing command lines in a nice way that is a bit
 	// more standard.
 	tExprReader(int argc, char** argv);
-	~tExprReader()																										{ delete[] ExprBuffer; }
+	~tExprReader()																										{ Clear(); }
 
 	// If isFile is true then the file 'name' is loaded, otherwise treats 'name' as the actual script string. The
-	// object is cleared before the new information is loaded. Any previous information is lost.
-	void Load(const tString& name, bool isFile = true);
+	// object is cleared before the new information is loaded. Any previous information is lost. If buildIndex is true
+	// the whole script is parsed once into a node table (about 40 bytes per expression). Expressions obtained from an
+	// indexed reader navigate by following the table and cache converted atom values, so don't read them from more
+	// than one thread at a time. Indexing also gets brackets inside strings and comments right. If the script is
+	// malformed (missing end quote, unclosed list, etc) no table is built and errors are reported as usual when the
+	// bad expression is reached.
+	void Load(const tString& name, bool isFile = true, bool buildIndex = false);
 
 	// The object will be invalid after this call.
-	void Clear()																										{ delete[] ExprBuffer; ExprBuffer = 0; }
+	void Clear()																										{ delete[] ExprBuffer; ExprBuffer = nullptr; delete[] Nodes; Nodes = nullptr; NodeIndex = -1; NumNodes = 0; }
+	bool IsIndexed() const																								{ return Nodes ? true : false; }
+	int GetNumNodes() const																								{ return NumNodes; }
 	bool IsValid() const																								{ return ExprBuffer ? true : false; }
 
 private:
+	// Fills in Nodes and NumNodes from ExprBuffer. Returns false and leaves Nodes null if the script is malformed.
+	bool BuildIndex();
+
 	// ExprBuffer is officially a UTF-8 string. i.e. We support unicode codepoints in script files.
 	char8_t* ExprBuffer;
+	int NumNodes = 0;
 };
 
 
-// Use this to create a script file.
+// Use this to create a script file. Output is collected in a buffer and written to the file in large blocks.
 class tExprWriter
 {
 public:
-	// Creates the file if it doesn't exist, overwrites it if it does.
-	tExprWriter(const tString& filename);
-	~tExprWriter()																										{ tSystem::tCloseFile(ExprFile); }
+	static const int DefaultBufferSize = 64*1024;
+
+	// Creates the file if it doesn't exist, overwrites it if it does. The buffer is written to the file when it fills
+	// up, when Flush is called, and when the writer is destroyed. Write errors are thrown as tScriptErrors when the
+	// buffer is written, so they may show up a little after the call that caused them.
+	tExprWriter(const tString& filename, int bufferSize = DefaultBufferSize);
+	~tExprWriter();
+
+	// Writes any buffered output to the file. Throws a tScriptError if the write fails.
+	void Flush();
 
 	// If you call this with a value > 0 the writer starts using spaces instead of tabs. Zero means use tabs (default).
 	void SetTabWidth(int tabWidth = 0)																					{ TabWidth = tabWidth; }
@@ -270,6 +327,17 @@ public:
 	void WriteAtom(const tMath::tMatrix4&, bool incBitRep = true);
 	void WriteAtom(const tColour4b&);
 
+	// Bulk writers for numeric arrays. Each value (or vector tuple) is a separate atom, as if WriteAtom were called in a
+	// loop, but no tStrings are made along the way. Floats and doubles are written in the shortest form that reads back
+	// to exactly the same value (0.1 rather than 0.10000000), so a bit representation is never needed. Special values
+	// like NAN and Infinity are written as 0.0.
+	void WriteAtoms(const int*, int count);
+	void WriteAtoms(const float*, int count);
+	void WriteAtoms(const double*, int count);
+	void WriteAtoms(const tMath::tVector2*, int count);
+	void WriteAtoms(const tMath::tVector3*, int count);
+	void WriteAtoms(const tMath::tVector4*, int count);
+
 	// These functions write a raw string. They do not check for spaces being used and will not add quotes if there is.
 	// This can be useful for qriting tuples like (a, b) that are still atoms even though they may contain a space after
 	// the commas. These functions do still write the trailing space.
@@ -353,16 +421,28 @@ public:
 	template<typename T> void Coms(const tString& s, const T& a, const T& b, const T& c, const T& d)					{ Begin(); Atom(s); Atom(a); Atom(b); Atom(c); Atom(d); End(); }
 
 private:
-	int WriteIndents()
+	void WriteIndents()
 	{
 		int numChars = TabWidth ? CurrIndent*TabWidth : CurrIndent;
 		char writeChar = TabWidth ? ' ' : '\t';
-		for (int c = 0; c < numChars; c++) tSystem::tWriteFile(ExprFile, &writeChar, 1);
-		return numChars;
+		for (int c = 0; c < numChars; c++) Write(writeChar);
 	}
 
+	// All output goes through these.
+	void Write(const char* text, int numChars);
+	void Write(char c)																									{ if (BufferUsed == BufferSize) Flush(); Buffer[BufferUsed++] = c; }
+
+	// Writes the shortest text that reads back as the same value. Returns the number of chars written to dest, which
+	// must have room for 32.
+	static int ShortestToString(char* dest, float);
+	static int ShortestToString(char* dest, double);
+	template<typename T> void WriteShortest(const T* values, int count, int tupleSize);
+
 	int CurrIndent;			// Number of tabs. If using spaces it's the number of groups of TabWidth spaces.
 	int TabWidth;
+	char* Buffer;
+	int BufferSize;
+	int BufferUsed;
 
 protected:
 	tFileHandle ExprFile;
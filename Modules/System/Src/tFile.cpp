@@ -33,9 +33,20 @@
 #include <pwd.h>
 #include <fstream>
 #include <dirent.h>			// For fast (C-style) directory entry queries.
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
 #endif
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "System/tTime.h"
+#include "System/tMachine.h"
+#include "System/tHashCache.h"
 #include "System/tFile.h"
 
 
@@ -78,6 +89,12 @@ namespace tSystem
 
 	bool tFindFilesRec_Stndrd(tList<tStringItem>* files, tList<tFileInfo>* infos, const tString& dir, const tExtensions*, bool hidden);
 	bool tFindFilesRec_Native(tList<tStringItem>* files, tList<tFileInfo>* infos, const tString& dir, const tExtensions*, bool hidden);
+
+	// The parallel walker used by the tFind*RecParallel functions. The emit function receives the index of the worker
+	// calling it so callers can keep per-worker results without locking.
+	typedef std::function<bool(int worker, const char* path, int length, bool isDir)> tWalkEmit;
+	bool tWalkParallel(const tWalkEmit&, int& numWorkers, const tString& dir, bool emitFiles, bool emitDirs, const tExtensions*, bool hidden, int numThreads);
+	int tGetNumWalkWorkers(int numThreads);
 }
 
 
@@ -169,6 +186,45 @@ int tSystem::tFileSeek(tFileHandle handle, int offsetBytes, tSeekOrigin seekOrig
 }
 
 
+int64 tSystem::tGetFileSize64(tFileHandle handle)
+{
+	if (!handle)
+		return 0;
+
+	tFileSeek64(handle, 0, tSeekOrigin::End);
+	int64 fileSize = tFileTell64(handle);
+
+	tFileSeek64(handle, 0, tSeekOrigin::Beginning);			// Go back to beginning.
+	return fileSize;
+}
+
+
+int tSystem::tFileSeek64(tFileHandle handle, int64 offsetBytes, tSeekOrigin seekOrigin)
+{
+	int origin = SEEK_SET;
+	switch (seekOrigin)
+	{
+		case tSeekOrigin::Beginning:
+			origin = SEEK_SET;
+			break;
+
+		case tSeekOrigin::Current:
+			origin = SEEK_CUR;
+			break;
+
+		case tSeekOrigin::End:
+			origin = SEEK_END;
+			break;
+	}
+
+	#ifdef PLATFORM_WINDOWS
+	return _fseeki64(handle, offsetBytes, origin);
+	#else
+	return fseeko(handle, off_t(offsetBytes), origin);
+	#endif
+}
+
+
 tString tSystem::tGetFileFullName(const tString& file)
 {
 	tString filename(file);
@@ -557,6 +613,40 @@ int tSystem::tGetFileSize(const tString& file)
 }
 
 
+int64 tSystem::tGetFileSize64(const tString& file)
+{
+	if (file.IsEmpty())
+		return 0;
+
+	#ifdef PLATFORM_WINDOWS
+	tString filename(file);
+	tPathWin(filename);
+	uint prevErrorMode = SetErrorMode(SEM_FAILCRITICALERRORS | SEM_NOOPENFILEERRORBOX);
+
+	Win32FindData fd;
+	#ifdef TACENT_UTF16_API_CALLS
+	tStringUTF16 fileUTF16(filename);
+	WinHandle h = FindFirstFile(fileUTF16.GetLPWSTR(), &fd);
+	#else
+	WinHandle h = FindFirstFile(filename.Chr(), &fd);
+	#endif
+	SetErrorMode(prevErrorMode);
+	if (h == INVALID_HANDLE_VALUE)
+		return 0;
+
+	FindClose(h);
+	return (int64(fd.nFileSizeHigh) << 32) | int64(fd.nFileSizeLow);
+
+	#else
+	struct stat statBuf;
+	if ((stat(file.Chr(), &statBuf) != 0) || !S_ISREG(statBuf.st_mode))
+		return 0;
+
+	return int64(statBuf.st_size);
+	#endif
+}
+
+
 bool tSystem::tIsReadOnly(const tString& path)
 {
 	tString pathname(path);
@@ -849,8 +939,16 @@ bool tSystem::tIsFileNewer(const tString& filea, const tString& fileb)
 	if (CompareFileTime(&timeA, &timeB) > 0)
 		return true;
 
-	#elif defined(PLAYFORM_LINUX)
-	tToDo("Implement tISFileNewer.");
+	#elif defined(PLATFORM_LINUX)
+	struct stat statA, statB;
+	if (stat(filea.Chr(), &statA) != 0)
+		throw tFileError("Cannot stat file: " + filea);
+	if (stat(fileb.Chr(), &statB) != 0)
+		throw tFileError("Cannot stat file: " + fileb);
+
+	if (statA.st_mtim.tv_sec != statB.st_mtim.tv_sec)
+		return statA.st_mtim.tv_sec > statB.st_mtim.tv_sec;
+	return statA.st_mtim.tv_nsec > statB.st_mtim.tv_nsec;
 
 	#endif
 	return false;
@@ -859,6 +957,9 @@ bool tSystem::tIsFileNewer(const tString& filea, const tString& fileb)
 
 bool tSystem::tFilesIdentical(const tString& fileA, const tString& fileB)
 {
+	if (tHashCache* cache = tGetHashCache())
+		return cache->FilesIdentical(fileA, fileB);
+
 	auto localCloseFiles = [](tFileHandle a, tFileHandle b)
 	{
 		tCloseFile(a);
@@ -873,36 +974,48 @@ bool tSystem::tFilesIdentical(const tString& fileA, const tString& fileB)
 		return false;
 	}
 
-	int faSize = tGetFileSize(fa);
-	int fbSize = tGetFileSize(fb);
+	int64 faSize = tGetFileSize64(fa);
+	int64 fbSize = tGetFileSize64(fb);
 	if (faSize != fbSize)
 	{
 		localCloseFiles(fa, fb);
 		return false;
 	}
 
-	uint8* bufA = new uint8[faSize];
-	uint8* bufB = new uint8[fbSize];
-
-	int numReadA = tReadFile(fa, bufA, faSize);
-	int numReadB = tReadFile(fb, bufB, fbSize);
-	tAssert((faSize + fbSize) == (numReadA + numReadB));
-
-	for (int i = 0; i < faSize; i++)
+	#if defined(PLATFORM_LINUX)
+	// Two names for the same file (hard links, or the same path spelled differently) are identical without reading.
+	struct stat statA, statB;
+	if ((fstat(fileno(fa), &statA) == 0) && (fstat(fileno(fb), &statB) == 0))
 	{
-		if (bufA[i] != bufB[i])
+		if ((statA.st_dev == statB.st_dev) && (statA.st_ino == statB.st_ino))
 		{
 			localCloseFiles(fa, fb);
-			delete[] bufA;
-			delete[] bufB;
-			return false;
+			return true;
 		}
 	}
+	#endif
+
+	// The files are compared a chunk at a time. memcmp is vectorized by the C runtime and we stop at the first
+	// chunk that differs.
+	const int64 maxChunkSize = 1 << 20;
+	int chunkSize = int(tMath::tMin(tMath::tMax(faSize, int64(1)), maxChunkSize));
+	uint8* bufA = new uint8[2*chunkSize];
+	uint8* bufB = bufA + chunkSize;
+
+	bool identical = true;
+	for (int64 remaining = faSize; (remaining > 0) && identical; )
+	{
+		int numBytes = int(tMath::tMin(remaining, int64(chunkSize)));
+		if ((tReadFile(fa, bufA, numBytes) != numBytes) || (tReadFile(fb, bufB, numBytes) != numBytes))
+			identical = false;
+		else
+			identical = (tStd::tMemcmp(bufA, bufB, numBytes) == 0);
+		remaining -= numBytes;
+	}
 
 	localCloseFiles(fa, fb);
 	delete[] bufA;
-	delete[] bufB;
-	return true;
+	return identical;
 }
 
 
@@ -930,14 +1043,93 @@ bool tSystem::tCopyFile(const tString& destFile, const tString& srcFile, bool ov
 	}
 	return success ? true : false;
 
+	#elif defined(PLATFORM_LINUX)
+	int src = open(srcFile.Chr(), O_RDONLY | O_CLOEXEC);
+	if (src < 0)
+		return false;
+
+	struct stat srcStat;
+	if ((fstat(src, &srcStat) != 0) || !S_ISREG(srcStat.st_mode))
+	{
+		close(src);
+		return false;
+	}
+
+	// Copying a file onto itself, by any path, would truncate it before anything is read. Refuse like CopyFile does.
+	struct stat destStat;
+	if ((stat(destFile.Chr(), &destStat) == 0) && (destStat.st_dev == srcStat.st_dev) && (destStat.st_ino == srcStat.st_ino))
+	{
+		close(src);
+		return false;
+	}
+
+	// New files get the permissions of the source. A read-only destination can only be written if allowed.
+	int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+	int dest = open(destFile.Chr(), flags, srcStat.st_mode & 0777);
+	if ((dest < 0) && (errno == EACCES) && overWriteReadOnly && tFileExists(destFile))
+	{
+		tSetReadOnly(destFile, false);
+		dest = open(destFile.Chr(), flags, srcStat.st_mode & 0777);
+	}
+	if (dest < 0)
+	{
+		close(src);
+		return false;
+	}
+
+	// A reflink shares the extents (btrfs, xfs, etc) so it is the fastest. Otherwise copy_file_range lets the kernel
+	// (or a network filesystem server) do the copy. sendfile works across more filesystem types for older kernels.
+	// A plain read/write loop is the last resort.
+	bool success = (ioctl(dest, FICLONE, src) == 0);
+	int64 remaining = int64(srcStat.st_size);
+	if (!success)
+	{
+		while (remaining > 0)
+		{
+			ssize_t numCopied = copy_file_range(src, nullptr, dest, nullptr, size_t(remaining), 0);
+			if (numCopied <= 0)
+				break;
+			remaining -= numCopied;
+		}
+
+		while (remaining > 0)
+		{
+			ssize_t numCopied = sendfile(dest, src, nullptr, size_t(tMath::tMin(remaining, int64(0x40000000))));
+			if (numCopied <= 0)
+				break;
+			remaining -= numCopied;
+		}
+
+		if (remaining > 0)
+		{
+			const int bufSize = 1 << 20;
+			uint8* buf = new uint8[bufSize];
+			while (remaining > 0)
+			{
+				ssize_t numRead = read(src, buf, size_t(tMath::tMin(remaining, int64(bufSize))));
+				if ((numRead <= 0) || (write(dest, buf, size_t(numRead)) != numRead))
+					break;
+				remaining -= numRead;
+			}
+			delete[] buf;
+		}
+		success = (remaining == 0);
+	}
+
+	close(src);
+	if (close(dest) != 0)
+		success = false;
+	return success;
+
 	#else
 	std::filesystem::path pathFrom(srcFile.Chr());
 	std::filesystem::path pathTo(destFile.Chr());
-	bool success = std::filesystem::copy_file(pathFrom, pathTo);
+	std::error_code ec;
+	bool success = std::filesystem::copy_file(pathFrom, pathTo, std::filesystem::copy_options::overwrite_existing, ec);
 	if (!success && overWriteReadOnly)
 	{
 		tSetReadOnly(destFile, false);
-		success = std::filesystem::copy_file(pathFrom, pathTo);
+		success = std::filesystem::copy_file(pathFrom, pathTo, std::filesystem::copy_options::overwrite_existing, ec);
 	}
 		
 	return success;
@@ -3108,6 +3300,299 @@ bool tSystem::tFindFilesRec(tList<tFileInfo>& files, const tString& dir, const t
 }
 
 
+void tSystem::tPathArena::Clear()
+{
+	delete[] Buffer;
+	delete[] Offsets;
+	Buffer = nullptr;
+	BufferSize = 0;
+	BufferCapacity = 0;
+	Offsets = nullptr;
+	NumPaths = 0;
+	OffsetsCapacity = 0;
+}
+
+
+void tSystem::tPathArena::Append(const char* path, int length)
+{
+	tAssert(path && (length >= 0));
+	if (BufferSize + length + 1 > BufferCapacity)
+	{
+		int64 newCapacity = tMath::tMax(BufferCapacity*2, BufferSize + length + 1, int64(4096));
+		char* newBuffer = new char[newCapacity];
+		if (BufferSize)
+			memcpy(newBuffer, Buffer, size_t(BufferSize));
+		delete[] Buffer;
+		Buffer = newBuffer;
+		BufferCapacity = newCapacity;
+	}
+
+	if (NumPaths >= OffsetsCapacity)
+	{
+		int newCapacity = tMath::tMax(OffsetsCapacity*2, 256);
+		int64* newOffsets = new int64[newCapacity];
+		if (NumPaths)
+			memcpy(newOffsets, Offsets, size_t(NumPaths)*sizeof(int64));
+		delete[] Offsets;
+		Offsets = newOffsets;
+		OffsetsCapacity = newCapacity;
+	}
+
+	Offsets[NumPaths++] = BufferSize;
+	tStd::tMemcpy(Buffer + BufferSize, path, length);
+	Buffer[BufferSize + length] = '\0';
+	BufferSize += length + 1;
+}
+
+
+void tSystem::tPathArena::Append(const tPathArena& src)
+{
+	// Appending to ourselves would read paths out of a buffer that Append may reallocate, so go through a copy.
+	if (&src == this)
+	{
+		tPathArena copy;
+		copy.Append(src);
+		Append(copy);
+		return;
+	}
+
+	for (int p = 0; p < src.NumPaths; p++)
+		Append(src.GetPath(p), src.GetPathLength(p));
+}
+
+
+int tSystem::tGetNumWalkWorkers(int numThreads)
+{
+	return (numThreads > 0) ? numThreads : tMath::tMax(tGetNumCores(), 1);
+}
+
+
+bool tSystem::tWalkParallel
+(
+	const tWalkEmit& emit, int& numWorkers, const tString& dir,
+	bool emitFiles, bool emitDirs, const tExtensions* extensions, bool hidden, int numThreads
+)
+{
+	if (extensions && extensions->IsEmpty())
+		return false;
+
+	tString rootDir(dir);
+	if (rootDir.IsEmpty())
+		rootDir = tGetCurrentDir();
+	tPathStdDir(rootDir);
+	if (!tDirExists(rootDir))
+		return false;
+
+	// The queue holds directories waiting to be scanned. Pending counts those plus the ones being scanned. The walk is
+	// finished when pending gets to zero.
+	std::mutex mutex;
+	std::condition_variable wake;
+	tList<tStringItem> queue;
+	int pending = 1;
+	std::atomic<bool> stop(false);
+	queue.Append(new tStringItem(rootDir));
+
+	#if defined(PLATFORM_LINUX)
+	// A file matches if its extension (after the last dot) is in the list. The list is stored lower-case.
+	auto extensionMatches = [extensions](const char* name) -> bool
+	{
+		if (!extensions)
+			return true;
+		const char* dot = strrchr(name, '.');
+		const char* ext = dot ? dot+1 : "";
+		for (tStringItem* e = extensions->First(); e; e = e->Next())
+			if (tStd::tStricmp(e->Chr(), ext) == 0)
+				return true;
+		return false;
+	};
+
+	// Returns false if the walk should stop. The subdirectories are appended to subdirs.
+	auto scanDir = [&](int worker, const tString& dirPath, tList<tStringItem>& subdirs) -> bool
+	{
+		int fd = open(dirPath.Chr(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0)
+			return true;
+
+		// The path of each entry is built in place after the directory path so no allocations are needed per entry.
+		int dirLen = dirPath.Length();
+		char path[PATH_MAX + 2];
+		if (dirLen > PATH_MAX)
+		{
+			close(fd);
+			return true;
+		}
+		tStd::tMemcpy(path, dirPath.Chr(), dirLen);
+
+		// The linux_dirent64 layout is fixed by the kernel ABI. glibc does not declare it.
+		struct LinuxDirent64
+		{
+			uint64 Inode;
+			int64 Offset;
+			uint16 RecordLength;
+			uint8 Type;
+			char Name[1];
+		};
+		alignas(8) char entries[32768];
+		bool keepGoing = true;
+		while (keepGoing)
+		{
+			long numBytes = syscall(SYS_getdents64, fd, entries, sizeof(entries));
+			if (numBytes <= 0)
+				break;
+
+			for (long pos = 0; (pos < numBytes) && keepGoing; )
+			{
+				LinuxDirent64* entry = (LinuxDirent64*)(entries + pos);
+				pos += entry->RecordLength;
+				const char* name = entry->Name;
+				if ((name[0] == '.') && ((name[1] == '\0') || ((name[1] == '.') && (name[2] == '\0'))))
+					continue;
+				if (!hidden && (name[0] == '.'))
+					continue;
+
+				uint8 type = entry->Type;
+				if (type == DT_UNKNOWN)
+				{
+					struct stat statBuf;
+					if (fstatat(fd, name, &statBuf, AT_SYMLINK_NOFOLLOW) != 0)
+						continue;
+					if (S_ISDIR(statBuf.st_mode))
+						type = DT_DIR;
+					else if (S_ISREG(statBuf.st_mode))
+						type = DT_REG;
+				}
+
+				int nameLen = tStd::tStrlen(name);
+				if (dirLen + nameLen + 1 > PATH_MAX)
+					continue;
+				tStd::tMemcpy(path + dirLen, name, nameLen);
+
+				if (type == DT_DIR)
+				{
+					path[dirLen + nameLen] = '/';
+					path[dirLen + nameLen + 1] = '\0';
+					if (emitDirs && !emit(worker, path, dirLen + nameLen + 1, true))
+						keepGoing = false;
+					subdirs.Append(new tStringItem(path));
+				}
+				else if ((type == DT_REG) && emitFiles && extensionMatches(name))
+				{
+					path[dirLen + nameLen] = '\0';
+					if (!emit(worker, path, dirLen + nameLen, false))
+						keepGoing = false;
+				}
+			}
+		}
+		close(fd);
+		return keepGoing;
+	};
+
+	#else
+	auto scanDir = [&](int worker, const tString& dirPath, tList<tStringItem>& subdirs) -> bool
+	{
+		tFindDirs_Native(&subdirs, nullptr, dirPath, hidden);
+		if (emitDirs)
+			for (tStringItem* d = subdirs.First(); d; d = d->Next())
+				if (!emit(worker, d->Chr(), d->Length(), true))
+					return false;
+
+		if (emitFiles)
+		{
+			tList<tStringItem> files;
+			tFindFiles_Native(&files, nullptr, dirPath, extensions, hidden);
+			for (tStringItem* f = files.First(); f; f = f->Next())
+				if (!emit(worker, f->Chr(), f->Length(), false))
+					return false;
+		}
+		return true;
+	};
+
+	#endif
+
+	auto workerFn = [&](int worker)
+	{
+		while (true)
+		{
+			tStringItem* dirItem = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]() { return !queue.IsEmpty() || (pending == 0) || stop; });
+				if (stop || queue.IsEmpty())
+					return;
+				dirItem = queue.Remove();
+			}
+
+			tList<tStringItem> subdirs;
+			if (!scanDir(worker, *dirItem, subdirs))
+				stop = true;
+			delete dirItem;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			int numSubdirs = subdirs.GetNumItems();
+			while (tStringItem* sub = subdirs.Remove())
+				queue.Append(sub);
+			pending += numSubdirs - 1;
+			if ((pending == 0) || stop || (numSubdirs > 1))
+				wake.notify_all();
+			else if (numSubdirs == 1)
+				wake.notify_one();
+		}
+	};
+
+	numWorkers = tGetNumWalkWorkers(numThreads);
+	if (numWorkers <= 1)
+	{
+		workerFn(0);
+	}
+	else
+	{
+		std::thread* workers = new std::thread[numWorkers];
+		for (int w = 0; w < numWorkers; w++)
+			workers[w] = std::thread(workerFn, w);
+		for (int w = 0; w < numWorkers; w++)
+			workers[w].join();
+		delete[] workers;
+	}
+
+	queue.Empty();
+	return !stop;
+}
+
+
+bool tSystem::tFindRecParallel(const tFindRecCallback& callback, const tString& dir, bool includeDirs, const tExtensions* extensions, bool hidden, int numThreads)
+{
+	int numWorkers = 0;
+	auto emit = [&callback](int worker, const char* path, int length, bool isDir) -> bool { return callback(path, isDir); };
+	return tWalkParallel(emit, numWorkers, dir, true, includeDirs, extensions, hidden, numThreads);
+}
+
+
+bool tSystem::tFindFilesRecParallel(tPathArena& files, const tString& dir, const tExtensions* extensions, bool hidden, int numThreads)
+{
+	int numWorkers = tGetNumWalkWorkers(numThreads);
+	tPathArena* arenas = new tPathArena[numWorkers];
+	auto emit = [arenas](int worker, const char* path, int length, bool isDir) -> bool { arenas[worker].Append(path, length); return true; };
+	bool success = tWalkParallel(emit, numWorkers, dir, true, false, extensions, hidden, numWorkers);
+	for (int w = 0; w < numWorkers; w++)
+		files.Append(arenas[w]);
+	delete[] arenas;
+	return success;
+}
+
+
+bool tSystem::tFindDirsRecParallel(tPathArena& dirs, const tString& dir, bool hidden, int numThreads)
+{
+	int numWorkers = tGetNumWalkWorkers(numThreads);
+	tPathArena* arenas = new tPathArena[numWorkers];
+	auto emit = [arenas](int worker, const char* path, int length, bool isDir) -> bool { arenas[worker].Append(path, length); return true; };
+	bool success = tWalkParallel(emit, numWorkers, dir, false, true, nullptr, hidden, numWorkers);
+	for (int w = 0; w < numWorkers; w++)
+		dirs.Append(arenas[w]);
+	delete[] arenas;
+	return success;
+}
+
+
 bool tSystem::tCreateDir(const tString& dir)
 {
 	tString dirPath = dir;
@@ -3288,6 +3773,14 @@ uint32 tSystem::tHashFile32(const tString& filename, uint32 iv)
 
 uint64 tSystem::tHashFile64(const tString& filename, uint64 iv)
 {
+	tHashCache* cache = tGetHashCache();
+	if (cache && (iv == tHash::HashIV64))
+	{
+		uint64 hash = iv;
+		cache->GetHash(hash, filename);
+		return hash;
+	}
+
 	int dataSize = 0;
 	uint8* data = tLoadFile(filename, nullptr, &dataSize);
 	if (!data)
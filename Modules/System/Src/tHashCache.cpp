@@ -0,0 +1,481 @@
+// tHashCache.cpp
+//
+// A persistent cache mapping file metadata to content hashes. Each entry is keyed by path and remembers the file's
+// size, modification time, and inode along with the 64-bit content hash. If the metadata of a file still matches, the
+// hash is returned without reading the file. The cache lives in a single file that is memory-mapped and updated in
+// place, so only entries that changed are ever written.
+//
+// Copyright (c) 2025 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <Foundation/tPlatform.h>
+#ifdef PLATFORM_WINDOWS
+#include <Windows.h>
+#elif defined(PLATFORM_LINUX)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#include <chrono>
+#include <Foundation/tHash.h>
+#include "System/tFile.h"
+#include "System/tHashCache.h"
+
+
+namespace tSystem
+{
+	const uint32 HashCacheMagic			= 0x43485474;	// "tTHC" in little-endian.
+	const uint32 HashCacheVersion		= 1;
+	const uint32 HashCacheMinCapacity	= 1024;
+
+	// Files modified this recently (in nanoseconds) are not recorded.
+	const int64 HashCacheRacyWindow		= 2000000000ll;
+
+	tHashCache* GlobalHashCache			= nullptr;
+
+	// Reads and hashes a file without going through the installed cache.
+	bool HashFileContents(uint64& hash, const tString& file, const tFileStamp&);
+	int64 GetTimeNowNs();
+}
+
+
+bool tSystem::tGetFileStamp(tFileStamp& stamp, const tString& file)
+{
+	#if defined(PLATFORM_WINDOWS)
+	tString winFile(file);
+	tPathWin(winFile);
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	#ifdef TACENT_UTF16_API_CALLS
+	tStringUTF16 file16(winFile);
+	if (!GetFileAttributesEx(file16.GetLPWSTR(), GetFileExInfoStandard, &data))
+		return false;
+	#else
+	if (!GetFileAttributesEx(winFile.Chr(), GetFileExInfoStandard, &data))
+		return false;
+	#endif
+	if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		return false;
+
+	// File times are in 100ns intervals since January 1, 1601.
+	int64 ticks = (int64(data.ftLastWriteTime.dwHighDateTime) << 32) | int64(data.ftLastWriteTime.dwLowDateTime);
+	stamp.Size = (uint64(data.nFileSizeHigh) << 32) | uint64(data.nFileSizeLow);
+	stamp.ModTime = (ticks - 116444736000000000ll) * 100ll;
+	stamp.Inode = 0;
+	return true;
+
+	#else
+	struct stat statBuf;
+	if ((stat(file.Chr(), &statBuf) != 0) || S_ISDIR(statBuf.st_mode))
+		return false;
+
+	stamp.Size = uint64(statBuf.st_size);
+	stamp.ModTime = int64(statBuf.st_mtim.tv_sec)*1000000000ll + int64(statBuf.st_mtim.tv_nsec);
+	stamp.Inode = uint64(statBuf.st_ino);
+	return true;
+
+	#endif
+}
+
+
+int64 tSystem::GetTimeNowNs()
+{
+	auto now = std::chrono::system_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+
+bool tSystem::HashFileContents(uint64& hash, const tString& file, const tFileStamp& stamp)
+{
+	// Same result as tHashFile64 with the default iv, including for empty files.
+	if (stamp.Size == 0)
+	{
+		hash = tHash::HashIV64;
+		return true;
+	}
+
+	int dataSize = 0;
+	uint8* data = tLoadFile(file, nullptr, &dataSize);
+	if (!data)
+		return false;
+
+	hash = tHash::tHashData64(data, dataSize, tHash::HashIV64);
+	delete[] data;
+	return true;
+}
+
+
+void tSystem::tSetHashCache(tHashCache* cache)
+{
+	GlobalHashCache = cache;
+}
+
+
+tSystem::tHashCache* tSystem::tGetHashCache()
+{
+	return GlobalHashCache;
+}
+
+
+uint64 tSystem::tHashCache::ComputeKey(const tString& path)
+{
+	// The same file must always give the same key no matter what the working directory was when it was named.
+	tString key = tGetAbsolutePath(path);
+	tPathStd(key);
+	#ifdef PLATFORM_WINDOWS
+	key.ToLower();
+	#endif
+	uint64 hash = tHash::tHashString64(key);
+	return hash ? hash : 1;
+}
+
+
+uint64 tSystem::tHashCache::ComputeCheck(const EntryType& entry)
+{
+	// Everything except the check itself.
+	return tHash::tHashData64((const uint8*)&entry, int(sizeof(EntryType) - sizeof(uint64)), HashCacheMagic);
+}
+
+
+bool tSystem::tHashCache::Open(const tString& cacheFile)
+{
+	Close();
+	CacheFile = cacheFile;
+
+	#if defined(PLATFORM_LINUX)
+	FileDescriptor = open(cacheFile.Chr(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (FileDescriptor < 0)
+		return false;
+
+	struct stat statBuf;
+	if (fstat(FileDescriptor, &statBuf) != 0)
+	{
+		Unmap();
+		return false;
+	}
+
+	// A valid existing file is mapped as-is. Anything else gets reset.
+	HeaderType header;
+	bool valid =
+		(statBuf.st_size >= int64(sizeof(HeaderType))) &&
+		(pread(FileDescriptor, &header, sizeof(HeaderType), 0) == sizeof(HeaderType)) &&
+		(header.Magic == HashCacheMagic) && (header.Version == HashCacheVersion) &&
+		(header.Capacity >= HashCacheMinCapacity) && !(header.Capacity & (header.Capacity-1)) &&
+		(uint64(header.NumEntries)*4 <= uint64(header.Capacity)*3) &&
+		(statBuf.st_size == int64(sizeof(HeaderType) + header.Capacity*sizeof(EntryType)));
+
+	if (valid)
+	{
+		void* mapped = mmap(nullptr, statBuf.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0);
+		if (mapped == MAP_FAILED)
+		{
+			Unmap();
+			return false;
+		}
+		Data = (uint8*)mapped;
+		DataSize = statBuf.st_size;
+		return true;
+	}
+
+	#else
+	int fileSize = 0;
+	uint8* fileData = tLoadFile(cacheFile, nullptr, &fileSize);
+	HeaderType* header = (HeaderType*)fileData;
+	bool valid =
+		fileData && (fileSize >= int(sizeof(HeaderType))) &&
+		(header->Magic == HashCacheMagic) && (header->Version == HashCacheVersion) &&
+		(header->Capacity >= HashCacheMinCapacity) && !(header->Capacity & (header->Capacity-1)) &&
+		(uint64(header->NumEntries)*4 <= uint64(header->Capacity)*3) &&
+		(fileSize == int(sizeof(HeaderType) + header->Capacity*sizeof(EntryType)));
+
+	if (valid)
+	{
+		Data = fileData;
+		DataSize = fileSize;
+		return true;
+	}
+	delete[] fileData;
+
+	#endif
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (!Resize(HashCacheMinCapacity))
+	{
+		Unmap();
+		return false;
+	}
+	return true;
+}
+
+
+bool tSystem::tHashCache::Flush()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (!Data)
+		return false;
+
+	#if defined(PLATFORM_LINUX)
+	return msync(Data, DataSize, MS_SYNC) == 0;
+
+	#else
+	if (!Dirty)
+		return true;
+	Dirty = false;
+	return tCreateFile(CacheFile, Data, int(DataSize));
+
+	#endif
+}
+
+
+void tSystem::tHashCache::Close()
+{
+	if (Data)
+		Flush();
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	Unmap();
+	CacheFile.Clear();
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+
+void tSystem::tHashCache::Unmap()
+{
+	#if defined(PLATFORM_LINUX)
+	if (Data)
+		munmap(Data, DataSize);
+	if (FileDescriptor >= 0)
+		close(FileDescriptor);
+	FileDescriptor = -1;
+
+	#else
+	delete[] Data;
+	Dirty = false;
+
+	#endif
+	Data = nullptr;
+	DataSize = 0;
+}
+
+
+bool tSystem::tHashCache::Resize(uint32 capacity)
+{
+	// Keep a copy of the live entries so they can be put back into the bigger table.
+	uint32 oldNumEntries = Data ? Header()->NumEntries : 0;
+	EntryType* oldEntries = oldNumEntries ? new EntryType[oldNumEntries] : nullptr;
+	int numKept = 0;
+	for (uint32 e = 0; Data && (e < Header()->Capacity) && (numKept < int(oldNumEntries)); e++)
+		if (Entries()[e].Key)
+			oldEntries[numKept++] = Entries()[e];
+
+	int64 newSize = int64(sizeof(HeaderType) + capacity*sizeof(EntryType));
+
+	#if defined(PLATFORM_LINUX)
+	if (Data)
+		munmap(Data, DataSize);
+	Data = nullptr;
+	DataSize = 0;
+
+	// Truncating to zero first makes sure the new table starts out all zero (empty).
+	void* mapped = MAP_FAILED;
+	if ((ftruncate(FileDescriptor, 0) == 0) && (ftruncate(FileDescriptor, newSize) == 0))
+		mapped = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0);
+	if (mapped == MAP_FAILED)
+	{
+		delete[] oldEntries;
+		return false;
+	}
+	Data = (uint8*)mapped;
+
+	#else
+	delete[] Data;
+	Data = new uint8[newSize];
+	tStd::tMemset(Data, 0, int(newSize));
+	Dirty = true;
+
+	#endif
+	DataSize = newSize;
+
+	// The header is filled in with no entries. Store increments the count.
+	HeaderType* header = Header();
+	header->Magic = HashCacheMagic;
+	header->Version = HashCacheVersion;
+	header->Capacity = capacity;
+	header->NumEntries = 0;
+	for (int e = 0; e < numKept; e++)
+	{
+		EntryType& entry = oldEntries[e];
+		tFileStamp stamp;
+		stamp.Size = entry.Size;
+		stamp.ModTime = entry.ModTime;
+		stamp.Inode = entry.Inode;
+		Store(entry.Key, stamp, entry.Value);
+	}
+
+	delete[] oldEntries;
+	return true;
+}
+
+
+bool tSystem::tHashCache::Lookup(uint64& value, uint64 key, const tFileStamp& stamp)
+{
+	if (!Data)
+		return false;
+
+	// Linear probing. The table is never more than three-quarters full so there is normally an empty slot to stop at.
+	// A damaged file may have none, so never probe more slots than there are.
+	uint32 capacity = Header()->Capacity;
+	uint32 mask = capacity - 1;
+	uint32 slot = uint32(key) & mask;
+	for (uint32 probe = 0; probe < capacity; probe++, slot = (slot + 1) & mask)
+	{
+		const EntryType& entry = Entries()[slot];
+		if (!entry.Key)
+			return false;
+		if (entry.Key != key)
+			continue;
+
+		if ((entry.Size != stamp.Size) || (entry.ModTime != stamp.ModTime) || (entry.Inode != stamp.Inode))
+			return false;
+		if (entry.Check != ComputeCheck(entry))
+			return false;
+
+		value = entry.Value;
+		return true;
+	}
+
+	return false;
+}
+
+
+void tSystem::tHashCache::Store(uint64 key, const tFileStamp& stamp, uint64 value)
+{
+	if (!Data)
+		return;
+
+	if ((Header()->NumEntries + 1) * 4 > Header()->Capacity * 3)
+		if (!Resize(Header()->Capacity * 2))
+			return;
+
+	uint32 capacity = Header()->Capacity;
+	uint32 mask = capacity - 1;
+	uint32 slot = uint32(key) & mask;
+	for (uint32 probe = 0; Entries()[slot].Key && (Entries()[slot].Key != key); probe++)
+	{
+		// Only a damaged table can be full. It's only a cache so it is started again empty.
+		if (probe >= capacity)
+		{
+			Header()->NumEntries = 0;
+			if (!Resize(capacity))
+				return;
+			slot = uint32(key) & mask;
+			continue;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	EntryType& entry = Entries()[slot];
+	if (!entry.Key)
+		Header()->NumEntries++;
+
+	EntryType updated;
+	updated.Key = key;
+	updated.Size = stamp.Size;
+	updated.ModTime = stamp.ModTime;
+	updated.Inode = stamp.Inode;
+	updated.Value = value;
+	updated.Check = ComputeCheck(updated);
+	entry = updated;
+
+	#if !defined(PLATFORM_LINUX)
+	Dirty = true;
+	#endif
+}
+
+
+bool tSystem::tHashCache::GetHash(uint64& hash, const tString& file, tFileStamp* fileStamp)
+{
+	tFileStamp stamp;
+	if (!tGetFileStamp(stamp, file))
+		return false;
+	if (fileStamp)
+		*fileStamp = stamp;
+
+	uint64 key = ComputeKey(file);
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (Lookup(hash, key, stamp))
+		{
+			NumHits++;
+			return true;
+		}
+		NumMisses++;
+	}
+
+	// The file is read without holding the lock so other threads can keep using the cache.
+	uint64 contentHash = 0;
+	if (!HashFileContents(contentHash, file, stamp))
+		return false;
+
+	if (stamp.ModTime < GetTimeNowNs() - HashCacheRacyWindow)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Store(key, stamp, contentHash);
+	}
+
+	hash = contentHash;
+	return true;
+}
+
+
+bool tSystem::tHashCache::FilesIdentical(const tString& fileA, const tString& fileB)
+{
+	tFileStamp stampA, stampB;
+	if (!tGetFileStamp(stampA, fileA) || !tGetFileStamp(stampB, fileB))
+		return false;
+
+	if (stampA.Size != stampB.Size)
+		return false;
+
+	uint64 hashA = 0, hashB = 0;
+	if (!GetHash(hashA, fileA) || !GetHash(hashB, fileB))
+		return false;
+
+	return hashA == hashB;
+}
+
+
+bool tSystem::tHashCache::GetValue(uint64& value, const tString& key, const tFileStamp& stamp)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	uint64 hashKey = tHash::tHashString64(key);
+	return Lookup(value, hashKey ? hashKey : 1, stamp);
+}
+
+
+void tSystem::tHashCache::SetValue(const tString& key, const tFileStamp& stamp, uint64 value)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	uint64 hashKey = tHash::tHashString64(key);
+	Store(hashKey ? hashKey : 1, stamp, value);
+}
+
+
+void tSystem::tHashCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (!Data)
+		return;
+
+	// Dropping the old contents first means Resize has nothing to copy.
+	Header()->NumEntries = 0;
+	Resize(HashCacheMinCapacity);
+}
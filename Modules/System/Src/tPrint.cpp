@@ -18,9 +18,14 @@
 #ifdef PLATFORM_WINDOWS
 #include <windows.h>
 #endif
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <Foundation/tStandard.h>
 #include <Foundation/tArray.h>
 #include <Foundation/tHash.h>
+#include <Foundation/tRingBuffer.h>
 #include <Math/tLinearAlgebra.h>
 #include "System/tMachine.h"
 #include "System/tTime.h"
@@ -34,32 +39,37 @@ namespace tSystem
 	// Global settings for all print functionality.
 	static int DefaultPrecision = 4;
 
+	class ConvBuffer;
+
 	// This class receives the final properly formatted characters. As it receives them it counts how many were
 	// received. If you construct with either an external character buffer or external string, it populates them.
 	class Receiver
 	{
 	public:
 		// This constructor creates a receiver that only counts characters received.
-		Receiver()																										: Buffer(nullptr), ReceiveLimit(-1), String(nullptr), NumReceived(0) { }
+		Receiver()																										: Buffer(nullptr), ReceiveLimit(-1), String(nullptr), NumReceived(0), NumDropped(0) { }
 
 		// Populates buffer as chars are received. Buffer is owned externally and its lifespan must outlast Receiver.
-		Receiver(tArray<char>* buffer)																					: Buffer(buffer), ReceiveLimit(-1), String(nullptr), NumReceived(0) { }
+		Receiver(tArray<char>* buffer)																					: Buffer(buffer), ReceiveLimit(-1), String(nullptr), NumReceived(0), NumDropped(0) { }
 
 		// Populates string as chars are received. Buffer is owned externally and its lifespan must outlast Receiver.
 		// The caller must ensure enough room in string for all the receives that will be called.
-		Receiver(char* string)																							: Buffer(nullptr), ReceiveLimit(-1), String(string), NumReceived(0) { }
+		Receiver(char* string)																							: Buffer(nullptr), ReceiveLimit(-1), String(string), NumReceived(0), NumDropped(0) { }
 
 		// Populates string as chars are received. Buffer is owned externally and its lifespan must outlast Receiver.
 		// The caller must ensure enough room in string for all the receives that will be called. After receiveLimit
 		// characters are received, string will no longer be written to.
-		Receiver(char* string, int receiveLimit)																		: Buffer(nullptr), ReceiveLimit(receiveLimit), String(string), NumReceived(0) { }
+		Receiver(char* string, int receiveLimit)																		: Buffer(nullptr), ReceiveLimit(receiveLimit), String(string), NumReceived(0), NumDropped(0) { }
 
 		void Receive(char chr);
 		void Receive(const char* str);						// Assumes null termination.
 		void Receive(const char* str, int numChars);		// No null termination necessary.
-		void Receive(const tArray<char>&);
+		void Receive(const ConvBuffer&);
 		int GetNumReceived() const																						{ return NumReceived; }
 
+		// Includes the characters that did not fit under the receive limit.
+		int GetNumRequested() const																						{ return NumReceived + NumDropped; }
+
 	private:
 		// We could have used a tString here but it wouldn't have been very efficient since appending a single character
 		// would cause a memcpy.
@@ -70,6 +80,31 @@ namespace tSystem
 		int ReceiveLimit;
 		char* String;
 		int NumReceived;
+		int NumDropped;
+	};
+
+	// The handlers convert into one of these before justifying. Conversions live on the stack unless they are very
+	// long (512 bit binary or a huge %f value), so printing does not normally touch the heap.
+	class ConvBuffer
+	{
+	public:
+		ConvBuffer()																									{ }
+		~ConvBuffer()																									{ if (Elements != Local) delete[] Elements; }
+
+		void Append(char c)																								{ Grow(1); Elements[NumElements++] = c; }
+		void Append(const char* str, int numChars)																		{ Grow(numChars); tStd::tMemcpy(Elements+NumElements, str, numChars); NumElements += numChars; }
+		char* GetElements()																								{ return Elements; }
+		const char* GetElements() const																					{ return Elements; }
+		int GetNumElements() const																						{ return NumElements; }
+		char& operator[](int index)																						{ return Elements[index]; }
+
+	private:
+		void Grow(int numMore);
+
+		char Local[256];
+		char* Elements				= Local;
+		int Capacity				= 256;
+		int NumElements				= 0;
 	};
 
 	// This is the workhorse. It processes the format string and deposits the resulting formatted text in the receiver.
@@ -81,18 +116,67 @@ namespace tSystem
 	bool SupplementaryDebuggerOutput																					= false;
 	RedirectCallback* StdoutRedirectCallback																			= nullptr;
 
+	// Asynchronous output. Printing threads only touch their own ring buffer. The mutex is taken when a thread prints
+	// for the first time (to get a ring buffer) or exits (to give it back), and by the writer, flush, and stop. The
+	// writer only holds it long enough to copy the ring list.
+	struct AsyncState
+	{
+		std::mutex Mutex;
+		std::condition_variable Wake;
+		std::condition_variable Flushed;
+		std::thread Writer;
+		tArray<tRingBufferSPSC<char>*> Rings;		// Every ring. Only freed on stop.
+		tArray<tRingBufferSPSC<char>*> IdleRings;	// Rings from exited threads, ready for new ones.
+		tFileHandle LogFile			= nullptr;
+		int BufferSize				= 0;
+		bool StopRequested			= false;
+		uint32 NumFlushRequests		= 0;
+		uint32 NumFlushesDone		= 0;
+		int NumDroppedReported		= 0;
+	};
+	AsyncState* Async																									= nullptr;
+	std::atomic<bool> AsyncEnabled																						= false;
+	std::atomic<int> AsyncNumPrinting																					= 0;
+	std::atomic<int> AsyncNumDropped																					= 0;
+	std::atomic<uint32> AsyncGeneration																					= 0;
+
+	// Each thread remembers its ring buffer along with the generation it was made in, so rings from a previous start
+	// are never used. When the thread exits the ring is given back for the next new printing thread to use, so there
+	// are only as many rings as threads that were printing at the same time.
+	struct AsyncRingHolder
+	{
+		~AsyncRingHolder();
+		tRingBufferSPSC<char>* Ring	= nullptr;
+		uint32 Generation			= 0;
+	};
+	thread_local AsyncRingHolder AsyncThreadRing;
+	thread_local bool AsyncIsWriter																						= false;
+
+	// Returns true if the text was queued (or dropped). Returns false if async output is off and the caller should
+	// print it itself.
+	bool AsyncPrint(const char* text, int numChars);
+	void AsyncWriterMain();
+	void AsyncWrite(const char* text, int numChars);
+
+	// Makes sure the writer is stopped at exit so the thread isn't destroyed while joinable.
+	struct AsyncShutdown
+	{
+		~AsyncShutdown()																								{ tStopAsyncOutput(); }
+	};
+	AsyncShutdown AsyncShutdownAtExit;
+
 	// A format specification consists of the information stored in the expression:
 	// %[flags] [width] [.precision] [:typesize][|typesize]type
 	// except for the type character.
 	enum Flag
 	{
-		Flag_ForcePosOrNegSign					= 1 << 0,
-		Flag_SpaceForPosSign					= 1 << 1,
-		Flag_LeadingZeros						= 1 << 2,
-		Flag_LeftJustify						= 1 << 3,
-		Flag_DecorativeFormatting				= 1 << 4,
-		Flag_DecorativeFormattingAlt			= 1 << 5,
-		Flag_BasePrefix							= 1 << 6
+		Flag_ForcePosOrNegSign					= tPrintFlag_ForcePosOrNegSign,
+		Flag_SpaceForPosSign					= tPrintFlag_SpaceForPosSign,
+		Flag_LeadingZeros						= tPrintFlag_LeadingZeros,
+		Flag_LeftJustify						= tPrintFlag_LeftJustify,
+		Flag_DecorativeFormatting				= tPrintFlag_DecorativeFormatting,
+		Flag_DecorativeFormattingAlt			= tPrintFlag_DecorativeFormattingAlt,
+		Flag_BasePrefix							= tPrintFlag_BasePrefix
 	};
 
 	struct FormatSpec
@@ -139,13 +223,13 @@ namespace tSystem
 	// please see the function HandlerHelper_IntegerTacent.
 	void HandlerHelper_IntegerNative
 	(
-		tArray<char>&, const FormatSpec&, void* data, bool treatAsUnsigned,
+		ConvBuffer&, const FormatSpec&, void* data, bool treatAsUnsigned,
 		int bitSize, bool upperCase, int base, bool forcePrefixLowerCase = false
 	);
 
 	void HandlerHelper_IntegerTacent
 	(
-		tArray<char>&, const FormatSpec&, void* data, bool treatAsUnsigned,
+		ConvBuffer&, const FormatSpec&, void* data, bool treatAsUnsigned,
 		int bitSize, bool upperCase, int base, bool forcePrefixLowerCase = false
 	);
 
@@ -159,9 +243,9 @@ namespace tSystem
 	};
 	PrologHelperFloat HandlerHelper_FloatNormal
 	(
-		tArray<char>&, const FormatSpec&, double value, bool treatPrecisionAsSigDigits = false
+		ConvBuffer&, const FormatSpec&, double value, bool treatPrecisionAsSigDigits = false
 	);
-	bool HandlerHelper_HandleSpecialFloatTypes(tArray<char>&, double value);
+	bool HandlerHelper_HandleSpecialFloatTypes(ConvBuffer&, double value);
 	int  HandlerHelper_FloatComputeExponent(double value);
 	void HandlerHelper_Vector(Receiver&, const FormatSpec&, const float* components, int numComponents);
 	void HandlerHelper_JustificationProlog(Receiver&, int itemLength, const FormatSpec&);
@@ -216,6 +300,12 @@ void tSystem::tSetChannels(tChannel channelsToSee)
 }
 
 
+tSystem::tChannel tSystem::tGetChannels()
+{
+	return OutputChannels;
+}
+
+
 void tSystem::tSetStdoutRedirectCallback(RedirectCallback cb)
 {
 	StdoutRedirectCallback = cb;
@@ -228,6 +318,211 @@ void tSystem::tSetSupplementaryDebuggerOutput(bool enable)
 }
 
 
+bool tSystem::tStartAsyncOutput(const tString& logFile, int bufferSize)
+{
+	tStopAsyncOutput();
+	tFileHandle file = nullptr;
+	if (logFile.IsValid())
+	{
+		file = tOpenFile(logFile.Chr(), "wb");
+		if (!file)
+			return false;
+	}
+
+	Async = new AsyncState;
+	Async->LogFile = file;
+	Async->BufferSize = tMath::tMax(bufferSize, 256);
+	AsyncNumDropped = 0;
+	AsyncGeneration++;
+	Async->Writer = std::thread(AsyncWriterMain);
+	AsyncEnabled = true;
+	return true;
+}
+
+
+bool tSystem::tIsAsyncOutput()
+{
+	return AsyncEnabled;
+}
+
+
+void tSystem::tFlushAsyncOutput()
+{
+	if (!AsyncEnabled || AsyncIsWriter)
+		return;
+
+	std::unique_lock<std::mutex> lock(Async->Mutex);
+	uint32 request = ++Async->NumFlushRequests;
+	Async->Wake.notify_one();
+	Async->Flushed.wait(lock, [&]() { return int32(Async->NumFlushesDone - request) >= 0; });
+}
+
+
+void tSystem::tStopAsyncOutput()
+{
+	if (!AsyncEnabled || AsyncIsWriter)
+		return;
+
+	// No new prints will queue once disabled. Wait for any that are part way through before the writer does its last
+	// pass and the rings are freed.
+	AsyncEnabled = false;
+	while (AsyncNumPrinting)
+		std::this_thread::yield();
+
+	{
+		std::lock_guard<std::mutex> lock(Async->Mutex);
+		Async->StopRequested = true;
+		Async->Wake.notify_one();
+	}
+	Async->Writer.join();
+
+	for (int r = 0; r < Async->Rings.GetNumElements(); r++)
+		delete Async->Rings[r];
+	if (Async->LogFile)
+		tCloseFile(Async->LogFile);
+	delete Async;
+	Async = nullptr;
+}
+
+
+int tSystem::tGetNumDroppedOutput()
+{
+	return AsyncNumDropped;
+}
+
+
+bool tSystem::AsyncPrint(const char* text, int numChars)
+{
+	if (!AsyncEnabled || AsyncIsWriter)
+		return false;
+
+	// Stop waits for AsyncNumPrinting to go to zero, so checking enabled again after the increment means the state
+	// can't be freed while we use it.
+	AsyncNumPrinting++;
+	if (!AsyncEnabled)
+	{
+		AsyncNumPrinting--;
+		return false;
+	}
+
+	// An idle ring may still hold text from the thread that exited. That's fine, it comes out before ours.
+	if (!AsyncThreadRing.Ring || (AsyncThreadRing.Generation != AsyncGeneration))
+	{
+		std::lock_guard<std::mutex> lock(Async->Mutex);
+		if (Async->IdleRings.GetNumElements())
+		{
+			AsyncThreadRing.Ring = Async->IdleRings.Truncate();
+		}
+		else
+		{
+			AsyncThreadRing.Ring = new tRingBufferSPSC<char>(Async->BufferSize);
+			Async->Rings.Append(AsyncThreadRing.Ring);
+		}
+		AsyncThreadRing.Generation = AsyncGeneration;
+	}
+
+	if (!AsyncThreadRing.Ring->Append(text, numChars))
+		AsyncNumDropped++;
+
+	AsyncNumPrinting--;
+	return true;
+}
+
+
+tSystem::AsyncRingHolder::~AsyncRingHolder()
+{
+	if (!Ring)
+		return;
+
+	// Same guard as AsyncPrint. If async output was stopped (or restarted) the ring has already been freed.
+	AsyncNumPrinting++;
+	if (AsyncEnabled && (Generation == AsyncGeneration))
+	{
+		std::lock_guard<std::mutex> lock(Async->Mutex);
+		Async->IdleRings.Append(Ring);
+	}
+	Ring = nullptr;
+	AsyncNumPrinting--;
+}
+
+
+void tSystem::AsyncWriterMain()
+{
+	AsyncIsWriter = true;
+	const int batchSize = 64*1024;
+	char* batch = new char[batchSize+1];
+	tArray<tRingBufferSPSC<char>*> rings;
+
+	std::unique_lock<std::mutex> lock(Async->Mutex);
+	while (true)
+	{
+		// Everything printed before a flush request was queued before the request was made, so one pass over the rings
+		// is enough to satisfy it. Rings are never freed while the writer runs, so the copy of the list can be used
+		// without the lock. That way threads getting a ring don't wait on the console or log file.
+		uint32 flushRequests = Async->NumFlushRequests;
+		bool stopping = Async->StopRequested;
+		rings = Async->Rings;
+		lock.unlock();
+
+		int batchUsed = 0;
+		for (int r = 0; r < rings.GetNumElements(); r++)
+		{
+			tRingBufferSPSC<char>* ring = rings[r];
+			while (int numRemoved = ring->Remove(batch + batchUsed, batchSize - batchUsed))
+			{
+				batchUsed += numRemoved;
+				if (batchUsed == batchSize)
+				{
+					AsyncWrite(batch, batchUsed);
+					batchUsed = 0;
+				}
+			}
+		}
+
+		int numDropped = AsyncNumDropped;
+		if (numDropped != Async->NumDroppedReported)
+		{
+			if (batchUsed > batchSize - 64)
+			{
+				AsyncWrite(batch, batchUsed);
+				batchUsed = 0;
+			}
+			batchUsed += tsPrintf(batch + batchUsed, "[%d output messages dropped]\n", numDropped - Async->NumDroppedReported);
+			Async->NumDroppedReported = numDropped;
+		}
+
+		if (batchUsed)
+			AsyncWrite(batch, batchUsed);
+		if (Async->LogFile)
+			tFlush(Async->LogFile);
+
+		lock.lock();
+		Async->NumFlushesDone = flushRequests;
+		Async->Flushed.notify_all();
+		if (stopping)
+			break;
+
+		Async->Wake.wait_for(lock, std::chrono::milliseconds(10));
+	}
+
+	delete[] batch;
+}
+
+
+void tSystem::AsyncWrite(const char* text, int numChars)
+{
+	if (Async->LogFile)
+	{
+		tWriteFile(Async->LogFile, text, numChars);
+		return;
+	}
+
+	// The batch buffer always has room for the terminator. We're on the writer thread so this goes straight out.
+	((char*)text)[numChars] = '\0';
+	tPrint(text, tFileHandle(0));
+}
+
+
 int tSystem::tPrint(const char* text, tSystem::tChannel channels)
 {
 	if (!(channels & OutputChannels))
@@ -243,6 +538,14 @@ int tSystem::tPrint(const char* text, tFileHandle fileHandle)
 	if (!text || (*text == '\0'))
 		return numPrinted;
 
+	// Stdout output is handed to the writer thread when async output is on.
+	if (!fileHandle && AsyncEnabled)
+	{
+		int numChars = tStd::tStrlen(text);
+		if (AsyncPrint(text, numChars))
+			return numChars;
+	}
+
 	// Print supplementary output unfiltered.
 	#ifdef PLATFORM_WINDOWS
 	if (!fileHandle && SupplementaryDebuggerOutput && IsDebuggerPresent())
@@ -315,7 +618,10 @@ void tSystem::Receiver::Receive(char c)
 {
 	// Are we full?
 	if (String && (ReceiveLimit != -1) && (NumReceived >= ReceiveLimit))
+	{
+		NumDropped++;
 		return;
+	}
 
 	if (Buffer)
 		Buffer->Append(c);
@@ -342,11 +648,17 @@ void tSystem::Receiver::Receive(const char* str)
 	{
 		// Are we full?
 		if (NumReceived >= ReceiveLimit)
+		{
+			NumDropped += len;
 			return;
+		}
 
 		int remaining = ReceiveLimit - NumReceived;
 		if (len > remaining)
+		{
+			NumDropped += len - remaining;
 			len = remaining;
+		}
 	}
 
 	if (!len)
@@ -375,11 +687,17 @@ void tSystem::Receiver::Receive(const char* str, int numChars)
 	{
 		// Are we full?
 		if (NumReceived >= ReceiveLimit)
+		{
+			NumDropped += numChars;
 			return;
+		}
 
 		int remaining = ReceiveLimit - NumReceived;
 		if (numChars > remaining)
+		{
+			NumDropped += numChars - remaining;
 			numChars = remaining;
+		}
 	}
 
 	if (Buffer)
@@ -395,10 +713,24 @@ void tSystem::Receiver::Receive(const char* str, int numChars)
 }
 
 		
-void tSystem::Receiver::Receive(const tArray<char>& buf)
+void tSystem::Receiver::Receive(const ConvBuffer& buf)
+{
+	Receive(buf.GetElements(), buf.GetNumElements());
+}
+
+
+void tSystem::ConvBuffer::Grow(int numMore)
 {
-	int len = buf.GetNumElements();
-	Receive(buf.GetElements(), len);
+	if (NumElements + numMore <= Capacity)
+		return;
+
+	int newCapacity = tMath::tMax(2*Capacity, NumElements + numMore);
+	char* newElements = new char[newCapacity];
+	tStd::tMemcpy(newElements, Elements, NumElements);
+	if (Elements != Local)
+		delete[] Elements;
+	Elements = newElements;
+	Capacity = newCapacity;
 }
 
 
@@ -464,27 +796,33 @@ int tSystem::HandlerJumpTable[256] =
 
 int tvPrintf(const char* format, va_list argList)
 {
-	if (!format)
-		return 0;
-
-	tArray<char> buffer;
-	tSystem::Receiver receiver(&buffer);
-
-	Process(receiver, format, argList);
-	tSystem::tPrint(buffer.GetElements());
-	return receiver.GetNumReceived() - 1;
+	return tvPrintf(tSystem::tChannel_Default, format, argList);
 }
 
 
 int tvPrintf(tSystem::tChannel channels, const char* format, va_list argList)
 {
-	if (!format)
+	// Filtering before formatting is what makes disabled channels cheap.
+	if (!format || !(channels & tSystem::OutputChannels))
 		return 0;
 
+	// Most prints fit on the stack. Longer ones are formatted again into a heap buffer.
+	va_list argList2;
+	va_copy(argList2, argList);
+	char local[512];
+	tSystem::Receiver localReceiver(local, sizeof(local));
+	Process(localReceiver, format, argList);
+	if (localReceiver.GetNumRequested() <= int(sizeof(local)))
+	{
+		va_end(argList2);
+		tSystem::tPrint(local, channels);
+		return localReceiver.GetNumReceived() - 1;
+	}
+
 	tArray<char> buffer;
 	tSystem::Receiver receiver(&buffer);
-
-	Process(receiver, format, argList);
+	Process(receiver, format, argList2);
+	va_end(argList2);
 	tSystem::tPrint(buffer.GetElements(), channels);
 	return receiver.GetNumReceived() - 1;
 }
@@ -637,6 +975,24 @@ int tcvPrintf(const char* format, va_list argList)
 }
 
 
+int tSystem::tPrintValue(char* dest, int destSize, const tPrintSpec& printSpec, const void* data)
+{
+	HandlerInfo* handler = FindHandler(printSpec.Type);
+	if (!handler || !data)
+		return 0;
+
+	FormatSpec spec;
+	spec.Flags = printSpec.Flags;
+	spec.Width = printSpec.Width;
+	spec.Precision = printSpec.Precision;
+	spec.TypeSizeBytes = printSpec.TypeSizeBytes;
+
+	Receiver receiver(dest, tMath::tMax(destSize, 0));
+	(handler->Handler)(receiver, spec, (void*)data);
+	return receiver.GetNumRequested();
+}
+
+
 int tfPrintf(tFileHandle dest, const char* format, ...)
 {
 	va_list argList;
@@ -971,7 +1327,7 @@ void tSystem::HandlerHelper_JustificationEpilog(Receiver& receiver, int itemLeng
 
 void tSystem::HandlerHelper_IntegerNative
 (
-	tArray<char>& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
+	ConvBuffer& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
 	int bitSize, bool upperCase, int base, bool forcePrefixLowerCase
 )
 {
@@ -1053,9 +1409,19 @@ void tSystem::HandlerHelper_IntegerNative
 	}
 
 	curr++;
-	if (flags & Flag_LeadingZeros)
+	int numZeroes = (flags & Flag_LeadingZeros) ? remWidth - tStd::tStrlen(curr) : 0;
+
+	// Wide fields can need more leading zeroes than there is room for in buf.
+	ConvBuffer wide;
+	if (numZeroes > int(curr - buf))
+	{
+		for (int z = 0; z < numZeroes; z++)
+			wide.Append('0');
+		wide.Append(curr, tStd::tStrlen(curr) + 1);
+		curr = wide.GetElements();
+	}
+	else
 	{
-		int numZeroes = remWidth - tStd::tStrlen(curr);
 		for (int z = 0; z < numZeroes; z++)
 		{
 			curr--;
@@ -1094,7 +1460,7 @@ void tSystem::HandlerHelper_IntegerNative
 
 void tSystem::HandlerHelper_IntegerTacent
 (
-	tArray<char>& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
+	ConvBuffer& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
 	int bitSize, bool upperCase, int base, bool forcePrefixLowerCase
 )
 {
@@ -1183,9 +1549,19 @@ void tSystem::HandlerHelper_IntegerTacent
 	}
 
 	curr++;
-	if (flags & Flag_LeadingZeros)
+	int numZeroes = (flags & Flag_LeadingZeros) ? remWidth - tStd::tStrlen(curr) : 0;
+
+	// Wide fields can need more leading zeroes than there is room for in buf.
+	ConvBuffer wide;
+	if (numZeroes > int(curr - buf))
+	{
+		for (int z = 0; z < numZeroes; z++)
+			wide.Append('0');
+		wide.Append(curr, tStd::tStrlen(curr) + 1);
+		curr = wide.GetElements();
+	}
+	else
 	{
-		int numZeroes = remWidth - tStd::tStrlen(curr);
 		for (int z = 0; z < numZeroes; z++)
 		{
 			curr--;
@@ -1233,11 +1609,7 @@ void tSystem::Handler_b(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	// Tacent integers are quite a bit bigger and will require more buffer space. Enough for 512 binary digits.
-	// Native: max 64 (*2) = 128. Tacent max 512 (*2) = 1024. Or, if the native needed X bytes (for 64bit number)
-	// then the tacent type will need 8 times that (4*X) cuz it's 512 bits.
-	int bufSize = nativeInt ? 128 : 1024;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1260,8 +1632,7 @@ void tSystem::Handler_o(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1284,8 +1655,7 @@ void tSystem::Handler_d(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1308,8 +1678,7 @@ void tSystem::Handler_i(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1332,8 +1701,7 @@ void tSystem::Handler_u(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1356,8 +1724,7 @@ void tSystem::Handler_x(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1380,8 +1747,7 @@ void tSystem::Handler_X(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1404,7 +1770,7 @@ void tSystem::Handler_p(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool upperCase = true;
 	int base = 16;
 	bool forcePrefixLowerCase = true;
-	tArray<char> convInt(64, 0);
+	ConvBuffer convInt;
 	HandlerHelper_IntegerNative(convInt, pspec, data, treatAsUnsigned, bitSize, upperCase, base, forcePrefixLowerCase);
 
 	HandlerHelper_JustificationProlog(receiver, convInt.GetNumElements(), pspec);
@@ -1440,7 +1806,7 @@ int tSystem::HandlerHelper_FloatComputeExponent(double value)
 }
 
 
-bool tSystem::HandlerHelper_HandleSpecialFloatTypes(tArray<char>& convBuf, double value)
+bool tSystem::HandlerHelper_HandleSpecialFloatTypes(ConvBuffer& convBuf, double value)
 {
 	tStd::tFloatType ft = tStd::tGetFloatType(value);
 	switch (ft)
@@ -1475,7 +1841,7 @@ void tSystem::Handler_e(Receiver& receiver, const FormatSpec& spec, void* data)
 	double v = *((double*)data);
 
 	// Check for early exit infinities and NANs.
-	tArray<char> convBuf(64, 32);
+	ConvBuffer convBuf;
 	if (HandlerHelper_HandleSpecialFloatTypes(convBuf, v))
 	{
 		receiver.Receive(convBuf);
@@ -1602,9 +1968,9 @@ void tSystem::Handler_e(Receiver& receiver, const FormatSpec& spec, void* data)
 }
 
 
-tSystem::PrologHelperFloat tSystem::HandlerHelper_FloatNormal(tArray<char>& convBuf, const FormatSpec& spec, double value, bool treatPrecisionAsSigDigits)
+tSystem::PrologHelperFloat tSystem::HandlerHelper_FloatNormal(ConvBuffer& convBuf, const FormatSpec& spec, double value, bool treatPrecisionAsSigDigits)
 {
-	tArray<char> buf(64, 32);
+	ConvBuffer buf;
 	buf.Append('0');
 
 	// Default floating point printf precision. ANSI is 6, ours is 4.
@@ -1727,7 +2093,7 @@ void tSystem::Handler_f(Receiver& receiver, const FormatSpec& spec, void* data)
 {
 	// Variable arg rules say you must treat the data as double. It converts automatically. That's why %f is always 64 bits.
 	double value = *((double*)data);
-	tArray<char> convFloat(64, 32);
+	ConvBuffer convFloat;
 
 	// Check for early exit infinities and NANs.
 	PrologHelperFloat res = PrologHelperFloat::None;
@@ -1757,7 +2123,7 @@ void tSystem::Handler_g(Receiver& receiver, const FormatSpec& spec, void* data)
 {
 	// Variable argument specifies data should be treated data as double. i.e. %f is 64 bits.
 	double v = *((double*)data);
-	tArray<char> convBuf(64, 32);
+	ConvBuffer convBuf;
 
 	// Default floating point printf precision. ANSI is 6, ours is 4.
 	// For %g, the precision is treated as significant digits, not number of digits after the decimal point.
@@ -33,6 +33,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <Foundation/tMemory.h>
+#include <Foundation/tHash.h>
 #include "System/tThrow.h"
 #include "System/tRegex.h"
 #include "System/tPrint.h"
@@ -758,6 +759,645 @@ const char* tRegex::MatchNode(const tRegex::Node* node, const char* str, const t
 }
 
 
+// The automaton works on bytes. Build turns the parsed nodes into a Thompson NFA. DFA states, each standing for a set
+// of NFA states, are only made the first time the text steps into them, and the number kept is capped so memory stays
+// bounded. There are two DFAs. The anchored one only finds matches that start where the run starts. The unanchored one
+// adds the NFA start state at every step so it finds a match starting anywhere.
+struct tRegex::Automaton
+{
+	~Automaton();
+
+	// Returns false if the pattern uses something the automaton doesn't support or would be too big.
+	bool Build(const tRegex&);
+
+	// Returns true if all of the null-terminated text matches.
+	bool IsMatch(const char* text);
+
+	// Returns true if a match starts at or after begin. atBegin says whether begin is the start of the text.
+	bool Contains(const char* begin, const char* end, bool atBegin);
+
+	// Returns true if some match starts exactly at pos.
+	bool MatchesAt(const char* pos, const char* end, bool atBegin);
+
+private:
+	enum class tKind : uint8
+	{
+		Byte,								// Consumes a byte in the byte set and goes to Out.
+		Split,								// Goes to both Out and Out1 without consuming.
+		BOL,								// Goes to Out at the beginning of the text.
+		EOL,								// Goes to Out at the end of the text.
+		Match
+	};
+
+	struct State
+	{
+		tKind Kind;
+		int Out;
+		int Out1;
+		int ByteSet;
+	};
+
+	struct ByteSet
+	{
+		bool Contains(uint8 b) const																					{ return (Bits[b >> 5] & (1u << (b & 31))) ? true : false; }
+		uint32 Bits[8];
+	};
+
+	enum DfaFlag : uint8
+	{
+		DfaFlag_Match						= 1 << 0,	// A match ends right here.
+		DfaFlag_MatchAtEnd					= 1 << 1,	// A match ends here if this is the end of the text.
+		DfaFlag_Dead						= 1 << 2	// No match is possible from here.
+	};
+
+	struct Dfa
+	{
+		bool Unanchored						= false;
+		int NumStates						= 0;
+		int StatesCapacity					= 0;
+		int* Trans							= nullptr;	// NumClasses entries per state. -1 if not made yet.
+		uint8* Flags						= nullptr;
+		int* SetStart						= nullptr;	// Into SetPool.
+		int* SetLength						= nullptr;
+		int* SetPool						= nullptr;	// Sorted NFA state indices.
+		int PoolSize						= 0;
+		int PoolCapacity					= 0;
+		int* Table							= nullptr;	// Open addressing hash table of DFA states.
+		int TableSize						= 0;
+		int StartAtBegin					= -1;
+		int StartElsewhere					= -1;
+		int NumResets						= 0;
+	};
+
+	int AddState(tKind, int out, int out1 = -1, int byteSet = -1);
+	int BuildChain(const tRegex&, int node, int next);
+	int BuildNode(const tRegex&, int node, int next);
+	int BuildStar(const tRegex&, int node, int next);
+	void BuildClasses();
+
+	// Follows Split and (if atBegin) BOL states. The result is sorted and holds only Byte, EOL, and Match states.
+	int Closure(const int* in, int numIn, bool atBegin, int* out);
+	bool ReachesMatchAtEnd(const int* set, int numSet, bool atBegin);
+
+	void ResetDfa(Dfa&);
+	void GrowDfa(Dfa&);
+	void FreeDfa(Dfa&);
+	int GetDfaState(Dfa&, const int* set, int numSet);
+	int GetStart(Dfa&, bool atBegin);
+	int Step(Dfa& dfa, int state, uint8 b)																				{ int next = dfa.Trans[state*NumClasses + ClassOf[b]]; return (next >= 0) ? next : MakeStep(dfa, state, b); }
+	int MakeStep(Dfa&, int state, uint8);
+
+	// A pattern that needs more NFA states than this (usually from big {n,m} counts) uses the backtracking matcher.
+	// When a DFA reaches MaxDfaStates it is thrown away and rebuilt as the text needs it.
+	static const int MaxStates				= 8192;
+	static const int MaxDfaStates			= 2048;
+
+	State* States							= nullptr;
+	int NumStates							= 0;
+	int StatesCapacity						= 0;
+	ByteSet* ByteSets						= nullptr;
+	int NumByteSets							= 0;
+	int ByteSetsCapacity					= 0;
+	int Start								= -1;
+	bool Failed								= false;
+
+	// Bytes that every byte set treats the same way share a class, so DFA states only need a transition per class.
+	int NumClasses							= 0;
+	uint8 ClassOf[256];
+	uint8 ClassRep[256];
+
+	// Scratch space for closures. Marks avoid clearing between uses.
+	int* Mark								= nullptr;
+	int* Stack								= nullptr;
+	int* ScratchIn							= nullptr;
+	int* ScratchOut							= nullptr;
+	int Generation							= 0;
+
+	Dfa Anchored;
+	Dfa Unanchored;
+};
+
+
+namespace tRegexInternal
+{
+	// Grows a plain array (of trivially copyable items) so it can hold at least needed items.
+	template<typename T> void Reserve(T*& items, int& capacity, int needed);
+}
+
+
+template<typename T> void tRegexInternal::Reserve(T*& items, int& capacity, int needed)
+{
+	if (needed <= capacity)
+		return;
+
+	int newCapacity = tMath::tMax(needed, 2*capacity, 64);
+	T* grown = new T[newCapacity];
+	if (items)
+	{
+		tMemcpy(grown, items, capacity*sizeof(T));
+		delete[] items;
+	}
+	items = grown;
+	capacity = newCapacity;
+}
+
+
+tRegex::Automaton::~Automaton()
+{
+	FreeDfa(Anchored);
+	FreeDfa(Unanchored);
+	delete[] States;
+	delete[] ByteSets;
+	delete[] Mark;
+	delete[] Stack;
+	delete[] ScratchIn;
+	delete[] ScratchOut;
+}
+
+
+int tRegex::Automaton::AddState(tKind kind, int out, int out1, int byteSet)
+{
+	if (NumStates >= MaxStates)
+	{
+		Failed = true;
+		return -1;
+	}
+
+	tRegexInternal::Reserve(States, StatesCapacity, NumStates+1);
+	State& state = States[NumStates];
+	state.Kind = kind;
+	state.Out = out;
+	state.Out1 = out1;
+	state.ByteSet = byteSet;
+	return NumStates++;
+}
+
+
+int tRegex::Automaton::BuildChain(const tRegex& regex, int node, int next)
+{
+	// Chains are built back to front so every node knows the state that follows it.
+	int numNodes = 0;
+	for (int n = node; n != -1; n = regex.Nodes[n].Next)
+		numNodes++;
+
+	int* chain = new int[tMath::tMax(numNodes, 1)];
+	int c = 0;
+	for (int n = node; n != -1; n = regex.Nodes[n].Next)
+		chain[c++] = n;
+
+	for (c = numNodes-1; (c >= 0) && !Failed; c--)
+		next = BuildNode(regex, chain[c], next);
+
+	delete[] chain;
+	return next;
+}
+
+
+int tRegex::Automaton::BuildStar(const tRegex& regex, int node, int next)
+{
+	int loop = AddState(tKind::Split, -1, next);
+	if (Failed)
+		return -1;
+
+	int body = BuildNode(regex, node, loop);
+	States[loop].Out = body;
+	return loop;
+}
+
+
+int tRegex::Automaton::BuildNode(const tRegex& regex, int node, int next)
+{
+	if (Failed)
+		return -1;
+
+	const Node& n = regex.Nodes[node];
+	switch (n.Type)
+	{
+		case tOperator_Greedy:
+		{
+			int p0 = (n.Right >> 16) & 0x0000FFFF;
+			int p1 = n.Right & 0x0000FFFF;
+			if ((p1 != 0xFFFF) && (p0 > p1))
+			{
+				Failed = true;
+				return -1;
+			}
+
+			// x{2,4} is xx(x(x)?)? and x{2,} is xxx*.
+			int c = next;
+			if (p1 == 0xFFFF)
+				c = BuildStar(regex, n.Left, next);
+			else
+				for (int i = 0; (i < p1-p0) && !Failed; i++)
+					c = AddState(tKind::Split, BuildNode(regex, n.Left, c), next);
+
+			for (int i = 0; (i < p0) && !Failed; i++)
+				c = BuildNode(regex, n.Left, c);
+			return c;
+		}
+
+		case tOperator_Or:
+			return AddState(tKind::Split, BuildChain(regex, n.Left, next), BuildChain(regex, n.Right, next));
+
+		case tOperator_Expr:
+		case tOperator_NoCapExpr:
+			return BuildChain(regex, n.Left, next);
+
+		case tOperator_BOL:
+			return AddState(tKind::BOL, next);
+
+		case tOperator_EOL:
+			return AddState(tKind::EOL, next);
+
+		case tOperator_WB:
+			Failed = true;
+			return -1;
+	}
+
+	// Everything else consumes a single char. The byte set is made by asking the backtracking matcher about every
+	// byte value so the two always agree.
+	ByteSet set;
+	tMemset(&set, 0, sizeof(set));
+	for (int b = 0; b < 256; b++)
+	{
+		char c = char(b);
+		bool in = false;
+		switch (n.Type)
+		{
+			case tOperator_Dot:		in = true;													break;
+			case tOperator_Class:	in = regex.MatchClass(&regex.Nodes[n.Left], c);				break;
+			case tOperator_NClass:	in = !regex.MatchClass(&regex.Nodes[n.Left], c);			break;
+			case tOperator_CClass:	in = MatchCClass(n.Left, c);								break;
+			default:
+				if (n.Type >= tOperator_Invalid)
+				{
+					Failed = true;
+					return -1;
+				}
+				in = (c == n.Type);
+				break;
+		}
+		if (in)
+			set.Bits[b >> 5] |= 1u << (b & 31);
+	}
+
+	tRegexInternal::Reserve(ByteSets, ByteSetsCapacity, NumByteSets+1);
+	ByteSets[NumByteSets] = set;
+	return AddState(tKind::Byte, next, -1, NumByteSets++);
+}
+
+
+void tRegex::Automaton::BuildClasses()
+{
+	// Each byte set splits the classes into bytes in the set and bytes not in it.
+	tMemset(ClassOf, 0, sizeof(ClassOf));
+	NumClasses = 1;
+	int remap[512];
+	for (int s = 0; s < NumByteSets; s++)
+	{
+		for (int r = 0; r < 2*NumClasses; r++)
+			remap[r] = -1;
+
+		int numNew = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			int key = ClassOf[b]*2 + (ByteSets[s].Contains(uint8(b)) ? 1 : 0);
+			if (remap[key] < 0)
+				remap[key] = numNew++;
+			ClassOf[b] = uint8(remap[key]);
+		}
+		NumClasses = numNew;
+	}
+
+	for (int b = 255; b >= 0; b--)
+		ClassRep[ClassOf[b]] = uint8(b);
+}
+
+
+bool tRegex::Automaton::Build(const tRegex& regex)
+{
+	int match = AddState(tKind::Match, -1);
+	Start = BuildNode(regex, regex.First, match);
+	if (Failed || (Start < 0))
+		return false;
+
+	BuildClasses();
+	Mark = new int[NumStates];
+	Stack = new int[NumStates];
+	ScratchIn = new int[NumStates];
+	ScratchOut = new int[NumStates];
+	tMemset(Mark, 0, NumStates*sizeof(int));
+	Unanchored.Unanchored = true;
+	return true;
+}
+
+
+int tRegex::Automaton::Closure(const int* in, int numIn, bool atBegin, int* out)
+{
+	Generation++;
+	int numStack = 0;
+	for (int i = 0; i < numIn; i++)
+	{
+		if (Mark[in[i]] != Generation)
+		{
+			Mark[in[i]] = Generation;
+			Stack[numStack++] = in[i];
+		}
+	}
+
+	int numOut = 0;
+	while (numStack)
+	{
+		const State& state = States[Stack[--numStack]];
+		int follow[2] = { -1, -1 };
+		switch (state.Kind)
+		{
+			case tKind::Split:
+				follow[0] = state.Out;
+				follow[1] = state.Out1;
+				break;
+
+			case tKind::BOL:
+				if (atBegin)
+					follow[0] = state.Out;
+				break;
+
+			default:
+				out[numOut++] = int(&state - States);
+				break;
+		}
+
+		for (int f = 0; f < 2; f++)
+		{
+			if ((follow[f] >= 0) && (Mark[follow[f]] != Generation))
+			{
+				Mark[follow[f]] = Generation;
+				Stack[numStack++] = follow[f];
+			}
+		}
+	}
+
+	// Sets are compared as sorted lists. They are small so an insertion sort is fine.
+	for (int i = 1; i < numOut; i++)
+	{
+		int v = out[i];
+		int j = i - 1;
+		for (; (j >= 0) && (out[j] > v); j--)
+			out[j+1] = out[j];
+		out[j+1] = v;
+	}
+	return numOut;
+}
+
+
+bool tRegex::Automaton::ReachesMatchAtEnd(const int* set, int numSet, bool atBegin)
+{
+	// At the end of the text EOL states pass too. This is a search through the non-consuming states.
+	Generation++;
+	int numStack = 0;
+	for (int i = 0; i < numSet; i++)
+	{
+		Mark[set[i]] = Generation;
+		Stack[numStack++] = set[i];
+	}
+
+	while (numStack)
+	{
+		const State& state = States[Stack[--numStack]];
+		int follow[2] = { -1, -1 };
+		switch (state.Kind)
+		{
+			case tKind::Match:
+				return true;
+
+			case tKind::Split:
+				follow[0] = state.Out;
+				follow[1] = state.Out1;
+				break;
+
+			case tKind::BOL:
+				if (atBegin)
+					follow[0] = state.Out;
+				break;
+
+			case tKind::EOL:
+				follow[0] = state.Out;
+				break;
+
+			default:
+				break;
+		}
+
+		for (int f = 0; f < 2; f++)
+		{
+			if ((follow[f] >= 0) && (Mark[follow[f]] != Generation))
+			{
+				Mark[follow[f]] = Generation;
+				Stack[numStack++] = follow[f];
+			}
+		}
+	}
+	return false;
+}
+
+
+void tRegex::Automaton::ResetDfa(Dfa& dfa)
+{
+	dfa.NumStates = 0;
+	dfa.PoolSize = 0;
+	dfa.StartAtBegin = -1;
+	dfa.StartElsewhere = -1;
+	dfa.NumResets++;
+	for (int t = 0; t < dfa.TableSize; t++)
+		dfa.Table[t] = -1;
+}
+
+
+void tRegex::Automaton::FreeDfa(Dfa& dfa)
+{
+	delete[] dfa.Trans;
+	delete[] dfa.Flags;
+	delete[] dfa.SetStart;
+	delete[] dfa.SetLength;
+	delete[] dfa.SetPool;
+	delete[] dfa.Table;
+	dfa = Dfa();
+}
+
+
+void tRegex::Automaton::GrowDfa(Dfa& dfa)
+{
+	int capacity = tMath::tMin(tMath::tMax(2*dfa.StatesCapacity, 64), MaxDfaStates);
+	int* trans = new int[capacity*NumClasses];
+	uint8* flags = new uint8[capacity];
+	int* setStart = new int[capacity];
+	int* setLength = new int[capacity];
+	if (dfa.NumStates)
+	{
+		tMemcpy(trans, dfa.Trans, dfa.NumStates*NumClasses*sizeof(int));
+		tMemcpy(flags, dfa.Flags, dfa.NumStates);
+		tMemcpy(setStart, dfa.SetStart, dfa.NumStates*sizeof(int));
+		tMemcpy(setLength, dfa.SetLength, dfa.NumStates*sizeof(int));
+	}
+	delete[] dfa.Trans;
+	delete[] dfa.Flags;
+	delete[] dfa.SetStart;
+	delete[] dfa.SetLength;
+	dfa.Trans = trans;
+	dfa.Flags = flags;
+	dfa.SetStart = setStart;
+	dfa.SetLength = setLength;
+	dfa.StatesCapacity = capacity;
+}
+
+
+int tRegex::Automaton::GetDfaState(Dfa& dfa, const int* set, int numSet)
+{
+	if (!dfa.TableSize)
+	{
+		dfa.TableSize = 2*MaxDfaStates;
+		dfa.Table = new int[dfa.TableSize];
+		for (int t = 0; t < dfa.TableSize; t++)
+			dfa.Table[t] = -1;
+	}
+
+	uint32 hash = tHash::tHashData32((const uint8*)set, numSet*sizeof(int));
+	uint32 mask = uint32(dfa.TableSize - 1);
+	uint32 slot = hash & mask;
+	for (; dfa.Table[slot] >= 0; slot = (slot + 1) & mask)
+	{
+		int s = dfa.Table[slot];
+		if ((dfa.SetLength[s] == numSet) && !tMemcmp(dfa.SetPool + dfa.SetStart[s], set, numSet*sizeof(int)))
+			return s;
+	}
+
+	if (dfa.NumStates == MaxDfaStates)
+	{
+		ResetDfa(dfa);
+		slot = hash & mask;
+	}
+
+	if (dfa.NumStates == dfa.StatesCapacity)
+		GrowDfa(dfa);
+	tRegexInternal::Reserve(dfa.SetPool, dfa.PoolCapacity, dfa.PoolSize + numSet);
+
+	int s = dfa.NumStates++;
+
+	dfa.SetStart[s] = dfa.PoolSize;
+	dfa.SetLength[s] = numSet;
+	tMemcpy(dfa.SetPool + dfa.PoolSize, set, numSet*sizeof(int));
+	dfa.PoolSize += numSet;
+	for (int c = 0; c < NumClasses; c++)
+		dfa.Trans[s*NumClasses + c] = -1;
+
+	uint8 flags = 0;
+	for (int i = 0; i < numSet; i++)
+		if (States[set[i]].Kind == tKind::Match)
+			flags |= DfaFlag_Match;
+	if (ReachesMatchAtEnd(set, numSet, false))
+		flags |= DfaFlag_MatchAtEnd;
+	if (!numSet)
+		flags |= DfaFlag_Dead;
+	dfa.Flags[s] = flags;
+
+	dfa.Table[slot] = s;
+	return s;
+}
+
+
+int tRegex::Automaton::GetStart(Dfa& dfa, bool atBegin)
+{
+	int& start = atBegin ? dfa.StartAtBegin : dfa.StartElsewhere;
+	if (start < 0)
+	{
+		int numSet = Closure(&Start, 1, atBegin, ScratchOut);
+		start = GetDfaState(dfa, ScratchOut, numSet);
+	}
+	return start;
+}
+
+
+int tRegex::Automaton::MakeStep(Dfa& dfa, int state, uint8 b)
+{
+	const int* set = dfa.SetPool + dfa.SetStart[state];
+	int numSet = dfa.SetLength[state];
+	uint8 rep = ClassRep[ClassOf[b]];
+
+	int numIn = 0;
+	for (int i = 0; i < numSet; i++)
+	{
+		const State& nfa = States[set[i]];
+		if ((nfa.Kind == tKind::Byte) && ByteSets[nfa.ByteSet].Contains(rep))
+			ScratchIn[numIn++] = nfa.Out;
+	}
+	if (dfa.Unanchored && (numIn < NumStates))
+		ScratchIn[numIn++] = Start;
+
+	int numOut = Closure(ScratchIn, numIn, false, ScratchOut);
+	int numResets = dfa.NumResets;
+	int next = GetDfaState(dfa, ScratchOut, numOut);
+	if (numResets == dfa.NumResets)
+		dfa.Trans[state*NumClasses + ClassOf[b]] = next;
+	return next;
+}
+
+
+bool tRegex::Automaton::IsMatch(const char* text)
+{
+	int s = GetStart(Anchored, true);
+	const uint8* c = (const uint8*)text;
+	if (!*c)
+		return ReachesMatchAtEnd(Anchored.SetPool + Anchored.SetStart[s], Anchored.SetLength[s], true);
+
+	for (; *c; c++)
+	{
+		s = Step(Anchored, s, *c);
+		if (Anchored.Flags[s] & DfaFlag_Dead)
+			return false;
+	}
+	return (Anchored.Flags[s] & DfaFlag_MatchAtEnd) ? true : false;
+}
+
+
+bool tRegex::Automaton::Contains(const char* begin, const char* end, bool atBegin)
+{
+	int s = GetStart(Unanchored, atBegin);
+	if (Unanchored.Flags[s] & DfaFlag_Match)
+		return true;
+	if (begin == end)
+		return ReachesMatchAtEnd(Unanchored.SetPool + Unanchored.SetStart[s], Unanchored.SetLength[s], atBegin);
+
+	for (const uint8* c = (const uint8*)begin; c != (const uint8*)end; c++)
+	{
+		s = Step(Unanchored, s, *c);
+		if (Unanchored.Flags[s] & DfaFlag_Match)
+			return true;
+	}
+	return (Unanchored.Flags[s] & DfaFlag_MatchAtEnd) ? true : false;
+}
+
+
+bool tRegex::Automaton::MatchesAt(const char* pos, const char* end, bool atBegin)
+{
+	int s = GetStart(Anchored, atBegin);
+	if (Anchored.Flags[s] & DfaFlag_Match)
+		return true;
+	if (pos == end)
+		return ReachesMatchAtEnd(Anchored.SetPool + Anchored.SetStart[s], Anchored.SetLength[s], atBegin);
+
+	for (const uint8* c = (const uint8*)pos; c != (const uint8*)end; c++)
+	{
+		s = Step(Anchored, s, *c);
+		uint8 flags = Anchored.Flags[s];
+		if (flags & DfaFlag_Match)
+			return true;
+		if (flags & DfaFlag_Dead)
+			return false;
+	}
+	return (Anchored.Flags[s] & DfaFlag_MatchAtEnd) ? true : false;
+}
+
+
 void tRegex::CompileInternal()
 {
 	tAssert(Pattern && !EOL && !BOL && !NumNodes && !Matches && !NumSubExpr);
@@ -788,6 +1428,17 @@ void tRegex::CompileInternal()
 
 	Matches = (MatchInternal*)tMalloc(NumSubExpr * sizeof(MatchInternal));
 	tMemset(Matches, 0, NumSubExpr * sizeof(MatchInternal));
+
+	// Any plain chars at the start of the top-level chain must begin every match.
+	for (int n = Nodes[First].Left; (n != -1) && (Nodes[n].Type < tOperator_Invalid); n = Nodes[n].Next)
+		Prefix += char(Nodes[n].Type);
+
+	Auto = new Automaton;
+	if (!Auto->Build(*this))
+	{
+		delete Auto;
+		Auto = nullptr;
+	}
 }
 
 
@@ -814,6 +1465,10 @@ void tRegex::Clear()
 	if (Pattern)
 		tFree(Pattern);
 	Pattern = 0;
+
+	Prefix.Clear();
+	delete Auto;
+	Auto = nullptr;
 }
 
 
@@ -847,6 +1502,9 @@ void tRegex::Compile(const char* pattern)
 
 bool tRegex::IsMatch(const char* text) const
 {
+	if (Auto)
+		return Auto->IsMatch(text);
+
 	const char* res = 0;
 	BOL = text;
 	EOL = text + tStrlen(text);
@@ -859,46 +1517,88 @@ bool tRegex::IsMatch(const char* text) const
 }
 
 
-void tRegex::Search(const char* textBegin, const char* textEnd, tList<Match>& matches) const
+const char* tRegex::FindPrefix(const char* pos, const char* end) const
 {
-	const char* cur = 0;
-	int node = First;
-	const char* origBegin = textBegin;
-	if (textBegin >= textEnd)
-		return;
+	int prefixLength = Prefix.Length();
+	if (!prefixLength)
+		return (pos < end) ? pos : nullptr;
 
-	BOL = textBegin;
-	EOL = textEnd;
-	do
+	const char* prefix = Prefix.Chr();
+	while (end - pos >= prefixLength)
 	{
-		cur = textBegin;
-		while (node != -1)
-		{
-			CurrSubExpr = 0;
-			cur = MatchNode(&Nodes[node], cur, 0);
-			if (!cur)
-				break;
+		pos = (const char*)tMemchr(pos, uint8(prefix[0]), int(end - pos) - prefixLength + 1);
+		if (!pos)
+			return nullptr;
 
-			node = Nodes[node].Next;
-		}
+		if (!tMemcmp(pos+1, prefix+1, prefixLength-1))
+			return pos;
+		pos++;
+	}
+	return nullptr;
+}
+
+
+int tRegex::Search(const char* textBegin, const char* textEnd, Match* matches, int maxMatches) const
+{
+	if (!IsValid() || (textBegin >= textEnd))
+		return 0;
+
+	// No match can start before the first place the prefix appears.
+	const char* start = FindPrefix(textBegin, textEnd);
+	if (!start)
+		return 0;
+
+	// The automaton rules out text without a match in one pass, then finds where the first match starts. The
+	// backtracking matcher is still what fills in the sub-expression matches.
+	if (Auto)
+	{
+		if (!Auto->Contains(start, textEnd, start == textBegin))
+			return 0;
 
-		textBegin++;
+		while (start && !Auto->MatchesAt(start, textEnd, start == textBegin))
+			start = FindPrefix(start+1, textEnd);
+		if (!start)
+			return 0;
 	}
-	while (cur == 0 && textBegin != textEnd);
 
-	if (cur == 0)
-		return;
+	BOL = textBegin;
+	EOL = textEnd;
+	const char* cur = nullptr;
+	for (; start; start = FindPrefix(start+1, textEnd))
+	{
+		CurrSubExpr = 0;
+		cur = MatchNode(&Nodes[First], start, 0);
+		if (cur)
+			break;
+	}
 
-	--textBegin;
+	if (!cur)
+		return 0;
 
-	// Populate the matches list.
 	tAssert(Matches);
-	for (int m = 0; m < NumSubExpr; m++)
+	int numMatches = tMath::tMin(NumSubExpr, maxMatches);
+	for (int m = 0; m < numMatches; m++)
 	{
 		MatchInternal& mi = Matches[m];
-		matches.Append(new Match(int(mi.Begin-origBegin), mi.Length));
+		matches[m].IndexStart = int(mi.Begin-textBegin);
+		matches[m].Length = mi.Length;
 	}
+	return numMatches;
 }
 
 
+void tRegex::Search(const char* textBegin, const char* textEnd, tList<Match>& matches) const
+{
+	const int maxLocal = 16;
+	Match local[maxLocal];
+	Match* found = (NumSubExpr > maxLocal) ? new Match[NumSubExpr] : local;
+
+	int numFound = Search(textBegin, textEnd, found, tMath::tMax(NumSubExpr, maxLocal));
+	for (int m = 0; m < numFound; m++)
+		matches.Append(new Match(found[m]));
+
+	if (found != local)
+		delete[] found;
+}
+
 }
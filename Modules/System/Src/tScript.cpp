@@ -5,7 +5,9 @@
 // find this notation much more elegant than stuff like the lame XML notation. This site agrees:
 // http://c2.com/cgi/wiki?XmlIsaPoorCopyOfEssExpressions
 // The tExpression reader class in this file parses 'in-place'. That is, the entire file is just read into memory once
-// and accessed as const data. This reduces memory fragmentation but may have made implementation more complex. 
+// and accessed as const data. This reduces memory fragmentation but may have made implementation more complex. For
+// big scripts the reader can optionally build a node table in one pass when loading. Navigation then no longer rescans
+// the text.
 //
 // The second format is a functional format. ex. a(b,c) See tFunExtression.
 //
@@ -19,6 +21,7 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <charconv>
 #include <Foundation/tString.h>
 #include "System/tFile.h"
 #include "System/tScript.h"
@@ -37,6 +40,11 @@ using namespace tScript;
 tExpression tExpression::Car() const
 {
 	tAssert( IsValid() );
+	if (Nodes && (*ExprData == '['))
+	{
+		int firstChild = Nodes[NodeIndex].FirstChild;
+		return (firstChild >= 0) ? GetNodeExpression(firstChild) : tExpression();
+	}
 
 	const char8_t* c = ExprData + 1;
 
@@ -56,6 +64,14 @@ tExpression tExpression::Car() const
 
 tExpression tExpression::CarCdrN(int n) const
 {
+	// The items of an indexed list are next to each other in the table.
+	if (Nodes && (*ExprData == '['))
+	{
+		const tExprNode& node = Nodes[NodeIndex];
+		n = tMath::tMax(n, 0);
+		return (n < node.NumChildren) ? GetNodeExpression(node.FirstChild + n) : tExpression();
+	}
+
 	tExpression e = Car();
 
 	for (int i = 0; i < n; i++)
@@ -73,6 +89,11 @@ tExpression tExpression::CarCdrN(int n) const
 tExpression tExpression::Next() const
 {
 	tAssert( IsValid() );
+	if (Nodes)
+	{
+		int nextSibling = Nodes[NodeIndex].NextSibling;
+		return (nextSibling >= 0) ? GetNodeExpression(nextSibling) : tExpression();
+	}
 
 	const char8_t* c = ExprData;
 	int count = 0;
@@ -177,6 +198,134 @@ bool tExpression::IsAtom() const
 }
 
 
+int tExpression::CountArgs() const
+{
+	if (!IsValid())
+		return 0;
+
+	if (Nodes && (*ExprData == '['))
+		return Nodes[NodeIndex].NumChildren;
+
+	int c = 0;
+	while (CarCdrN(c).IsValid())
+		c++;
+	return c;
+}
+
+
+tExpression tExpression::GetNodeExpression(int nodeIndex) const
+{
+	// All nodes share one buffer so its start can be found from this expression's offset.
+	const char8_t* buffer = ExprData - Nodes[NodeIndex].Offset;
+	const tExprNode& node = Nodes[nodeIndex];
+	return tExpression(buffer + node.Offset, node.LineNumber, Nodes, nodeIndex);
+}
+
+
+bool tExpression::GetCachedValue(uint64& bits, tExprNode::tValueType valueType) const
+{
+	if (!Nodes || (Nodes[NodeIndex].ValueType != valueType))
+		return false;
+
+	bits = Nodes[NodeIndex].ValueBits;
+	return true;
+}
+
+
+void tExpression::SetCachedValue(uint64 bits, tExprNode::tValueType valueType) const
+{
+	if (!Nodes)
+		return;
+
+	Nodes[NodeIndex].ValueBits = bits;
+	Nodes[NodeIndex].ValueType = valueType;
+}
+
+
+bool tExpression::GetAtomBool() const
+{
+	uint64 bits;
+	if (GetCachedValue(bits, tExprNode::tValueType::Bool))
+		return bits ? true : false;
+
+	bool value = GetAtomString().GetAsBool();
+	SetCachedValue(value ? 1 : 0, tExprNode::tValueType::Bool);
+	return value;
+}
+
+
+uint tExpression::GetAtomUint() const
+{
+	uint64 bits;
+	if (GetCachedValue(bits, tExprNode::tValueType::Uint))
+		return uint(bits);
+
+	uint value = GetAtomString().GetAsUInt();
+	SetCachedValue(uint64(value), tExprNode::tValueType::Uint);
+	return value;
+}
+
+
+uint64 tExpression::GetAtomUint64() const
+{
+	uint64 bits;
+	if (GetCachedValue(bits, tExprNode::tValueType::Uint64))
+		return bits;
+
+	uint64 value = GetAtomString().GetAsUInt64();
+	SetCachedValue(value, tExprNode::tValueType::Uint64);
+	return value;
+}
+
+
+int tExpression::GetAtomInt() const
+{
+	uint64 bits;
+	if (GetCachedValue(bits, tExprNode::tValueType::Int))
+		return int(int64(bits));
+
+	int value = GetAtomString().GetAsInt();
+	SetCachedValue(uint64(int64(value)), tExprNode::tValueType::Int);
+	return value;
+}
+
+
+float tExpression::GetAtomFloat() const
+{
+	uint64 bits;
+	float value;
+	if (GetCachedValue(bits, tExprNode::tValueType::Float))
+	{
+		uint32 bits32 = uint32(bits);
+		tStd::tMemcpy(&value, &bits32, sizeof(value));
+		return value;
+	}
+
+	value = GetAtomString().GetAsFloat();
+	uint32 bits32;
+	tStd::tMemcpy(&bits32, &value, sizeof(value));
+	SetCachedValue(uint64(bits32), tExprNode::tValueType::Float);
+	return value;
+}
+
+
+double tExpression::GetAtomDouble() const
+{
+	uint64 bits;
+	double value;
+	if (GetCachedValue(bits, tExprNode::tValueType::Double))
+	{
+		tStd::tMemcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	value = GetAtomString().GetAsDouble();
+	tStd::tMemcpy(&bits, &value, sizeof(value));
+	SetCachedValue(bits, tExprNode::tValueType::Double);
+	return value;
+}
+
+
 tString tExpression::GetExpressionString() const
 {
 	tAssert( IsValid() );
@@ -216,6 +365,15 @@ tString tExpression::GetAtomString() const
 	if (!IsAtom())
 		throw tScriptError(LineNumber, "Atom expected near: %s", GetContext().Pod());
 
+	if (Nodes)
+	{
+		const char8_t* start = (*ExprData == '"') ? ExprData + 1 : ExprData;
+		int numChars = Nodes[NodeIndex].AtomLength;
+		tString atom(numChars);
+		tStd::tStrncpy(atom.Text(), start, numChars);
+		return atom;
+	}
+
 	const char8_t* start;
 	const char8_t* end;
 	if (*ExprData == '"')
@@ -529,7 +687,7 @@ tExprReader::tExprReader(int argc, char** argv) :
 }
 
 
-void tExprReader::Load(const tString& name, bool isFile)
+void tExprReader::Load(const tString& name, bool isFile, bool buildIndex)
 {
 	Clear();
 	if (name.IsEmpty())
@@ -581,120 +739,302 @@ void tExprReader::Load(const tString& name, bool isFile)
 
 	LineNumber = 1;
 	ExprData = EatWhiteAndComments(ExprBuffer, LineNumber);
+	if (buildIndex && BuildIndex())
+		NodeIndex = 0;
+}
+
+
+bool tExprReader::BuildIndex()
+{
+	// This follows the same rules as Car and Next, but visits every expression once. Nodes are first made in text
+	// order with sibling links while a stack holds the lists that are still open. Line numbers are found by counting
+	// newlines up to each expression as we go.
+	tAssert(ExprBuffer && (ExprBuffer[0] == '['));
+	int capacity = 1024;
+	int numNodes = 0;
+	tExprNode* nodes = new tExprNode[capacity];
+
+	int stackCapacity = 64;
+	int depth = 0;
+	int* openLists = new int[stackCapacity];
+	int* lastChilds = new int[stackCapacity];
+
+	const char8_t* lineScan = ExprBuffer;
+	int lineNumber = 0;
+
+	auto addNode = [&](const char8_t* c, int atomLength) -> int
+	{
+		if (numNodes == capacity)
+		{
+			capacity *= 2;
+			tExprNode* grown = new tExprNode[capacity];
+			tStd::tMemcpy(grown, nodes, numNodes*sizeof(tExprNode));
+			delete[] nodes;
+			nodes = grown;
+		}
+
+		while (lineScan < c)
+			if (*lineScan++ == '\n')
+				lineNumber++;
+
+		tExprNode& node = nodes[numNodes];
+		node.Offset = int(c - ExprBuffer);
+		node.AtomLength = atomLength;
+		node.LineNumber = lineNumber;
+		node.FirstChild = -1;
+		node.NumChildren = 0;
+		node.NextSibling = -1;
+		node.ValueBits = 0;
+		node.ValueType = tExprNode::tValueType::None;
+
+		// Link to the parent list.
+		if (depth)
+		{
+			tExprNode& parent = nodes[openLists[depth-1]];
+			int& lastChild = lastChilds[depth-1];
+			if (lastChild >= 0)
+				nodes[lastChild].NextSibling = numNodes;
+			else
+				parent.FirstChild = numNodes;
+			lastChild = numNodes;
+			parent.NumChildren++;
+		}
+		return numNodes++;
+	};
+
+	auto pushList = [&](int index)
+	{
+		if (depth == stackCapacity)
+		{
+			stackCapacity *= 2;
+			int* grownLists = new int[stackCapacity];
+			int* grownChilds = new int[stackCapacity];
+			tStd::tMemcpy(grownLists, openLists, depth*sizeof(int));
+			tStd::tMemcpy(grownChilds, lastChilds, depth*sizeof(int));
+			delete[] openLists;
+			delete[] lastChilds;
+			openLists = grownLists;
+			lastChilds = grownChilds;
+		}
+		openLists[depth] = index;
+		lastChilds[depth] = -1;
+		depth++;
+	};
+
+	pushList(addNode(ExprBuffer, 0));
+	const char8_t* c = ExprBuffer + 1;
+	bool wellFormed = true;
+	int lineCount = 0;
+	while (depth)
+	{
+		c = EatWhiteAndComments(c, lineCount);
+		if (*c == '\0')
+		{
+			wellFormed = false;
+			break;
+		}
+
+		if (*c == ']')
+		{
+			depth--;
+			c++;
+			continue;
+		}
+
+		if (*c == '[')
+		{
+			pushList(addNode(c, 0));
+			c++;
+			continue;
+		}
+
+		// An atom. The end used by GetAtomString and the end used by Next differ slightly for plain atoms.
+		const char8_t* end = nullptr;
+		int atomLength = 0;
+		if ((*c == '"') || (*c == '('))
+		{
+			end = tStd::tStrchr(c+1, (*c == '"') ? '"' : ')');
+			if (!end)
+			{
+				wellFormed = false;
+				break;
+			}
+			atomLength = (*c == '"') ? int(end - c - 1) : int(end - c + 1);
+			end++;
+		}
+		else
+		{
+			const char8_t* atomEnd = c;
+			while
+			(
+				(*atomEnd != ' ') && (*atomEnd != '\t') && (*atomEnd != '[') && (*atomEnd != ']') && (*atomEnd != '\0') &&
+				(*atomEnd != '\r') && (*atomEnd != '\n') && (*atomEnd != ';') && (*atomEnd != BCB) && (*atomEnd != '"')
+			) atomEnd++;
+			atomLength = int(atomEnd - c);
+
+			// Next only stops at these (or after a newline).
+			end = c;
+			char8_t c1 = *end;
+			while ((c1 != ' ') && (c1 != '\t') && (c1 != '[') && (c1 != ']') && (c1 != '\0') && (c1 != ';') && (c1 != BCB) && (c1 != '"'))
+			{
+				end++;
+				if (c1 == '\n')
+					break;
+				c1 = *end;
+			}
+		}
+
+		addNode(c, atomLength);
+		c = end;
+	}
+	delete[] openLists;
+	delete[] lastChilds;
+
+	if (!wellFormed)
+	{
+		delete[] nodes;
+		return false;
+	}
+
+	// Now lay the nodes out so the items of every list are next to each other. Lists are visited breadth first and
+	// their items are copied to the end of the table, following the sibling links from the first pass.
+	Nodes = new tExprNode[numNodes];
+	Nodes[0] = nodes[0];
+	int numPlaced = 1;
+	for (int n = 0; n < numPlaced; n++)
+	{
+		int child = Nodes[n].FirstChild;
+		if (child < 0)
+			continue;
+
+		Nodes[n].FirstChild = numPlaced;
+		for (; child >= 0; child = nodes[child].NextSibling)
+		{
+			Nodes[numPlaced] = nodes[child];
+			Nodes[numPlaced].NextSibling = numPlaced + 1;
+			numPlaced++;
+		}
+		Nodes[numPlaced-1].NextSibling = -1;
+	}
+	tAssert(numPlaced == numNodes);
+	delete[] nodes;
+
+	NumNodes = numNodes;
+	return true;
 }
 
 
-tExprWriter::tExprWriter(const tString& filename) :
+tExprWriter::tExprWriter(const tString& filename, int bufferSize) :
 	CurrIndent(0),
-	TabWidth(0)
+	TabWidth(0),
+	Buffer(nullptr),
+	BufferSize(tMath::tMax(bufferSize, 64)),
+	BufferUsed(0)
 {
 	ExprFile = tSystem::tOpenFile(filename, "wt");
 
 	if (!ExprFile)
 		throw tScriptError("Cannot open file [%s].", tPod(filename));
+
+	Buffer = new char[BufferSize];
 }
 
 
-void tExprWriter::BeginExpression()
+tExprWriter::~tExprWriter()
 {
-	char beg[] = "[ ";
-	int numWritten = tSystem::tWriteFile(ExprFile, beg, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	// Destructors can't throw. Call Flush first if you need to know the write worked.
+	if (BufferUsed)
+		tSystem::tWriteFile(ExprFile, Buffer, BufferUsed);
+	tSystem::tCloseFile(ExprFile);
+	delete[] Buffer;
 }
 
 
-void tExprWriter::EndExpression()
+void tExprWriter::Flush()
 {
-	char end[] = "] ";
-	int numWritten = tSystem::tWriteFile(ExprFile, end, 2);
-	if (numWritten != 2)
+	if (!BufferUsed)
+		return;
+
+	int numToWrite = BufferUsed;
+	BufferUsed = 0;
+	int numWritten = tSystem::tWriteFile(ExprFile, Buffer, numToWrite);
+	if (numWritten != numToWrite)
 		throw tScriptError("Cannot write to script file.");
 }
 
 
-void tExprWriter::WriteAtom(const tString& atom)
+void tExprWriter::Write(const char* text, int numChars)
+{
+	while (numChars)
+	{
+		if (BufferUsed == BufferSize)
+			Flush();
+
+		int numCopy = tMath::tMin(numChars, BufferSize - BufferUsed);
+		tStd::tMemcpy(Buffer + BufferUsed, text, numCopy);
+		BufferUsed += numCopy;
+		text += numCopy;
+		numChars -= numCopy;
+	}
+}
+
+
+void tExprWriter::BeginExpression()
 {
-	char qu = '"';
+	Write("[ ", 2);
+}
 
-	bool hasSpace = true;
-	if (atom.FindChar(' ') == -1)
-		hasSpace = false;
 
+void tExprWriter::EndExpression()
+{
+	Write("] ", 2);
+}
+
+
+void tExprWriter::WriteAtom(const tString& atom)
+{
 	// Here we determine whether to use quotes. If the atom has a space, we need them.
+	bool hasSpace = (atom.FindChar(' ') != -1);
 	bool useQuotes = hasSpace || atom.IsEmpty();
-	int numWritten = 0;
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ExprFile, &qu, 1);
+		Write('"');
 
-	int atomLen = atom.Length();
-	numWritten += tSystem::tWriteFile(ExprFile, atom, atomLen);
+	Write(atom.Chr(), atom.Length());
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ExprFile, &qu, 1);
+		Write('"');
 
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ExprFile, &sp, 1);
-
-	if (numWritten != (1 + (useQuotes ? 2 : 0) + atomLen))
-		throw tScriptError("Cannot write atom [%s] to script file.", tPod(atom));
+	Write(' ');
 }
 
 
 void tExprWriter::WriteAtom(const char* atom)
 {
-	char qu = '"';
-
-	bool hasSpace = false;
-	if (tStd::tStrchr(atom, ' '))
-		hasSpace = true;
-
 	// Here we determine whether to use quotes if necessary. If the atom is a tuple (a vector or matrix etc) then we do
 	// not use quotes even if spaces are present.
+	bool hasSpace = tStd::tStrchr(atom, ' ') ? true : false;
 	bool useQuotes = hasSpace;
-	int numWritten = 0;
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ExprFile, &qu, 1);
+		Write('"');
 
-	int atomLen = tStd::tStrlen(atom);
-	numWritten += tSystem::tWriteFile(ExprFile, atom, atomLen);
+	Write(atom, tStd::tStrlen(atom));
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ExprFile, &qu, 1);
+		Write('"');
 
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ExprFile, &sp, 1);
-
-	if (numWritten != (1 + (useQuotes ? 2 : 0) + atomLen))
-		throw tScriptError("Cannot write atom '%s' to script file.", atom);
+	Write(' ');
 }
 
 
 void tExprWriter::WriteRaw(const tString& atom)
 {
-	int numWritten = 0;
-
-	int atomLen = atom.Length();
-	numWritten += tSystem::tWriteFile(ExprFile, atom, atomLen);
-
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ExprFile, &sp, 1);
-
-	if (numWritten != (1 + atomLen))
-		throw tScriptError("Cannot write atom [%s] to script file.", tPod(atom));
+	Write(atom.Chr(), atom.Length());
+	Write(' ');
 }
 
 
 void tExprWriter::WriteRaw(const char* atom)
 {
-	int numWritten = 0;
-
-	int atomLen = tStd::tStrlen(atom);
-	numWritten += tSystem::tWriteFile(ExprFile, atom, atomLen);
-
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ExprFile, &sp, 1);
-
-	if (numWritten != (1 + atomLen))
-		throw tScriptError("Cannot write atom '%s' to script file.", atom);
+	Write(atom, tStd::tStrlen(atom));
+	Write(' ');
 }
 
 
@@ -950,36 +1290,128 @@ void tExprWriter::WriteAtom(const tColour4b& c)
 }
 
 
-void tExprWriter::WriteComment(const char* comment)
+void tExprWriter::WriteAtoms(const int* values, int count)
 {
-	char sc[] = "; ";
-	int numWritten = tSystem::tWriteFile(ExprFile, sc, 2);
-	int commentLen = 0;
-	if (comment)
+	for (int v = 0; v < count; v++)
 	{
-		commentLen = tStd::tStrlen(comment);
-		numWritten += tSystem::tWriteFile(ExprFile, comment, commentLen);
+		char val[16];
+		std::to_chars_result result = std::to_chars(val, val+16, values[v]);
+		Write(val, int(result.ptr - val));
+		Write(' ');
 	}
+}
 
-	if (numWritten != (2 + commentLen))
-		throw tScriptError("Cannot write to script file.");
 
-	NewLine();
+void tExprWriter::WriteAtoms(const float* values, int count)
+{
+	WriteShortest(values, count, 1);
 }
 
 
-void tExprWriter::WriteCommentLine(const char* comment)
+void tExprWriter::WriteAtoms(const double* values, int count)
 {
-	int numWritten = 0;
-	int commentLen = 0;
-	if (comment)
+	WriteShortest(values, count, 1);
+}
+
+
+void tExprWriter::WriteAtoms(const tVector2* values, int count)
+{
+	WriteShortest(&values->x, count, 2);
+}
+
+
+void tExprWriter::WriteAtoms(const tVector3* values, int count)
+{
+	WriteShortest(&values->x, count, 3);
+}
+
+
+void tExprWriter::WriteAtoms(const tVector4* values, int count)
+{
+	WriteShortest(&values->x, count, 4);
+}
+
+
+template<typename T> void tExprWriter::WriteShortest(const T* values, int count, int tupleSize)
+{
+	// Tuples are written in the same (a, b, c) form as the WriteAtom vector calls so GetAtomVector3 etc can read them.
+	for (int t = 0; t < count; t++)
 	{
-		commentLen = tStd::tStrlen(comment);
-		numWritten += tSystem::tWriteFile(ExprFile, comment, commentLen);
+		if (tupleSize > 1)
+			Write('(');
+
+		for (int e = 0; e < tupleSize; e++)
+		{
+			char val[32];
+			int numChars = ShortestToString(val, values[t*tupleSize + e]);
+			Write(val, numChars);
+			if (e != tupleSize-1)
+				Write(", ", 2);
+		}
+
+		if (tupleSize > 1)
+			Write(')');
+		Write(' ');
 	}
+}
 
-	if (numWritten != commentLen)
-		throw tScriptError("Cannot write to script file.");
+
+int tExprWriter::ShortestToString(char* dest, float value)
+{
+	if (tStd::tIsSpecial(value))
+		value = 0.0f;
+
+	// std::to_chars without a format or precision gives the shortest representation that round-trips.
+	std::to_chars_result result = std::to_chars(dest, dest+30, value);
+	int numChars = int(result.ptr - dest);
+
+	// Add a trailing .0 to whole numbers because it looks better and makes it clear it's not an integer.
+	if (!tStd::tMemchr(dest, '.', numChars) && !tStd::tMemchr(dest, 'e', numChars))
+	{
+		dest[numChars++] = '.';
+		dest[numChars++] = '0';
+	}
+	return numChars;
+}
+
+
+int tExprWriter::ShortestToString(char* dest, double value)
+{
+	if (tStd::tIsSpecial(value))
+		value = 0.0;
+
+	std::to_chars_result result = std::to_chars(dest, dest+30, value);
+	int numChars = int(result.ptr - dest);
+	if (!tStd::tMemchr(dest, '.', numChars) && !tStd::tMemchr(dest, 'e', numChars))
+	{
+		dest[numChars++] = '.';
+		dest[numChars++] = '0';
+	}
+	return numChars;
+}
+
+
+void tExprWriter::WriteComment(const char* comment)
+{
+	Write("; ", 2);
+	if (comment)
+		Write(comment, tStd::tStrlen(comment));
+
+	NewLine();
+}
+
+
+void tExprWriter::WriteCommentBegin()
+{
+	Write(BCB);
+	Write('\n');
+}
+
+
+void tExprWriter::WriteCommentLine(const char* comment)
+{
+	if (comment)
+		Write(comment, tStd::tStrlen(comment));
 
 	NewLine();
 }
@@ -987,60 +1419,37 @@ void tExprWriter::WriteCommentLine(const char* comment)
 
 void tExprWriter::WriteCommentEnd()
 {
-	char sc[] = ">\n";
-	sc[0] = BCE;
-	int numWritten = tSystem::tWriteFile(ExprFile, sc, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	Write(BCE);
+	Write('\n');
 }
 
 
 void tExprWriter::WriteCommentInlineBegin()
 {
-	char sc[] = "< ";
-	sc[0] = BCB;
-	int numWritten = tSystem::tWriteFile(ExprFile, sc, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	Write(BCB);
+	Write(' ');
 }
 
 
 void tExprWriter::WriteCommentInline(const char* comment)
 {
-	int numWritten = 0;
-	int commentLen = 0;
 	if (comment)
-	{
-		commentLen = tStd::tStrlen(comment);
-		numWritten += tSystem::tWriteFile(ExprFile, comment, commentLen);
-	}
-
-	if (numWritten != commentLen)
-		throw tScriptError("Cannot write to script file.");
+		Write(comment, tStd::tStrlen(comment));
 }
 
 
 void tExprWriter::WriteCommentInlineEnd()
 {
-	char sc[] = " > ";
-	sc[1] = BCE;
-	int numWritten = tSystem::tWriteFile(ExprFile, sc, 3);
-	if (numWritten != 3)
-		throw tScriptError("Cannot write to script file.");
+	Write(' ');
+	Write(BCE);
+	Write(' ');
 }
 
 
 void tExprWriter::NewLine()
 {
-	char nl = '\n';
-	char tb = '\t';
-
-	int numWritten = tSystem::tWriteFile(ExprFile, &nl, 1);
-	numWritten += WriteIndents();
-	int expectedWritten = 1 + (TabWidth ? CurrIndent*TabWidth : CurrIndent);
-
-	if (numWritten != expectedWritten)
-		throw tScriptError("Cannot write to script file.");
+	Write('\n');
+	WriteIndents();
 }
 
 
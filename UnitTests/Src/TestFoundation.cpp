@@ -1491,6 +1491,33 @@ tTestUnit(String)
 	numRemoved = remnot.RemoveAnyNot("abc");
 	tPrintf("Remove Not After: %s\n", remnot.Chr());
 	tRequire((numRemoved == 4) && (remnot.Length() == 8));	
+
+	// Short strings live inside the tString object and only move to the heap when they outgrow it.
+	tString inl;
+	tRequire(inl.Capacity() == 15);
+	inl = "short";
+	tRequire((inl.Capacity() == 15) && ((uint8*)inl.Chars() > (uint8*)&inl) && ((uint8*)inl.Chars() < (uint8*)(&inl + 1)));
+	inl += "-and-now-somewhat-longer";
+	tRequire((inl == "short-and-now-somewhat-longer") && (inl.Capacity() > 15));
+	inl = "tiny";
+	inl.Shrink();
+	tRequire((inl == "tiny") && (inl.Capacity() == 15) && ((uint8*)inl.Chars() < (uint8*)(&inl + 1)));
+
+	// Strings made while an arena is installed get their memory from it.
+	tStringArena arena(256);
+	tList<tStringItem> arenaItems;
+	tStringArena* prevArena = tSetStringArena(&arena);
+	for (int i = 0; i < 100; i++)
+		arenaItems.Append(new tStringItem(tString("Directory/Subdirectory/File") + tString(char('A' + i%26))));
+	tString big(200);
+	tSetStringArena(prevArena);
+	tRequire((tGetStringArena() == prevArena) && (arena.GetNumBlocks() > 1) && (arena.GetNumUnitsAllocated() > 100*28));
+	tRequire((arenaItems.GetNumItems() == 100) && (*arenaItems.Last() == "Directory/Subdirectory/FileV") && (big.Length() == 200));
+	tString copied = *arenaItems.First();
+	arenaItems.Empty();
+	big = "";
+	arena.Reset();
+	tRequire((copied == "Directory/Subdirectory/FileA") && (arena.GetNumBlocks() == 0));
 }
 
 
@@ -1621,6 +1648,30 @@ tTestUnit(Name)
 	nameB.Set("AB");
 	tPrintf("NameB hash (ABC)  : %_016|64X\n", nameB.GetHash());
 	tRequire(nameA == nameB);
+
+	// Interned names share their text and compare by pointer. Copies of interned names do not allocate.
+	int numInterned = tName::GetNumInterned();
+	tName jointA = tName("Skeleton/Spine/Chest/LeftShoulder").Intern();
+	tName jointB = tName("Skeleton/Spine/Chest/LeftShoulder").Intern();
+	tName jointC(jointA);
+	tName jointD("Skeleton/Spine/Chest/LeftShoulder");
+	tRequire(jointA.IsInterned() && jointB.IsInterned() && jointC.IsInterned() && !jointD.IsInterned());
+	tRequire((jointA.Chars() == jointB.Chars()) && (jointA.Chars() == jointC.Chars()) && (jointA.Chars() != jointD.Chars()));
+	tRequire((jointA == jointB) && (jointA == jointD) && (jointA == "Skeleton/Spine/Chest/LeftShoulder"));
+	tRequire(tName::GetNumInterned() == numInterned+1);
+	tRequire((uint32(jointA) == uint32(jointD)) && (uint32(jointA) != uint32(nameA)));
+
+	tName empty = tName("").Intern();
+	tName invalid = tName().Intern();
+	tRequire(empty.IsInterned() && empty.IsEmpty() && !invalid.IsInterned() && invalid.IsInvalid());
+
+	jointC.Append("Twist");
+	tRequire(!jointC.IsInterned() && (jointC == "Skeleton/Spine/Chest/LeftShoulderTwist") && (jointA == jointB));
+	jointB.Clear();
+	tRequire(jointB.IsInvalid() && (jointA == "Skeleton/Spine/Chest/LeftShoulder"));
+
+	tName utf32(U"Joint", 5);
+	tRequire(utf32 == "Joint");
 }
 
 
@@ -1682,6 +1733,35 @@ tTestUnit(RingBuffer)
 		if (ok) tPrintf("Removed %c\n", rm);
 	}
 	tPrintf("\n");
+
+	// One thread streams a known sequence through a small lock-free ring while another reads it back.
+	tRingBufferSPSC<int> spsc(60);
+	tRequire(spsc.GetCapacity() == 64);
+	const int numStreamed = 100000;
+	std::thread producer([&spsc]()
+	{
+		int next = 0;
+		while (next < numStreamed)
+		{
+			int items[7];
+			int count = tMath::tMin(7, numStreamed - next);
+			for (int i = 0; i < count; i++)
+				items[i] = next + i;
+			if (spsc.Append(items, count))
+				next += count;
+		}
+	});
+	int expected = 0;
+	bool inOrder = true;
+	while (expected < numStreamed)
+	{
+		int items[16];
+		int count = spsc.Remove(items, 16);
+		for (int i = 0; i < count; i++)
+			inOrder = inOrder && (items[i] == expected++);
+	}
+	producer.join();
+	tRequire(inOrder && spsc.IsEmpty() && (spsc.Remove(&expected, 1) == 0));
 }
 
 
@@ -12,6 +12,7 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <Foundation/tSmallFloat.h>
 #include <Image/tTexture.h>
 #include <Image/tImageDDS.h>
 #include <Image/tImageKTX.h>
@@ -33,6 +34,8 @@
 #include <Image/tImageTIFF.h>
 #include <Image/tImagePVR.h>
 #include <Image/tPaletteImage.h>
+#include <Image/tPixelUtil.h>
+#include <Image/tFrameStream.h>
 #include <System/tFile.h>
 #include "UnitTests.h"
 using namespace tImage;
@@ -144,6 +147,68 @@ void TestSaveGif(const tString& pngFile, tPixelFormat format, tQuantize::Method
 }
 
 
+// Saves the frames of pngFile as a normal gif and as streamed gifs. The streamed gif with a shared palette must decode
+// to the same pixels as the normal one when all frames fit in the palette sample. Otherwise it and the local-palette
+// gif must at least have the same frames with the same transparency.
+void TestSaveGifStream(const tString& pngFile, bool transparency, bool expectExact)
+{
+	tImageAPNG apng(pngFile);
+	tList<tFrame> frames;
+	apng.StealFrames(frames);
+	tImageGIF gif;
+	gif.Set(frames, true);
+
+	tString baseName = tSystem::tGetFileBaseName(pngFile);
+	tString refFile, globalFile, localFile;
+	tsPrintf(refFile,		"WrittenGIF_Stream_%s_%s_Ref.gif",		baseName.Chr(), transparency ? "Transp" : "Opaque");
+	tsPrintf(globalFile,	"WrittenGIF_Stream_%s_%s_Global.gif",	baseName.Chr(), transparency ? "Transp" : "Opaque");
+	tsPrintf(localFile,		"WrittenGIF_Stream_%s_%s_Local.gif",	baseName.Chr(), transparency ? "Transp" : "Opaque");
+
+	tImageGIF::SaveParams params;
+	params.Method = tQuantize::Method::Wu;
+	params.AlphaThreshold = transparency ? 127 : 255;
+	tRequire(gif.Save(refFile, params));
+
+	params.Stream = true;
+	params.NumThreads = 3;
+	tRequire(gif.Save(globalFile, params));
+
+	params.LocalPalettes = true;
+	tRequire(gif.Save(localFile, params));
+
+	tImageGIF ref(refFile);
+	tImageGIF global(globalFile);
+	tImageGIF local(localFile);
+	tRequire(ref.IsValid() && global.IsValid() && local.IsValid());
+	tRequire(global.GetNumFrames() == gif.GetNumFrames());
+	tRequire(local.GetNumFrames() == gif.GetNumFrames());
+
+	bool same = true;
+	bool sameAlpha = true;
+	int numPixels = gif.GetWidth()*gif.GetHeight();
+	for (int f = 0; f < gif.GetNumFrames(); f++)
+	{
+		tPixel4b* refPixels = ref.GetFrame(f)->Pixels;
+		tPixel4b* globalPixels = global.GetFrame(f)->Pixels;
+		tPixel4b* localPixels = local.GetFrame(f)->Pixels;
+		for (int p = 0; p < numPixels; p++)
+		{
+			if (refPixels[p] != globalPixels[p])
+				same = false;
+			if ((refPixels[p].A != globalPixels[p].A) || (refPixels[p].A != localPixels[p].A))
+				sameAlpha = false;
+		}
+	}
+	tRequire(sameAlpha);
+	if (!expectExact)
+		return;
+
+	// Same indices and the same changed rectangles means the same file.
+	tRequire(same);
+	tRequire(tSystem::tGetFileSize(globalFile) == tSystem::tGetFileSize(refFile));
+}
+
+
 tTestUnit(ImageSave)
 {
 	if (!tSystem::tDirExists("TestData/Images/"))
@@ -212,6 +277,12 @@ tTestUnit(ImageSave)
 	TestSaveGif("Icos4D.apng",				tPixelFormat::PAL7BIT, tQuantize::Method::Wu,		true);
 	TestSaveGif("Icos4D.apng",				tPixelFormat::PAL8BIT, tQuantize::Method::Wu,		true);
 
+	// Icos4D fits in the palette sample so its streamed gif should match. Flame has too many pixels and is sampled.
+	tPrintf("Testing GIF streamed save.\n");
+	TestSaveGifStream("Icos4D.apng",	true,	true);
+	TestSaveGifStream("Icos4D.apng",	false,	true);
+	TestSaveGifStream("Flame.apng",		false,	false);
+
 	tImagePNG pngA("PNG/Xeyes.png");
 	pngA.Save("WrittenNewA.png");
 	tRequire( tSystem::tFileExists("WrittenNewA.png"));
@@ -464,6 +535,78 @@ tTestUnit(ImagePicture)
 	// tga.Save("WrittenCrane.tga");
 	// tRequire( tSystem::tFileExists("WrittenCrane.tga"));
 
+	// Copies share pixels until one of them is written to. Reading through a const picture doesn't unshare.
+	tPicture shareA(64, 32);
+	shareA.SetAll(tPixel4b::red);
+	tPicture shareB(shareA);
+	tPicture shareC(shareA);
+	const tPicture& constA = shareA;
+	const tPicture& constB = shareB;
+	tRequire(shareA.IsShared() && shareB.IsShared() && shareC.IsShared());
+	tRequire(constA.GetPixels() == constB.GetPixels());
+	shareB.SetPixel(3, 4, tPixel4b::blue);
+	tRequire(!shareB.IsShared() && shareA.IsShared());
+	tRequire(constA.GetPixels() != constB.GetPixels());
+	tRequire((shareA.GetPixel(3, 4) == tPixel4b::red) && (shareC.GetPixel(3, 4) == tPixel4b::red));
+	tRequire(shareB.GetPixel(3, 4) == tPixel4b::blue);
+	shareC.Flip(true);
+	tRequire(!shareA.IsShared() && (shareA.GetPixel(3, 4) == tPixel4b::red));
+
+	// Stolen pixels are never shared.
+	tPicture shareD(shareA);
+	tPixel4b* stolen = shareD.StealPixels();
+	tRequire(stolen && (stolen != constA.GetPixels()) && !shareD.IsValid() && !shareA.IsShared());
+	stolen[0] = tPixel4b::green;
+	tRequire(shareA.GetPixel(0, 0) == tPixel4b::red);
+	delete[] stolen;
+
+	// A writable pointer is never shared either.
+	tPicture shareE(shareA);
+	tPixel4b* writable = shareE.GetPixelPointer(1, 0);
+	writable[0] = tPixel4b::green;
+	tRequire(!shareE.IsShared() && !shareA.IsShared());
+	tRequire((shareA.GetPixel(1, 0) == tPixel4b::red) && (shareE.GetPixel(1, 0) == tPixel4b::green));
+
+	// Setting an image from a picture only reads the pixels, so a shared picture stays shared.
+	tPicture shareF(shareA);
+	tImageTGA shareTGA;
+	tRequire(shareTGA.Set(shareF, false) && shareF.IsShared() && shareA.IsShared());
+	tRequire(shareTGA.GetPixels()[1] == tPixel4b::red);
+
+	// Frames and layers have public pixel pointers that can be written without unsharing, so their copies never share.
+	tFrame* copyFrame = new tFrame(constA.GetPixels(), 64, 32, 0.5f);
+	tFrame copyFrameCopy(*copyFrame);
+	copyFrameCopy.Pixels[0] = tPixel4b::green;
+	tRequire(copyFrame->Pixels[0] == tPixel4b::red);
+	tPicture copyPic(copyFrame, false);
+	copyFrame->Pixels[0] = tPixel4b::blue;
+	tRequire(copyPic.GetPixel(0, 0) == tPixel4b::red);
+	delete copyFrame;
+
+	tLayer copyLayer(tPixelFormat::R8G8B8A8, 64, 32, (uint8*)constA.GetPixels());
+	tLayer copyLayerCopy(copyLayer);
+	tRequire((copyLayer.Data != copyLayerCopy.Data) && (copyLayer == copyLayerCopy));
+
+	// They share only when asked to, and then unshare before writing.
+	tFrame shareFrame(constA.GetPixels(), 64, 32, 0.5f);
+	tFrame shareFrameCopy;
+	tRequire(shareFrameCopy.Share(shareFrame) && shareFrame.IsShared() && (shareFrame.Pixels == shareFrameCopy.Pixels));
+	shareFrameCopy.SetPixel(0, 0, tPixel4b::green);
+	tRequire(!shareFrame.IsShared() && (shareFrame.Pixels[0] == tPixel4b::red));
+	tRequire(shareFrameCopy.Pixels[0] == tPixel4b::green);
+	tFrame shareFrameStolen;
+	shareFrameStolen.Share(shareFrame);
+	tPixel4b* stolenFrame = shareFrameStolen.GetPixels(true);
+	tRequire(stolenFrame && (stolenFrame != shareFrame.Pixels) && !shareFrame.IsShared());
+	delete[] stolenFrame;
+
+	tLayer shareLayer;
+	shareLayer.Share(copyLayer);
+	tRequire(copyLayer.IsShared() && (shareLayer.Data == copyLayer.Data));
+	shareLayer.Unshare();
+	shareLayer.Data[0] = 0;
+	tRequire(!copyLayer.IsShared() && (shareLayer.Data != copyLayer.Data) && (copyLayer.Data[0] == tPixel4b::red.R));
+
 	tSystem::tSetCurrentDir(origDir);
 }
 
@@ -904,6 +1047,63 @@ tTestUnit(ImageRotation)
 		rottga.Save(writeFile);
 	}
 
+	// Direct rotations sample the original with the filter kernel. Nearest must match the non-resampled rotate and the
+	// smooth filters must come out close to the upscale-rotate-downscale result.
+	bool sameNearest = true;
+	bool sameSize = true;
+	bool sameThreaded = true;
+	float maxMeanDiff = 0.0f;
+	for (int rotNum = 0; rotNum < numRotations; rotNum++)
+	{
+		float angle = float(rotNum) * tMath::fTwoPi / numRotations + 0.1f;
+		tPicture nearestPic(aroPic);
+		nearestPic.RotateCenter(angle, tColour4b::transparent);
+		tPicture directNearestPic(aroPic);
+		directNearestPic.RotateCenterDirect(angle, tColour4b::transparent, tImage::tResampleFilter::Nearest);
+		if (nearestPic != directNearestPic)
+			sameNearest = false;
+
+		tPicture resampledPic(aroPic);
+		resampledPic.RotateCenter(angle, tColour4b::transparent, tImage::tResampleFilter::Bilinear, tImage::tResampleFilter::Box);
+		tPicture directPic(aroPic);
+		directPic.RotateCenterDirect(angle, tColour4b::transparent, tImage::tResampleFilter::Bilinear);
+		tPicture directSinglePic(aroPic);
+		directSinglePic.RotateCenterDirect(angle, tColour4b::transparent, tImage::tResampleFilter::Bilinear, 1);
+		if (directPic != directSinglePic)
+			sameThreaded = false;
+
+		// The x4 rotate truncates when scaling back down so it can be a pixel or two smaller.
+		if ((nearestPic.GetWidth() != directPic.GetWidth()) || (nearestPic.GetHeight() != directPic.GetHeight()))
+		{
+			sameSize = false;
+			continue;
+		}
+		directPic.Crop(resampledPic.GetWidth(), resampledPic.GetHeight(), tPicture::Anchor::MiddleMiddle);
+
+		float totalDiff = 0.0f;
+		for (int p = 0; p < directPic.GetNumPixels(); p++)
+		{
+			tPixel4b a = resampledPic.GetPixels()[p];
+			tPixel4b b = directPic.GetPixels()[p];
+			totalDiff += float(tMath::tAbs(int(a.R)-int(b.R)) + tMath::tAbs(int(a.G)-int(b.G)) + tMath::tAbs(int(a.B)-int(b.B)) + tMath::tAbs(int(a.A)-int(b.A))) / 4.0f;
+		}
+		maxMeanDiff = tMath::tMax(maxMeanDiff, totalDiff / float(directPic.GetNumPixels()));
+
+		if (rotNum == 1)
+		{
+			tPicture lanczosPic(aroPic);
+			lanczosPic.RotateCenterDirect(angle, tColour4b::transparent, tImage::tResampleFilter::Lanczos_Normal);
+			tImageTGA lanczosTga(lanczosPic, true);
+			lanczosTga.Save("TestData/Images/WrittenRightArrow_DirectLanczosRot.tga");
+			tRequire(tSystem::tFileExists("TestData/Images/WrittenRightArrow_DirectLanczosRot.tga"));
+		}
+	}
+	tPrintf("Direct rotate max mean difference: %f\n", maxMeanDiff);
+	tRequire(sameNearest);
+	tRequire(sameSize);
+	tRequire(sameThreaded);
+	tRequire(maxMeanDiff < 4.0f);
+
 	tPrintf("Test 'plane' rotation.\n");
 	tImagePNG planepng("TestData/Images/PNG/plane.png");
 	w = planepng.GetWidth(); h = planepng.GetHeight();
@@ -929,6 +1129,59 @@ tTestUnit(ImageCrop)
 	png.Set(planePic);
 	tImagePNG::tFormat fmt = png.Save("TestData/Images/PNG/WrittenPlane.png");
 	tRequire(fmt != tImagePNG::tFormat::Invalid);
+
+	// An OpChain must give the same pixels as calling the functions one at a time, on one thread and with the tiles
+	// split between four. The image does not fill the last tiles. Crops both cut and grow the image.
+	tPicture src(301, 257);
+	uint32 seed = 7654321;
+	for (int y = 0; y < src.GetHeight(); y++)
+		for (int x = 0; x < src.GetWidth(); x++)
+		{
+			seed = seed*1664525u + 1013904223u;
+			src.SetPixel(x, y, tColour4b(uint8(seed >> 24), uint8(seed >> 16), uint8(seed >> 8), uint8(seed)));
+		}
+
+	tPicture::OpChain chain;
+	chain.Flip(true).Rotate90(false).Crop(200, 320, 20, -30, tColour4b::red).Swizzle(tComp::B, tComp::G, tComp::R, tComp::A);
+	chain.Intensity(tCompBit_G).Rotate90(true).Crop(400, 150, tPicture::Anchor::RightTop, tColour4b::blue);
+	chain.AlphaBlendColour(tColour4b::green, tCompBit_RGB, -1).Flip(false).Spread(tComp::A);
+
+	tPicture seq(src);
+	seq.Flip(true);
+	seq.Rotate90(false);
+	seq.Crop(200, 320, 20, -30, tColour4b::red);
+	seq.Swizzle(tComp::B, tComp::G, tComp::R, tComp::A);
+	seq.Intensity(tCompBit_G);
+	seq.Rotate90(true);
+	seq.Crop(400, 150, tPicture::Anchor::RightTop, tColour4b::blue);
+	seq.AlphaBlendColour(tColour4b::green, tCompBit_RGB, -1);
+	seq.Flip(false);
+	seq.Spread(tComp::A);
+
+	tPicture fused1(src);
+	tPicture fused4(src);
+	tRequire(fused1.Apply(chain, 1) && fused4.Apply(chain, 4));
+	tRequire((fused1.GetWidth() == seq.GetWidth()) && (fused1.GetHeight() == seq.GetHeight()));
+	tRequire((fused1 == seq) && (fused4 == seq));
+	tRequire(src.GetWidth() == 301);
+
+	// With a resample in the middle each side is fused separately.
+	tPicture::OpChain resChain;
+	resChain.Rotate90(true).Crop(250, 250, tPicture::Anchor::LeftBottom).Resample(125, 90, tResampleFilter::Bilinear);
+	resChain.Flip(true).Intensity(tCompBit_RGB);
+	seq.Set(src);
+	seq.Rotate90(true);
+	seq.Crop(250, 250, tPicture::Anchor::LeftBottom);
+	seq.Resample(125, 90, tResampleFilter::Bilinear);
+	seq.Flip(true);
+	seq.Intensity(tCompBit_RGB);
+	fused4.Set(src);
+	tRequire(fused4.Apply(resChain, 4) && (fused4 == seq));
+
+	// Bad sizes leave the picture alone.
+	tPicture::OpChain badChain;
+	badChain.Flip(true).Crop(0, 10);
+	tRequire(!fused4.Apply(badChain) && (fused4 == seq));
 }
 
 
@@ -1100,6 +1353,52 @@ tTestUnit(ImageAdjustment)
 		tImagePNG::tFormat fmt = png.Save(file.Chr());
 		tRequire(fmt != tImagePNG::tFormat::Invalid);
 	}
+
+	// Adjustments are applied with lookup tables on multiple threads. Check them against the per-pixel maths on an
+	// image big enough to be split up. Components not adjusted must keep their previous values.
+	tPicture big(1024, 512);
+	uint32 seed = 1234567;
+	tPixel4b* bigPixels = big.GetPixels();
+	for (int p = 0; p < big.GetNumPixels(); p++)
+	{
+		seed = seed*1664525u + 1013904223u;
+		bigPixels[p].BP = seed;
+	}
+	tPicture orig(big);
+
+	tRequire(big.AdjustmentBegin());
+	float totalA = 0.0f;
+	for (int g = 0; g < tPicture::NumGroups; g++)
+		totalA += big.HistogramA[g];
+	tRequire(tMath::tApproxEqual(totalA, float(big.GetNumPixels())));
+
+	int offset = int(tMath::tLinearInterp(0.7f, 0.0f, 1.0f, float(-big.BrightnessRGBMax), float(255 - big.BrightnessRGBMin)));
+	big.AdjustContrast(0.8f, tCompBit_A);
+	big.AdjustBrightness(0.7f, tCompBit_RGB);
+	float contrast = tMath::tLinearInterp(0.8f, 0.0f, 1.0f, -255.0f, 255.0f);
+	float factor = (259.0f * (contrast + 255.0f)) / (255.0f * (259.0f - contrast));
+	bool sameAdjusted = true;
+	for (int p = 0; p < big.GetNumPixels(); p++)
+	{
+		tPixel4b src = orig.GetPixels()[p];
+		tPixel4b adj = big.GetPixels()[p];
+		if
+		(
+			(adj.R != tMath::tClamp(int(src.R) + offset, 0, 255)) ||
+			(adj.G != tMath::tClamp(int(src.G) + offset, 0, 255)) ||
+			(adj.B != tMath::tClamp(int(src.B) + offset, 0, 255)) ||
+			(adj.A != tMath::tClamp(int(factor * (float(src.A) - 128.0f) + 128.0f), 0, 255))
+		)
+			sameAdjusted = false;
+	}
+	tRequire(sameAdjusted);
+
+	big.AdjustLevels(0.1f, 0.4f, 0.9f, 0.05f, 0.95f, true, tCompBit_G);
+	tPixel4b afterLevels = big.GetPixels()[100];
+	tRequire(afterLevels.R == tMath::tClamp(int(orig.GetPixels()[100].R) + offset, 0, 255));
+	big.AdjustRestoreOriginal();
+	tRequire(big == orig);
+	tRequire(big.AdjustmentEnd());
 }
 
 
@@ -1224,6 +1523,78 @@ tTestUnit(ImageMipmap)
 		tPrintf("Dim %dx%d Mip %d : %dx%d\n", width, height, m, mipWidth, mipHeight);
 		tRequire((correctWidths[m] == mipWidth) && (correctHeights[m] == mipHeight));
 	}
+
+	// Linear mipmaps. A black and white checkerboard must average to linear grey, which is 188 in sRGB, not 128.
+	tPicture checker(64, 33);
+	for (int y = 0; y < checker.GetHeight(); y++)
+		for (int x = 0; x < checker.GetWidth(); x++)
+			checker.SetPixel(x, y, ((x+y) & 1) ? tPixel4b::white : tPixel4b::black);
+
+	tList<tLayer> gammaLayers;
+	tList<tLayer> linearLayers;
+	int numGamma = checker.GenerateLayers(gammaLayers, tImage::tResampleFilter::Box);
+	int numLinear = checker.GenerateLayersLinear(linearLayers, tImage::tResampleFilter::Box);
+	tRequire(numLinear == numGamma);
+	bool sameDims = (numLinear == numGamma);
+	for (tLayer* g = gammaLayers.First(), *l = linearLayers.First(); g && l; g = g->Next(), l = l->Next())
+		if ((g->Width != l->Width) || (g->Height != l->Height) || (l->PixelFormat != tPixelFormat::R8G8B8A8))
+			sameDims = false;
+	tRequire(sameDims);
+
+	tLayer* mip1 = linearLayers.First()->Next();
+	tPixel4b grey = ((tPixel4b*)mip1->Data)[mip1->Width*3 + 5];
+	tPrintf("Linear checkerboard mip 1 grey: %d\n", grey.R);
+	tRequire((grey.R >= 187) && (grey.R <= 189) && (grey.G == grey.R) && (grey.A == 255));
+
+	// A single colour stays the same at every level with every filter.
+	tPicture flat;
+	flat.Set(37, 20, tColour4b(200, 40, 90, 128));
+	bool flatSame = true;
+	for (int f = 0; f < int(tImage::tResampleFilter::NumFilters); f++)
+	{
+		tList<tLayer> flatLayers;
+		flat.GenerateLayersLinear(flatLayers, tImage::tResampleFilter(f), tImage::tResampleEdgeMode::Wrap);
+		for (tLayer* layer = flatLayers.First(); layer; layer = layer->Next())
+		{
+			tPixel4b* pixels = (tPixel4b*)layer->Data;
+			for (int p = 0; p < layer->Width*layer->Height; p++)
+				if
+				(
+					(tMath::tAbs(int(pixels[p].R) - 200) > 1) || (tMath::tAbs(int(pixels[p].G) - 40) > 1) ||
+					(tMath::tAbs(int(pixels[p].B) - 90) > 1) || (tMath::tAbs(int(pixels[p].A) - 128) > 1)
+				)
+					flatSame = false;
+		}
+	}
+	tRequire(flatSame);
+
+	// Six faces at once must give the same layers as one at a time on one thread.
+	tPicture faces[6];
+	tPicture* facePtrs[6];
+	for (int f = 0; f < 6; f++)
+	{
+		faces[f].Set(40 + f*8, 24, tPixel4b::black);
+		for (int p = 0; p < faces[f].GetNumPixels(); p++)
+			faces[f].GetPixels()[p] = tPixel4b(uint8(p*7 + f*31), uint8(p*3), uint8(p*11 + f), uint8(255 - p));
+		facePtrs[f] = &faces[f];
+	}
+	tList<tLayer> faceLayers[6];
+	int numFaceLayers = tPicture::GenerateLayersLinear(faceLayers, facePtrs, 6, tImage::tResampleFilter::Lanczos_Narrow);
+	int numSingleLayers = 0;
+	bool sameFaces = true;
+	for (int f = 0; f < 6; f++)
+	{
+		tList<tLayer> single;
+		numSingleLayers += faces[f].GenerateLayersLinear(single, tImage::tResampleFilter::Lanczos_Narrow, tImage::tResampleEdgeMode::Clamp, 1);
+		for (tLayer* a = single.First(), *b = faceLayers[f].First(); a || b; a = a->Next(), b = b->Next())
+			if (!a || !b || (*a != *b))
+			{
+				sameFaces = false;
+				break;
+			}
+	}
+	tRequire(numFaceLayers == numSingleLayers);
+	tRequire(sameFaces);
 }
 
 
@@ -1290,6 +1661,61 @@ tTestUnit(ImageFilter)
 }
 
 
+// Checks every frame of a stream against the frames loaded all at once, then jumps around to test the ring and going
+// back to the start.
+void TestFrameStream(const tString& file, tList<tFrame>& frames)
+{
+	tFrameStream::Params params;
+	params.RingSize = 2;
+	params.NumPrefetch = 3;
+	params.NumThreads = 2;
+	tFrameStream stream(file, params);
+	tRequire(stream.IsValid());
+	tRequire(stream.GetNumFrames() == frames.GetNumItems());
+	if (!stream.IsValid() || (stream.GetNumFrames() != frames.GetNumItems()))
+		return;
+
+	tFrame** loaded = new tFrame*[frames.GetNumItems()];
+	int f = 0;
+	for (tFrame* frame = frames.First(); frame; frame = frame->Next(), f++)
+		loaded[f] = frame;
+
+	auto matches = [&](int frameNum) -> bool
+	{
+		const tPixel4b* pixels = stream.GetPixels(frameNum);
+		tFrame* frame = loaded[frameNum];
+		if (!pixels || (frame->Width != stream.GetWidth()) || (frame->Height != stream.GetHeight()))
+			return false;
+		if (tMath::tAbs(stream.GetFrameDuration(frameNum) - frame->Duration) > 0.0001f)
+			return false;
+		return !tStd::tMemcmp(pixels, frame->Pixels, frame->Width*frame->Height*sizeof(tPixel4b));
+	};
+
+	bool same = true;
+	int numFrames = stream.GetNumFrames();
+	for (int n = 0; n < numFrames; n++)
+		same = matches(n) && same;
+	tRequire(same);
+
+	int jumps[] = { numFrames-1, 0, 1, numFrames/2, numFrames/2 - 1, numFrames-1, 0 };
+	bool sameJumping = true;
+	for (int j = 0; j < tNumElements(jumps); j++)
+		sameJumping = matches(tMath::tClamp(jumps[j], 0, numFrames-1)) && sameJumping;
+	tRequire(sameJumping);
+
+	// The pixels can also come from memory and as a new frame. No prefetching this time.
+	int numBytes = 0;
+	uint8* data = tSystem::tLoadFile(file, nullptr, &numBytes);
+	params.NumPrefetch = 0;
+	stream.Open(data, numBytes, tSystem::tGetFileType(file), params);
+	delete[] data;
+	tFrame* last = stream.GetFrame(numFrames-1);
+	tRequire(last && !tStd::tMemcmp(last->Pixels, loaded[numFrames-1]->Pixels, last->Width*last->Height*sizeof(tPixel4b)));
+	delete last;
+	delete[] loaded;
+}
+
+
 tTestUnit(ImageMultiFrame)
 {
 	if (!tSystem::tDirExists("TestData/Images/"))
@@ -1375,6 +1801,34 @@ tTestUnit(ImageMultiFrame)
 	tImageTIFF tiffDst2(webpSrc.Frames, true);
 	tiffDst2.Save("TestData/Images/WrittenAnimatedTestManyFrames.tiff");
 	tRequire(tSystem::tFileExists("TestData/Images/WrittenAnimatedTestManyFrames.tiff"));
+
+	// tFrameStream decodes frames only when they are asked for. They must match the frames loaded all at once.
+	tPrintf("Test frame streams.\n");
+	tList<tFrame> streamFrames;
+	tImageGIF gifSimple("TestData/Images/8-cell-simple.gif");
+	gifSimple.StealFrames(streamFrames);
+	TestFrameStream("TestData/Images/8-cell-simple.gif", streamFrames);
+	streamFrames.Empty();
+
+	tImageGIF gifIcos("TestData/Images/WrittenIcos4DManyFrames.gif");
+	gifIcos.StealFrames(streamFrames);
+	TestFrameStream("TestData/Images/WrittenIcos4DManyFrames.gif", streamFrames);
+	streamFrames.Empty();
+
+	tImageAPNG apngIcos("TestData/Images/Icos4D.apng");
+	apngIcos.StealFrames(streamFrames);
+	TestFrameStream("TestData/Images/Icos4D.apng", streamFrames);
+	streamFrames.Empty();
+
+	tImageAPNG apngFlame("TestData/Images/Flame.apng");
+	apngFlame.StealFrames(streamFrames);
+	TestFrameStream("TestData/Images/Flame.apng", streamFrames);
+	streamFrames.Empty();
+
+	tImageWEBP webpAnimated("TestData/Images/WEBP/AnimatedTest.webp");
+	webpAnimated.StealFrames(streamFrames);
+	TestFrameStream("TestData/Images/WEBP/AnimatedTest.webp", streamFrames);
+	streamFrames.Empty();
 }
 
 
@@ -1562,6 +2016,65 @@ tTestUnit(ImagePNG)
 	saveParams.Format = tImagePNG::tFormat::BPP48_RGB_BPC16;
 	png.Save("Written_R16G16B16_From_16BPC.png", saveParams); 
 
+	//
+	// Test parallel saves. They must load back the same as the SPNG saves and not depend on the number of threads.
+	// The image is big enough for many bands and is a gradient with noise so every filter gets picked somewhere.
+	//
+	const int parWidth = 700;
+	const int parHeight = 600;
+	tPixel4s* parPixels = new tPixel4s[parWidth*parHeight];
+	uint32 seed = 1234;
+	for (int y = 0; y < parHeight; y++)
+		for (int x = 0; x < parWidth; x++)
+		{
+			seed = seed*1664525u + 1013904223u;
+			int noise = (y < parHeight/2) ? int(seed >> 28) : int(seed >> 16);
+			parPixels[y*parWidth + x] = tColour4s(uint16(x*90 + noise), uint16(y*100), uint16((x*y) + noise), uint16(65535 - x*50));
+		}
+	tImagePNG parallelPNG(parPixels, parWidth, parHeight, true);
+	tRequire(parallelPNG.IsValid());
+
+	loadParams.Flags = 0;
+	tImagePNG::tFormat parFormats[] =
+	{
+		tImagePNG::tFormat::BPP24_RGB_BPC8, tImagePNG::tFormat::BPP32_RGBA_BPC8,
+		tImagePNG::tFormat::BPP48_RGB_BPC16, tImagePNG::tFormat::BPP64_RGBA_BPC16
+	};
+	for (tImagePNG::tFormat parFormat : parFormats)
+	{
+		saveParams.Reset();
+		saveParams.Format = parFormat;
+		tRequire(parallelPNG.Save("Written_Serial.png", saveParams) == parFormat);
+		tImagePNG serial("Written_Serial.png", loadParams);
+		tRequire(serial.IsValid());
+
+		for (int fast = 0; fast < 2; fast++)
+		{
+			tPrintf("Test Save Parallel Format %d Fast %d\n", int(parFormat), fast);
+			saveParams.Parallel = true;
+			saveParams.Fast = fast ? true : false;
+			saveParams.NumThreads = 1;
+			tRequire(parallelPNG.Save("Written_Parallel1.png", saveParams) == parFormat);
+			saveParams.NumThreads = 4;
+			tRequire(parallelPNG.Save("Written_Parallel4.png", saveParams) == parFormat);
+
+			int numBytes1 = 0; int numBytes4 = 0;
+			uint8* file1 = tSystem::tLoadFile("Written_Parallel1.png", nullptr, &numBytes1);
+			uint8* file4 = tSystem::tLoadFile("Written_Parallel4.png", nullptr, &numBytes4);
+			tRequire((numBytes1 == numBytes4) && !tStd::tMemcmp(file1, file4, numBytes1));
+			delete[] file1;
+			delete[] file4;
+
+			tImagePNG parallel("Written_Parallel4.png", loadParams);
+			tRequire(parallel.IsValid());
+			tRequire((parallel.GetWidth() == parWidth) && (parallel.GetHeight() == parHeight));
+			if (serial.GetPixels8())
+				tRequire(parallel.GetPixels8() && !tStd::tMemcmp(parallel.GetPixels8(), serial.GetPixels8(), parWidth*parHeight*sizeof(tPixel4b)));
+			else
+				tRequire(parallel.GetPixels16() && !tStd::tMemcmp(parallel.GetPixels16(), serial.GetPixels16(), parWidth*parHeight*sizeof(tPixel4s)));
+		}
+	}
+
 	tSystem::tSetCurrentDir(origDir.Chr());
 }
 
@@ -1846,6 +2359,78 @@ tTestUnit(ImageDDS)
 	DDSLoadDecodeSave("B10G11R11uf_RGB_Modern.dds",		revrow);
 	DDSLoadDecodeSave("E5B9G9R9uf_RGB_Modern.dds",		revrow);
 
+	// Direct packed conversions. These must agree with tHalf and the small float classes exactly.
+	tPrintf("Testing packed pixel-data conversion.\n");
+	const int numConv = 300*1024;
+	float* floats = new float[numConv*4];
+	uint32 seed = 4321;
+	for (int f = 0; f < numConv*4; f++)
+	{
+		seed = seed*1664525u + 1013904223u;
+		floats[f] = (float(seed >> 8) / float(1 << 24))*130.0f - 30.0f;
+	}
+
+	uint16* halves = new uint16[numConv*4];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R32G32B32A32f, (uint8*)floats, tPixelFormat::R16G16B16A16f, (uint8*)halves, numConv));
+	bool halvesMatch = true;
+	for (int f = 0; f < numConv*4; f++)
+		halvesMatch = halvesMatch && (halves[f] == FloatToHalfRaw(floats[f]));
+	tRequire(halvesMatch);
+
+	float* fromHalves = new float[numConv*4];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R16G16B16A16f, (uint8*)halves, tPixelFormat::R32G32B32A32f, (uint8*)fromHalves, numConv));
+	bool floatsMatch = true;
+	for (int f = 0; f < numConv*4; f++)
+		floatsMatch = floatsMatch && (fromHalves[f] == HalfRawToFloat(halves[f]));
+	tRequire(floatsMatch);
+
+	uint32* packed = new uint32[numConv];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R32G32B32A32f, (uint8*)floats, tPixelFormat::R11G11B10uf, (uint8*)packed, numConv, 1));
+	bool packedMatch = true;
+	for (int p = 0; p < numConv; p++)
+		packedMatch = packedMatch && (packed[p] == tPackedF11F11F10(floats[p*4+0], floats[p*4+1], floats[p*4+2]).Raw);
+	tRequire(packedMatch);
+
+	// B10G11R11uf has the same bits per channel so going there and back loses nothing. The half path never makes a float.
+	uint32* packedBGR = new uint32[numConv];
+	uint32* packedRGB = new uint32[numConv];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R11G11B10uf, (uint8*)packed, tPixelFormat::B10G11R11uf, (uint8*)packedBGR, numConv));
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::B10G11R11uf, (uint8*)packedBGR, tPixelFormat::R11G11B10uf, (uint8*)packedRGB, numConv));
+	tRequire(!tStd::tMemcmp(packed, packedRGB, numConv*sizeof(uint32)));
+
+	tColour4b* decodedLDR = nullptr;
+	tColour4f* decodedHDR = nullptr;
+	tRequire(tImage::DecodePixelData(tPixelFormat::B10G11R11uf, (uint8*)packedBGR, numConv*4, numConv, 1, decodedLDR, decodedHDR) == tImage::DecodeResult::Success);
+	bool decodeMatch = decodedHDR && !decodedLDR;
+	for (int p = 0; decodeMatch && (p < numConv); p++)
+	{
+		float r, g, b;
+		tPackedF10F11F11(packedBGR[p]).Get(b, g, r);
+		decodeMatch = (decodedHDR[p].R == r) && (decodedHDR[p].G == g) && (decodedHDR[p].B == b) && (decodedHDR[p].A == 1.0f);
+	}
+	tRequire(decodeMatch);
+	delete[] decodedHDR;
+
+	// Swizzles, missing channels, and the 16 bit packed formats.
+	uint8 rgba[8] = { 10, 20, 30, 40, 255, 128, 0, 7 };
+	uint8 bgr[6];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R8G8B8A8, rgba, tPixelFormat::B8G8R8, bgr, 2));
+	tRequire((bgr[0] == 30) && (bgr[1] == 20) && (bgr[2] == 10) && (bgr[3] == 0) && (bgr[4] == 128) && (bgr[5] == 255));
+	uint16 rgba16[8];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::B8G8R8, bgr, tPixelFormat::R16G16B16A16, (uint8*)rgba16, 2));
+	tRequire((rgba16[0] == 10*257) && (rgba16[2] == 30*257) && (rgba16[3] == 65535) && (rgba16[4] == 65535));
+	uint16 rgb565[2];
+	tRequire(tImage::ConvertPixelData_Packed(tPixelFormat::R8G8B8A8, rgba, tPixelFormat::G3B5R5G3, (uint8*)rgb565, 2));
+	tRequire(rgb565[1] == ((31 << 11) | (32 << 5) | 0));
+	tRequire(!tImage::CanConvertPixelData_Packed(tPixelFormat::R8G8B8A8, tPixelFormat::E5B9G9R9uf));
+
+	delete[] packedRGB;
+	delete[] packedBGR;
+	delete[] packed;
+	delete[] fromHalves;
+	delete[] halves;
+	delete[] floats;
+
 	tSystem::tSetCurrentDir(origDir.Chr());
 }
 
@@ -2275,6 +2860,79 @@ tTestUnit(ImageKTX2)
 	KTXLoadDecodeSave("B10G11R11uf_RGB.ktx2",			revrow);
 	KTXLoadDecodeSave("E5B9G9R9uf_RGB.ktx2",			revrow);
 
+	// Stream a mip chain out with tKTX2Writer, as is and Zstandard supercompressed on 1 and 4 threads, then read it
+	// back a level at a time. LibKTX must be able to load the written files too.
+	tPrintf("Testing KTX2 streaming writer and lazy reader.\n\n");
+	tImagePNG png("../TacentTestPattern.png");
+	tPicture pattern(png);
+	tList<tLayer> mips(tListMode::ListOwns);
+	int numMips = pattern.GenerateLayers(mips);
+	tRequire((numMips > 1) && (numMips <= 16));
+	tLayer* mipArray[16];
+	int numArray = 0;
+	for (tLayer* mip = mips.First(); mip; mip = mip->Next())
+		mipArray[numArray++] = mip;
+
+	for (int variant = 0; variant < 3; variant++)
+	{
+		tKTX2Writer::Params params;
+		params.Supercompress = (variant > 0);
+		params.NumThreads = (variant == 2) ? 4 : 1;
+		tString written = params.Supercompress ? "WrittenStreamZstd.ktx2" : "WrittenStream.ktx2";
+		tRequire(tKTX2Writer::Write(written, mips, params));
+
+		tKTX2Reader reader(written);
+		tRequire(reader.IsValid() && (reader.GetNumLevels() == numMips) && (reader.IsSupercompressed() == params.Supercompress));
+		tRequire((reader.GetPixelFormat() == tPixelFormat::R8G8B8A8) && reader.IsTopRowFirst());
+
+		// Smallest first to show the levels don't need to be read in order.
+		bool levelsMatch = true;
+		for (int level = numMips-1; level >= 0; level--)
+		{
+			bool reversed = false;
+			tLayer* layer = reader.GetLevel(level, 0, true, &reversed);
+			if (!layer || !reversed || (layer->Width != mipArray[level]->Width) || (layer->Height != mipArray[level]->Height) ||
+				tStd::tMemcmp(layer->Data, mipArray[level]->Data, mipArray[level]->GetDataSize()))
+				levelsMatch = false;
+			delete layer;
+		}
+		tRequire(levelsMatch);
+		tRequire(!reader.GetLevel(numMips) && !reader.GetLevel(0, 1));
+
+		tImageKTX::LoadParams loadParams;
+		loadParams.Flags = tImageKTX::LoadFlag_ReverseRowOrder;
+		tImageKTX ktx(written, loadParams);
+		tRequire(ktx.IsValid() && (ktx.GetNumMipmapLevels() == numMips));
+		tRequire(!tStd::tMemcmp(ktx.GetLayer(numMips-1, 0)->Data, mipArray[numMips-1]->Data, mipArray[numMips-1]->GetDataSize()));
+		tRequire(!tStd::tMemcmp(ktx.GetLayer(0, 0)->Data, mipArray[0]->Data, mipArray[0]->GetDataSize()));
+	}
+
+	// A level whose uncompressed length doesn't match its dimensions is refused instead of being allocated. The level
+	// index follows the 80 byte header and each entry is the offset, length, and uncompressed length as uint64s.
+	int damagedSize = 0;
+	uint8* damaged = tSystem::tLoadFile("WrittenStreamZstd.ktx2", nullptr, &damagedSize);
+	tRequire(damaged && (damagedSize > 128));
+	uint64 hugeLength = uint64(1) << 40;
+	tStd::tMemcpy(damaged + 96, &hugeLength, sizeof(hugeLength));
+	tRequire(tSystem::tCreateFile("WrittenStreamDamaged.ktx2", damaged, damagedSize));
+	delete[] damaged;
+	tKTX2Reader damagedReader("WrittenStreamDamaged.ktx2");
+	tLayer* damagedLevel = damagedReader.GetLevel(1);
+	tRequire(damagedReader.IsValid() && !damagedReader.GetLevel(0) && damagedLevel);
+	delete damagedLevel;
+
+	// Levels may be added in any order, but all of them must be added or no file is left behind.
+	tKTX2Writer::Params zstdParams;
+	zstdParams.Supercompress = true;
+	tKTX2Writer writer;
+	tRequire(writer.Open("WrittenStreamPartial.ktx2", tPixelFormat::R8G8B8A8, pattern.GetWidth(), pattern.GetHeight(), numMips, zstdParams));
+	for (int level = numMips-1; level >= 1; level--)
+		tRequire(writer.AddLevel(level, *mipArray[level]));
+	tRequire(!writer.AddLevel(1, *mipArray[1]));
+	tRequire(!writer.AddLevel(0, *mipArray[1]));
+	tRequire(!writer.Close());
+	tRequire(!tSystem::tFileExists("WrittenStreamPartial.ktx2"));
+
 	tSystem::tSetCurrentDir(origDir.Chr());
 }
 
@@ -583,6 +583,23 @@ tTestUnit(Geometry)
 	intersects = tIntersectTestRayTriangle(ray, tri);
 	tPrintf("Ray intersects triangle: %s\n", intersects ? "true" : "false");
 	tRequire(!intersects);
+
+	tABox box(tVector3(-1.0f, -1.0f, -1.0f), tVector3(1.0f, 1.0f, 1.0f));
+	tRequire(tApproxEqual(box.ComputeSurfaceArea(), 24.0f));
+	tRequire(box.Overlaps(tABox(tVector3(0.5f, 0.5f, 0.5f), tVector3(2.0f, 2.0f, 2.0f))));
+	tRequire(!box.Overlaps(tABox(tVector3(1.5f, 0.5f, 0.5f), tVector3(2.0f, 2.0f, 2.0f))));
+	tRequire(tIntersectTestSphereBox(tSphere(tVector3(2.0f, 0.0f, 0.0f), 1.5f), box));
+	tRequire(!tIntersectTestSphereBox(tSphere(tVector3(2.0f, 2.0f, 0.0f), 1.0f), box));
+
+	float t = 0.0f;
+	ray.Start.Set(-5.0f, 0.0f, 0.0f);
+	ray.Dir.Set(1.0f, 0.0f, 0.0f);
+	intersects = tIntersectFindRayBox(t, ray, box);
+	tPrintf("Ray intersects box: %s  t: %f\n", intersects ? "true" : "false", t);
+	tRequire(intersects && tApproxEqual(t, 4.0f));
+	tRequire(!tIntersectFindRayBox(t, ray, box, 3.0f));
+	ray.Dir.Set(-1.0f, 0.0f, 0.0f);
+	tRequire(!tIntersectFindRayBox(t, ray, box));
 }
 
 
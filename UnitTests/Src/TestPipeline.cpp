@@ -16,6 +16,7 @@
 #include <System/tTime.h>
 #include <Pipeline/tProcess.h>
 #include <Pipeline/tRule.h>
+#include <Pipeline/tRuleGraph.h>
 #include "UnitTests.h"
 using namespace tPipeline;
 namespace tUnitTest
@@ -62,6 +63,26 @@ tTestUnit(Process)
 		tPrintf("We expect an error here since an invalid directory was passed on purpose.\n");
 	}
 	tRequire(exitCode != 0);
+
+	#elif defined(PLATFORM_LINUX)
+	ulong exitCode = 0;
+	tString output;
+	tProcess("ls", "TestData/", output, &exitCode);
+	tPrintf("Output:\n[\n%s\n]\n", output.Pod());
+	tRequire((exitCode == 0) && output.IsValid());
+
+	tProcess("ls", "TestData/DoesNotExist/", output, &exitCode);
+	tRequire(exitCode != 0);
+
+	// Stdout and stderr can go to separate callbacks. The non-blocking process is done when the destructor returns.
+	struct Capture { tString Out; tString Err; int Exit = -1; } capture;
+	auto onExit = [](void* user, int code) { ((Capture*)user)->Exit = code; };
+	auto onOut = [](void* user, const char* text) { ((Capture*)user)->Out += text; };
+	auto onErr = [](void* user, const char* text) { ((Capture*)user)->Err += text; };
+	tProcess* process = new tProcess("echo out; echo err 1>&2; exit 3", tString(), onExit, &capture, onOut, &capture, onErr, &capture);
+	delete process;
+	tRequire(capture.Exit == 3);
+	tRequire((capture.Out == "out\n") && (capture.Err == "err\n"));
 	#endif
 }
 
@@ -94,6 +115,144 @@ tTestUnit(Rule)
 	tr.SetTarget("WrittenOlderFile.txt");
 	localRules.Head()->AddDep("TestData/WrittenNewerFile.txt");
 	tRequire(tr.OutOfDate());
+
+	// The stat-once version with a stamp cache. There are enough dependencies for them to be checked in parallel.
+	tString dir = "TestData/StampCache/";
+	tSystem::tDeleteDir(dir);
+	tSystem::tCreateDir(dir);
+	tSystem::tCreateFile(dir + "Target.txt", "Target");
+	tSystem::tSleep(20);
+	TestRule big(0);
+	big.SetTarget(dir + "Target.txt");
+	for (int d = 0; d < 600; d++)
+	{
+		tString dep = tsrPrintf("%sDep%03d.txt", dir.Chr(), d);
+		tSystem::tCreateFile(dep, dep);
+		big.AddDep(dep);
+	}
+	tStampCache stamps(4);
+	tRequire(big.OutOfDate(stamps));
+	tRequire(big.OutOfDate());
+
+	tSystem::tSleep(20);
+	tSystem::tCreateFile(dir + "Target.txt", "Rebuilt Target");
+	stamps.Invalidate(dir + "Target.txt");
+	tRequire(!big.OutOfDate(stamps));
+	tRequire(!big.OutOfDate());
+
+	tSystem::tDeleteFile(dir + "Dep300.txt");
+	stamps.Clear();
+	bool threw = false;
+	try
+	{
+		big.OutOfDate(stamps);
+	}
+	catch (tRuleError& error)
+	{
+		tPrintf("%s\n", error.Message.Pod());
+		threw = true;
+	}
+	tRequire(threw);
+	tSystem::tDeleteDir(dir);
+}
+
+
+// Writes the target with the contents of all its dependencies.
+struct ConcatRule : public tPipeline::tRule
+{
+	ConcatRule(const tString& target, const tString& depA, const tString& depB = tString(), bool fail = false) : Fail(fail)
+	{
+		SetTarget(target);
+		AddGenDep(depA);
+		if (depB.IsValid())
+			AddGenDep(depB);
+	}
+
+	void Build() override
+	{
+		if (Fail)
+			throw tRuleError("Failing on purpose.");
+
+		tString contents;
+		for (tStringItem* dep = Dependencies.First(); dep; dep = dep->Next())
+		{
+			int size = 0;
+			uint8* data = tSystem::tLoadFile(*dep, nullptr, &size);
+			contents += tString((const char*)data, size);
+			delete[] data;
+		}
+		tSystem::tCreateFile(Target, contents);
+	}
+	bool Fail;
+};
+
+
+tTestUnit(RuleGraph)
+{
+	if (!tSystem::tDirExists("TestData/"))
+		tSkipUnit(RuleGraph)
+
+	tString dir = "TestData/RuleGraph/";
+	tSystem::tDeleteDir(dir);
+	tSystem::tCreateDir(dir);
+	tSystem::tCreateFile(dir + "A.txt", "A");
+
+	// Added out of order on purpose. E depends on C and D, C on B, and B and D on the source file A.
+	ConcatRule ruleE(dir + "E.txt", dir + "C.txt", dir + "D.txt");
+	ConcatRule ruleC(dir + "C.txt", dir + "B.txt");
+	ConcatRule ruleB(dir + "B.txt", dir + "A.txt");
+	ConcatRule ruleD(dir + "D.txt", dir + "A.txt");
+	tRuleGraph graph;
+	graph.AddRule(&ruleE);
+	graph.AddRule(&ruleC);
+	graph.AddRule(&ruleB);
+	graph.AddRule(&ruleD);
+	tRequire(graph.Build(4));
+	tRequire(graph.GetNumBuilt() == 4);
+	tRequire(graph.GetState(&ruleE) == tRuleGraph::tState::Built);
+
+	int size = 0;
+	uint8* data = tSystem::tLoadFile(dir + "E.txt", nullptr, &size);
+	tRequire((size == 2) && (data[0] == 'A') && (data[1] == 'A'));
+	delete[] data;
+
+	// Nothing changed so nothing gets built.
+	tRequire(graph.Build(4));
+	tRequire(graph.GetNumBuilt() == 0);
+	tRequire(graph.GetState(&ruleC) == tRuleGraph::tState::UpToDate);
+
+	// A failure skips everything downstream but independent rules still build.
+	tSystem::tSleep(20);
+	tSystem::tCreateFile(dir + "A.txt", "a");
+	ConcatRule ruleF(dir + "F.txt", dir + "B.txt", tString(), true);
+	ConcatRule ruleG(dir + "G.txt", dir + "F.txt");
+	graph.AddRule(&ruleF);
+	graph.AddRule(&ruleG);
+	tRequire(!graph.Build(2));
+	tRequire((graph.GetNumFailed() == 1) && (graph.GetErrors().GetNumItems() == 1));
+	tRequire(graph.GetState(&ruleF) == tRuleGraph::tState::Failed);
+	tRequire(graph.GetState(&ruleG) == tRuleGraph::tState::Skipped);
+	tRequire(graph.GetState(&ruleE) == tRuleGraph::tState::Built);
+
+	// Cycles are found before anything is built.
+	tRuleGraph cyclic;
+	ConcatRule ruleX(dir + "X.txt", dir + "Y.txt");
+	ConcatRule ruleY(dir + "Y.txt", dir + "X.txt");
+	cyclic.AddRule(&ruleX);
+	cyclic.AddRule(&ruleY);
+	bool threw = false;
+	try
+	{
+		cyclic.Build();
+	}
+	catch (tRuleError& error)
+	{
+		tPrintf("%s\n", error.Message.Pod());
+		threw = true;
+	}
+	tRequire(threw && !tSystem::tFileExists(dir + "X.txt"));
+
+	tSystem::tDeleteDir(dir);
 }
 
 
@@ -20,4 +20,5 @@ namespace tUnitTest
 {
 	tTestUnit(Process);
 	tTestUnit(Rule);
+	tTestUnit(RuleGraph);
 }
@@ -12,8 +12,13 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <Foundation/tMemory.h>
 #include <Scene/tWorld.h>
+#include <Scene/tBVH.h>
+#include <Scene/tSimplify.h>
 #include "UnitTests.h"
+using namespace tMath;
+using namespace tScene;
 namespace tUnitTest
 {
 
@@ -24,4 +29,280 @@ tTestUnit(World)
 }
 
 
+tTestUnit(PolyModel)
+{
+	// Seven vertices and five faces so both the vector path and the remainder loop are used.
+	tPolyModel model;
+	model.Mesh.NumVertPositions = 7;
+	model.Mesh.VertTablePositions = new tVector3[7];
+	tVector3* pos = model.Mesh.VertTablePositions;
+	pos[0].Set( 0.0f,  0.0f,  1.0f);		pos[1].Set( 2.0f,  0.0f,  0.0f);		pos[2].Set( 0.0f,  3.0f,  0.0f);
+	pos[3].Set(-1.0f, -2.0f,  0.0f);		pos[4].Set( 0.0f,  0.0f, -4.0f);		pos[5].Set( 1.0f,  1.0f,  1.0f);
+	pos[6].Set( 0.0f,  5.0f,  0.0f);
+
+	model.Mesh.NumFaces = 5;
+	model.Mesh.FaceTableVertPositionIndices = new tTriFace[5];
+	tTriFace* faces = model.Mesh.FaceTableVertPositionIndices;
+	int indices[5][3] = { {0, 1, 2}, {0, 2, 3}, {1, 4, 2}, {3, 4, 1}, {2, 6, 2} };
+	for (int f = 0; f < 5; f++)
+		for (int i = 0; i < 3; i++)
+			faces[f].Index[i] = indices[f][i];
+	model.Mesh.Modified();
+
+	// Brute force reference values.
+	tBox refBox;
+	float refMin = fInfinity, refMax = 0.0f, refArea = 0.0f;
+	for (int v = 0; v < model.Mesh.NumVertPositions; v++)
+	{
+		refBox.AddPoint(pos[v]);
+		refMin = tMin(refMin, pos[v].Length());
+		refMax = tMax(refMax, pos[v].Length());
+	}
+	for (int f = 0; f < model.Mesh.NumFaces; f++)
+		refArea += ((pos[faces[f].Index[1]] - pos[faces[f].Index[0]]) % (pos[faces[f].Index[2]] - pos[faces[f].Index[0]])).Length() / 2.0f;
+
+	float minRadius, maxRadius;
+	model.ComputeMinMaxRadius(minRadius, maxRadius);
+	tBox box = model.ComputeBoundingBox();
+	tPrintf("MinRadius:%f MaxRadius:%f Area:%f\n", minRadius, maxRadius, model.ComputeApproxArea());
+	tRequire(tApproxEqual(minRadius, refMin) && tApproxEqual(maxRadius, refMax));
+	tRequire(tApproxEqual(model.ComputeBoundingRadius(), refMax));
+	tRequire(box.Min == refBox.Min && box.Max == refBox.Max);
+	tRequire(tApproxEqual(model.ComputeApproxArea(), refArea, 0.001f));
+
+	// The last face is degenerate and contributes nothing.
+	float area = model.ComputeApproxArea();
+	tRequire(area == area);
+
+	// Scaling updates the cached values without recomputing.
+	model.Scale(-2.0f);
+	box = model.ComputeBoundingBox();
+	tRequire(tApproxEqual(box.Min.x, -4.0f) && tApproxEqual(box.Max.x, 2.0f));
+	tRequire(tApproxEqual(box.Min.z, -2.0f) && tApproxEqual(box.Max.z, 8.0f));
+	tRequire(tApproxEqual(model.ComputeBoundingRadius(), refMax*2.0f));
+	tRequire(tApproxEqual(model.ComputeApproxArea(), refArea*4.0f, 0.001f));
+
+	// Direct table edits followed by Modified invalidate the cache.
+	pos[6].Set(0.0f, -20.0f, 0.0f);
+	model.Mesh.Modified();
+	tRequire(tApproxEqual(model.ComputeBoundingBox().Min.y, -20.0f));
+	tRequire(tApproxEqual(model.ComputeBoundingRadius(), 20.0f));
+
+	// The bounds are saved with the model and are valid after loading.
+	float savedArea = model.ComputeApproxArea();
+	tBox savedBox = model.ComputeBoundingBox();
+	const int bufSize = 4096;
+	uint8* buffer = (uint8*)tMem::tMalloc(bufSize, tChunkReader::GetBufferAlignmentNeeded());
+	int numWritten = 0;
+	{
+		tChunkWriter writer(buffer, bufSize);
+		model.Save(writer);
+		numWritten = writer.GetNumBytesWritten();
+	}
+
+	tChunkReader reader(buffer, numWritten);
+	tPolyModel loaded(reader.Chunk());
+	tRequire(loaded.Mesh.NumVertPositions == 7);
+	tRequire(tApproxEqual(loaded.ComputeApproxArea(), savedArea));
+	tRequire(loaded.ComputeBoundingBox().Min == savedBox.Min && loaded.ComputeBoundingBox().Max == savedBox.Max);
+
+	// Copies keep the cached values.
+	tPolyModel copy;
+	copy = loaded;
+	tRequire(tApproxEqual(copy.ComputeBoundingRadius(), 20.0f));
+
+	tMem::tFree(buffer);
+
+	// A copy constructed after a modification must not pick up the stale cached values.
+	tPolyModel single;
+	single.Mesh.NumVertPositions = 1;
+	single.Mesh.VertTablePositions = new tVector3[1];
+	single.Mesh.VertTablePositions[0].Set(1.0f, 0.0f, 0.0f);
+
+	// A copied mesh always ends up at the same revision. Caching at that revision is the case where a copy that kept
+	// the source's cache revision would wrongly trust it.
+	tMesh fresh(single.Mesh);
+	while (single.Mesh.GetRevision() < fresh.GetRevision())
+		single.Mesh.Modified();
+	tRequire(tApproxEqual(single.ComputeBoundingRadius(), 1.0f));
+	single.Mesh.VertTablePositions[0].Set(10.0f, 0.0f, 0.0f);
+	single.Mesh.Modified();
+	tPolyModel constructed(single);
+	tRequire(tApproxEqual(constructed.ComputeBoundingRadius(), 10.0f));
+}
+
+
+// A flat grid of quads in the xy plane with a UV seam down the middle. The UVs on the right of the seam are offset by
+// one so each corner's UV tells which side of the seam its face was on.
+static void BuildSeamGrid(tMesh& mesh, int cells)
+{
+	int side = cells + 1;
+	mesh.SetNumVertPositions(side*side);
+	mesh.CreateVertTablePositions();
+	mesh.SetNumVertUVs(side*side*2);
+	mesh.CreateVertTableUVs();
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			int v = y*side + x;
+			mesh.VertTablePositions[v].Set(float(x), float(y), 0.0f);
+			mesh.VertTableUVs[v].Set(float(x)/float(cells), float(y)/float(cells));
+			mesh.VertTableUVs[side*side + v].Set(float(x)/float(cells) + 1.0f, float(y)/float(cells));
+		}
+	}
+
+	mesh.SetNumFaces(cells*cells*2);
+	mesh.CreateFaceTableVertPositionIndices();
+	mesh.CreateFaceTableUVIndices();
+	int f = 0;
+	for (int y = 0; y < cells; y++)
+	{
+		for (int x = 0; x < cells; x++)
+		{
+			int v = y*side + x;
+			int quad[2][3] = { { v, v+1, v+side+1 }, { v, v+side+1, v+side } };
+			int uvOffset = (x >= cells/2) ? side*side : 0;
+			for (int t = 0; t < 2; t++, f++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					mesh.FaceTableVertPositionIndices[f].Index[c] = quad[t][c];
+					mesh.FaceTableUVIndices[f].Index[c] = quad[t][c] + uvOffset;
+				}
+			}
+		}
+	}
+}
+
+
+tTestUnit(Simplify)
+{
+	const int cells = 16;
+	tMesh grid;
+	BuildSeamGrid(grid, cells);
+
+	tMesh simple;
+	tSimplifyParams params;
+	params.TargetRatio = 0.25f;
+	int numFaces = tSimplify(simple, grid, params);
+	tPrintf("Simplified %d faces to %d. Positions:%d UVs:%d\n", grid.NumFaces, numFaces, simple.NumVertPositions, simple.NumVertUVs);
+	tRequire(numFaces == simple.NumFaces);
+	tRequire(numFaces <= grid.NumFaces/4);
+	tRequire(simple.NumVertPositions < grid.NumVertPositions);
+
+	// Every face must be valid, keep its winding, and stay entirely on one side of the seam.
+	bool valid = true;
+	bool seamKept = true;
+	tBox box;
+	for (int f = 0; f < simple.NumFaces; f++)
+	{
+		const tTriFace& face = simple.FaceTableVertPositionIndices[f];
+		const tTriFace& uvFace = simple.FaceTableUVIndices[f];
+		for (int c = 0; c < 3; c++)
+		{
+			if ((face.Index[c] < 0) || (face.Index[c] >= simple.NumVertPositions) || (uvFace.Index[c] < 0) || (uvFace.Index[c] >= simple.NumVertUVs))
+				valid = false;
+		}
+		if (!valid)
+			break;
+
+		const tVector3* pos = simple.VertTablePositions;
+		tVector3 normal = (pos[face.Index[1]] - pos[face.Index[0]]) % (pos[face.Index[2]] - pos[face.Index[0]]);
+		if (normal.z <= 0.0f)
+			valid = false;
+
+		float centroidX = (pos[face.Index[0]].x + pos[face.Index[1]].x + pos[face.Index[2]].x) / 3.0f;
+		float expectedOffset = (centroidX >= float(cells/2)) ? 1.0f : 0.0f;
+		for (int c = 0; c < 3; c++)
+		{
+			box.AddPoint(pos[face.Index[c]]);
+			float offset = simple.VertTableUVs[uvFace.Index[c]].x - pos[face.Index[c]].x/float(cells);
+			if (!tApproxEqual(offset, expectedOffset, 0.001f))
+				seamKept = false;
+		}
+	}
+	tRequire(valid);
+	tRequire(seamKept);
+	tRequire(box.Min == tVector3(0.0f, 0.0f, 0.0f) && box.Max == tVector3(float(cells), float(cells), 0.0f));
+
+	// LOD group generation.
+	tWorld world;
+	for (int m = 0; m < 2; m++)
+	{
+		tPolyModel* model = new tPolyModel();
+		model->ID = m;
+		model->Name = (m == 0) ? "Rock" : "Tree";
+		BuildSeamGrid(model->Mesh, cells);
+		world.InsertPolyModel(model);
+	}
+
+	float ratios[] = { 1.0f, 0.5f, 0.25f };
+	float thresholds[] = { 0.5f, 0.2f, 0.05f };
+	int numGroups = world.GenerateLodGroupsFromSimplification(3, ratios, thresholds);
+	tRequire(numGroups == 2);
+	tRequire(world.GetNumModels() == 6);
+
+	tLodGroup* group = world.FindLodGroup("Tree");
+	tRequire(group && (group->GetNumLodInfos() == 3));
+	tRequire(world.FindPolyModel("Tree")->IsLodGroupMember);
+	tPolyModel* lod = world.FindPolyModel("Tree_LOD_20");
+	tRequire(lod && lod->IsLodGroupMember && (lod->Mesh.NumFaces <= cells*cells));
+	tRequire(group && (group->LodParams.Head()->ModelID == world.FindPolyModel("Tree")->ID));
+
+	// Running again does nothing since every model is now in a group.
+	tRequire(world.GenerateLodGroupsFromSimplification(3, ratios, thresholds) == 0);
+}
+
+
+tTestUnit(BVH)
+{
+	tWorld world;
+
+	// A single unit-cube model instanced along the x-axis every 10 units.
+	tPolyModel* model = new tPolyModel();
+	model->ID = 0;
+	model->Mesh.NumVertPositions = 2;
+	model->Mesh.VertTablePositions = new tVector3[2];
+	model->Mesh.VertTablePositions[0].Set(-0.5f, -0.5f, -0.5f);
+	model->Mesh.VertTablePositions[1].Set(0.5f, 0.5f, 0.5f);
+	world.InsertPolyModel(model);
+
+	const int numInstances = 1000;
+	for (int i = 0; i < numInstances; i++)
+	{
+		tInstance* inst = new tInstance();
+		inst->ID = i;
+		inst->ObjectType = tInstance::tType::PolyModel;
+		inst->ObjectID = model->ID;
+		inst->Transform.MakeTranslate(tVector3(float(i)*10.0f, 0.0f, 0.0f));
+		world.InsertInstance(inst);
+	}
+
+	tBVH bvh(world);
+	tPrintf("BVH Items:%d Nodes:%d\n", bvh.GetNumItems(), bvh.GetNumNodes());
+	tRequire(bvh.GetNumItems() == numInstances);
+
+	tArray<tInstance*> found;
+	tRequire(bvh.FindSphere(found, tSphere(tVector3(100.0f, 0.0f, 0.0f), 1.0f)) == 1);
+	tRequire(found[0]->ID == 10);
+
+	found.Clear();
+	tRequire(bvh.FindBox(found, tABox(tVector3(-1.0f, -1.0f, -1.0f), tVector3(95.0f, 1.0f, 1.0f))) == 10);
+
+	float t = 0.0f;
+	tInstance* nearest = bvh.FindRayNearest(t, tRay(tVector3(-100.0f, 0.0f, 0.0f), tVector3(1.0f, 0.0f, 0.0f)));
+	tRequire(nearest && (nearest->ID == 0) && tApproxEqual(t, 99.5f));
+
+	// Move an instance far away and refit just it.
+	tInstance* moved = world.FindInstance(uint32(500));
+	moved->Transform.MakeTranslate(tVector3(0.0f, 1000.0f, 0.0f));
+	tRequire(bvh.Refit(moved));
+	found.Clear();
+	tRequire(bvh.FindSphere(found, tSphere(tVector3(0.0f, 1000.0f, 0.0f), 1.0f)) == 1);
+	found.Clear();
+	tRequire(bvh.FindSphere(found, tSphere(tVector3(5000.0f, 0.0f, 0.0f), 1.0f)) == 0);
+}
+
+
 }
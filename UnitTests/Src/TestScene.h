@@ -19,4 +19,7 @@
 namespace tUnitTest
 {
 	tTestUnit(Scene);
+	tTestUnit(PolyModel);
+	tTestUnit(Simplify);
+	tTestUnit(BVH);
 }
@@ -12,6 +12,9 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <atomic>
+#include <thread>
+#include <filesystem>
 #include <Foundation/tVersion.cmake.h>
 #include <Foundation/tAssert.h>
 #include <Foundation/tMemory.h>
@@ -27,6 +30,7 @@
 #include <System/tRegex.h>
 #include <System/tScript.h>
 #include <System/tChunk.h>
+#include <System/tHashCache.h>
 #include <System/tTime.h>
 #include "UnitTests.h"
 #pragma warning (disable: 4723)
@@ -228,6 +232,10 @@ void PrintTest(const char* format, ...)
 }
 
 
+// Compares the compile-time format functions against the regular ones. The format must be a string literal.
+#define StaticPrintCompare(format, ...) (tsrPrintf<format>(__VA_ARGS__) == tsrPrintf(format __VA_OPT__(,) __VA_ARGS__))
+
+
 template<typename T> static tString ConvertToString(T value)
 {
 	tString valStr = tsrPrint(value);
@@ -563,6 +571,97 @@ tTestUnit(Print)
 	tRequire(ConvertToString(tVector3(1.0f, 2.0f, 3.0f))			== "(1.0000, 2.0000, 3.0000)");
 	tRequire(ConvertToString(tVector4(1.0f, 2.0f, 3.0f, 4.0f))		== "(1.0000, 2.0000, 3.0000, 4.0000)");
 	tRequire(ConvertToString(tQuaternion(1.0f, 2.0f, 3.0f, 4.0f))	== "(1.0000, 2.0000, 3.0000, 4.0000)");
+
+	// Compile-time format strings must print exactly what the regular functions do.
+	tint128 i128 = -67;
+	tuint256 u256 = 70;
+	int64 i64 = -42;
+	tRequire(StaticPrintCompare("Hex %#010X %#010x %04x", 0x0123ABCD, 0, 0xFFFFF101));
+	tRequire(StaticPrintCompare("%|64d %016|64X %016!8X %016:2X", i64, u64, u64, u64));
+	tRequire(StaticPrintCompare("%0_64|64b %0_24:2o %08b %_b", u64, u64, u8, u32));
+	tRequire(StaticPrintCompare("%'d %+d % d %.6d %-10d| %010d", 123456789, 42, 42, 1234, -42, -42));
+	tRequire(StaticPrintCompare("%|128d %064|256X %'|128d", i128, u256, i128));
+	tRequire(StaticPrintCompare("%*d|%-*.*f|%.*s", 6, 42, 12, 3, 3.14159, 2, "xyz"));
+	tRequire(StaticPrintCompare("%-8s|%8s|%.3s|%s", "ab", "cd", "xyz123", tPod(test)));
+	tRequire(StaticPrintCompare("%c%c%3c %B %_B %'B %8B", 65, 'b', 'c', true, false, true, false));
+	tRequire(StaticPrintCompare("%f %f %010f %-010f| %+.2f % f %.0f", 42.5f, -1234.5678, 42.0f, 42.0f, 1.0f, 2.0, 0.5));
+	tRequire(StaticPrintCompare("%e %.2e %g %g %.2g", 1234.5678, -0.000123, 0.00012, 123456789.0, 98.765));
+	tRequire(StaticPrintCompare("%:2v %.3v %06.2:4v %_:4v", v2.Pod(), tPod(v3), tPod(v4), v4.Pod()));
+	tRequire(StaticPrintCompare("%q %_q %05.2m %_m %_:4m", tPod(quat), tPod(quat), tPod(mat), tPod(mat), tPod(mat2x2)));
+	tRequire(StaticPrintCompare("%p %p", &test, (void*)nullptr));
+	tRequire(StaticPrintCompare("100%% %^ done"));
+	tRequire(StaticPrintCompare("%0300d|%-300s|", 7, "long"));
+
+	// The checks happen while compiling.
+	tStaticAssert((tPrintInternal::IsMatch<"%|64d %s %s", int64, const char*, tString>()));
+	tStaticAssert((!tPrintInternal::IsMatch<"%d", int64>()));
+	tStaticAssert((!tPrintInternal::IsMatch<"%d", float>()));
+	tStaticAssert((!tPrintInternal::IsMatch<"%:4v", tVec3>()));
+	tStaticAssert((!tPrintInternal::IsMatch<"%d %d", int>()));
+	tStaticAssert(!tPrintInternal::Program<"Trailing %5">.Valid);
+
+	tString str;
+	tsPrintf<"%s has %d items">(str, test, 42);
+	tRequire(str == "This is the tString. has 42 items");
+	tsaPrintf<" and %05.1f%%">(str, 99.5f);
+	tRequire(str == "This is the tString. has 42 items and 099.5%");
+	tRequire(tcPrintf<"%|64d">(i64) == 3);
+	char small[8];
+	int count = tsPrintf<"%s world">(small, 8, "hello");
+	tRequire((count == 7) && !tStd::tStrcmp(small, "hello w"));
+	tsPrintf<"%0400d">(str, 5);
+	tRequire((str.Length() == 400) && (str[399] == '5'));
+
+	// Channels that aren't visible are skipped before any formatting happens.
+	tChannel channels = tGetChannels();
+	tSetChannels(tChannel_TestResult);
+	tRequire(tPrintf(tChannel_User7, "Hidden %d\n", 42) == 0);
+	tRequire(tPrintf(tChannel_TestResult, "Visible %d\n", 42) == 11);
+	tRequire(tPrintf<"Hidden %d\n">(tChannel_User7, 42) == 0);
+	tRequire(tPrintf<"Visible %d\n">(tChannel_TestResult, 42) == 11);
+	tSetChannels(channels | tChannel_TestResult);
+
+	// Asynchronous output from a few threads to a log file. The requirements print too, so they are only checked
+	// once async output is stopped.
+	tString logFile = "TestData/WrittenAsyncOutput.log";
+	bool started = tStartAsyncOutput(logFile) && tIsAsyncOutput();
+	std::thread printers[4];
+	for (int t = 0; t < 4; t++)
+		printers[t] = std::thread([t]() { for (int l = 0; l < 100; l++) tPrintf(tChannel_TestResult, "Thread %d Line %d\n", t, l); });
+	for (int t = 0; t < 4; t++)
+		printers[t].join();
+	tFlushAsyncOutput();
+	tString logText;
+	tLoadFile(logFile, logText);
+	tStopAsyncOutput();
+	tRequire(started && !tIsAsyncOutput());
+	tRequire((logText.CountChar('\n') == 400) && (tGetNumDroppedOutput() == 0));
+	int line98 = logText.FindString("Thread 2 Line 98\n");
+	tRequire((line98 != -1) && (logText.FindString("Thread 2 Line 99\n") > line98));
+
+	// Threads that come and go reuse the ring buffers of threads that have exited, along with any text still in them.
+	started = tStartAsyncOutput(logFile);
+	for (int t = 0; t < 64; t++)
+		std::thread([t]() { tPrintf(tChannel_TestResult, "Thread %d Exiting\n", t); }).join();
+	tStopAsyncOutput();
+	tLoadFile(logFile, logText);
+	int exit62 = logText.FindString("Thread 62 Exiting\n");
+	tRequire(started && (logText.CountChar('\n') == 64) && (exit62 != -1));
+	tRequire(logText.FindString("Thread 63 Exiting\n") > exit62);
+
+	// A small ring buffer drops messages rather than growing. Everything not dropped still arrives.
+	started = tStartAsyncOutput(logFile, 256);
+	for (int l = 0; l < 200; l++)
+		tPrintf(tChannel_TestResult, "%0100d\n", l);
+	tStopAsyncOutput();
+	tLoadFile(logFile, logText);
+	int numDropped = tGetNumDroppedOutput();
+	int numNotes = logText.CountChar('[');
+	tPrintf("Async output dropped %d of 200 messages.\n", numDropped);
+	tRequire(started && (logText.CountChar('\n') - numNotes == 200 - numDropped));
+	tRequire((numDropped == 0) || (numNotes > 0));
+	tDeleteFile(logFile);
+	tSetChannels(channels);
 }
 
 
@@ -651,6 +750,54 @@ tTestUnit(Regex)
 	RegexPattern("World$", "Hello World", "Test $ to match end of the string.");
 	RegexPattern("\\a\\a\\a\\A\\A\\A", "abC123", "Test \\a to match letters and \\A to match non-letters.");
 	RegexPattern("\\a\\a\\a\\A\\A\\A", "123abC", "Test \\a to match letters and \\A to match non-letters.");
+
+	// The automaton finds matches the backtracking matcher can't, and doesn't go exponential.
+	tRegex greedy("a*a");
+	tRequire(greedy.HasAutomaton());
+	tRequire(greedy.IsMatch("aaa"));
+	tRequire(!tRegex("llo\\b").HasAutomaton());
+
+	tRegex nested("(a|aa)*b");
+	tRequire(!nested.IsMatch("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+	tRequire(nested.IsMatch("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab"));
+	tRequire(tRegex("(a|b)*abb").IsMatch("abababb"));
+	tRequire(!tRegex(".....").IsMatch("Hi"));
+
+	// Searching with a caller supplied array.
+	tRegex paths("Textures/(\\w+)_n\\.tga$");
+	const char* path = "Assets/Textures/Textures/rock_n.tga";
+	tRegex::Match found[4];
+	int numFound = paths.Search(path, path + tStd::tStrlen(path), found, 4);
+	tRequire(numFound == 2);
+	tRequire((found[0].IndexStart == 16) && (found[0].Length == 19));
+	tRequire((found[1].IndexStart == 25) && (found[1].Length == 4));
+	tRequire(paths.Search(path, path + 20, found, 4) == 0);
+	tRequire(paths.Search(path, path + tStd::tStrlen(path), found, 1) == 1);
+	const char* backup = "Textures/rock_n.tga.bak";
+	tRequire(paths.Search(backup, backup + tStd::tStrlen(backup), found, 4) == 0);
+}
+
+
+// Walks two expressions in step and returns true if they have the same structure and atoms.
+bool ExpressionsMatch(const tExpression& a, const tExpression& b)
+{
+	if (a.IsValid() != b.IsValid())
+		return false;
+	if (!a.IsValid())
+		return true;
+	if ((a.IsAtom() != b.IsAtom()) || (a.GetLineNumber() != b.GetLineNumber()))
+		return false;
+	if (a.IsAtom())
+		return a.GetAtomString() == b.GetAtomString();
+
+	if (a.CountItems() != b.CountItems())
+		return false;
+	tExpression ea = a.First();
+	tExpression eb = b.First();
+	for (; ea.IsValid() || eb.IsValid(); ea = ea.Next(), eb = eb.Next())
+		if (!ExpressionsMatch(ea, eb))
+			return false;
+	return true;
 }
 
 
@@ -875,6 +1022,93 @@ tTestUnit(Script)
 		tPrintf("\n");
 	}
 	tRequire(numExceptions == 1);
+
+	tPrintf("Testing indexed script reading.\n");
+	{
+		tExprReader scanned("TestData/TestScript.txt");
+		tExprReader indexed("TestData/TestScript.txt", true, true);
+		tRequire(!scanned.IsIndexed() && indexed.IsIndexed());
+		tRequire(ExpressionsMatch(scanned, indexed));
+		tRequire(indexed.CountItems() == 10);
+		tRequire(indexed.Item1().GetAtomString() == "K");
+
+		tExpression varArgs = indexed.ItemN(4);			// [VarNumArg 1 2 3 4 5 [6 7]]
+		tRequire(varArgs.CountItems() == 7);
+		tRequire(varArgs.ItemN(4).GetAtomInt() == 4);
+		tRequire(varArgs.ItemN(4).GetAtomInt() == 4);
+		tRequire(varArgs.ItemN(4).GetAtomFloat() == 4.0f);
+		tRequire(varArgs.ItemN(6).Item1().GetAtomInt() == 7);
+		tRequire(!varArgs.ItemN(7).IsValid());
+		tVector3 v = indexed.ItemN(6).Item3();
+		tRequire(v == tVector3(4.0f, 5.0f, 6.0f));
+
+		// A generated script with long lists, nesting, comments, and brackets inside strings.
+		tString script;
+		for (int i = 0; i < 200; i++)
+			script += tsrPrintf("[Item %d [%f \"a [b] c\" (1, 2)] { ] comment } ; ]\n]\n[[[x]]]\n", i, float(i)/4.0f);
+		tExprReader scannedGen(script, false);
+		tExprReader indexedGen(script, false, true);
+		tRequire(indexedGen.IsIndexed());
+		tRequire(indexedGen.CountItems() == 400);
+		tRequire(indexedGen.ItemN(398).Item1().GetAtomInt() == 199);
+		tRequire(indexedGen.ItemN(399).Car().Car().Car().GetAtomString() == "x");
+		tRequire(indexedGen.ItemN(398).GetLineNumber() == 598);
+		tRequire(indexedGen.ItemN(2).Item2().Item1().GetAtomString() == "a [b] c");
+		tRequire(indexedGen.ItemN(2).Item2().Item0().GetAtomFloat() == 0.25f);
+
+		// A malformed script is not indexed and reports the error when reached, as before.
+		tExprReader broken("[a b] [c \"d e]", false, true);
+		tRequire(!broken.IsIndexed());
+		tRequire(broken.Item0().Item1().GetAtomString() == "b");
+	}
+
+	tPrintf("Testing bulk numeric writes.\n");
+	{
+		// A tiny buffer so the output is flushed many times.
+		const int numValues = 1000;
+		float floats[numValues];
+		double doubles[numValues];
+		int ints[numValues];
+		tVector3 vectors[numValues];
+		for (int v = 0; v < numValues; v++)
+		{
+			floats[v] = float(v) / 7.0f - 3.0f;
+			doubles[v] = double(v) * 1.0e-3 + 1.0e20 * double(v & 1);
+			ints[v] = v*v - 5000;
+			vectors[v].Set(floats[v], float(v) * 0.1f, 1.0e-30f * float(v));
+		}
+		floats[7] = tStd::tFloatPQNAN();
+
+		{
+			tExprWriter ws("TestData/WrittenArrays.cfg", 100);
+			ws.Begin(); ws.Atom("Floats"); ws.WriteAtoms(floats, numValues); ws.End(); ws.CR();
+			ws.Begin(); ws.Atom("Doubles"); ws.WriteAtoms(doubles, numValues); ws.End(); ws.CR();
+			ws.Begin(); ws.Atom("Ints"); ws.WriteAtoms(ints, numValues); ws.End(); ws.CR();
+			ws.Begin(); ws.Atom("Vectors"); ws.WriteAtoms(vectors, numValues); ws.End(); ws.CR();
+			ws.Flush();
+		}
+
+		tExprReader rs("TestData/WrittenArrays.cfg", true, true);
+		tRequire(rs.CountItems() == 4);
+		tExpression ef = rs.Item0().Item1();
+		tExpression ed = rs.Item1().Item1();
+		tExpression ei = rs.Item2().Item1();
+		tExpression ev = rs.Item3().Item1();
+		int numFloatsMatch = 0, numDoublesMatch = 0, numIntsMatch = 0, numVectorsMatch = 0;
+		for (int v = 0; v < numValues; v++, ef = ef.Next(), ed = ed.Next(), ei = ei.Next(), ev = ev.Next())
+		{
+			numFloatsMatch += (ef.GetAtomFloat() == ((v == 7) ? 0.0f : floats[v])) ? 1 : 0;
+			numDoublesMatch += (ed.GetAtomDouble() == doubles[v]) ? 1 : 0;
+			numIntsMatch += (ei.GetAtomInt() == ints[v]) ? 1 : 0;
+			numVectorsMatch += (ev.GetAtomVector3() == vectors[v]) ? 1 : 0;
+		}
+		tRequire(numFloatsMatch == numValues);
+		tRequire(numDoublesMatch == numValues);
+		tRequire(numIntsMatch == numValues);
+		tRequire(numVectorsMatch == numValues);
+		tRequire(!ef.IsValid());
+		tRequire(rs.Item0().ItemN(8).GetAtomString() == "0.0");
+	}
 }
 
 
@@ -1196,6 +1430,39 @@ tTestUnit(File)
 	tDeleteDir("TestData/CreatedA/");
 	tRequire(!tDirExists("TestData/CreatedA/"));
 
+	// Copy over an existing file and compare a file bigger than one compare chunk, differing only in the last byte.
+	tCreateDir("TestData/CreatedCopy/");
+	int bigSize = (1 << 20) + 4097;
+	uint8* bigData = new uint8[bigSize];
+	for (int b = 0; b < bigSize; b++)
+		bigData[b] = uint8((b*7) ^ (b >> 11));
+	tCreateFile("TestData/CreatedCopy/Big.bin", bigData, bigSize);
+	tCreateFile("TestData/CreatedCopy/Copy.bin", "Stale Contents");
+	tRequire(tCopyFile("TestData/CreatedCopy/Copy.bin", "TestData/CreatedCopy/Big.bin"));
+	tRequire(tGetFileSize64("TestData/CreatedCopy/Copy.bin") == int64(bigSize));
+	tRequire(tGetFileSize("TestData/CreatedCopy/Copy.bin") == bigSize);
+	tRequire(tFilesIdentical("TestData/CreatedCopy/Big.bin", "TestData/CreatedCopy/Copy.bin"));
+
+	// Copying a file onto itself, even by a different path, fails and leaves it alone.
+	tRequire(!tCopyFile("TestData/CreatedCopy/Copy.bin", "TestData/CreatedCopy/Copy.bin"));
+	tRequire(!tCopyFile("TestData/CreatedCopy/Copy.bin", "TestData/CreatedCopy/./Copy.bin"));
+	tRequire(tFilesIdentical("TestData/CreatedCopy/Big.bin", "TestData/CreatedCopy/Copy.bin"));
+
+	bigData[bigSize-1] ^= 0xFF;
+	tCreateFile("TestData/CreatedCopy/Changed.bin", bigData, bigSize);
+	tRequire(!tFilesIdentical("TestData/CreatedCopy/Big.bin", "TestData/CreatedCopy/Changed.bin"));
+	tRequire(!tFilesIdentical("TestData/CreatedCopy/Big.bin", "TestData/CreatedCopy/Missing.bin"));
+	delete[] bigData;
+
+	tFileHandle bigHandle = tOpenFile("TestData/CreatedCopy/Big.bin", "rb");
+	tRequire(tGetFileSize64(bigHandle) == int64(bigSize));
+	tRequire(tFileSeek64(bigHandle, int64(bigSize-1)) == 0);
+	tRequire(tFileTell64(bigHandle) == int64(bigSize-1));
+	tCloseFile(bigHandle);
+
+	tDeleteDir("TestData/CreatedCopy/");
+	tRequire(!tDirExists("TestData/CreatedCopy/"));
+
 	tString normalPath = "Q:/Projects/Calamity/Crypto/../../Reign/./Squiggle/";
 	tPrintf("Testing GetSimplifiedPath on '%s'\n", normalPath.Pod());
 	tString simpPath = tGetSimplifiedPath(normalPath);
@@ -1319,9 +1586,175 @@ tTestUnit(FindRec)
 	for (tFileInfo* info = infosNat.Head(); info; info = info->Next())
 		tPrintf("Found Dir: %s\n", info->FileName.Chr());
 	tRequire(infosStd.NumItems() == infosNat.NumItems());
+
+	// The parallel versions return the same sets in an unspecified order.
+	tPrintf("\nParallel Recursive Find Files. Incl Hidden. All Extensions.\n");
+	tPathArena filesPar;
+	tRequire(tFindFilesRecParallel(filesPar, "TestData/", nullptr, true, 4));
+	filesStd.Empty();
+	tFindFilesRec(filesStd, "TestData/", true, Backend::Stndrd);
+	tRequire(filesPar.GetNumPaths() == filesStd.NumItems());
+	int numFound = 0;
+	for (int p = 0; p < filesPar.GetNumPaths(); p++)
+		for (tStringItem* file = filesStd.Head(); file; file = file->Next())
+			if (*file == filesPar.GetPath(p)) { numFound++; break; }
+	tRequire(numFound == filesStd.NumItems());
+
+	tPrintf("\nParallel Recursive Find Files. Excl Hidden. TGA and JPG Extensions.\n");
+	filesPar.Clear();
+	tFindFilesRecParallel(filesPar, "TestData/", &exts, false);
+	infosStd.Empty();
+	tFindFilesRec(infosStd, "TestData/", exts, false, Backend::Stndrd);
+	tRequire(filesPar.GetNumPaths() == infosStd.NumItems());
+
+	tPrintf("\nParallel Recursive Find Dirs. Incl and Excl Hidden.\n");
+	tPathArena dirsPar;
+	tFindDirsRecParallel(dirsPar, "TestData/", true, 3);
+	dirsStd.Empty();
+	tFindDirsRec(dirsStd, "TestData/", true, Backend::Stndrd);
+	tRequire(dirsPar.GetNumPaths() == dirsStd.NumItems());
+	dirsPar.Clear();
+	tFindDirsRecParallel(dirsPar, "TestData/", false, 1);
+	infosStd.Empty();
+	tFindDirsRec(infosStd, "TestData/", false, Backend::Stndrd);
+	tRequire(dirsPar.GetNumPaths() == infosStd.NumItems());
+
+	// An arena may be appended to itself.
+	int numDirs = dirsPar.GetNumPaths();
+	dirsPar.Append(dirsPar);
+	tRequire(dirsPar.GetNumPaths() == numDirs*2);
+	bool appendedSame = true;
+	for (int p = 0; p < numDirs; p++)
+		if (tStd::tStrcmp(dirsPar.GetPath(p), dirsPar.GetPath(numDirs + p)) || (dirsPar.GetPathLength(p) != dirsPar.GetPathLength(numDirs + p)))
+			appendedSame = false;
+	tRequire(appendedSame);
+
+	// The callback may be called from any worker and can stop the walk early.
+	std::atomic<int> numCalls(0);
+	auto countAll = [&numCalls](const char* path, bool isDir) -> bool { numCalls++; return true; };
+	tRequire(tFindRecParallel(countAll, "TestData/", true));
+	tRequire(numCalls == filesStd.NumItems() + dirsStd.NumItems());
+
+	numCalls = 0;
+	auto stopEarly = [&numCalls](const char* path, bool isDir) -> bool { return ++numCalls < 2; };
+	tRequire(!tFindRecParallel(stopEarly, "TestData/", true, nullptr, true, 1));
+	tRequire(numCalls == 2);
 }
 
 
+tTestUnit(HashCache)
+{
+	if (!tDirExists("TestData/"))
+		tSkipUnit(HashCache)
+
+	// Files modified in the last couple of seconds are never recorded, so the test files are aged by an hour.
+	auto ageFile = [](const tString& file, int minutes)
+	{
+		std::filesystem::path path(file.Chr());
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::minutes(minutes));
+	};
+
+	tString dir = "TestData/HashCache/";
+	tString cacheFile = dir + "Cache.bin";
+	tString fileA = dir + "A.txt";
+	tString fileB = dir + "B.txt";
+	tString fileC = dir + "C.txt";
+	tDeleteDir(dir);
+	tCreateDir(dir);
+	tCreateFile(fileA, "Same Contents");
+	tCreateFile(fileB, "Same Contents");
+	tCreateFile(fileC, "Diff Contents");
+	ageFile(fileA, 60);
+	ageFile(fileB, 60);
+	ageFile(fileC, 60);
+
+	uint64 hashA = 0;
+	{
+		tHashCache cache(cacheFile);
+		tRequire(cache.IsOpen());
+		tRequire(cache.GetHash(hashA, fileA));
+		tRequire(hashA == tHashFile64(fileA));
+		tRequire((cache.GetNumMisses() == 1) && (cache.GetNumHits() == 0));
+
+		uint64 hash = 0;
+		tRequire(cache.GetHash(hash, fileA) && (hash == hashA));
+		tRequire(cache.GetNumHits() == 1);
+
+		tRequire(cache.FilesIdentical(fileA, fileB));
+		tRequire(!cache.FilesIdentical(fileA, fileC));
+		tRequire(!cache.FilesIdentical(fileA, dir + "Missing.txt"));
+		tRequire(cache.GetNumEntries() == 3);
+	}
+
+	// Reopening finds everything that was recorded. A changed file is re-read.
+	{
+		tHashCache cache(cacheFile);
+		tRequire(cache.GetNumEntries() == 3);
+		uint64 hash = 0;
+		tRequire(cache.GetHash(hash, fileA) && (hash == hashA));
+		tRequire((cache.GetNumHits() == 1) && (cache.GetNumMisses() == 0));
+
+		tCreateFile(fileC, "Same Contents");
+		ageFile(fileC, 30);
+		tRequire(cache.GetHash(hash, fileC) && (hash == hashA));
+		tRequire(cache.GetNumMisses() == 1);
+
+		// Recently modified files are hashed correctly but not recorded.
+		tCreateFile(fileB, "Diff Contents");
+		tRequire(cache.GetHash(hash, fileB) && (hash != hashA));
+		tRequire(cache.GetHash(hash, fileB) && (cache.GetNumMisses() == 3));
+
+		// With the cache installed the file functions use it.
+		tSetHashCache(&cache);
+		tRequire(tHashFile64(fileA) == hashA);
+		tRequire(tFilesIdentical(fileA, fileC));
+		tRequire(!tFilesIdentical(fileA, fileB));
+		tSetHashCache(nullptr);
+
+		// Enough values to make the table grow a few times.
+		tFileStamp stamp;
+		tRequire(tGetFileStamp(stamp, fileA));
+		for (int v = 0; v < 5000; v++)
+			cache.SetValue(tsrPrintf("Key%d", v), stamp, uint64(v)*3);
+		int numFound = 0;
+		for (int v = 0; v < 5000; v++)
+		{
+			uint64 value = 0;
+			if (cache.GetValue(value, tsrPrintf("Key%d", v), stamp) && (value == uint64(v)*3))
+				numFound++;
+		}
+		tRequire(numFound == 5000);
+		stamp.Size++;
+		uint64 value = 0;
+		tRequire(!cache.GetValue(value, "Key0", stamp));
+
+		cache.Clear();
+		tRequire(cache.GetNumEntries() == 0);
+	}
+
+	// A damaged file with a good header but every slot in use. Lookups must still finish and a store starts it again.
+	{
+		int fileSize = 0;
+		uint8* data = tLoadFile(cacheFile, nullptr, &fileSize);
+		tRequire(data && (fileSize > 16));
+		tStd::tMemset(data + 16, 0xFF, fileSize - 16);
+		tCreateFile(cacheFile, data, fileSize);
+		delete[] data;
+
+		tHashCache cache(cacheFile);
+		tRequire(cache.IsOpen());
+		tFileStamp stamp;
+		tRequire(tGetFileStamp(stamp, fileA));
+		uint64 value = 0;
+		tRequire(!cache.GetValue(value, "Damaged", stamp));
+		cache.SetValue("Damaged", stamp, 42);
+		tRequire(cache.GetValue(value, "Damaged", stamp) && (value == 42));
+		tRequire(cache.GetNumEntries() == 1);
+	}
+
+	tRequire(tDeleteDir(dir));
+}
+
 #if defined(PLATFORM_WINDOWS)
 tNetworkShareResult NetworkShareResult;
 void GetNetworkSharesThreadEntry()
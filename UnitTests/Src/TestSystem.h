@@ -28,6 +28,7 @@ namespace tUnitTest
 	tTestUnit(Directories);
 	tTestUnit(File);
 	tTestUnit(FindRec);
+	tTestUnit(HashCache);
 	tTestUnit(Network);
 	tTestUnit(Time);
 	tTestUnit(Machine);
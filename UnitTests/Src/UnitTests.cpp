@@ -153,14 +153,23 @@ int main(int argc, char** argv)
 	tTest(Directories);
 	tTest(File);
 	tTest(FindRec);
+	tTest(HashCache);
 	tTest(Network);
 	tTest(Time);
 	tTest(Machine);
 
 	// Pipeline tests.
-	#ifdef PLATFORM_WINDOWS
+	#if defined(PLATFORM_WINDOWS) || defined(PLATFORM_LINUX)
 	tTest(Process);
 	tTest(Rule);
+	tTest(RuleGraph);
+	#endif
+
+	// Scene tests.
+	#if !defined(ARCHITECTURE_ARM32) && !defined(ARCHITECTURE_ARM64)
+	tTest(PolyModel);
+	tTest(Simplify);
+	tTest(BVH);
 	#endif
 
 	// Image tests.